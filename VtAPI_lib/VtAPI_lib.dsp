@@ -123,18 +123,34 @@ SOURCE=.\VtABDiff.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\VtAccumulator.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\VtAPI.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\VtCalibBank.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\VtDataset.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\VtDefectList.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\VtErrors.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\VtFieldCalib.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\VthdsAPI.h
 # End Source File
 # Begin Source File
@@ -143,6 +159,14 @@ SOURCE=.\VthdsCalib.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\VthdsCalibCache.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\VthdsDarkCache.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\VthdsImpAPI.h
 # End Source File
 # Begin Source File
@@ -151,10 +175,30 @@ SOURCE=.\VthdsLineParser.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\VthdsReadoutProbe.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\VtImage.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\VtImageAlloc.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\VtKernels.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\VtMappedFile.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\VtPacked12.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\VtPanoramicCalibration.h
 # End Source File
 # Begin Source File
@@ -179,6 +223,10 @@ SOURCE=.\VtPipeData.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\VtSeamRepair.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\VtSys.h
 # End Source File
 # Begin Source File
@@ -187,6 +235,10 @@ SOURCE=.\VtSysdefs.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\VtThreadPool.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\ez_lib\VtUsbDriver.h
 # End Source File
 # Begin Source File
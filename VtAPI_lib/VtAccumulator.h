@@ -0,0 +1,376 @@
+/** \file VtAccumulator.h
+
+	\brief Streaming accumulation of dark and bright calibration frames.
+
+	A calibration is only as good as its dark and bright frames, and a single frame carries all of
+	its temporal noise into the coefficients. Averaging many frames removes it, but holding 50 or
+	100 frames to average them is not practical. The Vt::CVtFrameAccumulator class takes frames one
+	at a time, as they are captured, and keeps only running integer sums. From these it produces the
+	mean frame and the per pixel noise map, and the mean and noise of each row.
+
+	The sums are exact integers, so the mean and variance have no rounding error from the order in
+	which frames arrive and don't suffer the cancellation of a floating point sum of squares.
+
+ * Copyright (c) 2013 by
+ * All Rights Reserved
+ * REVISIONS:
+ * $Log: $
+ *
+ */
+
+#ifndef __CVTACCUMULATOR_H__
+#define __CVTACCUMULATOR_H__
+
+#include <math.h>
+#include <vector>
+#include "VtSysdefs.h"
+#include "VtErrors.h"
+#include "VtImage.h"
+
+#ifdef VT_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Vt {
+
+/**
+	\brief Add a line of 16 bit pixels to running 32 bit sums and 64 bit sums of squares.
+*/
+inline void accumulate_line(vt_uint32 *sum, vt_uint64 *sumsq, const vt_ushort *src, const vt_ulong num)
+{
+	vt_ulong idx = 0;
+
+#ifdef VT_SSE2
+	const __m128i zero = _mm_setzero_si128();
+
+	for (; idx + 8 <= num; idx += 8)
+	{
+		__m128i pix = _mm_loadu_si128( (const __m128i *) (src + idx) );
+
+		// sums
+		__m128i *ps = (__m128i *) (sum + idx);
+		_mm_storeu_si128( ps,			_mm_add_epi32( _mm_loadu_si128( ps ),			_mm_unpacklo_epi16( pix, zero ) ) );
+		_mm_storeu_si128( ps + 1, _mm_add_epi32( _mm_loadu_si128( ps + 1 ), _mm_unpackhi_epi16( pix, zero ) ) );
+
+		// 32 bit squares from the low and high halves of the 16 bit products
+		__m128i lo	= _mm_mullo_epi16( pix, pix );
+		__m128i hi	= _mm_mulhi_epu16( pix, pix );
+		__m128i sq0 = _mm_unpacklo_epi16( lo, hi );
+		__m128i sq1 = _mm_unpackhi_epi16( lo, hi );
+
+		__m128i *pq = (__m128i *) (sumsq + idx);
+		_mm_storeu_si128( pq,			_mm_add_epi64( _mm_loadu_si128( pq ),			_mm_unpacklo_epi32( sq0, zero ) ) );
+		_mm_storeu_si128( pq + 1, _mm_add_epi64( _mm_loadu_si128( pq + 1 ), _mm_unpackhi_epi32( sq0, zero ) ) );
+		_mm_storeu_si128( pq + 2, _mm_add_epi64( _mm_loadu_si128( pq + 2 ), _mm_unpacklo_epi32( sq1, zero ) ) );
+		_mm_storeu_si128( pq + 3, _mm_add_epi64( _mm_loadu_si128( pq + 3 ), _mm_unpackhi_epi32( sq1, zero ) ) );
+	}
+#endif
+
+	for (; idx < num; idx++)
+	{
+		const vt_uint32 val = src[idx];
+
+		sum[idx]	 += val;
+		sumsq[idx] += (vt_uint64) (val*val);
+	}
+}
+
+/**
+	\brief Running per pixel and per row statistics of a sequence of frames.
+
+	Every frame must have the same layout and line length (e.g. the number of rows of a pano
+	column-major frame). The number of lines may vary, pano frames are as wide as the scan,
+	statistics are kept for the lines common to every frame.
+
+	The per pixel sums are 32 bits, which holds MAX_FRAMES frames of 16 bit data. Each row also
+	keeps the sum and sum of squares of its per frame total, which gives the frame to frame noise
+	of the row mean - the banding that a per row calibration can't remove.
+*/
+template<typename ImageType>
+class CVtFrameAccumulator
+{
+public:
+	enum {
+		MAX_FRAMES = 65536	//!< frames before the 32 bit pixel sums can overflow
+	};
+
+private:
+	vt_ulong									m_count;
+	vt_ulong									m_lines;
+	vt_ulong									m_line_length;
+	CVtImageBaseClass::LAYOUT	m_layout;
+
+	std::vector<vt_uint32>		m_sum;
+	std::vector<vt_uint64>		m_sumsq;
+
+	// per row frame totals, relative to the first frame to keep the squares small
+	std::vector<vt_int64>			m_row_first;
+	std::vector<vt_int64>			m_row_dsum;
+	std::vector<vt_double>		m_row_dsumsq;
+	vt_ulong									m_row_width;
+
+	vt_ulong width() const	{ return (m_layout == CVtImageBaseClass::ROW_MAJOR) ? m_line_length : m_lines; }
+	vt_ulong height() const { return (m_layout == CVtImageBaseClass::ROW_MAJOR) ? m_lines : m_line_length; }
+
+	vt_ulong index(const vt_ulong col, const vt_ulong row) const
+	{
+		return (m_layout == CVtImageBaseClass::ROW_MAJOR) ? row*m_line_length + col : col*m_line_length + row;
+	}
+
+public:
+	CVtFrameAccumulator() : m_count( 0 )
+												, m_lines( 0 )
+												, m_line_length( 0 )
+												, m_layout( CVtImageBaseClass::ROW_MAJOR )
+												, m_row_width( 0 )
+	{}
+
+	virtual ~CVtFrameAccumulator() {}
+
+	/**
+	\brief Forget all frames added so far, and release the sums.
+	*/
+	void reset()
+	{
+		m_count = 0;
+		m_lines = 0;
+		m_line_length = 0;
+		m_row_width = 0;
+
+		std::vector<vt_uint32>().swap( m_sum );
+		std::vector<vt_uint64>().swap( m_sumsq );
+		std::vector<vt_int64>().swap( m_row_first );
+		std::vector<vt_int64>().swap( m_row_dsum );
+		std::vector<vt_double>().swap( m_row_dsumsq );
+	}
+
+	//! number of frames added
+	vt_ulong count() const
+	{
+		return m_count;
+	}
+
+	/**
+	\brief Add a frame to the running sums.
+	*/
+	void add(const CVtImage<ImageType> &frame)
+	{
+		Vt_precondition( m_count < MAX_FRAMES, "CVtFrameAccumulator::add - too many frames" );
+
+		if (m_count == 0)
+		{
+			m_layout			= frame.layout();
+			m_lines				= frame.num_lines();
+			m_line_length = frame.line_length();
+
+			m_sum.assign( m_lines*m_line_length, 0 );
+			m_sumsq.assign( m_lines*m_line_length, 0 );
+		}
+		else
+		{
+			Vt_precondition( frame.layout() == m_layout && frame.line_length() == m_line_length
+										 , "CVtFrameAccumulator::add - frame geometry differs from the first frame" );
+
+			// keep the lines common to every frame
+			if (frame.num_lines() < m_lines)
+			{
+				m_lines = frame.num_lines();
+				m_sum.resize( m_lines*m_line_length );
+				m_sumsq.resize( m_lines*m_line_length );
+			}
+		}
+
+		for (vt_ulong line = 0; line < m_lines; line++)
+		{
+			accumulate_line( &m_sum[line*m_line_length], &m_sumsq[line*m_line_length], frame[line], m_line_length );
+		}
+
+		add_rows( frame );
+
+		m_count++;
+	}
+
+	/**
+	\brief The mean frame, rounded to the nearest pixel value.
+
+	The returned image has the layout of the frames added, the caller owns it.
+	*/
+	CVtImage<ImageType> *mean(CVtImageAllocator &alloc = uninit_allocator()) const
+	{
+		Vt_precondition( m_count > 0, "CVtFrameAccumulator::mean - no frames added" );
+
+		CVtImage<ImageType> *im = new CVtImage<ImageType>( width(), height(), m_layout, alloc );
+
+		const vt_uint64 half = m_count/2;
+
+		for (vt_ulong line = 0; line < m_lines; line++)
+		{
+			const vt_uint32 *sum = &m_sum[line*m_line_length];
+			ImageType				*dst = (*im)[line];
+
+			for (vt_ulong idx = 0; idx < m_line_length; idx++)
+			{
+				dst[idx] = (ImageType) ((sum[idx] + half)/m_count);
+			}
+		}
+		return im;
+	}
+
+	/**
+	\brief The mean frame in single precision, unrounded.
+
+	\param dst the means, a row-major plane of width() x height() whatever the layout of the frames
+	*/
+	void mean_values(vt_float *dst) const
+	{
+		Vt_precondition( m_count > 0, "CVtFrameAccumulator::mean_values - no frames added" );
+
+		const vt_double scale = 1.0/m_count;
+
+		// where a line and the pixels along it go in a row-major plane
+		const vt_bool	 rows				= (m_layout == CVtImageBaseClass::ROW_MAJOR);
+		const vt_ulong line_step	= rows ? m_line_length : 1;
+		const vt_ulong pixel_step = rows ? 1 : m_lines;
+
+		for (vt_ulong line = 0; line < m_lines; line++)
+		{
+			const vt_uint32 *sum = &m_sum[line*m_line_length];
+			vt_float				*out = dst + line*line_step;
+
+			for (vt_ulong idx = 0; idx < m_line_length; idx++)
+			{
+				out[idx*pixel_step] = (vt_float) (sum[idx]*scale);
+			}
+		}
+	}
+
+	/**
+	\brief The per pixel temporal noise, the standard deviation of each pixel over the frames.
+
+	The returned image has the layout of the frames added, the caller owns it.
+	*/
+	CVtImage<vt_float> *noise() const
+	{
+		Vt_precondition( m_count > 0, "CVtFrameAccumulator::noise - no frames added" );
+
+		CVtImage<vt_float> *im = new CVtImage<vt_float>( width(), height(), m_layout );
+
+		const vt_double n = (vt_double) m_count;
+
+		for (vt_ulong line = 0; line < m_lines; line++)
+		{
+			const vt_uint32 *sum	 = &m_sum[line*m_line_length];
+			const vt_uint64 *sumsq = &m_sumsq[line*m_line_length];
+			vt_float				*dst	 = (*im)[line];
+
+			for (vt_ulong idx = 0; idx < m_line_length; idx++)
+			{
+				// n*sumsq - sum*sum is exact in 64 bits for up to MAX_FRAMES 16 bit frames
+				const vt_uint64 s		= sum[idx];
+				const vt_uint64 var = m_count*sumsq[idx] - s*s;
+
+				dst[idx] = (vt_float) (sqrt( (vt_double) var )/n);
+			}
+		}
+		return im;
+	}
+
+	/**
+	\brief The average of the per pixel temporal noise.
+	*/
+	vt_double mean_noise() const
+	{
+		Vt_precondition( m_count > 0, "CVtFrameAccumulator::mean_noise - no frames added" );
+
+		const vt_ulong num = m_lines*m_line_length;
+		vt_double			 sum = 0.0;
+
+		for (vt_ulong idx = 0; idx < num; idx++)
+		{
+			const vt_uint64 s = m_sum[idx];
+			sum += sqrt( (vt_double) (m_count*m_sumsq[idx] - s*s) );
+		}
+		return (num > 0) ? sum/((vt_double) m_count*num) : 0.0;
+	}
+
+	/**
+	\brief Mean value of a row over all pixels and frames.
+	*/
+	vt_double row_mean(const vt_ulong row) const
+	{
+		Vt_precondition( m_count > 0 && row < height(), "CVtFrameAccumulator::row_mean - invalid row" );
+
+		vt_uint64 total = 0;
+		for (vt_ulong col = 0; col < width(); col++)
+		{
+			total += m_sum[index( col, row )];
+		}
+		return (vt_double) total/((vt_double) m_count*width());
+	}
+
+	/**
+	\brief Frame to frame standard deviation of the mean of a row.
+	*/
+	vt_double row_noise(const vt_ulong row) const
+	{
+		Vt_precondition( m_count > 0 && row < height(), "CVtFrameAccumulator::row_noise - invalid row" );
+
+		const vt_double n		 = (vt_double) m_count;
+		const vt_double mean = m_row_dsum[row]/n;
+		const vt_double var	 = m_row_dsumsq[row]/n - mean*mean;
+
+		return (var > 0.0) ? sqrt( var )/m_row_width : 0.0;
+	}
+
+private:
+	//
+	// per row frame totals - the rows of the first frame set the width used for every frame
+	//
+	void add_rows(const CVtImage<ImageType> &frame)
+	{
+		if (m_count == 0)
+		{
+			m_row_width = frame.width();
+			m_row_first.assign( frame.height(), 0 );
+			m_row_dsum.assign( frame.height(), 0 );
+			m_row_dsumsq.assign( frame.height(), 0.0 );
+		}
+		const vt_ulong rows = (frame.height() < m_row_first.size()) ? frame.height() : m_row_first.size();
+		const vt_ulong cols = (frame.width() < m_row_width) ? frame.width() : m_row_width;
+
+		std::vector<vt_int64> total( rows, 0 );
+		if (frame.layout() == CVtImageBaseClass::ROW_MAJOR)
+		{
+			for (vt_ulong row = 0; row < rows; row++)
+			{
+				const ImageType *src = frame[row];
+				for (vt_ulong col = 0; col < cols; col++)
+					total[row] += src[col];
+			}
+		}
+		else
+		{
+			for (vt_ulong col = 0; col < cols; col++)
+			{
+				const ImageType *src = frame[col];
+				for (vt_ulong row = 0; row < rows; row++)
+					total[row] += src[row];
+			}
+		}
+
+		for (vt_ulong row = 0; row < rows; row++)
+		{
+			if (m_count == 0)
+				m_row_first[row] = total[row];
+
+			const vt_int64 d = total[row] - m_row_first[row];
+
+			m_row_dsum[row]		+= d;
+			m_row_dsumsq[row] += (vt_double) d*d;
+		}
+	}
+};
+
+} // Vt namespace
+
+#endif // __CVTACCUMULATOR_H__
@@ -0,0 +1,187 @@
+/** \file VtCalibBank.h
+
+	\brief The pano and ceph calibrations for every binning mode, held for the life of the process.
+
+	A pano/ceph calibration is a dark level, a bright level and a coefficient for every row of
+	the sensor, so it only suits frames with the row height it was made with. The vertically
+	binned modes (2x2, 2x1) have half the rows of the unbinned modes (1x1, 1x2), horizontal
+	binning makes no difference to the rows.
+
+	Vt::CVtCalibBank keeps the rows for each api and binning mode side by side. When the
+	deriveBinned api parameter is set, a calibration made without vertical binning also gives
+	the vertically binned modes by averaging pairs of rows, so one 1x1 calibration covers all
+	four modes. This is off by default: binned charge is summed on the chip before the ADC,
+	and that the dark levels and gains of binned rows are those of the row pairs averaged
+	hasn't been measured. The bank belongs to the process rather than the api object, so a
+	new session in another mode picks up its calibration without reading or recalculating
+	anything. Every access is made under the bank's lock.
+
+ * Copyright (c) 2013 by
+ * All Rights Reserved
+ * REVISIONS:
+ * $Log: $
+ *
+ */
+
+#ifndef __CVTCALIBBANK_H__
+#define __CVTCALIBBANK_H__
+
+#include <windows.h>
+#include <map>
+#include <vector>
+#include "VtSysdefs.h"
+#include "VtErrors.h"
+#include "VtAPI.h"
+
+namespace Vt {
+
+/**
+	\brief Per row pano/ceph calibrations keyed by api type and binning mode.
+*/
+template<typename CoefType>
+class CVtCalibBank
+{
+public:
+	/**
+	\brief The rows of one calibration.
+	*/
+	struct ENTRY
+	{
+		vt_ulong							chip_height;	//!< rows per tile
+		std::vector<CoefType>	dark;					//!< dark level of each row
+		std::vector<CoefType>	bright;				//!< bright level of each row
+		std::vector<CoefType>	coef;					//!< coefficient of each row
+		vt_bool								derived;			//!< made from an unbinned calibration rather than measured
+
+		ENTRY() : chip_height( 0 ), derived( false )
+		{}
+	};
+
+private:
+	typedef std::pair<CVtAPI::API_TYPE, BIN_MODE> KEY;
+	typedef std::map<KEY, ENTRY>									ENTRIES;
+
+	ENTRIES						m_entries;
+	CRITICAL_SECTION	m_lock;
+
+	CVtCalibBank(const CVtCalibBank &);
+	CVtCalibBank &operator=(const CVtCalibBank &);
+
+	void put(const CVtAPI::API_TYPE api, const BIN_MODE mode, const ENTRY &entry)
+	{
+		typename ENTRIES::iterator it = m_entries.find( KEY( api, mode ) );
+
+		// a measured calibration isn't replaced by a derived one
+		if (entry.derived && it != m_entries.end() && !it->second.derived)
+			return;
+
+		m_entries[KEY( api, mode )] = entry;
+	}
+
+public:
+	CVtCalibBank()
+	{
+		::InitializeCriticalSection( &m_lock );
+	}
+
+	virtual ~CVtCalibBank()
+	{
+		::DeleteCriticalSection( &m_lock );
+	}
+
+	/**
+	\brief true if the mode bins pairs of rows.
+	*/
+	static vt_bool vbin(const BIN_MODE mode)
+	{
+		return mode == BIN2x2 || mode == BIN2x1;
+	}
+
+	/**
+	\brief The mode with the same horizontal binning and the given vertical binning.
+	*/
+	static BIN_MODE with_vbin(const BIN_MODE mode, const vt_bool vbin_flag)
+	{
+		const vt_bool hbin = (mode == BIN2x2 || mode == BIN1x2);
+
+		if (vbin_flag)
+			return hbin ? BIN2x2 : BIN2x1;
+		else
+			return hbin ? BIN1x2 : BIN1x1;
+	}
+
+	/**
+	\brief The mode with the same vertical binning and the other horizontal binning.
+	*/
+	static BIN_MODE sibling(const BIN_MODE mode)
+	{
+		switch (mode)
+		{
+		case BIN1x1: return BIN1x2;
+		case BIN1x2: return BIN1x1;
+		case BIN2x1: return BIN2x2;
+		case BIN2x2: return BIN2x1;
+		default:		break;
+		}
+		return mode;
+	}
+
+	/**
+	\brief Add a calibration, for mode and the mode that differs from it only in horizontal binning.
+	*/
+	void store(const CVtAPI::API_TYPE api, const BIN_MODE mode, const ENTRY &entry)
+	{
+		Vt_precondition( mode != INVALID_BIN_MODE, "CVtCalibBank::store - invalid binning mode" );
+
+		::EnterCriticalSection( &m_lock );
+		put( api, mode, entry );
+		put( api, sibling( mode ), entry );
+		::LeaveCriticalSection( &m_lock );
+	}
+
+	/**
+	\brief Copy the calibration for an api and mode into entry, false if there isn't one.
+	*/
+	vt_bool find(const CVtAPI::API_TYPE api, const BIN_MODE mode, ENTRY &entry)
+	{
+		::EnterCriticalSection( &m_lock );
+		typename ENTRIES::const_iterator it = m_entries.find( KEY( api, mode ) );
+
+		const vt_bool found = (it != m_entries.end());
+		if (found)
+			entry = it->second;
+		::LeaveCriticalSection( &m_lock );
+
+		return found;
+	}
+
+	/**
+	\brief Forget every calibration for an api, e.g. before a new calibration run is stored.
+	*/
+	void clear(const CVtAPI::API_TYPE api)
+	{
+		::EnterCriticalSection( &m_lock );
+		for (typename ENTRIES::iterator it = m_entries.begin(); it != m_entries.end(); )
+		{
+			if (it->first.first == api)
+				m_entries.erase( it++ );
+			else
+				++it;
+		}
+		::LeaveCriticalSection( &m_lock );
+	}
+};
+
+/**
+	\brief The calibration bank shared by every pano/ceph session in the process
+*/
+template<typename CoefType>
+CVtCalibBank<CoefType> &calib_bank()
+{
+	static CVtCalibBank<CoefType> bank;
+	return bank;
+}
+
+} // Vt namespace
+
+#endif // __CVTCALIBBANK_H__
@@ -1,224 +1,785 @@
-/** \file VtDataset.h contains CVtDataset class.
-
-	Defines the class which holds a collection of related image data.
-
-	Typically a dataset will contain all the input and intermediate images require to produce
-	the final displayed image.
-
-* Copyright (c) 2013 by
-* All Rights Reserved
-*
-* REVISIONS: 
-* $Log: VtDataset.h $
-*
-*/
-
-#ifndef __CVTDATASET_H__
-#define __CVTDATASET_H__
-
-namespace Vt 
-{
-
-/**
-\class CVtDataset 
-*/
-
-
-template<class T>
-class CVtDataset 
-{
-public:
-	typedef std::pair<T, CVtImageBaseClass*>	DATASET_ENTRY;
-	typedef	std::vector<DATASET_ENTRY >	DATASET;
-
-	typedef DATASET::iterator iterator;
-	typedef DATASET::const_iterator const_iterator;
-
-protected:
-	DATASET		m_dataset;
-
-public:
-	//
-	// Initialise reconstruction and globals in base class
-	//
-	CVtDataset() {}
-  //
-  // Destructor
-  //
-  virtual ~CVtDataset() 
-	{
-		delete_dataset();
-	}
-
-	virtual iterator begin()
-	{
-		return m_dataset.begin();
-	}
-	virtual iterator end()
-	{
-		return m_dataset.end();
-	}
-
-	virtual vt_bool delete_dataset()
-	{
-		// get rid of any data sets hanging around
-		for(;!m_dataset.empty(); m_dataset.pop_back())
-		{
-			DATASET_ENTRY entry = m_dataset.back();
-			delete entry.second; // delete the image
-		}
-
-		return (_CrtCheckMemory() == TRUE);
-	}
-
-	virtual vt_bool delete_image(CVtAPI::IM_TYPE im_type)
-	{
-		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
-		{
-			if ( (*it).first.type == im_type)
-			{
-				CVtImageBaseClass* im = (*it).second;
-
-				if (im != NULL)
-					delete im;
-
-				m_dataset.erase( it );
-
-				Vt_precondition( _CrtCheckMemory() == TRUE, "image_ptr::Memory problem detected\n" );
-				return true;
-			}
-		}
-
-		return false;
-	}
-
-	///
-	// image data accessors
-	//
-	virtual vt_ushort * image_ptr()
-	{
-		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
-		{
-			CVtImage<vt_acq_im_type>* im = dynamic_cast<CVtImage<vt_acq_im_type>*>((*it).second);
-			if (im != NULL && ((*it).first.type == CVtAPI::OUTPUT_IM))
-			{
-				Vt_precondition( _CrtCheckMemory() == TRUE, "image_ptr::Memory problem detected\n" );
-				return im->begin();
-			}
-		}
-		return NULL;
-	}
-	virtual vt_ushort * image_ptr(CVtAPI::IM_TYPE im_type)
-	{
-		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
-		{
-			CVtImage<vt_acq_im_type>* im = dynamic_cast<CVtImage<vt_acq_im_type>*>((*it).second);
-			if (im != NULL && ((*it).first.type == im_type))
-			{
-				Vt_precondition( _CrtCheckMemory() == TRUE, "image_ptr::Memory problem detected\n" );
-				return im->begin();
-			}
-		}
-		return NULL;
-	}
-	virtual vt_ushort ** image_ptrs(CVtAPI::IM_TYPE im_type)
-	{
-		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
-		{
-			CVtImage<vt_acq_im_type>* im = dynamic_cast<CVtImage<vt_acq_im_type>*>((*it).second);
-			if (im != NULL && ((*it).first.type == im_type))
-			{
-				Vt_precondition( _CrtCheckMemory() == TRUE, "image_ptr::Memory problem detected\n" );
-				return im->lines();
-			}
-		}
-
-		return NULL;
-	}
-
-
-	///
-	// get image height - returns image height
-	// currently all the images are the same height
-	//
-	virtual vt_ulong image_width(CVtAPI::IM_TYPE im_type)
-	{
-		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
-		{
-			CVtImage<vt_acq_im_type>* im = dynamic_cast<CVtImage<vt_acq_im_type>*>((*it).second);
-			if (im != NULL && ((*it).first.type == im_type))
-			{
-				Vt_precondition( _CrtCheckMemory() == TRUE, "image_ptr::Memory problem detected\n" );
-				return im->width();
-			}
-		}
-		return 0;
-	}
-	virtual vt_ulong image_height(CVtAPI::IM_TYPE im_type) 
-	{
-		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
-		{
-			CVtImage<vt_acq_im_type>* im = dynamic_cast<CVtImage<vt_acq_im_type>*>((*it).second);
-			if (im != NULL && ((*it).first.type == im_type))
-			{
-				Vt_precondition( _CrtCheckMemory() == TRUE, "image_ptr::Memory problem detected\n" );
-				return im->height();
-			}
-		}
-		return 0;
-	}
-
-	//
-	// operator[]
-	// 
-	vt_ulong size()
-	{
-		return m_dataset.size();
-	}
-
-	//
-	// operator[]
-	// 
-	CVtImageBaseClass* operator [](const vt_ulong idx)
-	{
-		return m_dataset[idx].second;
-	}
-	///
-	// dataset manipulation
-	//
-	// Datasets can be any 2d set of data. If we are in non-sync
-	// mode then Dataset 0 is usually the raw input data buffers.
-	//
-	void add_dataset( T ent_type, CVtImageBaseClass *pdata )
-	{
-		m_dataset.push_back( std::pair< T, CVtImageBaseClass* >(ent_type, pdata ) );
-	}
-
-	///
-	// pop_back
-	//
-	DATASET_ENTRY pop_back( const CVtAPI::IM_TYPE im_type )
-	{
-		DATASET_ENTRY entry = m_dataset.back();
-
-		if ( im_type != entry.first.type )
-			Vt_fail( "VtSys::pop_back::Unexpected entry type" );
-
-		// remove entry from vector
-		m_dataset.pop_back();
-		return entry;
-	}
-
-	DATASET_ENTRY get_back( const CVtAPI::IM_TYPE im_type )
-	{
-		DATASET_ENTRY entry = m_dataset.back();
-
-		if ( im_type != entry.first.type )
-			Vt_fail( "VtSys::pop_back::Unexpected entry type" );
-
-		return entry;
-	}
-};
-
-} // end Vt namespace
-#endif // __CVTHDSIMPAPI_H__
+/** \file VtDataset.h contains CVtDataset class.
+
+	Defines the class which holds a collection of related image data.
+
+	Typically a dataset will contain all the input and intermediate images require to produce
+	the final displayed image.
+
+* Copyright (c) 2013 by
+* All Rights Reserved
+*
+* REVISIONS: 
+* $Log: VtDataset.h $
+*
+*/
+
+#ifndef __CVTDATASET_H__
+#define __CVTDATASET_H__
+
+namespace Vt 
+{
+
+/**
+\class CVtDatasetProducer
+
+	Implemented by the objects which know how to make a derived image type, e.g. the pano
+	API makes CENTRE_IM images from ACQ_IM images. A producer registered with a dataset is 
+	asked for its images the first time they are accessed.
+*/
+class CVtDatasetProducer
+{
+public:
+	virtual ~CVtDatasetProducer() {}
+
+	/**
+	\brief Make the images of type im_type and add them to the dataset. 
+	
+	Returns false if the producer can't make this image type.
+	*/
+	virtual vt_bool produce(const CVtAPI::IM_TYPE im_type) = 0;
+
+	/**
+	\brief The size and layout of the images produce() would make, without making them.
+
+	Returns false if the producer can't tell, the images are then made to measure them.
+	*/
+	virtual vt_bool geometry(const CVtAPI::IM_TYPE im_type, vt_ulong &width, vt_ulong &height, CVtImageBaseClass::LAYOUT &layout)
+	{
+		return false;
+	}
+};
+
+/**
+\class CVtDatasetConsumer
+
+	Implemented by the objects which take images as they arrive rather than leave them in the
+	dataset, e.g. the hds API folds each acquired frame into the calibration sums. A consumer
+	registered with a dataset is given every image of its type added from outside a producer.
+*/
+class CVtDatasetConsumer
+{
+public:
+	virtual ~CVtDatasetConsumer() {}
+
+	/**
+	\brief Take an image instead of the dataset, the consumer owns it from here on.
+	*/
+	virtual void consume(const CVtAPI::IM_TYPE im_type, CVtImageBaseClass *im) = 0;
+};
+
+/**
+\class CVtDataset 
+
+	The dataset owns every image produced during a session. Optionally the dataset can be given
+	a memory budget. When a processing stage completes it calls trim() and, if the resident images
+	exceed the budget, the dataset
+
+		-# deletes evictable intermediates whose downstream product is already present,
+		-# spills consumed images to temporary files, oldest first,
+		-# spills any other image whose type is not pinned.
+
+	Spilled images keep their geometry and are reloaded transparently by fetch() and the image
+	accessors. Usage is tracked per image type, see usage().
+
+	Images of a type with a consumer registered are handed to the consumer as they are added,
+	and never held, see set_consumer().
+
+	Derived image types can be made lazily. If a producer is registered for a type, the image
+	accessors call materialise() which asks the producer for the images the first time they are
+	needed. The results are kept until an input changes - adding an image from outside a producer
+	deletes the derived images downstream of it, so they are remade on the next access.
+*/
+
+
+template<class T>
+class CVtDataset 
+{
+public:
+	typedef std::pair<T, CVtImageBaseClass*>	DATASET_ENTRY;
+	typedef	std::vector<DATASET_ENTRY >	DATASET;
+
+	typedef DATASET::iterator iterator;
+	typedef DATASET::const_iterator const_iterator;
+
+	/**
+	 Memory usage of one image type, in bytes
+	*/
+	typedef struct {
+		vt_ulong current;			//!< resident in memory
+		vt_ulong peak;				//!< highest resident value seen
+		vt_ulong spilled;			//!< held in spill files
+	} USAGE;
+
+	typedef std::map<CVtAPI::IM_TYPE, USAGE> USAGE_MAP;
+
+protected:
+	DATASET		m_dataset;
+
+	//! the resident memory budget in bytes, 0 for no limit
+	vt_ulong	m_budget;
+	vt_ulong	m_current;
+	vt_ulong	m_peak;
+
+	USAGE_MAP	m_usage;
+
+	//! the input image type of each derived image type
+	std::map<CVtAPI::IM_TYPE, CVtAPI::IM_TYPE> m_input;
+	std::map<CVtAPI::IM_TYPE, vt_bool>				 m_evictable;
+	std::map<CVtAPI::IM_TYPE, vt_bool>				 m_pinned;
+
+	//! spill files of the spilled images
+	std::map<CVtImageBaseClass*, FILE*>				 m_spill;
+
+	//! producers of the derived image types
+	std::map<CVtAPI::IM_TYPE, CVtDatasetProducer*> m_producer;
+	std::map<CVtAPI::IM_TYPE, vt_bool>				 m_producing;
+	vt_ulong																	 m_depth;
+
+	//! consumers of the incoming image types
+	std::map<CVtAPI::IM_TYPE, CVtDatasetConsumer*> m_consumer;
+
+public:
+	//
+	// Initialise reconstruction and globals in base class
+	//
+	CVtDataset() : m_budget( 0 ), m_current( 0 ), m_peak( 0 ), m_depth( 0 ) {}
+  //
+  // Destructor
+  //
+  virtual ~CVtDataset() 
+	{
+		delete_dataset();
+	}
+
+	///
+	// memory budget
+	//
+	void set_budget(const vt_ulong bytes)
+	{
+		m_budget = bytes;
+	}
+	vt_ulong budget() const
+	{
+		return m_budget;
+	}
+
+	///
+	// record that images of type out are produced from images of type in
+	//
+	void set_input(const CVtAPI::IM_TYPE out, const CVtAPI::IM_TYPE in)
+	{
+		m_input[out] = in;
+	}
+
+	///
+	// register the producer of a derived image type, NULL to remove it
+	//
+	void set_producer(const CVtAPI::IM_TYPE im_type, CVtDatasetProducer *producer)
+	{
+		m_producer[im_type] = producer;
+	}
+
+	///
+	// register the consumer of an incoming image type, NULL to keep the images again
+	//
+	void set_consumer(const CVtAPI::IM_TYPE im_type, CVtDatasetConsumer *consumer)
+	{
+		m_consumer[im_type] = consumer;
+	}
+
+	///
+	// are there any images of this type
+	//
+	vt_bool present(const CVtAPI::IM_TYPE im_type)
+	{
+		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
+		{
+			if ((*it).first.type == im_type)
+				return true;
+		}
+		return false;
+	}
+
+	///
+	// materialise - make the images of a derived type if they aren't present,
+	// returns true if images of the type are present afterwards
+	//
+	vt_bool materialise(const CVtAPI::IM_TYPE im_type)
+	{
+		if (present( im_type ))
+			return true;
+
+		std::map<CVtAPI::IM_TYPE, CVtDatasetProducer*>::iterator pr = m_producer.find( im_type );
+		if (pr == m_producer.end() || (*pr).second == NULL || m_producing[im_type])
+			return false;
+
+		m_producing[im_type] = true;
+		m_depth++;
+		try
+		{
+			(*pr).second->produce( im_type );
+		}
+		catch(...)
+		{
+			m_producing[im_type] = false;
+			m_depth--;
+			throw;
+		}
+		m_producing[im_type] = false;
+		m_depth--;
+
+		return present( im_type );
+	}
+
+	///
+	// predict - the geometry of derived images which haven't been made yet, as their
+	// producer reports it. Returns false if the images are present or it can't be told.
+	//
+	vt_bool predict(const CVtAPI::IM_TYPE im_type, vt_ulong &width, vt_ulong &height, CVtImageBaseClass::LAYOUT &layout)
+	{
+		if (present( im_type ))
+			return false;
+
+		std::map<CVtAPI::IM_TYPE, CVtDatasetProducer*>::iterator pr = m_producer.find( im_type );
+		if (pr == m_producer.end() || (*pr).second == NULL || m_producing[im_type])
+			return false;
+
+		return (*pr).second->geometry( im_type, width, height, layout );
+	}
+
+	///
+	// invalidate - delete the derived images made from images of this type
+	//
+	void invalidate(const CVtAPI::IM_TYPE im_type)
+	{
+		for(std::map<CVtAPI::IM_TYPE, CVtAPI::IM_TYPE>::iterator in = m_input.begin(); in != m_input.end(); in++)
+		{
+			if ((*in).second != im_type || (*in).first == im_type)
+				continue;
+
+			std::map<CVtAPI::IM_TYPE, CVtDatasetProducer*>::iterator pr = m_producer.find( (*in).first );
+			if (pr == m_producer.end() || (*pr).second == NULL)
+				continue;
+
+			while (delete_image( (*in).first ))
+				;
+
+			invalidate( (*in).first );
+		}
+	}
+
+	///
+	// images of an evictable type may be deleted once their downstream product exists
+	//
+	void set_evictable(const CVtAPI::IM_TYPE im_type, const vt_bool evictable = true)
+	{
+		m_evictable[im_type] = evictable;
+	}
+
+	///
+	// images of a pinned type are only spilled once consumed downstream
+	//
+	void set_pinned(const CVtAPI::IM_TYPE im_type, const vt_bool pinned = true)
+	{
+		m_pinned[im_type] = pinned;
+	}
+
+	///
+	// memory usage
+	//
+	USAGE usage(const CVtAPI::IM_TYPE im_type) const
+	{
+		USAGE_MAP::const_iterator it = m_usage.find( im_type );
+		if (it != m_usage.end())
+			return (*it).second;
+
+		USAGE none = { 0, 0, 0 };
+		return none;
+	}
+	vt_ulong current_bytes() const
+	{
+		return m_current;
+	}
+	vt_ulong peak_bytes() const
+	{
+		return m_peak;
+	}
+
+	void report(std::ostream &os) const
+	{
+		os << "dataset memory: current " << m_current << " peak " << m_peak << " budget " << m_budget << std::endl;
+
+		for(USAGE_MAP::const_iterator it = m_usage.begin(); it != m_usage.end(); it++)
+		{
+			os << "  image type " << (*it).first 
+				 << ": current " << (*it).second.current 
+				 << " peak " << (*it).second.peak 
+				 << " spilled " << (*it).second.spilled << std::endl;
+		}
+	}
+
+	///
+	// fetch - returns the image of an entry, reloading it if it has been spilled
+	//
+	CVtImageBaseClass* fetch(iterator it)
+	{
+		CVtImageBaseClass* im = (*it).second;
+
+		if (im != NULL && im->spilled())
+		{
+			std::map<CVtImageBaseClass*, FILE*>::iterator sp = m_spill.find( im );
+			Vt_precondition( sp != m_spill.end(), "fetch::spill file missing" );
+
+			if (!im->reload( (*sp).second ))
+				Vt_fail( "fetch::failed to reload spilled image" );
+
+			fclose( (*sp).second );
+			m_spill.erase( sp );
+
+			account();
+		}
+		return im;
+	}
+
+	///
+	// trim - bring the resident images within the budget
+	//
+	void trim()
+	{
+		account();
+
+		if (m_budget == 0 || m_current <= m_budget)
+			return;
+
+		// evict consumed intermediates
+		for(vt_ulong idx = 0; idx < m_dataset.size() && m_current > m_budget; )
+		{
+			DATASET_ENTRY &entry = m_dataset[idx];
+
+			if (m_evictable[entry.first.type] && consumed( entry.first.type ))
+			{
+				discard( entry.second );
+				m_dataset.erase( m_dataset.begin() + idx );
+				account();
+			}
+			else
+			{
+				idx++;
+			}
+		}
+
+		// spill consumed images, then anything not pinned, oldest first
+		for(vt_ulong pass = 0; pass < 2 && m_current > m_budget; pass++)
+		{
+			for(vt_ulong idx = 0; idx < m_dataset.size() && m_current > m_budget; idx++)
+			{
+				DATASET_ENTRY &entry = m_dataset[idx];
+				CVtImageBaseClass* im = entry.second;
+
+				if (im == NULL || im->spilled())
+					continue;
+
+				if (pass == 0 ? consumed( entry.first.type ) : !m_pinned[entry.first.type])
+					spill( im );
+			}
+		}
+	}
+
+	virtual iterator begin()
+	{
+		return m_dataset.begin();
+	}
+	virtual iterator end()
+	{
+		return m_dataset.end();
+	}
+
+	virtual vt_bool delete_dataset()
+	{
+		// get rid of any data sets hanging around
+		for(;!m_dataset.empty(); m_dataset.pop_back())
+		{
+			DATASET_ENTRY entry = m_dataset.back();
+			discard( entry.second ); // delete the image
+		}
+		account();
+
+		return (_CrtCheckMemory() == TRUE);
+	}
+
+	virtual vt_bool delete_image(CVtAPI::IM_TYPE im_type)
+	{
+		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
+		{
+			if ( (*it).first.type == im_type)
+			{
+				CVtImageBaseClass* im = (*it).second;
+
+				discard( im );
+
+				m_dataset.erase( it );
+				account();
+
+				Vt_precondition( _CrtCheckMemory() == TRUE, "image_ptr::Memory problem detected\n" );
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	///
+	// image data accessors
+	//
+	// Spilled images are reloaded. The returned pointers stay valid until the next
+	// call to trim(), i.e. until the next processing stage completes.
+	//
+	virtual vt_ushort * image_ptr()
+	{
+		materialise( CVtAPI::OUTPUT_IM );
+
+		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
+		{
+			if ((*it).first.type != CVtAPI::OUTPUT_IM)
+				continue;
+
+			CVtImage<vt_acq_im_type>* im = dynamic_cast<CVtImage<vt_acq_im_type>*>(fetch( it ));
+			if (im != NULL)
+			{
+				Vt_precondition( _CrtCheckMemory() == TRUE, "image_ptr::Memory problem detected\n" );
+				return im->begin();
+			}
+		}
+		return NULL;
+	}
+	virtual vt_ushort * image_ptr(CVtAPI::IM_TYPE im_type)
+	{
+		materialise( im_type );
+
+		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
+		{
+			if ((*it).first.type != im_type)
+				continue;
+
+			CVtImage<vt_acq_im_type>* im = dynamic_cast<CVtImage<vt_acq_im_type>*>(fetch( it ));
+			if (im != NULL)
+			{
+				Vt_precondition( _CrtCheckMemory() == TRUE, "image_ptr::Memory problem detected\n" );
+				return im->begin();
+			}
+		}
+		return NULL;
+	}
+	virtual vt_ushort ** image_ptrs(CVtAPI::IM_TYPE im_type)
+	{
+		materialise( im_type );
+
+		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
+		{
+			if ((*it).first.type != im_type)
+				continue;
+
+			CVtImage<vt_acq_im_type>* im = dynamic_cast<CVtImage<vt_acq_im_type>*>(fetch( it ));
+			if (im != NULL)
+			{
+				Vt_precondition( _CrtCheckMemory() == TRUE, "image_ptr::Memory problem detected\n" );
+				return im->lines();
+			}
+		}
+
+		return NULL;
+	}
+
+
+	///
+	// get image height - returns image height
+	// currently all the images are the same height. Derived images which
+	// haven't been made yet are measured by their producer where it can.
+	//
+	virtual vt_ulong image_width(CVtAPI::IM_TYPE im_type)
+	{
+		vt_ulong width, height;
+		CVtImageBaseClass::LAYOUT layout;
+		if (predict( im_type, width, height, layout ))
+			return width;
+
+		materialise( im_type );
+
+		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
+		{
+			CVtImage<vt_acq_im_type>* im = dynamic_cast<CVtImage<vt_acq_im_type>*>((*it).second);
+			if (im != NULL && ((*it).first.type == im_type))
+			{
+				Vt_precondition( _CrtCheckMemory() == TRUE, "image_ptr::Memory problem detected\n" );
+				return im->width();
+			}
+		}
+		return 0;
+	}
+	virtual vt_ulong image_height(CVtAPI::IM_TYPE im_type) 
+	{
+		vt_ulong width, height;
+		CVtImageBaseClass::LAYOUT layout;
+		if (predict( im_type, width, height, layout ))
+			return height;
+
+		materialise( im_type );
+
+		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
+		{
+			CVtImage<vt_acq_im_type>* im = dynamic_cast<CVtImage<vt_acq_im_type>*>((*it).second);
+			if (im != NULL && ((*it).first.type == im_type))
+			{
+				Vt_precondition( _CrtCheckMemory() == TRUE, "image_ptr::Memory problem detected\n" );
+				return im->height();
+			}
+		}
+		return 0;
+	}
+
+	///
+	// get image layout - returns the storage order of the image, images
+	// which are not in the dataset are reported as row-major
+	//
+	virtual CVtImageBaseClass::LAYOUT image_layout(CVtAPI::IM_TYPE im_type) 
+	{
+		vt_ulong width, height;
+		CVtImageBaseClass::LAYOUT layout;
+		if (predict( im_type, width, height, layout ))
+			return layout;
+
+		materialise( im_type );
+
+		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
+		{
+			CVtImageBaseClass* im = (*it).second;
+			if (im != NULL && ((*it).first.type == im_type))
+			{
+				return im->layout();
+			}
+		}
+		return CVtImageBaseClass::ROW_MAJOR;
+	}
+
+	///
+	// pack - replace the images of type im_type with packed 12-bit copies, returns
+	// the number of images packed. Packed images are not visible to the image accessors
+	// above until they are unpacked.
+	//
+	vt_ulong pack(CVtAPI::IM_TYPE im_type, CVtImageAllocator & alloc = heap_allocator())
+	{
+		vt_ulong cnt = 0;
+		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
+		{
+			if ((*it).first.type != im_type)
+				continue;
+
+			CVtImage<vt_acq_im_type>* im = dynamic_cast<CVtImage<vt_acq_im_type>*>(fetch( it ));
+			if (im != NULL)
+			{
+				(*it).second = new CVtPacked12Image( *im, alloc );
+				delete im;
+				cnt++;
+			}
+		}
+		account();
+		return cnt;
+	}
+
+	///
+	// unpack - replace the packed images of type im_type with ordinary images, 
+	// returns the number of images unpacked
+	//
+	vt_ulong unpack(CVtAPI::IM_TYPE im_type, CVtImageAllocator & alloc = uninit_allocator())
+	{
+		vt_ulong cnt = 0;
+		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
+		{
+			if ((*it).first.type != im_type)
+				continue;
+
+			CVtPacked12Image* im = dynamic_cast<CVtPacked12Image*>(fetch( it ));
+			if (im != NULL)
+			{
+				(*it).second = im->unpack( alloc );
+				delete im;
+				cnt++;
+			}
+		}
+		account();
+		return cnt;
+	}
+
+	//
+	// operator[]
+	// 
+	vt_ulong size()
+	{
+		return m_dataset.size();
+	}
+
+	//
+	// operator[]
+	// 
+	CVtImageBaseClass* operator [](const vt_ulong idx)
+	{
+		return m_dataset[idx].second;
+	}
+	///
+	// dataset manipulation
+	//
+	// Datasets can be any 2d set of data. If we are in non-sync
+	// mode then Dataset 0 is usually the raw input data buffers.
+	//
+	void add_dataset( T ent_type, CVtImageBaseClass *pdata )
+	{
+		// a new input - anything derived from the old inputs is out of date
+		if (m_depth == 0)
+		{
+			invalidate( ent_type.type );
+
+			std::map<CVtAPI::IM_TYPE, CVtDatasetConsumer*>::iterator co = m_consumer.find( ent_type.type );
+			if (co != m_consumer.end() && (*co).second != NULL)
+			{
+				(*co).second->consume( ent_type.type, pdata );
+				return;
+			}
+		}
+
+		m_dataset.push_back( std::pair< T, CVtImageBaseClass* >(ent_type, pdata ) );
+		account();
+	}
+
+	///
+	// pop_back
+	//
+	DATASET_ENTRY pop_back( const CVtAPI::IM_TYPE im_type )
+	{
+		DATASET_ENTRY entry = m_dataset.back();
+
+		if ( im_type != entry.first.type )
+			Vt_fail( "VtSys::pop_back::Unexpected entry type" );
+
+		// the caller takes ownership - make sure the image is resident
+		fetch( m_dataset.end() - 1 );
+
+		// remove entry from vector
+		m_dataset.pop_back();
+		account();
+		return entry;
+	}
+
+	DATASET_ENTRY get_back( const CVtAPI::IM_TYPE im_type )
+	{
+		DATASET_ENTRY entry = m_dataset.back();
+
+		if ( im_type != entry.first.type )
+			Vt_fail( "VtSys::pop_back::Unexpected entry type" );
+
+		fetch( m_dataset.end() - 1 );
+		return entry;
+	}
+
+protected:
+	///
+	// account - recalculate the memory usage
+	//
+	void account()
+	{
+		for(USAGE_MAP::iterator ut = m_usage.begin(); ut != m_usage.end(); ut++)
+		{
+			(*ut).second.current = 0;
+			(*ut).second.spilled = 0;
+		}
+
+		m_current = 0;
+		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
+		{
+			CVtImageBaseClass* im = (*it).second;
+			if (im == NULL)
+				continue;
+
+			USAGE_MAP::iterator ut = m_usage.find( (*it).first.type );
+			if (ut == m_usage.end())
+			{
+				USAGE none = { 0, 0, 0 };
+				ut = m_usage.insert( USAGE_MAP::value_type( (*it).first.type, none ) ).first;
+			}
+
+			if (im->spilled())
+			{
+				(*ut).second.spilled += im->data_bytes();
+			}
+			else
+			{
+				(*ut).second.current += im->data_bytes();
+				m_current						 += im->data_bytes();
+			}
+		}
+
+		for(USAGE_MAP::iterator ut = m_usage.begin(); ut != m_usage.end(); ut++)
+		{
+			if ((*ut).second.current > (*ut).second.peak)
+				(*ut).second.peak = (*ut).second.current;
+		}
+		if (m_current > m_peak)
+			m_peak = m_current;
+	}
+
+	///
+	// consumed - is there an image produced from images of this type
+	//
+	vt_bool consumed(const CVtAPI::IM_TYPE im_type)
+	{
+		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
+		{
+			std::map<CVtAPI::IM_TYPE, CVtAPI::IM_TYPE>::iterator in = m_input.find( (*it).first.type );
+			if (in != m_input.end() && (*in).second == im_type)
+				return true;
+		}
+		return false;
+	}
+
+	///
+	// spill an image to a temporary file, the file is deleted when it is closed
+	//
+	vt_bool spill(CVtImageBaseClass* im)
+	{
+		vt_char dir[MAX_PATH];
+		vt_char name[MAX_PATH];
+
+		if (::GetTempPathA( MAX_PATH, dir ) == 0 || ::GetTempFileNameA( dir, "vts", 0, name ) == 0)
+			return false;
+
+		FILE *fp = fopen( name, "w+bD" );
+		if (fp == NULL)
+			return false;
+
+		if (!im->spill( fp ))
+		{
+			fclose( fp );
+			return false;
+		}
+
+		m_spill[im] = fp;
+		account();
+		return true;
+	}
+
+	///
+	// delete an image and any spill file
+	//
+	void discard(CVtImageBaseClass* im)
+	{
+		std::map<CVtImageBaseClass*, FILE*>::iterator sp = m_spill.find( im );
+		if (sp != m_spill.end())
+		{
+			fclose( (*sp).second );
+			m_spill.erase( sp );
+		}
+		delete im;
+	}
+};
+
+} // end Vt namespace
+#endif // __CVTHDSIMPAPI_H__
@@ -0,0 +1,206 @@
+/** \file VtDefectList.h
+
+	\brief Replacement of the defective pixels of a sensor from their good neighbours.
+
+	The hds calibration marks the pixels it can't calibrate in a mask, typically a few hundred
+	of the million or so pixels of the sensor. Testing the mask at every pixel of every image
+	would cost a pass over the whole frame to change almost nothing. Vt::CVtDefectList compiles
+	the mask once, when it is read or made, into a list of the defective pixels, each with the
+	positions and weights of the good pixels it is interpolated from. Correcting an image is then
+	a gather over the neighbours of the listed pixels only.
+
+ * Copyright (c) 2013 by
+ * All Rights Reserved
+ * REVISIONS:
+ * $Log: $
+ *
+ */
+
+#ifndef __CVTDEFECTLIST_H__
+#define __CVTDEFECTLIST_H__
+
+#include <vector>
+#include "VtSysdefs.h"
+#include "VtErrors.h"
+#include "VtImage.h"
+
+namespace Vt {
+
+/**
+	\brief The defective pixels of a mask and the good neighbours each is interpolated from.
+
+	A defective pixel takes the good pixels of the nearest square ring around it which has any,
+	out to MAX_RADIUS, weighted by the inverse square of their distance. An isolated defect is
+	the weighted mean of its eight neighbours, the diagonals at half weight, and a defect in a
+	cluster reaches past the cluster to good pixels. Only good pixels are read, so the order the
+	defects are corrected in makes no difference. A defect with no good pixel in range is left
+	as it is.
+*/
+class CVtDefectList
+{
+public:
+	enum {
+		MAX_RADIUS = 4		//!< the furthest ring searched for good neighbours
+	};
+
+private:
+	struct DEFECT
+	{
+		vt_ulong pixel;		//!< row*width + col of the defect
+		vt_ulong first;		//!< its first neighbour in m_source and m_weight
+		vt_ulong count;		//!< the number of neighbours
+	};
+
+	vt_ulong							m_width;
+	vt_ulong							m_height;
+
+	std::vector<DEFECT>		m_defects;
+	std::vector<vt_ulong> m_source;		//!< row*width + col of each neighbour
+	std::vector<vt_float> m_weight;		//!< the normalised weight of each neighbour
+
+	//
+	// the good pixels of ring radius around (row, col), returns the number added
+	//
+	template<typename MaskType>
+	vt_ulong add_ring(const CVtImage<MaskType> &mask, const vt_long row, const vt_long col, const vt_long radius)
+	{
+		vt_ulong count = 0;
+
+		for (vt_long dr = -radius; dr <= radius; dr++)
+		{
+			const vt_long r = row + dr;
+			if (r < 0 || r >= (vt_long) m_height)
+				continue;
+
+			const MaskType *good = mask[r];
+
+			// the whole of the top and bottom rows of the ring, the ends of the others
+			const vt_long step = (dr == -radius || dr == radius) ? 1 : 2*radius;
+
+			for (vt_long dc = -radius; dc <= radius; dc += step)
+			{
+				const vt_long c = col + dc;
+				if (c < 0 || c >= (vt_long) m_width || !good[c])
+					continue;
+
+				m_source.push_back( r*m_width + c );
+				m_weight.push_back( 1.0f/(vt_float) (dr*dr + dc*dc) );
+				count++;
+			}
+		}
+		return count;
+	}
+
+public:
+	CVtDefectList() : m_width( 0 )
+									, m_height( 0 )
+	{}
+
+	virtual ~CVtDefectList() {}
+
+	/**
+	\brief Forget the defects.
+	*/
+	void reset()
+	{
+		m_width	 = 0;
+		m_height = 0;
+
+		std::vector<DEFECT>().swap( m_defects );
+		std::vector<vt_ulong>().swap( m_source );
+		std::vector<vt_float>().swap( m_weight );
+	}
+
+	//! true if the list was made for images of this size
+	vt_bool valid(const vt_ulong width, const vt_ulong height) const
+	{
+		return m_width != 0 && m_width == width && m_height == height;
+	}
+
+	//! the number of defects corrected
+	vt_ulong size() const
+	{
+		return m_defects.size();
+	}
+
+	/**
+	\brief Make the list from a mask, zero for a defective pixel.
+
+	\param mask	a row-major mask, the size of the images to be corrected
+	*/
+	template<typename MaskType>
+	void build(const CVtImage<MaskType> &mask)
+	{
+		Vt_precondition( mask.layout() == CVtImageBaseClass::ROW_MAJOR, "CVtDefectList::build - mask must be row-major" );
+
+		reset();
+
+		m_width	 = mask.width();
+		m_height = mask.height();
+
+		for (vt_ulong row = 0; row < m_height; row++)
+		{
+			const MaskType *good = mask[row];
+
+			for (vt_ulong col = 0; col < m_width; col++)
+			{
+				if (good[col])
+					continue;
+
+				DEFECT defect;
+
+				defect.pixel = row*m_width + col;
+				defect.first = m_source.size();
+				defect.count = 0;
+
+				for (vt_long radius = 1; radius <= MAX_RADIUS && defect.count == 0; radius++)
+				{
+					defect.count = add_ring( mask, (vt_long) row, (vt_long) col, radius );
+				}
+
+				if (defect.count == 0)
+					continue;
+
+				vt_float total = 0.0f;
+				for (vt_ulong idx = defect.first; idx < m_source.size(); idx++)
+					total += m_weight[idx];
+
+				for (vt_ulong idx = defect.first; idx < m_source.size(); idx++)
+					m_weight[idx] /= total;
+
+				m_defects.push_back( defect );
+			}
+		}
+	}
+
+	/**
+	\brief Replace the defective pixels of a row-major image the size of the mask.
+	*/
+	template<typename ImageType>
+	void apply(CVtImage<ImageType> &im) const
+	{
+		Vt_precondition( im.layout() == CVtImageBaseClass::ROW_MAJOR && valid( im.width(), im.height() )
+									 , "CVtDefectList::apply - image is not the size of the mask" );
+
+		ImageType **lines = im.lines();
+
+		for (vt_ulong idx = 0; idx < m_defects.size(); idx++)
+		{
+			const DEFECT	 &defect = m_defects[idx];
+			const vt_ulong *source = &m_source[defect.first];
+			const vt_float *weight = &m_weight[defect.first];
+
+			vt_float val = 0.0f;
+			for (vt_ulong k = 0; k < defect.count; k++)
+			{
+				val += weight[k]*lines[source[k]/m_width][source[k]%m_width];
+			}
+
+			lines[defect.pixel/m_width][defect.pixel%m_width] = (ImageType) (val + 0.5f);
+		}
+	}
+};
+
+} // Vt namespace
+
+#endif // __CVTDEFECTLIST_H__
@@ -0,0 +1,225 @@
+/** \file VtFieldCalib.h
+
+	\brief Full field, per pixel, dark and gain correction for the pano and ceph images.
+
+	The pano/ceph calibration has a dark level and a coefficient for each row of the sensor,
+	which can't correct anything that varies along a row, such as the x-ray power over a scan.
+	Vt::CVtFieldCalib keeps a dark level and a gain for every pixel of the centred image
+	instead, made from the averaged dark and bright frames of a calibration run.
+
+	The planes are 16 bit, the dark level in pixel units and the gain in fixed point with
+	VT_GAIN_BITS fractional bits, so a 2880 x 2304 field is 26 MB. A pixel which gives no
+	usable gain, or a row the per row calibration leaves uncalibrated, takes the values of its
+	row so the two calibrations agree wherever the field has nothing to add.
+
+	The field is applied in 16 bit integers, see dark_gain_row(), which costs less than the
+	per row kernel. The two planes still add 4 bytes a pixel of memory traffic, so where the
+	calibration is memory bound it is slower than the per row path, and it stays opt-in.
+
+ * Copyright (c) 2013 by
+ * All Rights Reserved
+ * REVISIONS:
+ * $Log: $
+ *
+ */
+
+#ifndef __CVTFIELDCALIB_H__
+#define __CVTFIELDCALIB_H__
+
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+#include "VtSysdefs.h"
+#include "VtErrors.h"
+#include "VtImage.h"
+#include "VtKernels.h"
+
+namespace Vt {
+
+/**
+	\brief Per pixel dark levels and fixed point gains for a row-major frame geometry.
+*/
+template<typename ImageType>
+class CVtFieldCalib
+{
+public:
+	enum {
+		GAIN_ONE = 1 << VT_GAIN_BITS	//!< the fixed point gain of 1
+		, MAX_GAIN = 4								//!< gains from here up are left uncalibrated, as the per row MAX_COEF
+	};
+
+private:
+	vt_ulong								m_width;
+	vt_ulong								m_height;
+
+	std::vector<vt_ushort>	m_dark;
+	std::vector<vt_ushort>	m_gain;
+
+	//
+	// a level or gain to the nearest 16 bit value
+	//
+	static vt_ushort to_dark(const vt_double dark)
+	{
+		if (dark <= 0.0)
+			return 0;
+		if (dark >= (vt_double) USHRT_MAX)
+			return USHRT_MAX;
+		return (vt_ushort) (dark + 0.5);
+	}
+
+	static vt_ushort to_gain(const vt_double gain)
+	{
+		if (!(gain > 0.0) || gain >= MAX_GAIN)
+			return 0;
+
+		const vt_double fixed = gain*GAIN_ONE + 0.5;
+
+		return (fixed >= (vt_double) USHRT_MAX) ? (vt_ushort) USHRT_MAX : (vt_ushort) fixed;
+	}
+
+public:
+	CVtFieldCalib() : m_width( 0 )
+									, m_height( 0 )
+	{}
+
+	virtual ~CVtFieldCalib() {}
+
+	/**
+	\brief Forget the field and release the planes.
+	*/
+	void reset()
+	{
+		m_width	 = 0;
+		m_height = 0;
+
+		std::vector<vt_ushort>().swap( m_dark );
+		std::vector<vt_ushort>().swap( m_gain );
+	}
+
+	//! true if there is a field for frames of this size
+	vt_bool valid(const vt_ulong width, const vt_ulong height) const
+	{
+		return m_width != 0 && m_width == width && m_height == height;
+	}
+
+	vt_ulong width() const	{ return m_width; }
+	vt_ulong height() const { return m_height; }
+
+	/**
+	\brief Make the planes from averaged dark and bright frames.
+
+	The gain of each pixel brings its signal to the mean signal of the per row calibration,
+	mean_signal/(bright - dark), so the two calibrations give the same image level.
+
+	\param dark					the averaged dark frame, row-major
+	\param bright				the averaged bright frame, the same size as dark
+	\param mean_signal	the mean signal level the gains correct to
+	\param start_row		rows above this take the per row values
+	\param row_dark			the per row dark levels, a value per row of the frames
+	\param row_coef			the per row coefficients
+	*/
+	template<typename CoefType>
+	void build(const CVtImage<ImageType> &dark, const CVtImage<ImageType> &bright
+						, const vt_double mean_signal, const vt_ulong start_row
+						, const CoefType *row_dark, const CoefType *row_coef)
+	{
+		Vt_precondition( dark.layout() == CVtImageBaseClass::ROW_MAJOR && bright.layout() == CVtImageBaseClass::ROW_MAJOR
+									 && dark.width() == bright.width() && dark.height() == bright.height()
+									 , "CVtFieldCalib::build - dark and bright frames must be row-major and the same size" );
+
+		const vt_double eps = 0.000001;
+
+		m_width	 = dark.width();
+		m_height = dark.height();
+
+		m_dark.resize( m_width*m_height );
+		m_gain.resize( m_width*m_height );
+
+		for (vt_ulong row = 0; row < m_height; row++)
+		{
+			const ImageType *pdark	 = dark[row];
+			const ImageType *pbright = bright[row];
+			vt_ushort				*odark	 = &m_dark[row*m_width];
+			vt_ushort				*ogain	 = &m_gain[row*m_width];
+
+			const vt_ushort rdark = to_dark( row_dark[row] );
+			const vt_ushort rgain = to_gain( row_coef[row] );
+
+			for (vt_ulong col = 0; col < m_width; col++)
+			{
+				const vt_double diff = (vt_double) pbright[col] - (vt_double) pdark[col];
+				const vt_double gain = (diff > eps) ? mean_signal/diff : 0.0;
+
+				if (row > start_row && gain > 0.0 && gain < MAX_GAIN && rgain != 0)
+				{
+					odark[col] = to_dark( pdark[col] );
+					ogain[col] = to_gain( gain );
+				}
+				else
+				{
+					odark[col] = rdark;
+					ogain[col] = rgain;
+				}
+			}
+		}
+	}
+
+	/**
+	\brief Calibrate one row of a frame, dst = (src - dark)*gain + bias.
+	*/
+	void apply_row(ImageType *dst, const ImageType *src, const vt_ulong row, const vt_ulong width, const vt_float bias) const
+	{
+		dark_gain_row( dst, src, &m_dark[row*m_width], &m_gain[row*m_width], width, bias );
+	}
+
+	/**
+	\brief Write the field, the width and height then the dark and gain planes.
+	*/
+	void save(FILE *fpout) const
+	{
+		Vt_precondition( fpout != NULL, "CVtFieldCalib::save - invalid output file" );
+
+		const vt_uint32 size[2] = { (vt_uint32) m_width, (vt_uint32) m_height };
+
+		fwrite( (const char *) size, sizeof( size[0] ), 2, fpout );
+		if (m_width*m_height > 0)
+		{
+			fwrite( (const char *) &m_dark[0], sizeof( m_dark[0] ), m_width*m_height, fpout );
+			fwrite( (const char *) &m_gain[0], sizeof( m_gain[0] ), m_width*m_height, fpout );
+		}
+	}
+
+	/**
+	\brief Read a field written by save(), it is only kept if it is for frames of the given height.
+
+	\return true if the field was read
+	*/
+	vt_bool read(std::istream &IS, const vt_ulong height)
+	{
+		vt_uint32 size[2] = { 0, 0 };
+
+		IS.read( (char *) size, sizeof( size ) );
+		if (!IS.good() || size[1] != height || size[0] == 0)
+			return false;
+
+		m_width	 = size[0];
+		m_height = size[1];
+
+		m_dark.resize( m_width*m_height );
+		m_gain.resize( m_width*m_height );
+
+		IS.read( (char *) &m_dark[0], m_dark.size()*sizeof( m_dark[0] ) );
+		IS.read( (char *) &m_gain[0], m_gain.size()*sizeof( m_gain[0] ) );
+
+		if (!IS.good())
+		{
+			reset();
+			return false;
+		}
+		return true;
+	}
+};
+
+} // Vt namespace
+
+#endif // __CVTFIELDCALIB_H__
@@ -1,600 +1,885 @@
-/** \file VtImage.h
-
- The image abstraction file.
-
-  \par REQUIREMENTS: 
-  Define the 2d image iterators / containers for each image use.
-
-  \par SPECIFICATIONS: 
-  Contiains, mutates and access internally stored 2d coordinates which
-  can be used for a veriety of image processing operations
-
-  \par DESIGN NOTES: 
-  A baic class which provides a great number of functions to 
-  access and mutate its internal data items
-
- 
- Copyright (c) 2013 by
- All Rights Reserved
-
- REVISIONS: 
- $Log: VtImage.h,v $
- Revision 1.2  2013/05/27 12:04:18  david
- Ver 1
-
- */
-
-#ifndef __CVtImage_H__
-#define __CVtImage_H__
-
-
-
-//*********************************************************************
-// INCLUDES
-//*********************************************************************
-#include <cmath>
-#include <memory>
-#include <float.h>
-#include "VtSysdefs.h"
-
-
-namespace Vt {
-  
-
-class VTAPI_API Diff2D
-{
-public:
-  
-  /**
-   * The iterator's value type
-   */
-  typedef Diff2D value_type;
-
-  /**
-   * The iterator's PixelType
-   */
-  typedef Diff2D PixelType;
-  
-  /** 
-   * Default Constructor. Init iterator at position (0,0)
-   */
-  Diff2D() : x(0), y(0) {}
-  
-  /** 
-   * Construct at a given position
-   */
-  explicit Diff2D(vt_int ax, vt_int ay) : x(ax), y(ay) {}
-  
-  /** 
-   * Copy Constructor
-   */
-  Diff2D(Diff2D const & v) : x(v.x), y(v.y) {}
-  
-  /** 
-   * overloaded assignment operator
-   */
-  const Diff2D& operator=(Diff2D const & v);
-  
-  /** 
-   * Unary negation.
-   */
-  Diff2D operator-() const { return Diff2D(-x, -y); }
-  
-  /** 
-   * Increase coordinate by specified offset.
-   */
-  const Diff2D & operator+=(Diff2D const & offset);
-  
-  /** 
-   * Decrease coordinate by specified vector.
-   */
-  const Diff2D & operator-=(Diff2D const & offset);
-  
-  /**
-   * Create vector by adding specified offset.
-   */
-  Diff2D operator+(Diff2D const & offset) const { return Diff2D(x + offset.x, y + offset.y); }
-  
-  /** 
-   * Create vector by subtracting specified offset.
-   */
-  Diff2D operator-(Diff2D const & offset) const { return Diff2D(x - offset.x, y - offset.y); }
-  
-  /** 
-   * Calculate length of difference vector.
-   */
-  double magnitude() const { return sqrt((double)(x*x + y*y)); }
-  
-  /** 
-   * Equality operator
-   */
-  vt_bool operator==(Diff2D const & r) const { return (x == r.x) && (y == r.y); }
-  
-  /** 
-   * Inequality operator
-   */
-  vt_bool operator!=(Diff2D const & r) const { return (x != r.x) || (y != r.y); }
-  
-  /** 
-   * Read current coordinate
-   */
-  Diff2D operator*() const { return *this; }
-  
-  /** 
-   * Read coordinate at an offset
-   */
-  Diff2D operator()(vt_int const & dx, vt_int const & dy) const { return Diff2D(x + dx, y + dy); }
-  
-  /** 
-   * Read coordinate at an offset
-   */
-  Diff2D operator[](Diff2D const & offset) const { return Diff2D(x + offset.x, y + offset.y); }
-
-  /** 
-   * Returns the X ordinate safely
-   */
-  vt_int GetX() const { return x; }
-
-  /** 
-   * Returns the Y ordinate safely
-   */
-  vt_int GetY() const { return y; }
-
-
-private:
-
-  // Internal x and y parameters
-  vt_int x;
-  vt_int y;
-};
-
-
-
-/**
- *  $Author: david $
- *  $Revision: 1.2 $
- *  $Date: 2013/05/27 12:04:18 $
- *
- *  \par REQUIREMENTS: 
- *  Abstract base class for all image related classes
- *
- *  \par SPECIFICATIONS: 
- *  Provides functional access to image properties
- *  Such as image: width, height, size, and origin and size of region of interest
- *
- *  \par DESIGN NOTES: 
- *  Provided to support generic image passing via RTTI
- *
- *  @see <A HREF="../concepts.htm#datasets"> Concepts - Datasets </A>
- *  @see <BR> <A HREF="../concepts.htm#datasetid"> Concepts - DatasetID, KeyImageID and ImageID</A>
- *
- */
-class VTAPI_API CVtImageBaseClass
-{
-protected:
-  
-  // The origin of the region of interest
-  Diff2D m_roiorigin;
-  
-  // The size of the region of interest
-  Diff2D m_roisize;
-  
-  // The width (columns or x) of the image
-  vt_uint m_width;
-  
-  // The height (rows or y) of the image
-  vt_uint m_height;
-  
-  // Protected constructor to ensure class is not instantiated
-  explicit CVtImageBaseClass(vt_uint width, vt_uint height) :
-     m_roiorigin(0, 0),
-     m_roisize(0, 0),
-     m_width(width),
-     m_height(height) {}
-     
-public:
-  
-  /**
-   * Destructor remains public as its virtual
-   */
-  virtual ~CVtImageBaseClass() {}
-  
-  /**
-   * Returns the width of the image
-   *
-   * @see <BR> <A HREF="../concepts.htm#imagewidth"> Concepts - Image Width </A>
-   */
-  vt_uint width() const { return m_width; }
-  
-  /**
-   * Returns the height of the image
-   *
-   * @see <BR> <A HREF="../concepts.htm#imageheight"> Concepts - Image Height </A>
-   */
-  vt_uint height() const { return m_height; }
-  
-  /**
-   * Returns the size of the image
-   */
-  Diff2D size() const { return Diff2D(m_width, m_height); }  
-  
-  /**
-   * Returns the origin of the region of interest
-   */
-  const Diff2D& GetROIOrigin() const { return m_roiorigin; }
-  
-  /**
-   * Returns the size of the region of interest
-   */
-  const Diff2D& GetROISize() const { return m_roisize; }
-  
-  /**
-   * Sets the region of interest
-   */
-  void SetROI(const Diff2D& ROIOrigin, const Diff2D& ROISize);
-  
-};
-
-
-
-/**
- *  $Author: david $
- *  $Revision: 1.2 $
- *  $Date: 2013/05/27 12:04:18 $
- *
- *  \par REQUIREMENTS: 
- *  Templated image class providing access and mutators for underlying data
- *
- *  \par SPECIFICATIONS: 
- *  Provide the following functions to access / manipulate the data
- *  1. Construct (and assign) an image in a variety of different ways
- *  2. Provide const and non-const access to underlying data
- *
- *  \par DESIGN NOTES: 
- *  Templated class
- *
- */
-template <class PIXELTYPE> 
-class VTAPI_API CVtImage : public CVtImageBaseClass
-{
-public:
-    
-  /** 
-   * The Image's pixel type
-   */
-  typedef PIXELTYPE PixelType;
-  
-  /** 
-   * The Image's value type
-   */
-  typedef PIXELTYPE value_type;
-  
-  /** 
-   * The Image's 1D random access iterator
-   */
-  typedef PIXELTYPE * ScanOrderIterator;
-  
-  /** 
-   * The Image's 1D random access const iterator
-   */
-  typedef PIXELTYPE const * ConstScanOrderIterator;
-  
-  /**
-   * Pixel Type Allocator
-   */
-  struct Allocator
-  {
-    // Allocate
-    static PixelType * allocate(vt_uint n) { 
-      return (PixelType *)::operator new(n*sizeof(PixelType)); }
-    
-    // Deallocate
-    static void deallocate(PixelType * p) {
-      ::operator delete(p); }
-  };
-    
-  /**
-   * Default constructor (image size 0x0)
-   */
-  CVtImage()
-    : CVtImageBaseClass(0, 0),
-    m_data(0) {}
-  
-  /** 
-   * Construct image of size width x height - allocates data
-   */
-  CVtImage(vt_uint width, vt_uint height)
-    : CVtImageBaseClass(width, height),
-    m_data(0)
-  {
-    resize(width, height, PixelType());
-  }
-  
-  /**
-   * Constructs an image of width x height, copies specified data - allocates data
-   */
-  CVtImage(vt_uint width, vt_uint height, PixelType *data)
-    : CVtImageBaseClass(width, height),
-    m_data(0)
-  {
-    resizeCopy(width, height, data);
-  }
-  
-  /** 
-   * Construct image of size Diff2D width x height - allocates data
-   */
-  CVtImage(Diff2D size)
-    : CVtImageBaseClass(size.x, size.y),
-    m_data(0)
-  {
-    resize(size.x, size.y, PixelType());
-  }
-  
-  /** 
-   * construct image of size width*height and initialize every
-   * pixel with given data (use this constructor, if 
-   * PixelType doesn't have a default constructor)
-   */
-  CVtImage(vt_uint width, vt_uint height, PixelType d)
-    : CVtImageBaseClass(width, height),
-    m_data(0)
-  {
-    resize(width, height, d);
-  }
-  
-  /**
-   * Copy constructor
-   */
-  CVtImage(const CVtImage & rhs)
-    : CVtImageBaseClass(0, 0),
-    m_data(0)
-  {
-    resizeCopy(rhs);
-  }
-  
-  /**
-   * Destructor
-   */
-  virtual ~CVtImage() 
-  { 
-    deallocate(); 
-  }
-  
-  /**
-   * Assignment operator
-   */
-  const CVtImage & operator=(const CVtImage & rhs)
-  {
-    if(this != &rhs)
-    {
-      if((width() != rhs.width()) || 
-        (height() != rhs.height()))
-      {
-        resizeCopy(rhs);
-      }
-      else
-      {
-        ConstScanOrderIterator is = rhs.begin();
-        ConstScanOrderIterator iend = rhs.end();
-        ScanOrderIterator id = begin();
-        
-        for(; is != iend; ++is, ++id) *id = *is;
-      }
-    }
-    return *this;
-  }
-  
-  /** 
-   * Set Image with const value 
-   */
-  const CVtImage & operator=(PixelType pixel)
-  {
-    ScanOrderIterator i = begin();
-    ScanOrderIterator iend = end();
-    
-    for(; i != iend; ++i) *i = pixel;
-    
-    return *this;
-  }
-  
-  /** 
-   * Reset image to specified size (dimensions must not be negative)
-   * (old data is destroyed) 
-   */
-  void resize(vt_uint width, vt_uint height)
-  {
-    resize(width, height, PixelType());
-  }
-  
-  /** 
-   * Reset image to specified size (dimensions must not be negative)
-   * (old data is destroyed) 
-   */
-  void resize(Diff2D size)
-  {
-    resize(size.x, size.y, PixelType());
-  }
-  
-  /** 
-   * Reset image to specified size and initialize it with
-   * given data (use this if PixelType doesn't have a default
-   * constructor, dimensions must not be negative, old data are destroyed) 
-   */
-  void resize(vt_uint width, vt_uint height, PixelType d)
-  {
-    PixelType * newdata = 0;
-    PixelType ** newlines = 0;
-    if(width*height > 0)
-    {
-      newdata = Allocator::allocate(width*height);
-      
-      std::uninitialized_fill_n(newdata, width*height, d);
-      
-      newlines = initLineStartArray(newdata, width, height);
-    }
-    
-    deallocate();
-    m_data = newdata;
-    m_lines = newlines;
-    m_width = width;
-    m_height = height;
-  }
-  
-  /**
-   * Resize image to size of other image and copy it's data 
-   */
-  void resizeCopy(const vt_uint width, const vt_uint height, PixelType *newdata)
-  {
-    PixelType ** newlines = 0;
-    if(width*height > 0)
-    {
-      newlines = initLineStartArray(newdata, width, height);
-    }
-    
-    deallocate();
-    
-    m_data   = newdata;
-    m_lines  = newlines;
-    m_width  = width;
-    m_height = height; 
-  }
-  
-  /** 
-   * Resize image to size of other image and copy it's data 
-   */
-  void resizeCopy(const CVtImage & rhs)
-  {
-    PixelType * newdata = 0;  
-    PixelType ** newlines = 0;
-    if(rhs.width()*rhs.height() > 0)
-    {
-      newdata = Allocator::allocate(rhs.width()*rhs.height());
-      
-      std::uninitialized_copy(rhs.begin(), rhs.end(), newdata);
-      
-      newlines = initLineStartArray(newdata, rhs.width(), rhs.height());
-    }
-    
-    deallocate();
-    m_data = newdata;
-    m_lines = newlines;
-    m_width = rhs.width();
-    m_height = rhs.height(); 
-  }
-  
-  /**
-   * Returns a const data pointer to the start of the image
-   */
-  PixelType **lines() const { return m_lines; }
-  
-  /**
-   * Returns a non-const data pointer to the start of the image
-   */
-  PixelType **lines() { return m_lines; }
-  
-  /** 
-   * Test whether a given coordinate is inside the image
-   */
-  inline vt_bool isInside(Diff2D const & d) const
-  {
-    return d.x >= 0 && d.y >= 0 && d.x < width() && d.y < height();
-  }
-  
-  /** 
-   * non-const access pixel at given location. 
-   * usage:  PixelType value = image[Diff2D(1,2)] 
-   */
-  inline PixelType & operator[](Diff2D const & d) { return m_lines[d.y][d.x]; }
-  
-  /** 
-   * const access pixel at given location. 
-   * usage: PixelType value = image[Diff2D(1,2)] 
-   */
-  inline PixelType const & operator[](Diff2D const & d) const { return m_lines[d.y][d.x]; }
-  
-  /** 
-   * non-const access pixel at given location. 
-   * usage: PixelType value = image(1,2) 
-   */
-  inline PixelType & operator()(vt_uint const & dx, vt_uint const & dy) { return m_lines[dy][dx]; }
-  
-  /** 
-   * const access pixel at given location. 
-   * usage:  PixelType value = image(1,2) 
-   */
-  inline PixelType const & operator()(vt_uint const & dx, vt_uint const & dy) const { return m_lines[dy][dx]; }
-  
-  /** 
-   * non-const access pixel at given location. 
-   * Note that the 'x' index is the trailing index. 
-   * usage:  PixelType value = image[2][1] 
-   */
-  inline PixelType * operator[](vt_uint const & dy) { return m_lines[dy]; }
-  
-  /** 
-   * const access pixel at given location. 
-   * Note that the 'x' index is the trailing index. 
-   * usage:  PixelType value = image[2][1] 
-   */
-  inline PixelType const * operator[](vt_uint const & dy) const { return m_lines[dy]; }
-
-  /** 
-   * init 1D random access iterator pointing to first pixel
-   */
-  ScanOrderIterator begin() { return m_data; }
-  
-  /** 
-   * init 1D random access iterator pointing past the end
-   */
-  ScanOrderIterator end() { return m_data + width() * height(); }
-  
-  /** 
-   * init 1D random access const iterator pointing to first pixel
-   */
-  ConstScanOrderIterator begin() const { return m_data; }
-  
-  /** 
-   * init 1D random access const iterator pointing past the end
-   */
-  ConstScanOrderIterator end() const { return m_data + width() * height(); }
-  
-
-private:
-  
-  // Deallocate helper method
-  void deallocate()
-  {
-    if(m_data) 
-    {
-      ScanOrderIterator i = begin();
-      ScanOrderIterator iend = end();
-      
-      for(; i != iend; ++i) 
-      {
-        (*i).~PIXELTYPE();
-      }
-      
-      Allocator::deallocate(m_data);
-      delete[] m_lines;
-    }
-  }
-  
-  // initLineStartArray
-  static PixelType ** initLineStartArray(PixelType * data, vt_uint width, vt_uint height)
-  {
-    PixelType ** lines = new PIXELTYPE*[height];
-    for(vt_uint y=0; y<height; ++y) 
-    {
-      lines[y] = data + y*width;
-    }
-    return lines;
-  }
-  
-  // Data pointers
-  PIXELTYPE * m_data;
-  PIXELTYPE ** m_lines;
-};
-
-} // end iX Namespace
-
-#endif // __CVtImage_H__
+/** \file VtImage.h
+
+ The image abstraction file.
+
+  \par REQUIREMENTS: 
+  Define the 2d image iterators / containers for each image use.
+
+  \par SPECIFICATIONS: 
+  Contiains, mutates and access internally stored 2d coordinates which
+  can be used for a veriety of image processing operations
+
+  \par DESIGN NOTES: 
+  A baic class which provides a great number of functions to 
+  access and mutate its internal data items
+
+ 
+ Copyright (c) 2013 by
+ All Rights Reserved
+
+ REVISIONS: 
+ $Log: VtImage.h,v $
+ Revision 1.2  2013/05/27 12:04:18  david
+ Ver 1
+
+ */
+
+#ifndef __CVtImage_H__
+#define __CVtImage_H__
+
+
+
+//*********************************************************************
+// INCLUDES
+//*********************************************************************
+#include <cmath>
+#include <memory>
+#include <algorithm>
+#include <stdio.h>
+#include <float.h>
+#include "VtSysdefs.h"
+#include "VtImageAlloc.h"
+
+
+namespace Vt {
+  
+
+class VTAPI_API Diff2D
+{
+public:
+  
+  /**
+   * The iterator's value type
+   */
+  typedef Diff2D value_type;
+
+  /**
+   * The iterator's PixelType
+   */
+  typedef Diff2D PixelType;
+  
+  /** 
+   * Default Constructor. Init iterator at position (0,0)
+   */
+  Diff2D() : x(0), y(0) {}
+  
+  /** 
+   * Construct at a given position
+   */
+  explicit Diff2D(vt_int ax, vt_int ay) : x(ax), y(ay) {}
+  
+  /** 
+   * Copy Constructor
+   */
+  Diff2D(Diff2D const & v) : x(v.x), y(v.y) {}
+  
+  /** 
+   * overloaded assignment operator
+   */
+  const Diff2D& operator=(Diff2D const & v);
+  
+  /** 
+   * Unary negation.
+   */
+  Diff2D operator-() const { return Diff2D(-x, -y); }
+  
+  /** 
+   * Increase coordinate by specified offset.
+   */
+  const Diff2D & operator+=(Diff2D const & offset);
+  
+  /** 
+   * Decrease coordinate by specified vector.
+   */
+  const Diff2D & operator-=(Diff2D const & offset);
+  
+  /**
+   * Create vector by adding specified offset.
+   */
+  Diff2D operator+(Diff2D const & offset) const { return Diff2D(x + offset.x, y + offset.y); }
+  
+  /** 
+   * Create vector by subtracting specified offset.
+   */
+  Diff2D operator-(Diff2D const & offset) const { return Diff2D(x - offset.x, y - offset.y); }
+  
+  /** 
+   * Calculate length of difference vector.
+   */
+  double magnitude() const { return sqrt((double)(x*x + y*y)); }
+  
+  /** 
+   * Equality operator
+   */
+  vt_bool operator==(Diff2D const & r) const { return (x == r.x) && (y == r.y); }
+  
+  /** 
+   * Inequality operator
+   */
+  vt_bool operator!=(Diff2D const & r) const { return (x != r.x) || (y != r.y); }
+  
+  /** 
+   * Read current coordinate
+   */
+  Diff2D operator*() const { return *this; }
+  
+  /** 
+   * Read coordinate at an offset
+   */
+  Diff2D operator()(vt_int const & dx, vt_int const & dy) const { return Diff2D(x + dx, y + dy); }
+  
+  /** 
+   * Read coordinate at an offset
+   */
+  Diff2D operator[](Diff2D const & offset) const { return Diff2D(x + offset.x, y + offset.y); }
+
+  /** 
+   * Returns the X ordinate safely
+   */
+  vt_int GetX() const { return x; }
+
+  /** 
+   * Returns the Y ordinate safely
+   */
+  vt_int GetY() const { return y; }
+
+
+private:
+
+  // Internal x and y parameters
+  vt_int x;
+  vt_int y;
+};
+
+
+
+/**
+ *  $Author: david $
+ *  $Revision: 1.2 $
+ *  $Date: 2013/05/27 12:04:18 $
+ *
+ *  \par REQUIREMENTS: 
+ *  Abstract base class for all image related classes
+ *
+ *  \par SPECIFICATIONS: 
+ *  Provides functional access to image properties
+ *  Such as image: width, height, size, and origin and size of region of interest
+ *
+ *  \par DESIGN NOTES: 
+ *  Provided to support generic image passing via RTTI
+ *
+ *  @see <A HREF="../concepts.htm#datasets"> Concepts - Datasets </A>
+ *  @see <BR> <A HREF="../concepts.htm#datasetid"> Concepts - DatasetID, KeyImageID and ImageID</A>
+ *
+ */
+class VTAPI_API CVtImageBaseClass
+{
+public:
+  
+  /**
+   * Pixel storage order. Row-major images store each row contiguously and
+   * their storage lines are rows. Column-major images store each column
+   * contiguously and their storage lines are columns - this matches the pano
+   * and ceph data, which arrives one detector line (image column) at a time.
+   */
+  typedef enum {
+    ROW_MAJOR,
+    COL_MAJOR
+  } LAYOUT;
+  
+protected:
+  
+  // The origin of the region of interest
+  Diff2D m_roiorigin;
+  
+  // The size of the region of interest
+  Diff2D m_roisize;
+  
+  // The width (columns or x) of the image
+  vt_uint m_width;
+  
+  // The height (rows or y) of the image
+  vt_uint m_height;
+  
+  // The storage order of the pixel data
+  LAYOUT m_layout;
+  
+  // Set while the pixel data is held in a spill file rather than in memory
+  vt_bool m_spilled;
+  
+  // Protected constructor to ensure class is not instantiated
+  explicit CVtImageBaseClass(vt_uint width, vt_uint height, LAYOUT layout = ROW_MAJOR) :
+     m_roiorigin(0, 0),
+     m_roisize(0, 0),
+     m_width(width),
+     m_height(height),
+     m_layout(layout),
+     m_spilled(false) {}
+     
+public:
+  
+  /**
+   * Destructor remains public as its virtual
+   */
+  virtual ~CVtImageBaseClass() {}
+  
+  /**
+   * Returns the width of the image
+   *
+   * @see <BR> <A HREF="../concepts.htm#imagewidth"> Concepts - Image Width </A>
+   */
+  vt_uint width() const { return m_width; }
+  
+  /**
+   * Returns the height of the image
+   *
+   * @see <BR> <A HREF="../concepts.htm#imageheight"> Concepts - Image Height </A>
+   */
+  vt_uint height() const { return m_height; }
+  
+  /**
+   * Returns the size of the image
+   */
+  Diff2D size() const { return Diff2D(m_width, m_height); }  
+  
+  /**
+   * Returns the storage order of the image
+   */
+  LAYOUT layout() const { return m_layout; }
+  
+  /**
+   * Returns the number of storage lines (rows if row-major, columns if column-major)
+   */
+  vt_uint num_lines() const { return (m_layout == ROW_MAJOR) ? m_height : m_width; }
+  
+  /**
+   * Returns the length of a storage line
+   */
+  vt_uint line_length() const { return (m_layout == ROW_MAJOR) ? m_width : m_height; }
+  
+  /**
+   * Returns the size of the pixel data in bytes, whether or not it is resident
+   */
+  virtual vt_ulong data_bytes() const { return 0; }
+  
+  /**
+   * Returns true while the pixel data is spilled to a file
+   */
+  vt_bool spilled() const { return m_spilled; }
+  
+  /**
+   * Write the pixel data to fp and release the storage, the geometry is kept.
+   * Returns false if the image can't be spilled, in which case it is unchanged.
+   */
+  virtual vt_bool spill(FILE * /*fp*/) { return false; }
+  
+  /**
+   * Reallocate the storage and read back pixel data written by spill()
+   */
+  virtual vt_bool reload(FILE * /*fp*/) { return !m_spilled; }
+  
+  /**
+   * Returns the origin of the region of interest
+   */
+  const Diff2D& GetROIOrigin() const { return m_roiorigin; }
+  
+  /**
+   * Returns the size of the region of interest
+   */
+  const Diff2D& GetROISize() const { return m_roisize; }
+  
+  /**
+   * Sets the region of interest
+   */
+  void SetROI(const Diff2D& ROIOrigin, const Diff2D& ROISize);
+  
+};
+
+
+
+/**
+ *  $Author: david $
+ *  $Revision: 1.2 $
+ *  $Date: 2013/05/27 12:04:18 $
+ *
+ *  \par REQUIREMENTS: 
+ *  Templated image class providing access and mutators for underlying data
+ *
+ *  \par SPECIFICATIONS: 
+ *  Provide the following functions to access / manipulate the data
+ *  1. Construct (and assign) an image in a variety of different ways
+ *  2. Provide const and non-const access to underlying data
+ *
+ *  \par DESIGN NOTES: 
+ *  Templated class
+ *
+ */
+template <class PIXELTYPE> 
+class VTAPI_API CVtImage : public CVtImageBaseClass
+{
+public:
+    
+  /** 
+   * The Image's pixel type
+   */
+  typedef PIXELTYPE PixelType;
+  
+  /** 
+   * The Image's value type
+   */
+  typedef PIXELTYPE value_type;
+  
+  /** 
+   * The Image's 1D random access iterator
+   */
+  typedef PIXELTYPE * ScanOrderIterator;
+  
+  /** 
+   * The Image's 1D random access const iterator
+   */
+  typedef PIXELTYPE const * ConstScanOrderIterator;
+  
+  /**
+   * Default constructor (image size 0x0)
+   */
+  CVtImage()
+    : CVtImageBaseClass(0, 0),
+    m_data(0),
+    m_alloc(&heap_allocator()) {}
+  
+  /** 
+   * Construct image of size width x height - allocates data
+   */
+  CVtImage(vt_uint width, vt_uint height)
+    : CVtImageBaseClass(width, height),
+    m_data(0),
+    m_alloc(&heap_allocator())
+  {
+    resize(width, height, PixelType());
+  }
+  
+  /** 
+   * Construct image of size width x height using the given allocation policy.
+   * The pixels are value initialised only if the policy asks for it.
+   */
+  CVtImage(vt_uint width, vt_uint height, CVtImageAllocator & alloc)
+    : CVtImageBaseClass(width, height),
+    m_data(0),
+    m_alloc(&alloc)
+  {
+    resize(width, height);
+  }
+  
+  /** 
+   * Construct image of size width x height with the given storage order
+   * using the given allocation policy.
+   */
+  CVtImage(vt_uint width, vt_uint height, LAYOUT layout, CVtImageAllocator & alloc = heap_allocator())
+    : CVtImageBaseClass(width, height, layout),
+    m_data(0),
+    m_alloc(&alloc)
+  {
+    resize(width, height);
+  }
+  
+  /**
+   * Constructs an image of width x height, copies specified data - allocates data
+   */
+  CVtImage(vt_uint width, vt_uint height, PixelType *data)
+    : CVtImageBaseClass(width, height),
+    m_data(0),
+    m_alloc(&heap_allocator())
+  {
+    resizeCopy(width, height, data);
+  }
+  
+  /** 
+   * Construct image of size Diff2D width x height - allocates data
+   */
+  CVtImage(Diff2D size)
+    : CVtImageBaseClass(size.x, size.y),
+    m_data(0),
+    m_alloc(&heap_allocator())
+  {
+    resize(size.x, size.y, PixelType());
+  }
+  
+  /** 
+   * construct image of size width*height and initialize every
+   * pixel with given data (use this constructor, if 
+   * PixelType doesn't have a default constructor)
+   */
+  CVtImage(vt_uint width, vt_uint height, PixelType d)
+    : CVtImageBaseClass(width, height),
+    m_data(0),
+    m_alloc(&heap_allocator())
+  {
+    resize(width, height, d);
+  }
+  
+  /** 
+   * construct image of size width*height using the given allocation
+   * policy and initialize every pixel with given data
+   */
+  CVtImage(vt_uint width, vt_uint height, PixelType d, CVtImageAllocator & alloc)
+    : CVtImageBaseClass(width, height),
+    m_data(0),
+    m_alloc(&alloc)
+  {
+    resize(width, height, d);
+  }
+  
+  /**
+   * Copy constructor - the copy always uses the default heap policy
+   */
+  CVtImage(const CVtImage & rhs)
+    : CVtImageBaseClass(0, 0),
+    m_data(0),
+    m_alloc(&heap_allocator())
+  {
+    resizeCopy(rhs);
+  }
+  
+  /**
+   * Destructor
+   */
+  virtual ~CVtImage() 
+  { 
+    deallocate(); 
+  }
+  
+  /**
+   * Assignment operator
+   */
+  const CVtImage & operator=(const CVtImage & rhs)
+  {
+    if(this != &rhs)
+    {
+      if((width() != rhs.width()) || 
+        (height() != rhs.height()) ||
+        (layout() != rhs.layout()))
+      {
+        resizeCopy(rhs);
+      }
+      else
+      {
+        ConstScanOrderIterator is = rhs.begin();
+        ConstScanOrderIterator iend = rhs.end();
+        ScanOrderIterator id = begin();
+        
+        for(; is != iend; ++is, ++id) *id = *is;
+      }
+    }
+    return *this;
+  }
+  
+  /** 
+   * Set Image with const value 
+   */
+  const CVtImage & operator=(PixelType pixel)
+  {
+    ScanOrderIterator i = begin();
+    ScanOrderIterator iend = end();
+    
+    for(; i != iend; ++i) *i = pixel;
+    
+    return *this;
+  }
+  
+  /** 
+   * Reset image to specified size (dimensions must not be negative)
+   * (old data is destroyed). The new pixels are value initialised unless
+   * the image's allocation policy says they will be overwritten anyway.
+   */
+  void resize(vt_uint width, vt_uint height)
+  {
+    if (m_alloc->initialise() || !CVtPixelTraits<PIXELTYPE>::TRIVIAL)
+    {
+      resize(width, height, PixelType());
+      return;
+    }
+
+    PixelType * newdata = 0;
+    PixelType ** newlines = 0;
+    if(width*height > 0)
+    {
+      newdata = allocate(width, height);
+      newlines = initLineStartArray(newdata, width, height, m_layout);
+    }
+    
+    deallocate();
+    m_data = newdata;
+    m_lines = newlines;
+    m_spilled = false;
+    m_width = width;
+    m_height = height;
+  }
+  
+  /** 
+   * Reset image to specified size (dimensions must not be negative)
+   * (old data is destroyed) 
+   */
+  void resize(Diff2D size)
+  {
+    resize(size.x, size.y, PixelType());
+  }
+  
+  /** 
+   * Reset image to specified size and initialize it with
+   * given data (use this if PixelType doesn't have a default
+   * constructor, dimensions must not be negative, old data are destroyed) 
+   */
+  void resize(vt_uint width, vt_uint height, PixelType d)
+  {
+    PixelType * newdata = 0;
+    PixelType ** newlines = 0;
+    if(width*height > 0)
+    {
+      newdata = allocate(width, height);
+      
+      std::uninitialized_fill_n(newdata, width*height, d);
+      
+      newlines = initLineStartArray(newdata, width, height, m_layout);
+    }
+    
+    deallocate();
+    m_data = newdata;
+    m_lines = newlines;
+    m_spilled = false;
+    m_width = width;
+    m_height = height;
+  }
+  
+  /**
+   * Resize image to size of other image and copy it's data 
+   * Note: the image takes ownership of newdata, which must have been allocated
+   * by the image's allocator() and be stored in the image's current layout.
+   */
+  void resizeCopy(const vt_uint width, const vt_uint height, PixelType *newdata)
+  {
+    PixelType ** newlines = 0;
+    if(width*height > 0)
+    {
+      newlines = initLineStartArray(newdata, width, height, m_layout);
+    }
+    
+    deallocate();
+    
+    m_data   = newdata;
+    m_lines  = newlines;
+    m_spilled  = false;
+    m_width  = width;
+    m_height = height; 
+  }
+  
+  /** 
+   * Resize image to size of other image and copy it's data 
+   */
+  void resizeCopy(const CVtImage & rhs)
+  {
+    PixelType * newdata = 0;  
+    PixelType ** newlines = 0;
+    if(rhs.width()*rhs.height() > 0)
+    {
+      newdata = allocate(rhs.width(), rhs.height());
+      
+      std::uninitialized_copy(rhs.begin(), rhs.end(), newdata);
+      
+      newlines = initLineStartArray(newdata, rhs.width(), rhs.height(), rhs.layout());
+    }
+    
+    deallocate();
+    m_data = newdata;
+    m_lines = newlines;
+    m_spilled = false;
+    m_width = rhs.width();
+    m_height = rhs.height(); 
+    m_layout = rhs.layout();
+  }
+  
+  /**
+   * Change the storage order of the image, the pixel data is reordered
+   * with a cache blocked transpose. Nothing is done if the layout is unchanged.
+   */
+  void relayout(LAYOUT layout)
+  {
+    if (layout == m_layout)
+      return;
+    
+    CVtImage tmp(width(), height(), layout, *m_alloc);
+    copy_region(*this, Diff2D(0, 0), tmp, Diff2D(0, 0), size());
+    
+    // take over the reordered storage
+    PixelType * data = tmp.m_data;
+    PixelType ** lines = tmp.m_lines;
+    tmp.m_data = 0;
+    tmp.m_lines = 0;
+    
+    deallocate();
+    m_data = data;
+    m_lines = lines;
+    m_layout = layout;
+  }
+  
+  /**
+   * Returns a const data pointer to the start of the image
+   * Note: these are the storage lines - rows for a row-major image,
+   * columns for a column-major image.
+   */
+  PixelType **lines() const { return m_lines; }
+  
+  /**
+   * Returns a non-const data pointer to the start of the image
+   */
+  PixelType **lines() { return m_lines; }
+  
+  /** 
+   * Test whether a given coordinate is inside the image
+   */
+  inline vt_bool isInside(Diff2D const & d) const
+  {
+    return d.x >= 0 && d.y >= 0 && d.x < width() && d.y < height();
+  }
+  
+  /** 
+   * non-const access pixel at given location. 
+   * usage:  PixelType value = image[Diff2D(1,2)] 
+   */
+  inline PixelType & operator[](Diff2D const & d) { return (*this)(d.GetX(), d.GetY()); }
+  
+  /** 
+   * const access pixel at given location. 
+   * usage: PixelType value = image[Diff2D(1,2)] 
+   */
+  inline PixelType const & operator[](Diff2D const & d) const { return (*this)(d.GetX(), d.GetY()); }
+  
+  /** 
+   * non-const access pixel at given location. 
+   * usage: PixelType value = image(1,2) 
+   */
+  inline PixelType & operator()(vt_uint const & dx, vt_uint const & dy) 
+  { 
+    return (m_layout == ROW_MAJOR) ? m_lines[dy][dx] : m_lines[dx][dy]; 
+  }
+  
+  /** 
+   * const access pixel at given location. 
+   * usage:  PixelType value = image(1,2) 
+   */
+  inline PixelType const & operator()(vt_uint const & dx, vt_uint const & dy) const 
+  { 
+    return (m_layout == ROW_MAJOR) ? m_lines[dy][dx] : m_lines[dx][dy]; 
+  }
+  
+  /** 
+   * non-const access pixel at given location. 
+   * Note that the 'x' index is the trailing index. 
+   * usage:  PixelType value = image[2][1] 
+   * For a column-major image this returns column dy and the 'y' index trails.
+   */
+  inline PixelType * operator[](vt_uint const & dy) { return m_lines[dy]; }
+  
+  /** 
+   * const access pixel at given location. 
+   * Note that the 'x' index is the trailing index. 
+   * usage:  PixelType value = image[2][1] 
+   * For a column-major image this returns column dy and the 'y' index trails.
+   */
+  inline PixelType const * operator[](vt_uint const & dy) const { return m_lines[dy]; }
+
+  /** 
+   * init 1D random access iterator pointing to first pixel
+   * Note: scan order is storage order, see layout()
+   */
+  ScanOrderIterator begin() { return m_data; }
+  
+  /** 
+   * init 1D random access iterator pointing past the end
+   */
+  ScanOrderIterator end() { return m_data + width() * height(); }
+  
+  /** 
+   * init 1D random access const iterator pointing to first pixel
+   */
+  ConstScanOrderIterator begin() const { return m_data; }
+  
+  /** 
+   * init 1D random access const iterator pointing past the end
+   */
+  ConstScanOrderIterator end() const { return m_data + width() * height(); }
+  
+  /** 
+   * The allocation policy providing this image's storage
+   */
+  CVtImageAllocator & allocator() const { return *m_alloc; }
+  
+  /**
+   * Returns the size of the pixel data in bytes
+   */
+  virtual vt_ulong data_bytes() const { return width()*height()*sizeof(PixelType); }
+  
+  /**
+   * Write the pixel data to fp and release the storage. Only plain pixel
+   * types can be spilled.
+   */
+  virtual vt_bool spill(FILE * fp)
+  {
+    if (m_spilled || m_data == 0 || !CVtPixelTraits<PIXELTYPE>::TRIVIAL)
+      return false;
+    
+    const vt_ulong num = width()*height();
+    if (fwrite(m_data, sizeof(PixelType), num, fp) != num || fflush(fp) != 0)
+      return false;
+    
+    deallocate();
+    m_data = 0;
+    m_lines = 0;
+    m_spilled = true;
+    
+    return true;
+  }
+  
+  /**
+   * Reallocate the storage and read back the pixel data written by spill()
+   */
+  virtual vt_bool reload(FILE * fp)
+  {
+    if (!m_spilled)
+      return true;
+    
+    const vt_ulong num = width()*height();
+    PixelType * newdata = allocate(width(), height());
+    
+    rewind(fp);
+    if (fread(newdata, sizeof(PixelType), num, fp) != num)
+    {
+      m_alloc->deallocate(newdata, width(), height(), sizeof(PixelType));
+      return false;
+    }
+    
+    m_data = newdata;
+    m_lines = initLineStartArray(newdata, width(), height(), m_layout);
+    m_spilled = false;
+    
+    return true;
+  }
+  
+
+private:
+  
+  // Allocate helper method - storage only, no construction
+  PixelType * allocate(vt_uint width, vt_uint height)
+  {
+    return (PixelType *)m_alloc->allocate(width, height, sizeof(PixelType));
+  }
+  
+  // Deallocate helper method
+  void deallocate()
+  {
+    if(m_data) 
+    {
+      CVtPixelDestroy<CVtPixelTraits<PIXELTYPE>::TRIVIAL>::destroy(begin(), end());
+      
+      m_alloc->deallocate(m_data, width(), height(), sizeof(PixelType));
+      delete[] m_lines;
+    }
+  }
+  
+  // initLineStartArray - one pointer per storage line
+  static PixelType ** initLineStartArray(PixelType * data, vt_uint width, vt_uint height, LAYOUT layout)
+  {
+    vt_uint num = (layout == ROW_MAJOR) ? height : width;
+    vt_uint len = (layout == ROW_MAJOR) ? width : height;
+    
+    PixelType ** lines = new PIXELTYPE*[num];
+    for(vt_uint y=0; y<num; ++y) 
+    {
+      lines[y] = data + y*len;
+    }
+    return lines;
+  }
+  
+  // Data pointers
+  PIXELTYPE * m_data;
+  PIXELTYPE ** m_lines;
+  
+  // Storage allocation policy (not owned)
+  CVtImageAllocator * m_alloc;
+};
+
+
+//*********************************************************************
+// LAYOUT CONVERSION
+//*********************************************************************
+enum {
+  TRANSPOSE_BLOCK = 64 //!< tile edge for cache blocked layout conversion
+};
+
+/**
+ * Copy a size.x by size.y region of src starting at src_origin into dst
+ * at dst_origin. Either image may be row or column-major, when the layouts
+ * differ the copy is done in TRANSPOSE_BLOCK square tiles so that both the
+ * reads and the writes stay in cache.
+ */
+template <class T1, class T2>
+void copy_region(const CVtImage<T1> & src, const Diff2D src_origin,
+                 CVtImage<T2> & dst, const Diff2D dst_origin, const Diff2D size)
+{
+  const vt_int sx = src_origin.GetX();
+  const vt_int sy = src_origin.GetY();
+  const vt_int dx = dst_origin.GetX();
+  const vt_int dy = dst_origin.GetY();
+  const vt_int w  = size.GetX();
+  const vt_int h  = size.GetY();
+  
+  if (src.layout() == dst.layout())
+  {
+    // lines line up - straight copies along each storage line
+    if (src.layout() == CVtImageBaseClass::ROW_MAJOR)
+    {
+      for (vt_int row = 0; row < h; row++)
+        std::copy(src[sy + row] + sx, src[sy + row] + sx + w, dst[dy + row] + dx);
+    }
+    else
+    {
+      for (vt_int col = 0; col < w; col++)
+        std::copy(src[sx + col] + sy, src[sx + col] + sy + h, dst[dx + col] + dy);
+    }
+    return;
+  }
+  
+  for (vt_int row0 = 0; row0 < h; row0 += TRANSPOSE_BLOCK)
+  {
+    const vt_int row1 = (row0 + TRANSPOSE_BLOCK < h) ? row0 + TRANSPOSE_BLOCK : h;
+    
+    for (vt_int col0 = 0; col0 < w; col0 += TRANSPOSE_BLOCK)
+    {
+      const vt_int col1 = (col0 + TRANSPOSE_BLOCK < w) ? col0 + TRANSPOSE_BLOCK : w;
+      
+      if (dst.layout() == CVtImageBaseClass::ROW_MAJOR)
+      {
+        // column-major in, row-major out
+        for (vt_int row = row0; row < row1; row++)
+        {
+          T2 * out = dst[dy + row] + dx;
+          for (vt_int col = col0; col < col1; col++)
+            out[col] = (T2)src[sx + col][sy + row];
+        }
+      }
+      else
+      {
+        // row-major in, column-major out
+        for (vt_int col = col0; col < col1; col++)
+        {
+          T2 * out = dst[dx + col] + dy;
+          for (vt_int row = row0; row < row1; row++)
+            out[row] = (T2)src[sy + row][sx + col];
+        }
+      }
+    }
+  }
+}
+
+} // end iX Namespace
+
+#endif // __CVtImage_H__
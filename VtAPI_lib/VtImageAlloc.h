@@ -0,0 +1,371 @@
+/** \file VtImageAlloc.h
+
+	\brief Storage allocation policies for the Vt::CVtImage class.
+
+	By default an image takes its pixel storage from the heap and value initialises every
+	pixel. That is the right thing for images which are only partly written, but it is wasted
+	effort for acquired frames which the parser or a file read overwrites immediately. The
+	policies in this file let the creator of an image choose how its storage is obtained:
+
+	- CVtHeapAllocator			plain heap storage, optionally left uninitialised
+	- CVtPoolAllocator			recycled slabs keyed by image geometry
+	- CVtLargePageAllocator	large page (huge page) backed storage
+
+	Pixel types which are plain scalars (see CVtPixelTraits) never pay for per element
+	construction or destruction, whatever policy is used.
+
+ * Copyright (c) 2013 by
+ * All Rights Reserved
+ * REVISIONS:
+ * $Log: $
+ *
+ */
+
+#ifndef __CVTIMAGEALLOC_H__
+#define __CVTIMAGEALLOC_H__
+
+#include <windows.h>
+#include <map>
+#include <vector>
+#include "VtSysdefs.h"
+#include "VtErrors.h"
+
+namespace Vt {
+
+//*********************************************************************
+// PIXEL TRAITS
+//*********************************************************************
+/**
+	\brief Compile time description of a pixel type.
+
+	TRIVIAL is non-zero for pixel types that need no construction or destruction, these
+	are the plain scalar types and fixed size arrays of them (e.g. the HDS polynomial
+	coefficient types). Anything else is treated as a class type.
+*/
+template<class T>
+struct CVtPixelTraits
+{
+	enum { TRIVIAL = 0 };
+};
+
+#define VT_TRIVIAL_PIXEL(T) \
+	template<> struct CVtPixelTraits<T> { enum { TRIVIAL = 1 }; };
+
+VT_TRIVIAL_PIXEL(vt_char)
+VT_TRIVIAL_PIXEL(vt_byte)
+VT_TRIVIAL_PIXEL(vt_short)
+VT_TRIVIAL_PIXEL(vt_ushort)
+VT_TRIVIAL_PIXEL(vt_int)
+VT_TRIVIAL_PIXEL(vt_uint)
+VT_TRIVIAL_PIXEL(vt_long)
+VT_TRIVIAL_PIXEL(vt_ulong)
+VT_TRIVIAL_PIXEL(vt_uint64)
+VT_TRIVIAL_PIXEL(vt_float)
+VT_TRIVIAL_PIXEL(vt_double)
+VT_TRIVIAL_PIXEL(vt_longdouble)
+
+#undef VT_TRIVIAL_PIXEL
+
+template<class T, size_t N>
+struct CVtPixelTraits<T[N]>
+{
+	enum { TRIVIAL = CVtPixelTraits<T>::TRIVIAL };
+};
+
+/**
+	\brief Runs pixel destructors - a no-op for trivial pixel types.
+*/
+template<int TRIVIAL>
+struct CVtPixelDestroy
+{
+	template<class T>
+	static void destroy(T *first, T *last)
+	{
+		for (; first != last; ++first)
+			first->~T();
+	}
+};
+
+template<>
+struct CVtPixelDestroy<1>
+{
+	template<class T>
+	static void destroy(T *, T *) {}
+};
+
+//*********************************************************************
+// ALLOCATOR INTERFACE
+//*********************************************************************
+/**
+	\brief Abstract allocation policy for image pixel storage.
+
+	The allocator is handed the image geometry as well as the element size so that
+	policies which recycle or back storage by geometry can do so. Allocators are not
+	owned by the images using them, they must outlive every image they allocated for.
+*/
+class CVtImageAllocator
+{
+public:
+	virtual ~CVtImageAllocator() {}
+
+	/**
+	\brief allocate storage for width*height elements of elem_size bytes
+	*/
+	virtual void *allocate(vt_uint width, vt_uint height, vt_uint elem_size) = 0;
+
+	/**
+	\brief return storage previously obtained from allocate() with the same geometry
+	*/
+	virtual void deallocate(void *p, vt_uint width, vt_uint height, vt_uint elem_size) = 0;
+
+	/**
+	\brief should newly allocated pixels be value initialised
+
+	Returns false for policies intended for images which are completely overwritten
+	before they are read.
+	*/
+	virtual vt_bool initialise() const { return true; }
+};
+
+//*********************************************************************
+// HEAP
+//*********************************************************************
+/**
+	\brief Plain heap storage - the original CVtImage behaviour.
+
+	Constructed with init == false the storage is left uninitialised, use this
+	for frames which are about to be filled by a parser or a file read.
+*/
+class CVtHeapAllocator : public CVtImageAllocator
+{
+	vt_bool m_init;
+
+public:
+	explicit CVtHeapAllocator(const vt_bool init = true) : m_init( init ) {}
+
+	virtual void *allocate(vt_uint width, vt_uint height, vt_uint elem_size)
+	{
+		return ::operator new( width*height*elem_size );
+	}
+
+	virtual void deallocate(void *p, vt_uint, vt_uint, vt_uint)
+	{
+		::operator delete( p );
+	}
+
+	virtual vt_bool initialise() const { return m_init; }
+};
+
+//*********************************************************************
+// POOL
+//*********************************************************************
+/**
+	\brief Recycles released image buffers keyed by geometry.
+
+	Every capture produces frames of the same few sizes. Rather than returning a
+	frame's storage to the heap when the dataset is deleted the pool keeps it, and
+	hands it back out to the next image of identical geometry. At most m_max_free
+	buffers are held for each geometry, trim() releases everything held.
+
+	Recycled buffers hold stale data so by default the pool does not initialise.
+*/
+class CVtPoolAllocator : public CVtImageAllocator
+{
+	typedef std::pair< std::pair<vt_uint, vt_uint>, vt_uint > GEOMETRY;
+	typedef std::map< GEOMETRY, std::vector<void *> >					SLABS;
+
+	SLABS							m_free;
+	vt_uint						m_max_free;
+	vt_bool						m_init;
+	CRITICAL_SECTION	m_lock;
+
+	static GEOMETRY geometry(vt_uint width, vt_uint height, vt_uint elem_size)
+	{
+		return GEOMETRY( std::pair<vt_uint, vt_uint>( width, height ), elem_size );
+	}
+
+public:
+	explicit CVtPoolAllocator(const vt_uint max_free = 4, const vt_bool init = false)
+		: m_max_free( max_free )
+		, m_init( init )
+	{
+		::InitializeCriticalSection( &m_lock );
+	}
+
+	virtual ~CVtPoolAllocator()
+	{
+		trim();
+		::DeleteCriticalSection( &m_lock );
+	}
+
+	virtual void *allocate(vt_uint width, vt_uint height, vt_uint elem_size)
+	{
+		void *p = NULL;
+
+		::EnterCriticalSection( &m_lock );
+		SLABS::iterator it = m_free.find( geometry( width, height, elem_size ) );
+		if (it != m_free.end() && !(*it).second.empty())
+		{
+			p = (*it).second.back();
+			(*it).second.pop_back();
+		}
+		::LeaveCriticalSection( &m_lock );
+
+		if (p == NULL)
+			p = ::operator new( width*height*elem_size );
+
+		return p;
+	}
+
+	virtual void deallocate(void *p, vt_uint width, vt_uint height, vt_uint elem_size)
+	{
+		::EnterCriticalSection( &m_lock );
+		std::vector<void *> &slabs = m_free[ geometry( width, height, elem_size ) ];
+		if (slabs.size() < m_max_free)
+		{
+			slabs.push_back( p );
+			p = NULL;
+		}
+		::LeaveCriticalSection( &m_lock );
+
+		if (p != NULL)
+			::operator delete( p );
+	}
+
+	virtual vt_bool initialise() const { return m_init; }
+
+	/**
+	\brief release every buffer currently held by the pool
+	*/
+	void trim()
+	{
+		::EnterCriticalSection( &m_lock );
+		for (SLABS::iterator it = m_free.begin(); it != m_free.end(); it++)
+		{
+			for (vt_uint idx = 0; idx < (*it).second.size(); idx++)
+				::operator delete( (*it).second[idx] );
+		}
+		m_free.clear();
+		::LeaveCriticalSection( &m_lock );
+	}
+};
+
+//*********************************************************************
+// LARGE PAGES
+//*********************************************************************
+/**
+	\brief Large page backed storage.
+
+	Large pages cut TLB misses when streaming through 50MB+ frames. They need the
+	"Lock pages in memory" privilege, if that can't be enabled, or no large pages are
+	available, the allocation silently falls back to ordinary committed pages. Either
+	way the memory comes from VirtualAlloc so it is already zero filled.
+*/
+class CVtLargePageAllocator : public CVtImageAllocator
+{
+	SIZE_T	m_page;
+	vt_bool m_init;
+
+	static SIZE_T enable_large_pages()
+	{
+		HANDLE token = NULL;
+		if (::OpenProcessToken( ::GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token ))
+		{
+			TOKEN_PRIVILEGES tp;
+			tp.PrivilegeCount						= 1;
+			tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+			if (::LookupPrivilegeValue( NULL, SE_LOCK_MEMORY_NAME, &tp.Privileges[0].Luid ))
+				::AdjustTokenPrivileges( token, FALSE, &tp, 0, NULL, NULL );
+
+			vt_bool granted = (::GetLastError() == ERROR_SUCCESS);
+			::CloseHandle( token );
+
+			if (granted)
+				return ::GetLargePageMinimum();
+		}
+		return 0;
+	}
+
+public:
+	explicit CVtLargePageAllocator(const vt_bool init = false)
+		: m_page( enable_large_pages() )
+		, m_init( init )
+	{}
+
+	virtual void *allocate(vt_uint width, vt_uint height, vt_uint elem_size)
+	{
+		SIZE_T bytes = width*height*elem_size;
+		void *p = NULL;
+
+		if (m_page != 0)
+		{
+			SIZE_T rounded = ((bytes + m_page - 1)/m_page)*m_page;
+			p = ::VirtualAlloc( NULL, rounded, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE );
+		}
+		if (p == NULL)
+			p = ::VirtualAlloc( NULL, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
+
+		if (p == NULL)
+			Vt_fail( "CVtLargePageAllocator::allocate - VirtualAlloc failed" );
+
+		return p;
+	}
+
+	virtual void deallocate(void *p, vt_uint, vt_uint, vt_uint)
+	{
+		::VirtualFree( p, 0, MEM_RELEASE );
+	}
+
+	virtual vt_bool initialise() const { return m_init; }
+
+	/**
+	\brief true if large pages are actually in use
+	*/
+	vt_bool large_pages() const { return m_page != 0; }
+};
+
+//*********************************************************************
+// SHARED POLICY INSTANCES
+//*********************************************************************
+// The shared policies are created on first use and never destroyed. The images held by the
+// CVtSys singleton are released by CloseAPI(), which a client may call from its own static
+// destructors, after function statics have gone - the policies must still be there.
+/**
+	\brief the default policy - heap storage, value initialised
+*/
+inline CVtImageAllocator &heap_allocator()
+{
+	static CVtHeapAllocator *alloc = new CVtHeapAllocator( true );
+	return *alloc;
+}
+
+/**
+	\brief heap storage left uninitialised, for images that are fully overwritten
+*/
+inline CVtImageAllocator &uninit_allocator()
+{
+	static CVtHeapAllocator *alloc = new CVtHeapAllocator( false );
+	return *alloc;
+}
+
+/**
+	\brief process wide frame pool, for acquired frames and their temporaries
+*/
+inline CVtPoolAllocator &pool_allocator()
+{
+	static CVtPoolAllocator *alloc = new CVtPoolAllocator;
+	return *alloc;
+}
+
+/**
+	\brief process wide large page policy
+*/
+inline CVtLargePageAllocator &large_page_allocator()
+{
+	static CVtLargePageAllocator *alloc = new CVtLargePageAllocator;
+	return *alloc;
+}
+
+} // Vt namespace
+#endif // __CVTIMAGEALLOC_H__
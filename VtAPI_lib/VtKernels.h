@@ -0,0 +1,1518 @@
+/** \file VtKernels.h
+
+	\brief Pixel kernels shared by the calibration classes.
+
+	The calibration stages reduce to a few simple operations applied to every pixel of a
+	frame. These are kept here, each as a plain C++ version and, where VT_SSE2 is defined,
+	an SSE2 version which processes eight pixels at a time. Both versions give identical
+	results so the choice never shows up in the output images.
+
+	The reductions behind the image statistics have an AVX2 version as well. Which set is
+	used is decided once at run time from the processor, see Vt::kernels(), so one build
+	runs everywhere and takes the wider registers where they exist.
+
+ * Copyright (c) 2013 by
+ * All Rights Reserved
+ * REVISIONS:
+ * $Log: $
+ *
+ */
+
+#ifndef __CVTKERNELS_H__
+#define __CVTKERNELS_H__
+
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+#include "VtSysdefs.h"
+#include "VtErrors.h"
+
+#ifdef VT_SSE2
+#include <intrin.h>
+#include <emmintrin.h>
+#endif
+
+#ifdef VT_AVX2
+#include <immintrin.h>
+#endif
+
+namespace Vt {
+
+//*********************************************************************
+// GAIN AND BIAS
+//*********************************************************************
+/**
+	\brief Apply a gain and bias to a line of pixels, dst = src*gain + bias.
+
+	The result is truncated towards zero and clamped to [0, USHRT_MAX], which is what the
+	original double precision calibration loops did. Calibrations of the form
+	(src - dark)*coef + offset are folded into gain = coef and bias = offset - dark*coef
+	once, when the coefficients are loaded, so each row costs one multiply and one add.
+
+	The sums are done in single precision. For 12 and 16 bit data this agrees with the
+	double precision version to within one LSB.
+
+	\param dst  the output line, may be the same as src
+	\param src  the input line
+	\param num  number of pixels in the line
+	\param gain the gain applied to every pixel
+	\param bias the bias added after the gain
+*/
+inline void gain_bias_row(vt_ushort *dst, const vt_ushort *src, const vt_ulong num
+												, const vt_float gain, const vt_float bias)
+{
+	vt_ulong idx = 0;
+
+#ifdef VT_SSE2
+	const __m128  g      = _mm_set1_ps( gain );
+	const __m128  b      = _mm_set1_ps( bias );
+	const __m128  lo     = _mm_setzero_ps();
+	const __m128  hi     = _mm_set1_ps( (vt_float) USHRT_MAX );
+	const __m128i zero   = _mm_setzero_si128();
+	const __m128i half   = _mm_set1_epi32( 0x8000 );
+	const __m128i flip   = _mm_set1_epi16( (vt_short) 0x8000 );
+
+	for (; idx + 8 <= num; idx += 8)
+	{
+		__m128i pix = _mm_loadu_si128( (const __m128i *) (src + idx) );
+
+		__m128 f0 = _mm_cvtepi32_ps( _mm_unpacklo_epi16( pix, zero ) );
+		__m128 f1 = _mm_cvtepi32_ps( _mm_unpackhi_epi16( pix, zero ) );
+
+		f0 = _mm_add_ps( _mm_mul_ps( f0, g ), b );
+		f1 = _mm_add_ps( _mm_mul_ps( f1, g ), b );
+
+		// clamp before converting so the integer conversion can't overflow
+		f0 = _mm_min_ps( _mm_max_ps( f0, lo ), hi );
+		f1 = _mm_min_ps( _mm_max_ps( f1, lo ), hi );
+
+		// SSE2 only has a signed saturating pack - shift to the signed range and back
+		__m128i i0 = _mm_sub_epi32( _mm_cvttps_epi32( f0 ), half );
+		__m128i i1 = _mm_sub_epi32( _mm_cvttps_epi32( f1 ), half );
+
+		_mm_storeu_si128( (__m128i *) (dst + idx), _mm_xor_si128( _mm_packs_epi32( i0, i1 ), flip ) );
+	}
+#endif
+
+	for (; idx < num; idx++)
+	{
+		const vt_float out = (vt_float) src[idx]*gain + bias;
+
+		if (out <= 0.0f)
+			dst[idx] = 0;
+		else if (out >= (vt_float) USHRT_MAX)
+			dst[idx] = USHRT_MAX;
+		else
+			dst[idx] = (vt_ushort) out;
+	}
+}
+
+/**
+	\brief Generic version of gain_bias_row() for other pixel types.
+*/
+template<typename T>
+void gain_bias_row(T *dst, const T *src, const vt_ulong num, const vt_float gain, const vt_float bias)
+{
+	for (vt_ulong idx = 0; idx < num; idx++)
+	{
+		const vt_float out = (vt_float) src[idx]*gain + bias;
+
+		if (out <= 0.0f)
+			dst[idx] = (T) 0;
+		else if (out >= (vt_float) USHRT_MAX)
+			dst[idx] = (T) USHRT_MAX;
+		else
+			dst[idx] = (T) out;
+	}
+}
+
+/**
+	\brief The fixed point per pixel gains of dark_gain_row().
+*/
+enum {
+	VT_GAIN_BITS = 14	//!< fractional bits of the fixed point gains, gains are in [0, 4)
+};
+
+//
+// the bias of dark_gain_row() rounded to the nearest integer, as a positive and a negative part
+//
+inline void dark_gain_bias(const vt_float bias, vt_ushort &bias_pos, vt_ushort &bias_neg)
+{
+	const vt_float rbias = floorf( bias + 0.5f );
+
+	bias_pos = (rbias <= 0.0f) ? 0 : (rbias >= (vt_float) USHRT_MAX) ? (vt_ushort) USHRT_MAX : (vt_ushort) rbias;
+	bias_neg = (rbias >= 0.0f) ? 0 : (-rbias >= (vt_float) USHRT_MAX) ? (vt_ushort) USHRT_MAX : (vt_ushort) -rbias;
+}
+
+//
+// one pixel of dark_gain_row()
+//
+inline vt_ushort dark_gain_pixel(const vt_long src, const vt_long dark, const vt_ushort gain
+															 , const vt_ushort bias_pos, const vt_ushort bias_neg)
+{
+	const vt_long max_diff = (1 << VT_GAIN_BITS) - 1;
+
+	const vt_long diff = src - dark;
+	const vt_long mag	 = (diff < 0) ? -diff : diff;
+	const vt_long term = (((mag > max_diff) ? max_diff : mag)*gain) >> VT_GAIN_BITS;
+	const vt_long out	 = ((diff < 0) ? -term : term) + (vt_long) bias_pos - (vt_long) bias_neg;
+
+	if (out <= 0)
+		return 0;
+	if (out >= USHRT_MAX)
+		return USHRT_MAX;
+	return (vt_ushort) out;
+}
+
+/**
+	\brief Apply a per pixel dark level and gain to a line, dst = (src - dark)*gain/2^VT_GAIN_BITS + bias.
+
+	The full field version of gain_bias_row(). Every pixel costs two more 16 bit loads than
+	the per row version, so to keep the same latency the sums are done in 16 bit integers,
+	eight pixels an instruction rather than four. The difference from the dark level is split
+	into its positive and negative parts, each scaled by the gain with a high multiply, so
+	(src - dark)*gain/2^VT_GAIN_BITS is rounded towards zero. The bias is rounded to the
+	nearest integer and the result clamped to [0, USHRT_MAX].
+
+	Differences beyond 2^VT_GAIN_BITS - 1 = 16383 saturate, the 12 bit sensor data never
+	gets there.
+
+	\param dst  the output line, may be the same as src
+	\param src  the input line
+	\param dark the dark level of each pixel
+	\param gain the fixed point gain of each pixel
+	\param num  number of pixels in the line
+	\param bias the bias added after the gain
+*/
+inline void dark_gain_row(vt_ushort *dst, const vt_ushort *src, const vt_ushort *dark, const vt_ushort *gain
+												, const vt_ulong num, const vt_float bias)
+{
+	enum {
+		MAX_DIFF = (1 << VT_GAIN_BITS) - 1		//!< the largest difference the high multiply can scale
+		, DIFF_SHIFT = 16 - VT_GAIN_BITS
+	};
+
+	// at most one of the two is non zero
+	vt_ushort bias_pos;
+	vt_ushort bias_neg;
+	dark_gain_bias( bias, bias_pos, bias_neg );
+
+	vt_ulong idx = 0;
+
+#ifdef VT_SSE2
+	const __m128i bp   = _mm_set1_epi16( (vt_short) bias_pos );
+	const __m128i bn   = _mm_set1_epi16( (vt_short) bias_neg );
+	const __m128i top  = _mm_set1_epi16( (vt_short) (USHRT_MAX - MAX_DIFF) );
+
+	for (; idx + 8 <= num; idx += 8)
+	{
+		__m128i pix = _mm_loadu_si128( (const __m128i *) (src + idx) );
+		__m128i drk = _mm_loadu_si128( (const __m128i *) (dark + idx) );
+		__m128i gn  = _mm_loadu_si128( (const __m128i *) (gain + idx) );
+
+		// unsigned differences either side of the dark level, limited to MAX_DIFF
+		__m128i pos = _mm_subs_epu16( _mm_adds_epu16( _mm_subs_epu16( pix, drk ), top ), top );
+		__m128i neg = _mm_subs_epu16( _mm_adds_epu16( _mm_subs_epu16( drk, pix ), top ), top );
+
+		// (diff << DIFF_SHIFT)*gain >> 16 is diff*gain >> VT_GAIN_BITS
+		pos = _mm_mulhi_epu16( _mm_slli_epi16( pos, DIFF_SHIFT ), gn );
+		neg = _mm_mulhi_epu16( _mm_slli_epi16( neg, DIFF_SHIFT ), gn );
+
+		// pos + bias_pos can't go past USHRT_MAX unless neg + bias_neg is zero, so the saturations agree with the sum
+		_mm_storeu_si128( (__m128i *) (dst + idx), _mm_subs_epu16( _mm_adds_epu16( pos, bp ), _mm_adds_epu16( neg, bn ) ) );
+	}
+#endif
+
+	for (; idx < num; idx++)
+	{
+		dst[idx] = dark_gain_pixel( src[idx], dark[idx], gain[idx], bias_pos, bias_neg );
+	}
+}
+
+/**
+	\brief Generic version of dark_gain_row() for other pixel types.
+*/
+template<typename T>
+void dark_gain_row(T *dst, const T *src, const vt_ushort *dark, const vt_ushort *gain
+								 , const vt_ulong num, const vt_float bias)
+{
+	vt_ushort bias_pos;
+	vt_ushort bias_neg;
+	dark_gain_bias( bias, bias_pos, bias_neg );
+
+	for (vt_ulong idx = 0; idx < num; idx++)
+	{
+		dst[idx] = (T) dark_gain_pixel( (vt_long) src[idx], (vt_long) dark[idx], gain[idx], bias_pos, bias_neg );
+	}
+}
+
+//*********************************************************************
+// INTERPOLATION
+//*********************************************************************
+/**
+	\brief Interpolate a line between two others, dst = (wm*m + wp*p)/(wm + wp) + noise.
+
+	The result is truncated towards zero and clamped to [0, USHRT_MAX]. The weighted sum is
+	exact in single precision for weights up to 256 and the division is correctly rounded,
+	so without noise this is the exact integer interpolation.
+
+	\param dst		the output line, may be the same as m or p
+	\param m			the first line
+	\param p			the second line
+	\param num		number of pixels in the line
+	\param wm			weight of the first line
+	\param wp			weight of the second line
+	\param noise	noise added to each pixel before truncation, NULL for none
+*/
+inline void lerp_row(vt_ushort *dst, const vt_ushort *m, const vt_ushort *p, const vt_ulong num
+									 , const vt_ushort wm, const vt_ushort wp, const vt_float *noise)
+{
+	const vt_float fm		 = (vt_float) wm;
+	const vt_float fp		 = (vt_float) wp;
+	const vt_float total = (vt_float) (wm + wp);
+
+	vt_ulong idx = 0;
+
+#ifdef VT_SSE2
+	const __m128	vm		 = _mm_set1_ps( fm );
+	const __m128	vp		 = _mm_set1_ps( fp );
+	const __m128	vt		 = _mm_set1_ps( total );
+	const __m128	lo		 = _mm_setzero_ps();
+	const __m128	hi		 = _mm_set1_ps( (vt_float) USHRT_MAX );
+	const __m128i zero	 = _mm_setzero_si128();
+	const __m128i half	 = _mm_set1_epi32( 0x8000 );
+	const __m128i flip	 = _mm_set1_epi16( (vt_short) 0x8000 );
+
+	for (; idx + 8 <= num; idx += 8)
+	{
+		__m128i pm = _mm_loadu_si128( (const __m128i *) (m + idx) );
+		__m128i pp = _mm_loadu_si128( (const __m128i *) (p + idx) );
+
+		__m128 f0 = _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( pm, zero ) ), vm )
+													, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( pp, zero ) ), vp ) );
+		__m128 f1 = _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( pm, zero ) ), vm )
+													, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( pp, zero ) ), vp ) );
+
+		f0 = _mm_div_ps( f0, vt );
+		f1 = _mm_div_ps( f1, vt );
+
+		if (noise != NULL)
+		{
+			f0 = _mm_add_ps( f0, _mm_loadu_ps( noise + idx ) );
+			f1 = _mm_add_ps( f1, _mm_loadu_ps( noise + idx + 4 ) );
+		}
+
+		f0 = _mm_min_ps( _mm_max_ps( f0, lo ), hi );
+		f1 = _mm_min_ps( _mm_max_ps( f1, lo ), hi );
+
+		__m128i i0 = _mm_sub_epi32( _mm_cvttps_epi32( f0 ), half );
+		__m128i i1 = _mm_sub_epi32( _mm_cvttps_epi32( f1 ), half );
+
+		_mm_storeu_si128( (__m128i *) (dst + idx), _mm_xor_si128( _mm_packs_epi32( i0, i1 ), flip ) );
+	}
+#endif
+
+	for (; idx < num; idx++)
+	{
+		vt_float out = ((vt_float) m[idx]*fm + (vt_float) p[idx]*fp)/total;
+
+		if (noise != NULL)
+			out += noise[idx];
+
+		if (out <= 0.0f)
+			dst[idx] = 0;
+		else if (out >= (vt_float) USHRT_MAX)
+			dst[idx] = USHRT_MAX;
+		else
+			dst[idx] = (vt_ushort) out;
+	}
+}
+
+/**
+	\brief Generic version of lerp_row() for other pixel types.
+*/
+template<typename T>
+void lerp_row(T *dst, const T *m, const T *p, const vt_ulong num
+						, const vt_ushort wm, const vt_ushort wp, const vt_float *noise)
+{
+	const vt_float total = (vt_float) (wm + wp);
+
+	for (vt_ulong idx = 0; idx < num; idx++)
+	{
+		vt_float out = ((vt_float) m[idx]*wm + (vt_float) p[idx]*wp)/total;
+
+		if (noise != NULL)
+			out += noise[idx];
+
+		if (out <= 0.0f)
+			dst[idx] = (T) 0;
+		else if (out >= (vt_float) USHRT_MAX)
+			dst[idx] = (T) USHRT_MAX;
+		else
+			dst[idx] = (T) out;
+	}
+}
+
+//*********************************************************************
+// TRANSPOSITION
+//*********************************************************************
+/**
+	\brief Copy part of a column-major frame into the rows of a row-major one.
+
+	dst[row][col] = src[col][src_row + row] for rows [0, rows) and columns [0, cols). The
+	SSE2 version moves 8 x 8 blocks, eight columns are read and eight rows written with one
+	16 byte load or store each. A column at a time is kept within the block of rows so the
+	reads run down each column in turn.
+
+	\param dst			the output rows, starting at the first row and column to write
+	\param src			the input columns, starting at the first column to read
+	\param src_row	the first row of the input columns
+	\param rows			number of rows
+	\param cols			number of columns
+*/
+inline void transpose_lines(vt_ushort *const *dst, const vt_ushort *const *src, const vt_ulong src_row
+													, const vt_ulong rows, const vt_ulong cols)
+{
+	vt_ulong col = 0;
+
+#ifdef VT_SSE2
+	for (; col + 8 <= cols; col += 8)
+	{
+		vt_ulong row = 0;
+
+		for (; row + 8 <= rows; row += 8)
+		{
+			const vt_ulong srow = src_row + row;
+
+			__m128i a0 = _mm_loadu_si128( (const __m128i *) (src[col]			+ srow) );
+			__m128i a1 = _mm_loadu_si128( (const __m128i *) (src[col + 1] + srow) );
+			__m128i a2 = _mm_loadu_si128( (const __m128i *) (src[col + 2] + srow) );
+			__m128i a3 = _mm_loadu_si128( (const __m128i *) (src[col + 3] + srow) );
+			__m128i a4 = _mm_loadu_si128( (const __m128i *) (src[col + 4] + srow) );
+			__m128i a5 = _mm_loadu_si128( (const __m128i *) (src[col + 5] + srow) );
+			__m128i a6 = _mm_loadu_si128( (const __m128i *) (src[col + 6] + srow) );
+			__m128i a7 = _mm_loadu_si128( (const __m128i *) (src[col + 7] + srow) );
+
+			// pairs of columns, then quads, then all eight
+			__m128i t0 = _mm_unpacklo_epi16( a0, a1 );
+			__m128i t1 = _mm_unpackhi_epi16( a0, a1 );
+			__m128i t2 = _mm_unpacklo_epi16( a2, a3 );
+			__m128i t3 = _mm_unpackhi_epi16( a2, a3 );
+			__m128i t4 = _mm_unpacklo_epi16( a4, a5 );
+			__m128i t5 = _mm_unpackhi_epi16( a4, a5 );
+			__m128i t6 = _mm_unpacklo_epi16( a6, a7 );
+			__m128i t7 = _mm_unpackhi_epi16( a6, a7 );
+
+			__m128i u0 = _mm_unpacklo_epi32( t0, t2 );
+			__m128i u1 = _mm_unpackhi_epi32( t0, t2 );
+			__m128i u2 = _mm_unpacklo_epi32( t1, t3 );
+			__m128i u3 = _mm_unpackhi_epi32( t1, t3 );
+			__m128i u4 = _mm_unpacklo_epi32( t4, t6 );
+			__m128i u5 = _mm_unpackhi_epi32( t4, t6 );
+			__m128i u6 = _mm_unpacklo_epi32( t5, t7 );
+			__m128i u7 = _mm_unpackhi_epi32( t5, t7 );
+
+			_mm_storeu_si128( (__m128i *) (dst[row]			+ col), _mm_unpacklo_epi64( u0, u4 ) );
+			_mm_storeu_si128( (__m128i *) (dst[row + 1] + col), _mm_unpackhi_epi64( u0, u4 ) );
+			_mm_storeu_si128( (__m128i *) (dst[row + 2] + col), _mm_unpacklo_epi64( u1, u5 ) );
+			_mm_storeu_si128( (__m128i *) (dst[row + 3] + col), _mm_unpackhi_epi64( u1, u5 ) );
+			_mm_storeu_si128( (__m128i *) (dst[row + 4] + col), _mm_unpacklo_epi64( u2, u6 ) );
+			_mm_storeu_si128( (__m128i *) (dst[row + 5] + col), _mm_unpackhi_epi64( u2, u6 ) );
+			_mm_storeu_si128( (__m128i *) (dst[row + 6] + col), _mm_unpacklo_epi64( u3, u7 ) );
+			_mm_storeu_si128( (__m128i *) (dst[row + 7] + col), _mm_unpackhi_epi64( u3, u7 ) );
+		}
+
+		// the rows left over
+		for (; row < rows; row++)
+		{
+			for (vt_ulong c = col; c < col + 8; c++)
+				dst[row][c] = src[c][src_row + row];
+		}
+	}
+#endif
+
+	for (; col < cols; col++)
+	{
+		const vt_ushort *in = src[col] + src_row;
+
+		for (vt_ulong row = 0; row < rows; row++)
+			dst[row][col] = in[row];
+	}
+}
+
+/**
+	\brief Generic version of transpose_lines() for other pixel types.
+*/
+template<typename T>
+void transpose_lines(T *const *dst, const T *const *src, const vt_ulong src_row, const vt_ulong rows, const vt_ulong cols)
+{
+	for (vt_ulong col = 0; col < cols; col++)
+	{
+		const T *in = src[col] + src_row;
+
+		for (vt_ulong row = 0; row < rows; row++)
+			dst[row][col] = in[row];
+	}
+}
+
+//*********************************************************************
+// POLYNOMIALS
+//*********************************************************************
+//
+// poly_line() of pixels [first, num), the scalar version and the tail of the SSE2 version
+//
+template<typename T>
+void poly_pixels(vt_float *dst, const T *src, const vt_float *const *coefs
+							 , const vt_ulong order, const vt_ulong first, const vt_ulong num, const vt_float *sub)
+{
+	for (vt_ulong idx = first; idx < num; idx++)
+	{
+		const vt_float x = (vt_float) src[idx];
+
+		vt_float val = coefs[1][idx] + coefs[0][idx]*x;
+		for (vt_ulong k = 2; k < order; k++)
+			val = coefs[k][idx] + x*val;
+		val *= x;
+
+		if (sub != NULL)
+			dst[idx] += val - sub[idx];
+		else
+			dst[idx] = val;
+	}
+}
+
+/**
+	\brief Evaluate a polynomial with its own coefficients at every pixel of a line.
+
+	dst[i] = x*(((c0[i]*x + c1[i])*x + ... )*x + cn[i]) for x = src[i], where coefs[k] is
+	the line of coefficient k, one value per pixel. There is no constant term, this is the
+	polynomial of the hds calibration. With sub the result is accumulated instead,
+	dst[i] += poly - sub[i].
+
+	The sums are done in single precision. The SSE2 version runs eight pixels at a time as
+	two Horner chains of four, with one load per coefficient line, and does the scalar
+	operations in the same order so the results are identical.
+
+	\param dst		the output line, may be the same as src
+	\param src		the input line
+	\param coefs	the coefficient lines, highest power first
+	\param order	the number of coefficient lines, at least 2
+	\param num		number of pixels in the line
+	\param sub		subtracted from each result before it is added to dst, NULL to write dst
+*/
+template<typename T>
+void poly_line(vt_float *dst, const T *src, const vt_float *const *coefs
+						 , const vt_ulong order, const vt_ulong num, const vt_float *sub = NULL)
+{
+	poly_pixels( dst, src, coefs, order, 0, num, sub );
+}
+
+#ifdef VT_SSE2
+//
+// eight pixels as two sets of four floats
+//
+inline void load_quads(__m128 &x0, __m128 &x1, const vt_ushort *src)
+{
+	const __m128i pix = _mm_loadu_si128( (const __m128i *) src );
+
+	x0 = _mm_cvtepi32_ps( _mm_unpacklo_epi16( pix, _mm_setzero_si128() ) );
+	x1 = _mm_cvtepi32_ps( _mm_unpackhi_epi16( pix, _mm_setzero_si128() ) );
+}
+
+inline void load_quads(__m128 &x0, __m128 &x1, const vt_float *src)
+{
+	x0 = _mm_loadu_ps( src );
+	x1 = _mm_loadu_ps( src + 4 );
+}
+
+template<typename T>
+void poly_line_sse2(vt_float *dst, const T *src, const vt_float *const *coefs
+									, const vt_ulong order, const vt_ulong num, const vt_float *sub)
+{
+	vt_ulong idx = 0;
+
+	for (; idx + 8 <= num; idx += 8)
+	{
+		__m128 x0, x1;
+		load_quads( x0, x1, src + idx );
+
+		__m128 v0 = _mm_add_ps( _mm_loadu_ps( coefs[1] + idx ),			_mm_mul_ps( _mm_loadu_ps( coefs[0] + idx ), x0 ) );
+		__m128 v1 = _mm_add_ps( _mm_loadu_ps( coefs[1] + idx + 4 ), _mm_mul_ps( _mm_loadu_ps( coefs[0] + idx + 4 ), x1 ) );
+
+		for (vt_ulong k = 2; k < order; k++)
+		{
+			v0 = _mm_add_ps( _mm_loadu_ps( coefs[k] + idx ),		 _mm_mul_ps( x0, v0 ) );
+			v1 = _mm_add_ps( _mm_loadu_ps( coefs[k] + idx + 4 ), _mm_mul_ps( x1, v1 ) );
+		}
+		v0 = _mm_mul_ps( v0, x0 );
+		v1 = _mm_mul_ps( v1, x1 );
+
+		if (sub != NULL)
+		{
+			v0 = _mm_add_ps( _mm_loadu_ps( dst + idx ),			_mm_sub_ps( v0, _mm_loadu_ps( sub + idx ) ) );
+			v1 = _mm_add_ps( _mm_loadu_ps( dst + idx + 4 ), _mm_sub_ps( v1, _mm_loadu_ps( sub + idx + 4 ) ) );
+		}
+
+		_mm_storeu_ps( dst + idx, v0 );
+		_mm_storeu_ps( dst + idx + 4, v1 );
+	}
+
+	poly_pixels( dst, src, coefs, order, idx, num, sub );
+}
+
+/**
+	\brief poly_line() of 16 bit pixels.
+*/
+inline void poly_line(vt_float *dst, const vt_ushort *src, const vt_float *const *coefs
+										, const vt_ulong order, const vt_ulong num, const vt_float *sub = NULL)
+{
+	poly_line_sse2( dst, src, coefs, order, num, sub );
+}
+
+/**
+	\brief poly_line() of single precision values.
+*/
+inline void poly_line(vt_float *dst, const vt_float *src, const vt_float *const *coefs
+										, const vt_ulong order, const vt_ulong num, const vt_float *sub = NULL)
+{
+	poly_line_sse2( dst, src, coefs, order, num, sub );
+}
+#endif
+
+//
+// poly_sums_line() of pixels [first, num), the scalar version and the tail of the SSE2 version
+//
+template<typename T>
+void poly_sums_pixels(vt_double *sums, const vt_ulong stride, const T *x, const vt_double y
+										, const vt_double scale, const vt_ulong order, const vt_ulong first, const vt_ulong num)
+{
+	for (vt_ulong idx = first; idx < num; idx++)
+	{
+		const vt_double u = (vt_double) x[idx]*scale;
+
+		vt_double p = u;
+		for (vt_ulong k = 1; k <= 2*order; k++)
+		{
+			if (k >= 2)
+				sums[(k - 2)*stride + idx] += p;
+			if (k <= order)
+				sums[(2*order + k - 2)*stride + idx] += y*p;
+			p *= u;
+		}
+	}
+}
+
+/**
+	\brief Add a line of points to the least squares sums of a polynomial fit, one fit per pixel.
+
+	The fit is y = c[0]*u^order + ... + c[order-1]*u, with no constant term, for u = x*scale.
+	Its normal equations need the sums of u^k for k = 2 to 2*order and of y*u^k for k = 1 to
+	order, so each pixel keeps 3*order - 1 sums. These are held as planes stride apart, the
+	power sums first, lowest power first, then the products with y.
+
+	The sums are done in double precision. The SSE2 version does two pixels at a time with
+	the operations of the scalar loop, so the sums are identical.
+
+	\param sums		the first plane of sums, 3*order - 1 planes
+	\param stride	the distance between the planes
+	\param x			the points, one per pixel
+	\param y			the value the points are fitted to, the same for every pixel of the line
+	\param scale	the scale applied to the points, to keep the powers of u near 1
+	\param order	the number of coefficients
+	\param num		number of pixels in the line
+*/
+template<typename T>
+void poly_sums_line(vt_double *sums, const vt_ulong stride, const T *x, const vt_double y
+									, const vt_double scale, const vt_ulong order, const vt_ulong num)
+{
+	poly_sums_pixels( sums, stride, x, y, scale, order, 0, num );
+}
+
+#ifdef VT_SSE2
+//
+// two points as doubles
+//
+inline __m128d load_point_pair(const vt_float *x)
+{
+	return _mm_cvtps_pd( _mm_castsi128_ps( _mm_loadl_epi64( (const __m128i *) x ) ) );
+}
+
+inline __m128d load_point_pair(const vt_double *x)
+{
+	return _mm_loadu_pd( x );
+}
+
+template<typename T>
+void poly_sums_line_sse2(vt_double *sums, const vt_ulong stride, const T *x, const vt_double y
+											 , const vt_double scale, const vt_ulong order, const vt_ulong num)
+{
+	const __m128d vs = _mm_set1_pd( scale );
+	const __m128d vy = _mm_set1_pd( y );
+
+	vt_ulong idx = 0;
+
+	for (; idx + 2 <= num; idx += 2)
+	{
+		const __m128d u = _mm_mul_pd( load_point_pair( x + idx ), vs );
+
+		__m128d p = u;
+		for (vt_ulong k = 1; k <= 2*order; k++)
+		{
+			if (k >= 2)
+			{
+				vt_double *ps = sums + (k - 2)*stride + idx;
+				_mm_storeu_pd( ps, _mm_add_pd( _mm_loadu_pd( ps ), p ) );
+			}
+			if (k <= order)
+			{
+				vt_double *py = sums + (2*order + k - 2)*stride + idx;
+				_mm_storeu_pd( py, _mm_add_pd( _mm_loadu_pd( py ), _mm_mul_pd( vy, p ) ) );
+			}
+			p = _mm_mul_pd( p, u );
+		}
+	}
+
+	poly_sums_pixels( sums, stride, x, y, scale, order, idx, num );
+}
+
+/**
+	\brief poly_sums_line() of single precision points.
+*/
+inline void poly_sums_line(vt_double *sums, const vt_ulong stride, const vt_float *x, const vt_double y
+												 , const vt_double scale, const vt_ulong order, const vt_ulong num)
+{
+	poly_sums_line_sse2( sums, stride, x, y, scale, order, num );
+}
+
+/**
+	\brief poly_sums_line() of double precision points.
+*/
+inline void poly_sums_line(vt_double *sums, const vt_ulong stride, const vt_double *x, const vt_double y
+												 , const vt_double scale, const vt_ulong order, const vt_ulong num)
+{
+	poly_sums_line_sse2( sums, stride, x, y, scale, order, num );
+}
+#endif
+
+/**
+	\brief Solve a symmetric positive definite system, a*z = b, by Cholesky decomposition.
+
+	\param a	the n x n matrix, row-major, overwritten by its factor
+	\param b	the right hand side, overwritten by the solution
+	\param n	the size of the system
+	\return false if the matrix isn't safely positive definite, a and b are then undefined
+*/
+inline vt_bool cholesky_solve(vt_double *a, vt_double *b, const vt_ulong n)
+{
+	const vt_double eps = 1.0e-12;
+
+	for (vt_ulong j = 0; j < n; j++)
+	{
+		const vt_double diag = a[j*n + j];
+
+		vt_double d = diag;
+		for (vt_ulong k = 0; k < j; k++)
+			d -= a[j*n + k]*a[j*n + k];
+
+		if (!(d > eps*diag))
+			return false;
+
+		const vt_double l = sqrt( d );
+		a[j*n + j] = l;
+
+		for (vt_ulong i = j + 1; i < n; i++)
+		{
+			vt_double s = a[i*n + j];
+			for (vt_ulong k = 0; k < j; k++)
+				s -= a[i*n + k]*a[j*n + k];
+
+			a[i*n + j] = s/l;
+		}
+	}
+
+	// L z = b then L' x = z
+	for (vt_ulong i = 0; i < n; i++)
+	{
+		vt_double s = b[i];
+		for (vt_ulong k = 0; k < i; k++)
+			s -= a[i*n + k]*b[k];
+		b[i] = s/a[i*n + i];
+	}
+	for (vt_ulong i = n; i-- > 0; )
+	{
+		vt_double s = b[i];
+		for (vt_ulong k = i + 1; k < n; k++)
+			s -= a[k*n + i]*b[k];
+		b[i] = s/a[i*n + i];
+	}
+	return true;
+}
+
+enum {
+	VT_MAX_FIT_ORDER = 8	//!< the most coefficients fit_poly_line() will fit
+};
+
+/**
+	\brief Solve the fits of a line of pixels from the sums made by poly_sums_line().
+
+	The coefficients are written highest power first and scaled back to powers of x, so they
+	can go straight to poly_line(). A pixel whose normal equations can't be solved, e.g. one
+	whose points are all the same, is given y = x and marked in good.
+
+	\param coefs				the coefficients of the first pixel
+	\param coef_stride	the distance from the coefficients of one pixel to the next
+	\param sums					the sums of the first pixel, as poly_sums_line()
+	\param stride				the distance between the planes of sums
+	\param scale				the scale the sums were made with
+	\param order				the number of coefficients
+	\param num					number of pixels in the line
+	\param good					set to 1 for each pixel fitted and 0 for each that couldn't be
+*/
+inline void fit_poly_line(vt_double *coefs, const vt_ulong coef_stride, const vt_double *sums, const vt_ulong stride
+												, const vt_double scale, const vt_ulong order, const vt_ulong num, vt_byte *good)
+{
+	Vt_precondition( order >= 1 && order <= VT_MAX_FIT_ORDER, "fit_poly_line - unsupported order" );
+
+	vt_double a[VT_MAX_FIT_ORDER*VT_MAX_FIT_ORDER];
+	vt_double b[VT_MAX_FIT_ORDER];
+
+	for (vt_ulong idx = 0; idx < num; idx++)
+	{
+		// a[i][j] is the sum of u^(i + j + 2), b[i] the sum of y*u^(i + 1)
+		for (vt_ulong i = 0; i < order; i++)
+		{
+			for (vt_ulong j = 0; j < order; j++)
+				a[i*order + j] = sums[(i + j)*stride + idx];
+
+			b[i] = sums[(2*order + i - 1)*stride + idx];
+		}
+
+		vt_double *c = coefs + idx*coef_stride;
+
+		if (cholesky_solve( a, b, order ))
+		{
+			vt_double power = scale;
+			for (vt_ulong i = 0; i < order; i++, power *= scale)
+				c[order - 1 - i] = b[i]*power;
+
+			good[idx] = 1;
+		}
+		else
+		{
+			for (vt_ulong i = 0; i + 1 < order; i++)
+				c[i] = 0.0;
+			c[order - 1] = 1.0;
+
+			good[idx] = 0;
+		}
+	}
+}
+
+/**
+	\brief Convert a line of values to pixels, truncated towards zero and clamped to [0, USHRT_MAX].
+*/
+template<typename T, typename S>
+void clamp_line(T *dst, const S *src, const vt_ulong num)
+{
+	for (vt_ulong idx = 0; idx < num; idx++)
+	{
+		const S val = src[idx];
+
+		if (!(val > (S) 0))
+			dst[idx] = (T) 0;
+		else if (val >= (S) USHRT_MAX)
+			dst[idx] = (T) USHRT_MAX;
+		else
+			dst[idx] = (T) val;
+	}
+}
+
+//*********************************************************************
+// REDUCTIONS
+//*********************************************************************
+/**
+	\brief The instruction sets the reduction kernels are built for.
+*/
+enum VT_ISA {
+	VT_ISA_SCALAR = 0		//!< plain C++
+	, VT_ISA_SSE2				//!< 128 bit SSE2
+	, VT_ISA_AVX2				//!< 256 bit AVX2
+};
+
+/**
+	\brief The reduction kernels for one instruction set.
+
+	The image statistics (means, row and column means, roi statistics, frame sums) are all
+	built from these few line operations. The table is chosen once, from the processor the
+	library is running on, see kernels().
+
+	Every version gives identical results. Sums of 16 bit pixels are exact 64 bit integers
+	so the order of the additions doesn't matter. Sums of doubles are made in blocks of at
+	most PAIRWISE_BLOCK values, each block is summed in four interleaved lanes which are
+	combined as (lane0 + lane1) + (lane2 + lane3), and the blocks are combined pairwise. The
+	order of the additions is fixed by the length of the line alone.
+*/
+struct VT_KERNELS
+{
+	enum {
+		PAIRWISE_BLOCK	= 128			//!< doubles summed directly before a sum is split in two
+		, SUM_BLOCK			= 65536		//!< 16 bit values which can be summed in a 32 bit lane
+		, COLUMN_BLOCK	= 4096		//!< width of the strips column sums are accumulated in
+	};
+
+	VT_ISA		isa;
+
+	//! sum of a line of pixels
+	vt_uint64 (*sum_u16)(const vt_ushort *src, const vt_ulong num);
+
+	//! add the sum and sum of squares of a line of pixels to sum and sumsq
+	void			(*sum_sq_u16)(vt_uint64 &sum, vt_uint64 &sumsq, const vt_ushort *src, const vt_ulong num);
+
+	//! add a line of pixels to 32 bit sums, acc[i] += src[i]
+	void			(*add_u16)(vt_uint32 *acc, const vt_ushort *src, const vt_ulong num);
+
+	//! add a line of pixels to double sums, acc[i] += src[i]
+	void			(*add_u16_f64)(vt_double *acc, const vt_ushort *src, const vt_ulong num);
+
+	//! sum of a block of up to PAIRWISE_BLOCK doubles
+	vt_double (*sum_f64)(const vt_double *src, const vt_ulong num);
+
+	//! dst[i] /= divisor
+	void			(*div_f64)(vt_double *dst, const vt_ulong num, const vt_double divisor);
+};
+
+//
+// plain C++ kernels
+//
+inline vt_uint64 sum_u16_scalar(const vt_ushort *src, const vt_ulong num)
+{
+	vt_uint64 total = 0;
+	for (vt_ulong idx = 0; idx < num; idx++)
+		total += src[idx];
+	return total;
+}
+
+inline void sum_sq_u16_scalar(vt_uint64 &sum, vt_uint64 &sumsq, const vt_ushort *src, const vt_ulong num)
+{
+	for (vt_ulong idx = 0; idx < num; idx++)
+	{
+		const vt_uint32 val = src[idx];
+
+		sum		+= val;
+		sumsq += (vt_uint64) (val*val);
+	}
+}
+
+inline void add_u16_scalar(vt_uint32 *acc, const vt_ushort *src, const vt_ulong num)
+{
+	for (vt_ulong idx = 0; idx < num; idx++)
+		acc[idx] += src[idx];
+}
+
+inline void add_u16_f64_scalar(vt_double *acc, const vt_ushort *src, const vt_ulong num)
+{
+	for (vt_ulong idx = 0; idx < num; idx++)
+		acc[idx] += src[idx];
+}
+
+inline vt_double sum_f64_scalar(const vt_double *src, const vt_ulong num)
+{
+	vt_double lane[4] = { 0.0, 0.0, 0.0, 0.0 };
+
+	vt_ulong idx = 0;
+	for (; idx + 4 <= num; idx += 4)
+	{
+		lane[0] += src[idx];
+		lane[1] += src[idx + 1];
+		lane[2] += src[idx + 2];
+		lane[3] += src[idx + 3];
+	}
+
+	vt_double total = (lane[0] + lane[1]) + (lane[2] + lane[3]);
+	for (; idx < num; idx++)
+		total += src[idx];
+	return total;
+}
+
+inline void div_f64_scalar(vt_double *dst, const vt_ulong num, const vt_double divisor)
+{
+	for (vt_ulong idx = 0; idx < num; idx++)
+		dst[idx] /= divisor;
+}
+
+#ifdef VT_SSE2
+//
+// SSE2 kernels, eight pixels or four doubles at a time
+//
+inline vt_uint64 sum_u16_sse2(const vt_ushort *src, const vt_ulong num)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	vt_uint64 total = 0;
+	vt_ulong	idx		= 0;
+	while (idx + 8 <= num)
+	{
+		// each lane takes two pixels per step, a block can't overflow 32 bits
+		const vt_ulong end = (num - idx > VT_KERNELS::SUM_BLOCK) ? idx + VT_KERNELS::SUM_BLOCK : num;
+
+		__m128i acc = zero;
+		for (; idx + 8 <= end; idx += 8)
+		{
+			__m128i pix = _mm_loadu_si128( (const __m128i *) (src + idx) );
+
+			acc = _mm_add_epi32( acc, _mm_unpacklo_epi16( pix, zero ) );
+			acc = _mm_add_epi32( acc, _mm_unpackhi_epi16( pix, zero ) );
+		}
+
+		vt_uint32 lane[4];
+		_mm_storeu_si128( (__m128i *) lane, acc );
+		total += (vt_uint64) lane[0] + lane[1] + lane[2] + lane[3];
+	}
+	return total + sum_u16_scalar( src + idx, num - idx );
+}
+
+inline void sum_sq_u16_sse2(vt_uint64 &sum, vt_uint64 &sumsq, const vt_ushort *src, const vt_ulong num)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	vt_ulong idx = 0;
+	while (idx + 8 <= num)
+	{
+		const vt_ulong end = (num - idx > VT_KERNELS::SUM_BLOCK) ? idx + VT_KERNELS::SUM_BLOCK : num;
+
+		__m128i acc		= zero;
+		__m128i accsq = zero;
+		for (; idx + 8 <= end; idx += 8)
+		{
+			__m128i pix = _mm_loadu_si128( (const __m128i *) (src + idx) );
+
+			acc = _mm_add_epi32( acc, _mm_unpacklo_epi16( pix, zero ) );
+			acc = _mm_add_epi32( acc, _mm_unpackhi_epi16( pix, zero ) );
+
+			// 32 bit squares from the low and high halves of the 16 bit products
+			__m128i lo	= _mm_mullo_epi16( pix, pix );
+			__m128i hi	= _mm_mulhi_epu16( pix, pix );
+			__m128i sq0 = _mm_unpacklo_epi16( lo, hi );
+			__m128i sq1 = _mm_unpackhi_epi16( lo, hi );
+
+			accsq = _mm_add_epi64( accsq, _mm_unpacklo_epi32( sq0, zero ) );
+			accsq = _mm_add_epi64( accsq, _mm_unpackhi_epi32( sq0, zero ) );
+			accsq = _mm_add_epi64( accsq, _mm_unpacklo_epi32( sq1, zero ) );
+			accsq = _mm_add_epi64( accsq, _mm_unpackhi_epi32( sq1, zero ) );
+		}
+
+		vt_uint32 lane[4];
+		vt_uint64 lanesq[2];
+		_mm_storeu_si128( (__m128i *) lane, acc );
+		_mm_storeu_si128( (__m128i *) lanesq, accsq );
+
+		sum		+= (vt_uint64) lane[0] + lane[1] + lane[2] + lane[3];
+		sumsq += lanesq[0] + lanesq[1];
+	}
+	sum_sq_u16_scalar( sum, sumsq, src + idx, num - idx );
+}
+
+inline void add_u16_sse2(vt_uint32 *acc, const vt_ushort *src, const vt_ulong num)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	vt_ulong idx = 0;
+	for (; idx + 8 <= num; idx += 8)
+	{
+		__m128i pix = _mm_loadu_si128( (const __m128i *) (src + idx) );
+		__m128i *pa = (__m128i *) (acc + idx);
+
+		_mm_storeu_si128( pa,			_mm_add_epi32( _mm_loadu_si128( pa ),			_mm_unpacklo_epi16( pix, zero ) ) );
+		_mm_storeu_si128( pa + 1, _mm_add_epi32( _mm_loadu_si128( pa + 1 ), _mm_unpackhi_epi16( pix, zero ) ) );
+	}
+	add_u16_scalar( acc + idx, src + idx, num - idx );
+}
+
+inline void add_u16_f64_sse2(vt_double *acc, const vt_ushort *src, const vt_ulong num)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	vt_ulong idx = 0;
+	for (; idx + 8 <= num; idx += 8)
+	{
+		__m128i pix = _mm_loadu_si128( (const __m128i *) (src + idx) );
+		__m128i i0	= _mm_unpacklo_epi16( pix, zero );
+		__m128i i1	= _mm_unpackhi_epi16( pix, zero );
+
+		vt_double *pa = acc + idx;
+		_mm_storeu_pd( pa,		 _mm_add_pd( _mm_loadu_pd( pa ),		 _mm_cvtepi32_pd( i0 ) ) );
+		_mm_storeu_pd( pa + 2, _mm_add_pd( _mm_loadu_pd( pa + 2 ), _mm_cvtepi32_pd( _mm_srli_si128( i0, 8 ) ) ) );
+		_mm_storeu_pd( pa + 4, _mm_add_pd( _mm_loadu_pd( pa + 4 ), _mm_cvtepi32_pd( i1 ) ) );
+		_mm_storeu_pd( pa + 6, _mm_add_pd( _mm_loadu_pd( pa + 6 ), _mm_cvtepi32_pd( _mm_srli_si128( i1, 8 ) ) ) );
+	}
+	add_u16_f64_scalar( acc + idx, src + idx, num - idx );
+}
+
+inline vt_double sum_f64_sse2(const vt_double *src, const vt_ulong num)
+{
+	// lanes 0 and 1 in one register, 2 and 3 in the other
+	__m128d acc01 = _mm_setzero_pd();
+	__m128d acc23 = _mm_setzero_pd();
+
+	vt_ulong idx = 0;
+	for (; idx + 4 <= num; idx += 4)
+	{
+		acc01 = _mm_add_pd( acc01, _mm_loadu_pd( src + idx ) );
+		acc23 = _mm_add_pd( acc23, _mm_loadu_pd( src + idx + 2 ) );
+	}
+
+	vt_double lane[4];
+	_mm_storeu_pd( lane, acc01 );
+	_mm_storeu_pd( lane + 2, acc23 );
+
+	vt_double total = (lane[0] + lane[1]) + (lane[2] + lane[3]);
+	for (; idx < num; idx++)
+		total += src[idx];
+	return total;
+}
+
+inline void div_f64_sse2(vt_double *dst, const vt_ulong num, const vt_double divisor)
+{
+	const __m128d d = _mm_set1_pd( divisor );
+
+	vt_ulong idx = 0;
+	for (; idx + 2 <= num; idx += 2)
+	{
+		_mm_storeu_pd( dst + idx, _mm_div_pd( _mm_loadu_pd( dst + idx ), d ) );
+	}
+	div_f64_scalar( dst + idx, num - idx, divisor );
+}
+#endif // VT_SSE2
+
+#ifdef VT_AVX2
+//
+// AVX2 kernels. Each one clears the upper halves of the ymm registers on the way out, the
+// rest of the library is SSE code.
+//
+inline vt_uint64 sum_u16_avx2(const vt_ushort *src, const vt_ulong num)
+{
+	vt_uint64 total = 0;
+	vt_ulong	idx		= 0;
+	while (idx + 16 <= num)
+	{
+		const vt_ulong end = (num - idx > VT_KERNELS::SUM_BLOCK) ? idx + VT_KERNELS::SUM_BLOCK : num;
+
+		__m256i acc = _mm256_setzero_si256();
+		for (; idx + 16 <= end; idx += 16)
+		{
+			acc = _mm256_add_epi32( acc, _mm256_cvtepu16_epi32( _mm_loadu_si128( (const __m128i *) (src + idx) ) ) );
+			acc = _mm256_add_epi32( acc, _mm256_cvtepu16_epi32( _mm_loadu_si128( (const __m128i *) (src + idx + 8) ) ) );
+		}
+
+		vt_uint32 lane[8];
+		_mm256_storeu_si256( (__m256i *) lane, acc );
+		for (vt_ulong l = 0; l < 8; l++)
+			total += lane[l];
+	}
+	_mm256_zeroupper();
+
+	return total + sum_u16_scalar( src + idx, num - idx );
+}
+
+inline void sum_sq_u16_avx2(vt_uint64 &sum, vt_uint64 &sumsq, const vt_ushort *src, const vt_ulong num)
+{
+	vt_ulong idx = 0;
+	while (idx + 8 <= num)
+	{
+		const vt_ulong end = (num - idx > VT_KERNELS::SUM_BLOCK) ? idx + VT_KERNELS::SUM_BLOCK : num;
+
+		__m256i acc		= _mm256_setzero_si256();
+		__m256i accsq = _mm256_setzero_si256();
+		for (; idx + 8 <= end; idx += 8)
+		{
+			__m256i pix = _mm256_cvtepu16_epi32( _mm_loadu_si128( (const __m128i *) (src + idx) ) );
+			__m256i sq	= _mm256_mullo_epi32( pix, pix );
+
+			acc		= _mm256_add_epi32( acc, pix );
+			accsq = _mm256_add_epi64( accsq, _mm256_cvtepu32_epi64( _mm256_castsi256_si128( sq ) ) );
+			accsq = _mm256_add_epi64( accsq, _mm256_cvtepu32_epi64( _mm256_extracti128_si256( sq, 1 ) ) );
+		}
+
+		vt_uint32 lane[8];
+		vt_uint64 lanesq[4];
+		_mm256_storeu_si256( (__m256i *) lane, acc );
+		_mm256_storeu_si256( (__m256i *) lanesq, accsq );
+
+		for (vt_ulong l = 0; l < 8; l++)
+			sum += lane[l];
+		sumsq += (lanesq[0] + lanesq[1]) + (lanesq[2] + lanesq[3]);
+	}
+	_mm256_zeroupper();
+
+	sum_sq_u16_scalar( sum, sumsq, src + idx, num - idx );
+}
+
+inline void add_u16_avx2(vt_uint32 *acc, const vt_ushort *src, const vt_ulong num)
+{
+	vt_ulong idx = 0;
+	for (; idx + 8 <= num; idx += 8)
+	{
+		__m256i *pa = (__m256i *) (acc + idx);
+		__m256i pix = _mm256_cvtepu16_epi32( _mm_loadu_si128( (const __m128i *) (src + idx) ) );
+
+		_mm256_storeu_si256( pa, _mm256_add_epi32( _mm256_loadu_si256( pa ), pix ) );
+	}
+	_mm256_zeroupper();
+
+	add_u16_scalar( acc + idx, src + idx, num - idx );
+}
+
+inline void add_u16_f64_avx2(vt_double *acc, const vt_ushort *src, const vt_ulong num)
+{
+	vt_ulong idx = 0;
+	for (; idx + 8 <= num; idx += 8)
+	{
+		__m256i		 pix = _mm256_cvtepu16_epi32( _mm_loadu_si128( (const __m128i *) (src + idx) ) );
+		vt_double *pa	 = acc + idx;
+
+		_mm256_storeu_pd( pa,			_mm256_add_pd( _mm256_loadu_pd( pa ),			_mm256_cvtepi32_pd( _mm256_castsi256_si128( pix ) ) ) );
+		_mm256_storeu_pd( pa + 4, _mm256_add_pd( _mm256_loadu_pd( pa + 4 ), _mm256_cvtepi32_pd( _mm256_extracti128_si256( pix, 1 ) ) ) );
+	}
+	_mm256_zeroupper();
+
+	add_u16_f64_scalar( acc + idx, src + idx, num - idx );
+}
+
+inline vt_double sum_f64_avx2(const vt_double *src, const vt_ulong num)
+{
+	__m256d acc = _mm256_setzero_pd();
+
+	vt_ulong idx = 0;
+	for (; idx + 4 <= num; idx += 4)
+	{
+		acc = _mm256_add_pd( acc, _mm256_loadu_pd( src + idx ) );
+	}
+
+	vt_double lane[4];
+	_mm256_storeu_pd( lane, acc );
+	_mm256_zeroupper();
+
+	vt_double total = (lane[0] + lane[1]) + (lane[2] + lane[3]);
+	for (; idx < num; idx++)
+		total += src[idx];
+	return total;
+}
+
+inline void div_f64_avx2(vt_double *dst, const vt_ulong num, const vt_double divisor)
+{
+	const __m256d d = _mm256_set1_pd( divisor );
+
+	vt_ulong idx = 0;
+	for (; idx + 4 <= num; idx += 4)
+	{
+		_mm256_storeu_pd( dst + idx, _mm256_div_pd( _mm256_loadu_pd( dst + idx ), d ) );
+	}
+	_mm256_zeroupper();
+
+	div_f64_scalar( dst + idx, num - idx, divisor );
+}
+#endif // VT_AVX2
+
+/**
+	\brief The best instruction set supported by both the processor and this build.
+*/
+inline VT_ISA cpu_isa()
+{
+	VT_ISA isa = VT_ISA_SCALAR;
+
+#ifdef VT_SSE2
+	int info[4];
+
+	__cpuid( info, 0 );
+	const int max_leaf = info[0];
+
+	__cpuid( info, 1 );
+	if (info[3] & (1 << 26))
+		isa = VT_ISA_SSE2;
+
+#ifdef VT_AVX2
+	// the OS must save the ymm registers as well as the processor supporting AVX
+	const vt_bool osxsave = (info[2] & (1 << 27)) != 0;
+	const vt_bool avx			= (info[2] & (1 << 28)) != 0;
+
+	if (isa == VT_ISA_SSE2 && max_leaf >= 7 && osxsave && avx && (_xgetbv( 0 ) & 6) == 6)
+	{
+		__cpuidex( info, 7, 0 );
+		if (info[1] & (1 << 5))
+			isa = VT_ISA_AVX2;
+	}
+#endif
+#endif
+
+	return isa;
+}
+
+/**
+	\brief The kernel table for an instruction set, or the nearest one built in.
+*/
+inline VT_KERNELS kernel_table(const VT_ISA isa)
+{
+	VT_KERNELS k;
+
+	k.isa					= VT_ISA_SCALAR;
+	k.sum_u16			= sum_u16_scalar;
+	k.sum_sq_u16	= sum_sq_u16_scalar;
+	k.add_u16			= add_u16_scalar;
+	k.add_u16_f64 = add_u16_f64_scalar;
+	k.sum_f64			= sum_f64_scalar;
+	k.div_f64			= div_f64_scalar;
+
+#ifdef VT_SSE2
+	if (isa >= VT_ISA_SSE2)
+	{
+		k.isa					= VT_ISA_SSE2;
+		k.sum_u16			= sum_u16_sse2;
+		k.sum_sq_u16	= sum_sq_u16_sse2;
+		k.add_u16			= add_u16_sse2;
+		k.add_u16_f64 = add_u16_f64_sse2;
+		k.sum_f64			= sum_f64_sse2;
+		k.div_f64			= div_f64_sse2;
+	}
+#endif
+#ifdef VT_AVX2
+	if (isa >= VT_ISA_AVX2)
+	{
+		k.isa					= VT_ISA_AVX2;
+		k.sum_u16			= sum_u16_avx2;
+		k.sum_sq_u16	= sum_sq_u16_avx2;
+		k.add_u16			= add_u16_avx2;
+		k.add_u16_f64 = add_u16_f64_avx2;
+		k.sum_f64			= sum_f64_avx2;
+		k.div_f64			= div_f64_avx2;
+	}
+#endif
+
+	return k;
+}
+
+//! the kernel table in use, chosen from the processor the first time it's needed. The
+//! thread pool and the background workers ask for it before they start their threads, so
+//! it is made before any other thread can use it.
+inline VT_KERNELS &current_kernels()
+{
+	static VT_KERNELS table = kernel_table( cpu_isa() );
+	return table;
+}
+
+//! the thread pool jobs and background tasks running, which may be using the kernel table
+inline volatile long &kernel_users()
+{
+	static volatile long users = 0;
+	return users;
+}
+
+/**
+	\brief The reduction kernels in use.
+*/
+inline const VT_KERNELS &kernels()
+{
+	return current_kernels();
+}
+
+/**
+	\brief Use the kernels for a lower instruction set than the processor supports.
+
+	Intended for checking a build against the plain C++ kernels. It isn't possible to select
+	a higher instruction set than the processor supports. The table can't be changed while
+	the thread pool or a CVtWorker is running a task, call this between jobs from the thread
+	which starts them.
+
+	\return the instruction set now in use
+*/
+inline VT_ISA select_isa(const VT_ISA isa)
+{
+	Vt_precondition( kernel_users() == 0, "select_isa - the kernels are in use by a running task" );
+
+	const VT_ISA best = cpu_isa();
+
+	current_kernels() = kernel_table( (isa < best) ? isa : best );
+	return current_kernels().isa;
+}
+
+//*********************************************************************
+// LINE AND IMAGE SUMS
+//*********************************************************************
+/**
+	\brief Sum of a line of doubles, summed pairwise.
+*/
+inline vt_double line_sum(const vt_double *src, const vt_ulong num)
+{
+	if (num <= VT_KERNELS::PAIRWISE_BLOCK)
+		return kernels().sum_f64( src, num );
+
+	const vt_ulong half = num/2;
+	return line_sum( src, half ) + line_sum( src + half, num - half );
+}
+
+/**
+	\brief Sum of a line of 16 bit pixels, exact.
+*/
+inline vt_double line_sum(const vt_ushort *src, const vt_ulong num)
+{
+	return (vt_double) kernels().sum_u16( src, num );
+}
+
+/**
+	\brief Sum of a line of any other type, with the same pairwise order as the double version.
+*/
+template<typename T>
+vt_double line_sum(const T *src, const vt_ulong num)
+{
+	if (num > VT_KERNELS::PAIRWISE_BLOCK)
+	{
+		const vt_ulong half = num/2;
+		return line_sum( src, half ) + line_sum( src + half, num - half );
+	}
+
+	vt_double lane[4] = { 0.0, 0.0, 0.0, 0.0 };
+
+	vt_ulong idx = 0;
+	for (; idx + 4 <= num; idx += 4)
+	{
+		lane[0] += src[idx];
+		lane[1] += src[idx + 1];
+		lane[2] += src[idx + 2];
+		lane[3] += src[idx + 3];
+	}
+
+	vt_double total = (lane[0] + lane[1]) + (lane[2] + lane[3]);
+	for (; idx < num; idx++)
+		total += src[idx];
+	return total;
+}
+
+/**
+	\brief Sums of num values from offset along each of a set of lines, sums[i] = sum of lines[n][offset + i]
+
+	For a row-major image these are the column sums, for a column-major image the row sums.
+	The lines are added a strip of COLUMN_BLOCK values at a time, so the sums being
+	added to stay in the cache while every line is read in order. The 16 bit sums are exact.
+
+	\param sums				the num sums
+	\param lines			pointers to the lines
+	\param num_lines	number of lines to add
+	\param offset			index of the first value of each line
+	\param num				number of values from each line
+*/
+inline void column_sums(vt_double *sums, const vt_ushort *const *lines, const vt_ulong num_lines
+											, const vt_ulong offset, const vt_ulong num)
+{
+	vt_uint32 acc[VT_KERNELS::COLUMN_BLOCK];
+
+	for (vt_ulong start = 0; start < num; start += VT_KERNELS::COLUMN_BLOCK)
+	{
+		const vt_ulong len = (num - start < VT_KERNELS::COLUMN_BLOCK) ? num - start : VT_KERNELS::COLUMN_BLOCK;
+
+		for (vt_ulong idx = 0; idx < len; idx++)
+			sums[start + idx] = 0.0;
+
+		vt_ulong line = 0;
+		while (line < num_lines)
+		{
+			// a 32 bit sum holds SUM_BLOCK lines
+			const vt_ulong end = (num_lines - line > VT_KERNELS::SUM_BLOCK) ? line + VT_KERNELS::SUM_BLOCK : num_lines;
+
+			memset( acc, 0, sizeof( acc[0] )*len );
+			for (; line < end; line++)
+			{
+				kernels().add_u16( acc, lines[line] + offset + start, len );
+			}
+
+			for (vt_ulong idx = 0; idx < len; idx++)
+				sums[start + idx] += acc[idx];
+		}
+	}
+}
+
+/**
+	\brief column_sums() for any other type, the lines are added in order.
+*/
+template<typename T>
+void column_sums(vt_double *sums, const T *const *lines, const vt_ulong num_lines
+							 , const vt_ulong offset, const vt_ulong num)
+{
+	for (vt_ulong idx = 0; idx < num; idx++)
+		sums[idx] = 0.0;
+
+	for (vt_ulong line = 0; line < num_lines; line++)
+	{
+		const T *src = lines[line] + offset;
+		for (vt_ulong idx = 0; idx < num; idx++)
+			sums[idx] += src[idx];
+	}
+}
+
+/**
+	\brief Add a line of pixels to a line of sums, acc[i] += src[i]
+*/
+inline void add_line(vt_double *acc, const vt_ushort *src, const vt_ulong num)
+{
+	kernels().add_u16_f64( acc, src, num );
+}
+
+/**
+	\brief add_line() for any other types.
+*/
+template<typename SumType, typename T>
+void add_line(SumType *acc, const T *src, const vt_ulong num)
+{
+	for (vt_ulong idx = 0; idx < num; idx++)
+		acc[idx] += src[idx];
+}
+
+/**
+	\brief Divide a line of values, dst[i] /= divisor
+*/
+inline void divide_line(vt_double *dst, const vt_ulong num, const vt_double divisor)
+{
+	kernels().div_f64( dst, num, divisor );
+}
+
+/**
+	\brief divide_line() for any other type.
+*/
+template<typename T>
+void divide_line(T *dst, const vt_ulong num, const vt_double divisor)
+{
+	for (vt_ulong idx = 0; idx < num; idx++)
+		dst[idx] /= divisor;
+}
+
+enum {
+	VT_BOX_RESEED = 256	//!< box_filter() outputs between full sums of the window
+};
+
+/**
+	\brief Box filter, dst[pos] is the mean of src[pos - span] to src[pos + span].
+
+	Only dst[span] to dst[num - span - 1] are written. The window sum is kept as a running
+	sum, adding the sample entering the window and subtracting the one leaving it. The sum
+	is taken afresh with line_sum() every VT_BOX_RESEED outputs so rounding error can't
+	build up along a long line. The running part is plain C++, so every output is the
+	same whichever kernels are in use.
+*/
+template<typename T, typename S>
+void box_filter(T *dst, const S *src, const vt_ulong num, const vt_ulong span)
+{
+	const vt_ulong total = 2*span + 1;
+	vt_double sum = 0.0;
+
+	for (vt_ulong pos = span; pos + span < num; pos++)
+	{
+		if ((pos - span) % VT_BOX_RESEED == 0)
+			sum = line_sum( src + pos - span, total );
+		else
+			sum += (vt_double) src[pos + span] - (vt_double) src[pos - span - 1];
+
+		dst[pos] = (T) (sum/total);
+	}
+}
+
+} // Vt namespace
+
+#endif // __CVTKERNELS_H__
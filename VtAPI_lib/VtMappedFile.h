@@ -0,0 +1,137 @@
+/** \file VtMappedFile.h
+
+	\brief A read view of a whole file through a memory mapping.
+
+	Recorded captures are replayed by parsing them where they lie: the file is mapped and its
+	pages are read straight from the system file cache, rather than copied into a heap buffer
+	first. Vt::CVtMappedFile owns the file, the mapping and the view, and releases them when
+	it is closed or destroyed.
+
+	The view is copy on write. The data can be handed to code which takes a writable pointer,
+	the pipe data for instance, without the file ever being changed.
+
+ * Copyright (c) 2013 by
+ * All Rights Reserved
+ * REVISIONS:
+ * $Log: $
+ *
+ */
+
+#ifndef __CVTMAPPEDFILE_H__
+#define __CVTMAPPEDFILE_H__
+
+#include <windows.h>
+#include <string>
+#include "VtSysdefs.h"
+#include "VtErrors.h"
+
+namespace Vt {
+
+/**
+	\brief A copy on write view of a file.
+*/
+class CVtMappedFile
+{
+	HANDLE		m_file;
+	HANDLE		m_mapping;
+	vt_byte	 *m_data;
+	vt_ulong	m_size;
+
+	CVtMappedFile(const CVtMappedFile &);
+	CVtMappedFile &operator=(const CVtMappedFile &);
+
+public:
+	CVtMappedFile() : m_file( INVALID_HANDLE_VALUE )
+									, m_mapping( NULL )
+									, m_data( NULL )
+									, m_size( 0 )
+	{}
+
+	virtual ~CVtMappedFile()
+	{
+		close();
+	}
+
+	/**
+	\brief Map a file.
+
+	\return false if the file can't be opened, is empty or can't be mapped
+	*/
+	vt_bool open(const std::string &fname)
+	{
+		close();
+
+		// the file is read once from start to end
+		m_file = ::CreateFile( fname.c_str()
+												 , GENERIC_READ
+												 , FILE_SHARE_READ
+												 , NULL
+												 , OPEN_EXISTING
+												 , FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN
+												 , NULL );
+		if (m_file == INVALID_HANDLE_VALUE)
+			return false;
+
+		DWORD high = 0;
+		DWORD size = ::GetFileSize( m_file, &high );
+
+		if (size == INVALID_FILE_SIZE || size == 0 || high != 0)
+		{
+			close();
+			return false;
+		}
+
+		m_mapping = ::CreateFileMapping( m_file, NULL, PAGE_WRITECOPY, 0, 0, NULL );
+		if (m_mapping == NULL)
+		{
+			close();
+			return false;
+		}
+
+		m_data = (vt_byte *) ::MapViewOfFile( m_mapping, FILE_MAP_COPY, 0, 0, 0 );
+		if (m_data == NULL)
+		{
+			close();
+			return false;
+		}
+
+		m_size = size;
+		return true;
+	}
+
+	/**
+	\brief Unmap the file, the data pointer is no longer valid.
+	*/
+	void close()
+	{
+		if (m_data != NULL)
+			::UnmapViewOfFile( m_data );
+
+		if (m_mapping != NULL)
+			::CloseHandle( m_mapping );
+
+		if (m_file != INVALID_HANDLE_VALUE)
+			::CloseHandle( m_file );
+
+		m_file		= INVALID_HANDLE_VALUE;
+		m_mapping = NULL;
+		m_data		= NULL;
+		m_size		= 0;
+	}
+
+	//! the file's contents, NULL if no file is mapped
+	vt_byte *data() const
+	{
+		return m_data;
+	}
+
+	//! the size of the file in bytes
+	vt_ulong size() const
+	{
+		return m_size;
+	}
+};
+
+} // Vt namespace
+
+#endif // __CVTMAPPEDFILE_H__
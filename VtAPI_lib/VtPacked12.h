@@ -0,0 +1,454 @@
+/** \file VtPacked12.h
+
+	\brief Packed 12-bit pixel storage for raw and intermediate images.
+
+	The pano, ceph and HDS sensors all deliver 12-bit samples (see CHIP_DATA_MASK) but the
+	images hold them as 16-bit vt_ushort values. The Vt::CVtPacked12Image class stores the same
+	data with two pixels in three bytes, a quarter less memory, memory bandwidth and disk space.
+
+	The packed layout is little endian, pixel p0 followed by pixel p1 is held as
+
+		- byte 0  p0 bits 0..7
+		- byte 1  p0 bits 8..11 in the low nibble, p1 bits 0..3 in the high nibble
+		- byte 2  p1 bits 4..11
+
+	Each storage line of the source image (a row for a row-major image, a column for a
+	column-major image) is packed separately so that lines can be unpacked on their own.
+	Packed raw files are simply the packed lines one after another, in the same pixel order
+	as the raw files the APIs save, i.e. a column at a time.
+
+ * Copyright (c) 2013 by
+ * All Rights Reserved
+ * REVISIONS:
+ * $Log: $
+ *
+ */
+
+#ifndef __CVTPACKED12_H__
+#define __CVTPACKED12_H__
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include "VtSysdefs.h"
+#include "VtErrors.h"
+#include "VtImage.h"
+
+#ifdef VT_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Vt {
+
+//*********************************************************************
+// CONSTANTS
+//*********************************************************************
+enum {
+	PACKED12_MASK			= 0x0fff	//!< the bits kept for each pixel
+	, PACKED12_GROUP	= 8				//!< pixels handled by one pass of the SIMD kernels
+	, PACKED12_GROUP_BYTES = 12	//!< packed size of a group
+};
+
+//! Extension used for packed 12-bit raw files
+#define PACKED12_EXT ".p12"
+
+/**
+	\brief Number of bytes needed to hold num pixels in packed form, an odd
+	pixel count is padded to a whole byte triple.
+*/
+inline vt_ulong packed12_bytes(const vt_ulong num)
+{
+	return ((num + 1)/2)*3;
+}
+
+/**
+	\brief The packed file name for a raw file name, the extension is replaced by PACKED12_EXT
+*/
+inline std::string packed12_fname(const std::string &fname)
+{
+	std::string::size_type dot = fname.find_last_of( '.' );
+	std::string::size_type sep = fname.find_last_of( "\\/" );
+
+	if (dot == std::string::npos || (sep != std::string::npos && dot < sep))
+		return fname + PACKED12_EXT;
+
+	return fname.substr( 0, dot ) + PACKED12_EXT;
+}
+
+/**
+	\brief Is fname a packed raw file
+*/
+inline vt_bool is_packed12_fname(const std::string &fname)
+{
+	const std::string ext( PACKED12_EXT );
+
+	return fname.size() > ext.size() && fname.compare( fname.size() - ext.size(), ext.size(), ext ) == 0;
+}
+
+//*********************************************************************
+// KERNELS
+//*********************************************************************
+/**
+	\brief Pack num 12-bit pixels from src into dst.
+
+	Only the low 12 bits of each pixel are kept. dst must hold packed12_bytes(num) bytes,
+	nothing beyond that is written.
+*/
+inline void pack12(vt_byte *dst, const vt_ushort *src, const vt_ulong num)
+{
+	vt_ulong idx = 0;
+
+#ifdef VT_SSE2
+	const __m128i mask   = _mm_set1_epi16( PACKED12_MASK );
+	const __m128i madd   = _mm_set_epi16( 1 << 12, 1, 1 << 12, 1, 1 << 12, 1, 1 << 12, 1 );
+	const __m128i lo_dw  = _mm_set_epi32( 0, -1, 0, -1 );
+	const __m128i lo_48  = _mm_set_epi32( 0, 0, 0xffff, -1 );
+
+	for (; idx + PACKED12_GROUP <= num; idx += PACKED12_GROUP, dst += PACKED12_GROUP_BYTES)
+	{
+		__m128i pix = _mm_and_si128( _mm_loadu_si128( (const __m128i *) (src + idx) ), mask );
+
+		// p0 + p1*4096 -> four 24 bit values, one per dword
+		__m128i dw = _mm_madd_epi16( pix, madd );
+
+		// close the gap between the dwords of each 64 bit lane -> 48 bits per lane
+		__m128i q  = _mm_or_si128( _mm_and_si128( dw, lo_dw ), _mm_srli_epi64( _mm_andnot_si128( lo_dw, dw ), 8 ) );
+
+		// move the high lane down next to the low lane -> 12 contiguous bytes
+		__m128i r  = _mm_or_si128( _mm_and_si128( q, lo_48 ), _mm_slli_si128( _mm_srli_si128( q, 8 ), 6 ) );
+
+		_mm_storel_epi64( (__m128i *) dst, r );
+		*(vt_uint32 *) (dst + 8) = (vt_uint32) _mm_cvtsi128_si32( _mm_srli_si128( r, 8 ) );
+	}
+#endif
+
+	for (; idx + 2 <= num; idx += 2, dst += 3)
+	{
+		const vt_ushort p0 = src[idx] & PACKED12_MASK;
+		const vt_ushort p1 = src[idx + 1] & PACKED12_MASK;
+
+		dst[0] = (vt_byte) p0;
+		dst[1] = (vt_byte) ((p0 >> 8) | (p1 << 4));
+		dst[2] = (vt_byte) (p1 >> 4);
+	}
+
+	if (idx < num)
+	{
+		const vt_ushort p0 = src[idx] & PACKED12_MASK;
+
+		dst[0] = (vt_byte) p0;
+		dst[1] = (vt_byte) (p0 >> 8);
+		dst[2] = 0;
+	}
+}
+
+/**
+	\brief Unpack num 12-bit pixels from src into dst.
+
+	src must hold packed12_bytes(num) bytes, nothing beyond that is read.
+*/
+inline void unpack12(vt_ushort *dst, const vt_byte *src, const vt_ulong num)
+{
+	vt_ulong idx = 0;
+
+#ifdef VT_SSE2
+	const __m128i lo_48  = _mm_set_epi32( 0xffff, -1, 0xffff, -1 );
+	const __m128i lo_24  = _mm_set_epi32( 0, 0xffffff, 0, 0xffffff );
+	const __m128i mask   = _mm_set1_epi32( PACKED12_MASK );
+
+	for (; idx + PACKED12_GROUP <= num; idx += PACKED12_GROUP, src += PACKED12_GROUP_BYTES)
+	{
+		// 12 bytes, read as 8 + 4 so nothing past the group is touched
+		__m128i r  = _mm_or_si128( _mm_loadl_epi64( (const __m128i *) src )
+														 , _mm_slli_si128( _mm_cvtsi32_si128( *(const vt_int *) (src + 8) ), 8 ) );
+
+		// 6 bytes to each 64 bit lane
+		__m128i q  = _mm_and_si128( _mm_unpacklo_epi64( r, _mm_srli_si128( r, 6 ) ), lo_48 );
+
+		// 24 bits to each dword
+		__m128i dw = _mm_or_si128( _mm_and_si128( q, lo_24 ), _mm_slli_epi64( _mm_srli_epi64( q, 24 ), 32 ) );
+
+		// split each dword into its two pixels
+		__m128i pix = _mm_or_si128( _mm_and_si128( dw, mask ), _mm_slli_epi32( _mm_srli_epi32( dw, 12 ), 16 ) );
+
+		_mm_storeu_si128( (__m128i *) (dst + idx), pix );
+	}
+#endif
+
+	for (; idx + 2 <= num; idx += 2, src += 3)
+	{
+		dst[idx]		 = (vt_ushort) (src[0] | ((src[1] & 0x0f) << 8));
+		dst[idx + 1] = (vt_ushort) ((src[1] >> 4) | (src[2] << 4));
+	}
+
+	if (idx < num)
+	{
+		dst[idx] = (vt_ushort) (src[0] | ((src[1] & 0x0f) << 8));
+	}
+}
+
+//*********************************************************************
+// PACKED IMAGE
+//*********************************************************************
+/**
+	\brief An image of 12-bit pixels held two pixels to three bytes.
+
+	The packed image keeps the geometry and layout of the image it was packed from. It is
+	not directly addressable - lines are unpacked on demand with unpack_line() or the whole
+	image with unpack(). The storage comes from a CVtImageAllocator so packed frames can be
+	pooled or file backed in the same way as ordinary images.
+*/
+class CVtPacked12Image : public CVtImageBaseClass
+{
+private:
+	vt_byte						*m_data;
+	vt_ulong					 m_line_bytes;
+	CVtImageAllocator *m_alloc;
+
+	void allocate(const vt_uint width, const vt_uint height, const LAYOUT layout)
+	{
+		deallocate();
+
+		m_width			 = width;
+		m_height		 = height;
+		m_layout		 = layout;
+		m_line_bytes = packed12_bytes( line_length() );
+
+		if (m_line_bytes*num_lines() > 0)
+			m_data = (vt_byte *) m_alloc->allocate( m_line_bytes, num_lines(), 1 );
+	}
+
+	void deallocate()
+	{
+		if (m_data != NULL)
+			m_alloc->deallocate( m_data, m_line_bytes, num_lines(), 1 );
+
+		m_data = NULL;
+	}
+
+public:
+	/**
+	 * Construct an empty packed image
+	 */
+	CVtPacked12Image(CVtImageAllocator & alloc = heap_allocator())
+		: CVtImageBaseClass(0, 0)
+		, m_data( NULL )
+		, m_line_bytes( 0 )
+		, m_alloc( &alloc ) {}
+
+	/**
+	 * Construct an unfilled packed image of the given geometry
+	 */
+	CVtPacked12Image(vt_uint width, vt_uint height, LAYOUT layout, CVtImageAllocator & alloc = heap_allocator())
+		: CVtImageBaseClass(0, 0)
+		, m_data( NULL )
+		, m_line_bytes( 0 )
+		, m_alloc( &alloc )
+	{
+		allocate( width, height, layout );
+	}
+
+	/**
+	 * Construct by packing an image
+	 */
+	explicit CVtPacked12Image(const CVtImage<vt_ushort> & im, CVtImageAllocator & alloc = heap_allocator())
+		: CVtImageBaseClass(0, 0)
+		, m_data( NULL )
+		, m_line_bytes( 0 )
+		, m_alloc( &alloc )
+	{
+		pack( im );
+	}
+
+	virtual ~CVtPacked12Image()
+	{
+		deallocate();
+	}
+
+	/**
+	 * Pack an image, the packed image takes the geometry and layout of im
+	 */
+	void pack(const CVtImage<vt_ushort> & im)
+	{
+		allocate( im.width(), im.height(), im.layout() );
+
+		for (vt_uint line = 0; line < num_lines(); line++)
+			pack12( m_data + line*m_line_bytes, im[line], line_length() );
+	}
+
+	/**
+	 * Unpack into im, im must have this image's layout and is resized if required
+	 */
+	void unpack(CVtImage<vt_ushort> & im) const
+	{
+		Vt_precondition( im.layout() == layout(), "CVtPacked12Image::unpack - layout mismatch" );
+
+		if (im.width() != width() || im.height() != height())
+			im.resize( width(), height() );
+
+		for (vt_uint line = 0; line < num_lines(); line++)
+			unpack12( im[line], m_data + line*m_line_bytes, line_length() );
+	}
+
+	/**
+	 * Unpack into a newly allocated image - the caller owns the result
+	 */
+	CVtImage<vt_ushort> * unpack(CVtImageAllocator & alloc = uninit_allocator()) const
+	{
+		CVtImage<vt_ushort> *im = new CVtImage<vt_ushort>( width(), height(), layout(), alloc );
+
+		for (vt_uint line = 0; line < num_lines(); line++)
+			unpack12( (*im)[line], m_data + line*m_line_bytes, line_length() );
+
+		return im;
+	}
+
+	/**
+	 * Unpack a single storage line, out must hold line_length() pixels
+	 */
+	void unpack_line(const vt_uint line, vt_ushort *out) const
+	{
+		Vt_precondition( line < num_lines(), "CVtPacked12Image::unpack_line - line out of range" );
+
+		unpack12( out, m_data + line*m_line_bytes, line_length() );
+	}
+
+	/**
+	 * Pack a single storage line, in must hold line_length() pixels
+	 */
+	void pack_line(const vt_uint line, const vt_ushort *in)
+	{
+		Vt_precondition( line < num_lines(), "CVtPacked12Image::pack_line - line out of range" );
+
+		pack12( m_data + line*m_line_bytes, in, line_length() );
+	}
+
+	/**
+	 * Packed bytes per storage line
+	 */
+	vt_ulong line_bytes() const { return m_line_bytes; }
+
+	/**
+	 * Total packed size in bytes
+	 */
+	virtual vt_ulong data_bytes() const { return m_line_bytes*num_lines(); }
+
+	/**
+	 * Write the packed data to fp and release the storage
+	 */
+	virtual vt_bool spill(FILE *fp)
+	{
+		if (m_spilled || m_data == NULL)
+			return false;
+
+		if (fwrite( m_data, 1, data_bytes(), fp ) != data_bytes() || fflush( fp ) != 0)
+			return false;
+
+		m_alloc->deallocate( m_data, m_line_bytes, num_lines(), 1 );
+		m_data		= NULL;
+		m_spilled = true;
+
+		return true;
+	}
+
+	/**
+	 * Reallocate the storage and read back the data written by spill()
+	 */
+	virtual vt_bool reload(FILE *fp)
+	{
+		if (!m_spilled)
+			return true;
+
+		vt_byte *data = (vt_byte *) m_alloc->allocate( m_line_bytes, num_lines(), 1 );
+
+		rewind( fp );
+		if (fread( data, 1, data_bytes(), fp ) != data_bytes())
+		{
+			m_alloc->deallocate( data, m_line_bytes, num_lines(), 1 );
+			return false;
+		}
+
+		m_data		= data;
+		m_spilled = false;
+
+		return true;
+	}
+
+	/**
+	 * Raw access to the packed data
+	 */
+	const vt_byte * data() const { return m_data; }
+
+	/**
+	 * Write the packed lines to a raw file
+	 */
+	void save(const std::string &fname) const
+	{
+		FILE *fpout = fopen( fname.c_str(), "wb" );
+
+		if (fpout == NULL)
+		{
+			Vt_fail( "CVtPacked12Image::save - Failed to open output file\n" );
+		}
+
+		fwrite( m_data, 1, data_bytes(), fpout );
+
+		fclose( fpout );
+	}
+
+	/**
+	 * Write a raw file whose lines are file_layout's lines of the image, the columns for
+	 * COL_MAJOR, whatever the layout the image is held in
+	 */
+	void save(const std::string &fname, const LAYOUT file_layout) const
+	{
+		if (file_layout == layout())
+		{
+			save( fname );
+			return;
+		}
+
+		CVtImage<vt_ushort> im( width(), height(), layout(), uninit_allocator() );
+		unpack( im );
+		im.relayout( file_layout );
+
+		CVtPacked12Image( im ).save( fname );
+	}
+
+	/**
+	 * Read a raw packed file of lines of line_len pixels. The number of lines is
+	 * taken from the file size, the lines become columns for a column-major image.
+	 */
+	vt_bool load(const std::string &fname, const vt_uint line_len, const LAYOUT layout)
+	{
+		FILE *fpin = fopen( fname.c_str(), "rb" );
+
+		if (fpin == NULL)
+			return false;
+
+		fseek( fpin, 0, SEEK_END );
+		const vt_ulong fsize = ftell( fpin );
+		fseek( fpin, 0, SEEK_SET );
+
+		const vt_uint num = fsize/packed12_bytes( line_len );
+
+		if (layout == ROW_MAJOR)
+			allocate( line_len, num, layout );
+		else
+			allocate( num, line_len, layout );
+
+		const vt_ulong nread = fread( m_data, 1, data_bytes(), fpin );
+
+		fclose( fpin );
+
+		return nread == data_bytes();
+	}
+
+private:
+	CVtPacked12Image(const CVtPacked12Image &);
+	const CVtPacked12Image & operator = (const CVtPacked12Image &);
+};
+
+} // Vt namespace
+
+#endif // __CVTPACKED12_H__
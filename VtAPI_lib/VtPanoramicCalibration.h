@@ -1,1242 +1,1677 @@
-/** \file VTPanoramicCalibration.h
-
-	This file holds all the routines require for pano and ceph calibration.
-
-	Currently the pano and ceph systems use a flat field removal calibration approach based on 
-	gain and offset calculation. 
-
-	The calibration class contains the routines for a calibration run, and for calibration application.
-
-	@see Vt::CVtPanoramicCalibration for more details.
-
- * Copyright (c) 2013 by
- * All Rights Reserved
- * REVISIONS: 
- * $Log: VtPanoramicCalibration.h,v $
- * Revision 1.3  2013/05/27 17:41:57  david
- * V3
- *
- * Revision 1.2  2013/05/27 12:04:18  david
- * Ver 1
- *
- */
-
-#ifndef __CVTPANORAMICCALIBRATION_H__
-#define __CVTPANORAMICCALIBRATION_H__
-
-
-
-//*********************************************************************
-// INCLUDES
-//*********************************************************************
-
-namespace Vt {
-
-/**
- \brief Calculate the mean of an image
-
- \param data a two dimensional data set which contains the image which we wish to obtain the mean values from
-*/
-template<typename T1> 
-vt_double mean(const T1** data, const vt_int width, const vt_int height)
-{
-  vt_double			avg;
-	vt_longdouble sum=0;
-	
-	for (vt_int row=0; row<height; row++)
-	{
-		T1 *rowptr = data[row];
-		for (vt_int col=0; col<width; col++)
-		{
-			sum += rowptr[col];
-		}
-	}
-	return avg = (vt_double)sum/((vt_double)width*height );
-}
-
-/**
-   Calculate the means of the rows on an image.
-
-	\param row_means The row mean values which are returned.
-	\param data			 The 2-dimensional input data.
-	\par 
-	The input data is assumed to be a vector of pointers to vectors of type T2. Consequently
-	individual elements of the data can be acccesed via 
-
-		- data[row][col]
-	
-	\param width		The number of columns in the two d input data
-	\param height		The number of rows in the two d intput data
- */
-
-template<typename T1, typename T2> 
-vt_double row_mean(T1 *row_means, const T2 **data, const vt_int width, const vt_int height)
-{
-	vt_longdouble tot_sum=0;
-	
-	for (vt_int row=0; row<height; row++)
-	{
-		vt_double	 	sum	=	0;
-		const T2	*rowptr = data[row];
-
-		for (vt_int col=0; col<width; col++)
-		{
-			sum += rowptr[col];
-		}
-		row_means[row] = sum/(vt_double)width;
-		
-		// add to total for overall mean
-		tot_sum += sum;
-	}
-
-	return tot_sum/((vt_double)width*height);
-}
-
-
-template<typename T1, typename T2> 
-vt_double col_mean(T1 *col_means, const T2 **data, const vt_int width, const vt_int height)
-{
-	vt_longdouble tot_sum=0;
-
-	for (vt_int col=0; col<width; col++)	
-	{
-		vt_double		sum	=	0;
-		for (vt_int row=0; row<height; row++)
-		{
-			sum += data[row][col];
-		}
-		col_means[col] = sum/(vt_double)height;
-		
-		// add to total for overall mean
-		tot_sum += sum;
-	}
-
-	return tot_sum/((vt_double)width*height);
-}
-
-template<typename T1, typename T2> 
-vt_double col_mean(T1 *col_means,const T2 **data, const vt_int width, const vt_int row_start, const vt_int row_end)
-{
-	vt_longdouble tot_sum=0;
-
-	vt_double cnt = row_end - row_start;
-	for (vt_int col=0; col<width; col++)	
-	{
-		vt_double		sum	=	0;
-		for (vt_int row=row_start; row<row_end; row++)
-		{
-			sum += data[row][col];
-		}
-		col_means[col] = sum/cnt;
-		
-		// add to total for overall mean
-		tot_sum += sum;
-	}
-
-	return tot_sum/((vt_double)width*cnt);
-}
-
-
-template<typename T1, typename T2> 
-vt_double row_mean(T1 *row_means,const T2 **data, const vt_int width, const vt_int row_start, const vt_int row_end)
-{
-	vt_longdouble tot_sum=0;
-
-	for (vt_int row=row_start; row<row_end; row++)
-	{
-		vt_double		sum	=	0;
-		for (vt_int col=0; col<width; col++)	
-		{
-			sum += data[row][col];
-		}
-		row_means[row] = sum/width;
-		
-		// add to total for overall mean
-		tot_sum += sum;
-	}
-	vt_double cnt = row_end - row_start;
-	return tot_sum/((vt_double)width*cnt);
-}
-
-
-
-/**
-  \image html vatech.jpg
-
-  \par REQUIREMENTS: 
-  
-	This is class which implements the panoramic and cephelometric calibration functions.
-
-	The functions may be thought of as consisting of two distince groups those realated to the calculation of the calibration data and 
-	those related to the applicaton of the calibration process to acquired images. The former set consist of routines;-
-		
-		-# for the acquisition of source data required for calibration
-
-		-# for calculation and storage of the calibration data.
-
-
-	\todo
-	Merge the CVtHalfLineCalib and the CVtLineCalib classes.
-	The CVtHalfLineCalib calibration class was created to solve a problem with asymetric x-ray power in the panoramic
-	system i.e. two separate calibrations were applied on different sides of the panoramic scan. However
- */
-
-#define DF_THRESH 5.0
-template<typename ImageType, typename CoefType> 
-class CVtHalfLineCalib
-{
-private:
-	typedef 	ImageType IM_TYPE;
-	typedef 	CoefType  COEF_TYPE;
-
-	CVtImage<ImageType> m_bright;
-	CVtImage<ImageType> m_dark;
-
-	vt_ulong  m_chip_height;
-	vt_ulong  m_numChips;
-
-	CoefType *m_darkC;
-	CoefType *m_brightC;
-	CoefType *m_coef;
-	CoefType *m_bias;
-	vt_ulong m_bias_width;
-
-	vt_bool   m_initialised;
-	vt_bool   m_ceph_mode;
-	const vt_double m_max_coef;
-
-	const vt_bool m_smooth;
-public:
-	CoefType  m_pedestal;
-
-  /**
-	\enum SMOOTH_SPAN
-	\brief When the calibration coefficients are recalculated there is the option to smooth the resultant
-	coefficients. i.e. to minimise the difference in applied calibration
-	*/
-	enum {
-		SMOOTH_SPAN = 5
-		, TOTAL_SPAN = 2*SMOOTH_SPAN + 1
-		, DEFAULT_PEDESTAL = 1000
-		, MAX_COEF				 = 4
-		, EDGE_SKIP				 = 400
-		, CENTRAL_EXT			 = 500
-		};
-
-  /**
-   * Constructor
-   */
-  CVtHalfLineCalib(vt_ulong height
-							, vt_ulong numChips ) 
-									: m_darkC( NULL )
-									, m_brightC( NULL )
-									, m_coef( NULL )
-									, m_chip_height( height )
-									, m_numChips( numChips )
-									, m_initialised( false )
-									, m_pedestal( (CoefType)DEFAULT_PEDESTAL )
-									, m_bias( NULL )
-									, m_max_coef( MAX_COEF )
-									, m_smooth( false )
-	{}
-
-	virtual ~CVtHalfLineCalib() 
-	{
-		if (m_darkC != NULL)
-		{
-			delete m_darkC;
-		}
-		if (m_brightC != NULL)
-		{
-			delete m_brightC;
-		}
-		if (m_coef != NULL)
-		{
-			delete m_coef;
-		}
-		if (m_bias != NULL)
-		{
-			delete m_bias;
-		}
-	}
-
-	///
-	// smooth
-	//
-	// Produces a smoothed version of the input vector
-	// Returns smoothed version as a pointer it is the calling functions responsibility to remove
-	// this vector.
-	//
-	CoefType * smooth(CoefType *vec, const vt_ulong length)
-	{
-		CoefType * smth_vec = new CoefType[length]; //larger than require
-
-		memset( smth_vec, 0 , sizeof( smth_vec[0] )*length );
-
-		// smooth 
-		vt_double sum				 =  0;
-		vt_long  smooth_span = SMOOTH_SPAN;
-		for( vt_ulong pos = smooth_span; pos < length - smooth_span; pos++ )
-		{
-			if (smooth_span == pos) // first pixel
-			{
-				for( vt_long idx = -smooth_span; idx < smooth_span ; idx++)
-				{
-					sum += vec[pos+idx];
-				}
-
-				// deal with beginning
-				CoefType mn = sum/TOTAL_SPAN;
-				for(idx = 0; idx < smooth_span ; idx++)
-				{
-					smth_vec[idx] = mn;
-				}
-			}
-			else
-			{
-				vt_ulong last_start = pos - smooth_span - 1;
-				vt_ulong new_end    = pos + smooth_span;
-
-				sum -= vec[last_start];
-				sum += vec[new_end];
-			}
-
-			smth_vec[pos] = sum/TOTAL_SPAN;
-
-			if (length - smooth_span - 1 == pos) // last pixel
-			{
-				// deal with end - jut tidy up last few elements of the vector
-				CoefType mn = sum/TOTAL_SPAN; // this will fill the last
-																			// few entries with the last
-																			// valid smoothed entry
-				for(vt_ulong idx = pos+1; idx < length; idx++)
-				{
-					smth_vec[idx] = mn;
-				}
-			}
-		}
-
-		// deal with the
-		return smth_vec;
-	}
-
-	///
-	// note set bright and dark functions merely replace the dark and bright frames
-	// whereas the update_xxxx function replace the frame and recalculate the coefficients
-	// i.e. the update functions are equivalent to a set and a recalc.
-	//
-	void set_bright(const CVtImage<ImageType>& bright_frame)
-	{
-		m_bright = bright_frame;
-	}
-
-	///
-	// set_bright frame
-	//
-	void set_dark(const CVtImage<ImageType>& dark_frame)
-	{
-		m_dark   = dark_frame;
-	}
-
-	///
-	// calculate bias correction
-	//
-	void set_bias(const vt_double *bias, const vt_ulong width)
-	{
-		m_bias_width = width;
-		if (m_bias != NULL)
-			delete m_bias;
-
-		m_bias = (vt_double *) bias;
-	}
-
-	//
-	// default zero bias
-	//
-	void calc_bias(const vt_ulong width)
-	{
-		m_bias_width = width;
-		if (m_bias != NULL)
-			delete m_bias;
-
-		m_bias = new vt_double [m_bias_width];
-		memset( m_bias, 0, m_bias_width*sizeof( m_bias[0] ) );
-	}
-
-	///
-	// access functions
-	//
-	CVtImage<ImageType>& get_bright()
-	{
-		return m_bright;
-	}
-
-	/**
-	\brief Access function for the dark frame.
-	\return the calibration dark frame.
-	*/
-	CVtImage<ImageType>& get_dark()
-	{
-			return m_dark;
-	}
-	/**
-	\brief Add a new bright frame to the calibration 
-	This function replaces the current bright frame with a new one.
-	
-	\param bright_frame the new bright frame.
-
-	*/
-	void update_bright(const CVtImage<ImageType>& bright_frame)
-	{
-		recalc(bright_frame, m_dark);
-	} 
-
-	void update_dark(const CVtImage<ImageType>& dark_frame)
-	{
-		recalc(m_bright, dark_frame);
-	} 
-
-	/**
-	\brief Recalculate the calibration coefficients.
-
-	Uses a dark fram and a bright frame to 
-
-	*/
-	void recalc()
-	{
-		recalc( m_bright, m_dark );
-	}
-
-	void recalc(const CVtImage<ImageType>& BrightFrame, const CVtImage<ImageType>& DarkFrame) 
-	{
-		m_bright = BrightFrame;
-		m_dark   = DarkFrame;
-
-		if (m_bright.height() != m_dark.height() )
-			Vt_fail( "Invalid dark bright frames" );
-
-		vt_ulong height = m_bright.height();
-
-		// allocate coefficants
-		if (m_coef != NULL)
-			delete m_coef;
-		
-		m_coef = new CoefType[height];
-		memset( m_coef, 0, sizeof( m_coef[0])*height  );
-
-		// note the start row is dependent on the API type
-
-		CVtAPI::API_TYPE api_type = GetAPI().get_api_type();
-		vt_ulong start_row = 0;
-		vt_ulong end_row   = 0;
-
-		if (api_type == CVtAPI::PANO_API)
-		{
-			start_row = m_chip_height;
-			end_row   = m_numChips*m_chip_height;
-		}
-		else
-		{
-			start_row =  0; // ceph mode has actual data in 'C' hence calculation can start from
-											// row 0
-			end_row   = m_numChips*m_chip_height;
-		}
-
-		// allocate dark field
-		if (m_darkC != NULL)
-			delete m_darkC;
-
-		m_darkC = new CoefType[height];
-		
-		memset( m_darkC, 0, sizeof( m_darkC[0])*height  );
-
-		vt_double mean_dark	= row_mean( m_darkC, (const ImageType **) m_dark.lines(), m_dark.width(), start_row, end_row );
-		
-		printf( "mean dark level %lf ", mean_dark );
-
-		// smooth dark values
-		if (m_smooth)
-		{
-			CoefType *smth_dark = smooth( m_darkC, end_row );
-
-			delete m_darkC;
-			m_darkC = smth_dark;
-
-			// fix gap
-			m_darkC[m_chip_height-1]   = m_darkC[m_chip_height-2] + (m_darkC[m_chip_height] - m_darkC[m_chip_height-2])/2;
-			m_darkC[2*m_chip_height-1] = m_darkC[2*m_chip_height-2] + (m_darkC[2*m_chip_height] - m_darkC[2*m_chip_height-2])/2;
-		}
-
-		// allocate bright field
-		if (m_brightC != NULL)
-			delete m_brightC;
-
-		m_brightC	= new CoefType[height];
-		
-		memset( m_brightC, 0, sizeof( m_darkC[0])*height  );
-		vt_double mean_bright = row_mean( m_brightC, (const ImageType **)  m_bright.lines(), m_bright.width(), start_row, end_row );
-
-		printf( "mean bright level %lf\n", mean_bright );
-
-		vt_double	mean_signal = (mean_bright - mean_dark);
-
-		printf( "mean signal level %lf\n", mean_signal );
-
-		// smooth bright values
-		if (m_smooth)
-		{
-			CoefType *smth_bright = smooth( m_brightC, end_row );
-
-			delete m_brightC;
-			m_brightC = smth_bright;
-
-			// gap fix
-			m_brightC[m_chip_height-1]   = m_brightC[m_chip_height-2] + (m_brightC[m_chip_height] - m_brightC[m_chip_height-2])/2;
-			m_brightC[2*m_chip_height-1] = m_brightC[2*m_chip_height-2] + (m_brightC[2*m_chip_height] - m_brightC[2*m_chip_height-2])/2;
-		}
-
-
-		///
-		// main calculation loop
-		//
-		if (mean_signal != 0)
-		{
-			vt_double *dfvec = new vt_double [ height ];
-			vt_double dfsum   = 0;
-			vt_double dfsumsq = 0;
-			vt_ulong  dfcnt   = 0;
-			//						chip height     total_height
-			for (vt_int row=start_row+1; row<end_row; row++)
-			{
-				const vt_double eps = 0.000001;
-
-				vt_double diff = m_brightC[row] - m_darkC[row];
-
-				if (diff > eps)
-				{
-					m_coef[row] = mean_signal/diff;
-
-					// sanity check coefs
-					if (m_coef[row] > m_max_coef)
-						m_coef[row] = 0.0;
-
-					if (row > 0)
-					{
-						dfvec[row] = fabs(m_coef[row-1] - m_coef[row]);
-						dfsum += dfvec[row];
-						dfsumsq += dfvec[row]*dfvec[row];
-						dfcnt++;
-					}
-				}
-				else
-				{
-					m_coef[row] = 0.0;
-				}
-			}
-
-			// sanity check coefs some more
-			if (dfcnt > 0 )
-			{
-				vt_double df_mean = dfsum/dfcnt;
-				vt_double df_std  = sqrt( dfsumsq/dfcnt - df_mean*df_mean );	
-				for (row=start_row+1; end_row<height; row++)
-				{
-					if (dfvec[row] > 3*df_std)
-					{
-						m_coef[row] = 0.0;
-					}
-				}
-			}
-			if (dfvec != NULL)
-			{
-				delete dfvec;
-			}
-		}
-		else
-		{
-			Vt_fail( "Invalid dark or bright frame" );
-		}
-		m_initialised = true;
-	}
-
-
-	void gap_fixAB(ImageType **imptr, const vt_ulong pos, const vt_ulong width)
-	{
-		srand( (unsigned)time( NULL ) );
-		//
-		// fix gap BC
-		//
-		vt_long  plus  = 7; 
-		vt_long  minus = 2; 
-    ImageType *VecP		= imptr[pos+plus];
-    ImageType *VecM		= imptr[pos-minus];
-
-		vt_double mult_inc  = 1.0/(plus + minus);
-		vt_double mult_fac  = mult_inc;
-		for (vt_ulong row=pos-minus; row<pos+plus; row++, mult_fac += mult_inc)
-		{
-			// note not bounds checking here - needs caution
-			ImageType *Vec = imptr[row];
-			for (vt_ulong col=0; col<width; col++)
-			{
-				vt_double new_val = VecM[col] + mult_fac*(VecP[col] - VecM[col]);
-				Vec[col]					= new_val;
-			}
-		}
-	}
-
-	void gap_fix(ImageType **imptr, const vt_ulong pos, const vt_ulong width)
-	{
-		//
-		// fix gap 
-		//
-    ImageType *VecP1		= imptr[pos];
-    ImageType *Vec			= imptr[pos-1];
-    ImageType *VecM1		= imptr[pos-2];
-
-		for (vt_ulong col=0; col<width; col++)
-		{
-			Vec[col] = VecM1[col] + (VecP1[col] - VecM1[col])/2;
-		}
-	}
-
-	/**
-	\brief calculate the offset between to chips, the a and b chip
-
-	The calibration procedure is not perfect, due to dark current drift after application of the 
-	calibration the 
-
-	/
-	 This merely take the average difference of a few lines above and below the chip cut line
-	*/
-	const CoefType ABoffset( const vt_ulong ab_split, CVtImage<ImageType> &out )
-	{
-		CVtABDiff<ImageType> ab_diff(  ab_split );
-
-		return ab_diff( out );
-	}
-
-	/**
-	\brief calculate the offset between to BC
-
-	The 
-	*/
-	const CoefType BCoffset( ImageType **imptr, const vt_ulong width )
-	{
-		vt_long sum = 0;
-		ImageType *prow1 = imptr[2*m_chip_height-2];
-		ImageType *prow2 = imptr[2*m_chip_height+1];
-	
-		for(vt_ulong col=0; col < width; col++)
-		{
-			vt_long d1 = prow1[col];
-			vt_long d2 = prow2[col];
-
-			sum += d2 - d1;
-		}
-		return sum/(CoefType)width;
-	}
-
-	/**
-	\brief The main calibration interface for the panoramic and ceph system
-
-	The function applies a gain and offset calibration to the panoramic and ceph images.
-
-	\param  InFrame the input image
-	\param  OutFrame the calibrated output image
-	\note - these should be seperate images - this function doesn't guarentee
-	in place operation
-	*/
-	void operator () (const CVtImage<ImageType>& InFrame
-										, CVtImage<ImageType>& OutFrame
-									 )
-	{
-		if (!m_initialised)
-			return;
-
-		///
-		// apply calibration
-		//
-		vt_ulong				width    = InFrame.width();	
-		const ImageType **inptr  = (const ImageType **)InFrame.lines();
-		ImageType				**outptr = OutFrame.lines();
-
-		///
-		// apply calibration
-		//
-		vt_bool c1to2_done = false;
-		vt_bool c2to3_done = false;
-		CoefType offset		 = 0.0;
-
-		const vt_ulong scope     = 2;
-		const vt_ulong overshoot = CVtRectPairs::RECT_SIZE + CVtRectPairs::OFFSET + 2;
-
-		for (vt_long row=m_chip_height*m_numChips-1; row>=0; row--)
-		{
-      const ImageType *InVec	= inptr[row];
-      const CoefType   dark   = m_darkC[row];
-			const CoefType   coef   = m_coef[row];
-
-      ImageType *OutVec		= outptr[row];
-      
-			// calculate offsets
-			if (row == m_chip_height-overshoot && !c1to2_done)
-			{
-				if ( GetAPI().get_api_type() == CVtAPI::PANO_API )
-				{
-					offset	= 0;
-				}
-				else
-				{
-					// note we skip a larger boundary with initial tile
-					offset		 = ABoffset( m_chip_height, OutFrame );
-				}
-
-				row				 = m_chip_height;  // reset row to boundary
-				c1to2_done = true;
-			}
-			else if (row == 2*m_chip_height-overshoot && !c2to3_done)
-			{
-				offset = BCoffset( outptr, width );
-
-				row				 = 2*m_chip_height;  // reset row to boundary
-				c2to3_done = true;
-			}
-			CoefType actual_offset = m_pedestal + offset;
-
-			for (vt_ulong col=0; col<width; col++)
-			{
-				CoefType out = (((CoefType) InVec[col] - dark)*coef) + actual_offset;
-				if (out<0)
-				{
-					OutVec[col] = (ImageType)0.0;
-				}
-				else if (out >= USHRT_MAX)
-				{
-					OutVec[col] = USHRT_MAX;
-				}
-				else
-				{
-					OutVec[col] = (ImageType) out;
-				}
-			}
-		}
-
-		//
-		// fix gap 1
-		//
-		gap_fixAB( outptr, m_chip_height, width );
-
-		//
-		// fix gap 2
-		//
-		gap_fix( outptr, 2*m_chip_height, width );
-	}
-
-	//
-	// Dark frame only calibration
-	//
-	void operator () (const CVtImage<ImageType>& InFrame
-										, CVtImage<ImageType>& OutFrame
-										, vt_bool dummy
-									 )
-	{
-		if (!m_initialised)
-			return;
-
-		///
-		// apply calibration
-		//
-		vt_ulong				width    = InFrame.width();	
-		const ImageType **inptr  = (const ImageType **) InFrame.lines();
-		ImageType **outptr       = OutFrame.lines();
-
-		///
-		// apply calibration
-		//
-		vt_bool c1to2_done = false;
-		vt_bool c2to3_done = false;
-		CoefType offset		 = 0.0;
-
-		const vt_ulong scope     = 2;
-		const vt_ulong overshoot = 10;
-		for (vt_long row=m_chip_height*m_numChips-1; row>=0; row--)
-		{
-      const ImageType *InVec	= inptr[row];
-      const CoefType dark = m_darkC[row];
-			const CoefType coef = m_coef[row];
-
-      ImageType *OutVec		= outptr[row];
-      
-			// calculate offsets
-			if (row == m_chip_height-overshoot && !c1to2_done)
-			{
-				if (GetAPI().get_api_type() == CVtAPI::PANO_API)
-				{
-					offset	= 0;
-				}
-				else
-				{
-					// note we skip a larger boundary with initial tile
-					offset		 = ABoffset( m_chip_height, OutFrame );
-				}
-
-				row				 = m_chip_height;  // reset row to boundary
-				c1to2_done = true;
-			}
-			else if (row == 2*m_chip_height-overshoot && !c2to3_done)
-			{
-				offset = BCoffset( outptr, width );
-
-				row				 = 2*m_chip_height;  // reset row to boundary
-				c2to3_done = true;
-			}
-			CoefType actual_offset = m_pedestal + offset;
-
-			for (vt_ulong col=0; col<width; col++)
-			{
-				CoefType out = (CoefType) InVec[col] + actual_offset;
-				if (out<0)
-				{
-					OutVec[col] = (ImageType)0.0;
-				}
-				else if (out >= USHRT_MAX)
-				{
-					OutVec[col] = USHRT_MAX;
-				}
-				else
-				{
-					OutVec[col] = (ImageType) out;
-				}
-			}
-		}
-
-		//
-		// fix gap 1
-		//
-		gap_fixAB( outptr, m_chip_height, width );
-
-		//
-		// fix gap 2
-		//
-		gap_fix( outptr, 2*m_chip_height, width );
-	}
-
-	///
-	// save calibration coefficients
-	//
-	void save( std::string fname )
-	{
-		FILE *fpout = fopen( fname.c_str(), "wb" );
-
-		Vt_precondition(fpout != NULL, "CvtHalfLineCalib::save failed to open output file\n" );
-
-		fwrite( (const char *) m_darkC,		sizeof( m_darkC[0] ), m_chip_height*m_numChips, fpout );
-		fwrite( (const char *) m_brightC, sizeof( m_brightC[0] ), m_chip_height*m_numChips, fpout );
-		fwrite( (const char *) m_coef,		sizeof( m_coef[0] ), m_chip_height*m_numChips, fpout );
-
-		fclose(fpout);
-	}
-
-	///
-	// save calibration coefficients
-	//
-	void save( FILE *fpout )
-	{
-		Vt_precondition(fpout != NULL, "CvtHalfLineCalib::save failed to open output file\n" );
-
-		fwrite( (const char *) m_darkC,		sizeof( m_darkC[0] ), m_chip_height*m_numChips, fpout );
-		fwrite( (const char *) m_brightC, sizeof( m_brightC[0] ), m_chip_height*m_numChips, fpout );
-		fwrite( (const char *) m_coef,		sizeof( m_coef[0] ), m_chip_height*m_numChips, fpout );
-	}
-
-  ///
-  // istream operator
-  //
-  friend std::istream& operator >> (std::istream& IS, CVtHalfLineCalib<ImageType, CoefType>& Object)
-  {
-    Vt_precondition(IS.good() ? true : false, "CvtHalfLineCalib::operator >> - Failed to open input file");
-	
-    // Read the header data
-		if (Object.m_darkC != NULL)
-		{
-			delete Object.m_darkC;
-		}
-
-		Object.m_darkC = (CoefType *) new vt_byte[ Object.m_chip_height*Object.m_numChips*sizeof(CoefType) ];
-		IS.read( (char *) Object.m_darkC,   Object.m_chip_height*Object.m_numChips*sizeof(CoefType) );
-
-		// allocate and read
-		if (Object.m_brightC != NULL)
-		{
-			delete Object.m_brightC;
-		}
-		Object.m_brightC = (CoefType *)  new vt_byte[ Object.m_chip_height*Object.m_numChips*sizeof(CoefType)  ];
-		IS.read( (char *) Object.m_brightC, Object.m_chip_height*Object.m_numChips*sizeof(CoefType)  );
-		
-		// allocate and read
-		if (Object.m_coef != NULL)
-		{
-			delete Object.m_coef;
-		}
-		Object.m_coef = (CoefType *)  new vt_byte[ Object.m_chip_height*Object.m_numChips*sizeof(CoefType) ];
-		IS.read( (char *) Object.m_coef,   Object.m_chip_height*Object.m_numChips*sizeof(CoefType) );
-
-		Object.m_initialised = true;
-
-    return IS;
-  }
-};
-
-
-
-/**
- *  $Author: david $
- *  $Revision: 1.3 $
- *  $Date: 2013/05/27 17:41:57 $
- *
- * REQUIREMENTS: 
-
- * 
- * SPECIFICATIONS: 
-
- * 
- * DESIGN NOTES: 
-
- *
- */
-
-template<typename ImageType, typename CoefType> 
-class CVtLineCalib
-{
-	///
-	// Bias direction check
-	//
-	enum {
-		BIAS_ROW_OFFSET = 100 // we use the bottom x rows for checking the bias direction
-		, DEFAULT_BIAS_LEADER = 300
-	};
-
-	typedef vt_double *vt_double_ptr;	
-public:
-	///
-	// bright extraction - not these values are also used for the
-	// left right bias check averaging
-	//
-	// Note these figures assume single binning. If the binning mode is changed
-	// to double binning in the column direction these figures will have to change
-	// This is not good. However, no time to do it the right way.
-	//
-	enum {
-		SKIP_COUNT	  		 = 160
-		, PANO_EXT				 = 600
-		, P_LEXT_START_COL = 140
-		, P_LEXT_END_COL	 = P_LEXT_START_COL + PANO_EXT
-		, P_REXT_START_COL = 2140
-		, P_REXT_END_COL   = P_REXT_START_COL + PANO_EXT
-
-		, CEPH_EXT				 = 500
-		, C_LEXT_START_COL = 600 
-		, C_LEXT_END_COL	 = C_LEXT_START_COL + CEPH_EXT
-		, C_REXT_START_COL = 1700 
-		, C_REXT_END_COL	 = C_REXT_START_COL + CEPH_EXT
-	};
-
-	vt_ulong		m_skip_count;
-	vt_ulong		m_lext_start_col;
-	vt_ulong		m_lext_end_col;
-	vt_ulong		m_rext_start_col;
-	vt_ulong		m_rext_end_col;
-
-	CVtHalfLineCalib<ImageType, CoefType>		m_calib;
-
-	vt_ulong																m_chip_height;
-	vt_ulong																m_numChips;
-
-												
-	CVtLineCalib(const vt_ulong height
-							, const vt_ulong numChips
-							, const vt_bool hbin_flag
-							, const CVtAPI::API_TYPE api ) : m_calib( height, numChips )
-																						, m_chip_height( height )
-																						, m_numChips( numChips )
-	{
-		set_hbin( hbin_flag, api );
-	}
-
-	///
-	// set_hbin()
-	// turn on or off horizontal binning mode
-	//
-	void set_hbin(const vt_bool hbin_flag, const CVtAPI::API_TYPE api)
-	{
-		if (api == CVtAPI::PANO_API)
-		{
-			if (hbin_flag)
-			{
-				// hbin true i.e. there is horizontal binning
-				m_skip_count			=	SKIP_COUNT;
-				m_lext_start_col	= P_LEXT_START_COL;
-				m_lext_end_col		= P_LEXT_END_COL;
-				m_rext_start_col	= P_REXT_START_COL;
-				m_rext_end_col		= P_REXT_END_COL;
-			}
-			else
-			{
-				// hbin false i.e. no horizontal binning
-				m_skip_count			=	SKIP_COUNT;
-				m_lext_start_col	= 2*P_LEXT_START_COL;
-				m_lext_end_col		= 2*P_LEXT_END_COL;
-				m_rext_start_col	= 2*P_REXT_START_COL;
-				m_rext_end_col		= 2*P_REXT_END_COL;
-			}
-		}
-		else
-		{
-			if (hbin_flag)
-			{
-				// hbin true i.e. there is horizontal binning
-				m_skip_count			=	SKIP_COUNT;
-				m_lext_start_col	= C_LEXT_START_COL;
-				m_lext_end_col		= C_LEXT_END_COL;
-				m_rext_start_col	= C_REXT_START_COL;
-				m_rext_end_col		= C_REXT_END_COL;
-			}
-			else
-			{
-				// hbin false i.e. no horizontal binning
-				m_skip_count			=	SKIP_COUNT;
-				m_lext_start_col	= 2*C_LEXT_START_COL;
-				m_lext_end_col		= 2*C_LEXT_END_COL;
-				m_rext_start_col	= 2*C_REXT_START_COL;
-				m_rext_end_col		= 2*C_REXT_END_COL;
-			}
-		}
-	}
-
-	///
-	// Do coefficients calculation and calibration
-	//
-	// Try this version based on mean signal level.
-	// could try an alternative based on absolute differences.
-	//
-	void recalc()
-	{
-		m_calib.recalc();
-	}
-
-	///
-	// access functions
-	//
-	void set_dark(const CVtImage<ImageType>& dark_frame)
-	{
-		m_calib.set_dark(dark_frame);
-	}
-
-
-	void set_bright(const CVtImage<ImageType>& bright_frame, const vt_ulong half_index)
-	{
-		set_single_bright(bright_frame);
-	}
-
-
-	///
-	// OK - these are the main application of the calibration functions
-	//
-	void operator () (const CVtImage<ImageType>& InFrame
-										, CVtImage<ImageType>& OutFrame
-										, const vt_ulong half_position
-										, const vt_bool dark_frame_calib
-										)
-	{
-		m_calib( InFrame, OutFrame, true );
-	}
-
-	///
-	// OK - these are the main application of the calibration functions
-	//
-	void operator () (const CVtImage<ImageType>& InFrame
-										, CVtImage<ImageType>& OutFrame
-										, const vt_ulong half_position
-										)
-	{
-		m_calib( InFrame, OutFrame );
-	}
-
-	///
-	// save calibration coefficients
-	//
-	void save( std::string fname )
-	{
-		FILE *fpout = fopen( fname.c_str(), "wb" );
-
-		Vt_precondition(fpout != NULL, "CVtLineCalib::save failed to open output file\n" );
-
-		m_calib.save(fpout);
-
-		fclose(fpout);
-	}
-
-  ///
-  // istream operator
-  //
-  friend std::istream& operator >> (std::istream& IS, CVtLineCalib<ImageType, CoefType>& Object)
-  {
-    Vt_precondition(IS.good() ? true : false, "CVtLineCalib::operator >> - Failed to open input file");
-	
-		// OK stream out left and right
-		IS >> Object.m_calib;
-
-    return IS;
-  }
-
-private:
-	void set_single_bright(const CVtImage<ImageType>& bright_frame)
-	{
-		double *smth_mean;
-		double *diff;
-
-		vt_ulong frm_chip_height = bright_frame.height();
-		vt_ulong frm_width = bright_frame.width();
-
-		smooth(bright_frame, smth_mean, diff);
-
-		vt_bool *mask = new vt_bool[frm_width];
-		memset( mask, false, sizeof(vt_bool) * frm_width );
-		vt_ulong cols = left_bmask( mask, smth_mean, diff, frm_width);
-    cols += right_bmask( mask, smth_mean, diff, frm_width);
-
-		// allocate first half image
-		CVtImage<ImageType> *brtp = new CVtImage<ImageType> ( cols, frm_chip_height );
-		CVtImage<ImageType> &brt  = *brtp;
-		//
-		// copy image
-		//
-		vt_ulong cnt = 0;
-		for (vt_ulong col = 0; col < frm_width; col++)
-		{
-			if (mask[col])
-			{
-				for (vt_ulong row = 0; row < frm_chip_height; row++)
-				{
-					ImageType data = bright_frame[row][col]; 
-					brt[row][cnt] = data;
-				}
-				cnt++;
-			}
-		}
-		m_calib.set_bright(brt);
-
-		// clean up
-		if (mask != NULL)
-			delete mask;
-		if (smth_mean != NULL)
-			delete smth_mean;
-		if (diff != NULL)
-			delete diff;
-		if( brtp != NULL )
-			delete brtp; // delete this as copied to bright frame
-	}
-
-	///
-	//
-	// smooth
-	//
-	// calculate smoothed difference vector - returns 2 vectors
-	// these should be deleted in the calling function.
-	//
-	void smooth(const CVtImage<ImageType>& bright, vt_double_ptr &smth_mean, vt_double_ptr &df)
-	{
-		double *colmns = new double[bright.width()];
-		double bright_mn = col_mean(colmns, (const ImageType **) bright.lines(), bright.width(), m_chip_height, bright.height() );
-
-		smth_mean = new double[bright.width()]; //larger than require
-
-		memset( smth_mean, 0 , sizeof( smth_mean[0] )*bright.width() );
-
-		df = new double[bright.width()]; //larger than require
-		memset( df, 0 , sizeof( df[0] )*bright.width() );
-
-		// smooth colmeans
-		vt_double sum				  =  0;
-		vt_long  smooth_span = CVtHalfLineCalib<ImageType, CoefType>::SMOOTH_SPAN;
-		for( vt_ulong col = smooth_span; col < bright.width() - smooth_span; col++ )
-		{
-			if (smooth_span == col)
-			{
-				for( vt_long idx = -smooth_span; idx < smooth_span ; idx++)
-				{
-					sum += colmns[col+idx];
-				}
-			}
-			else
-			{
-				vt_ulong last_start = col - smooth_span - 1;
-				vt_ulong new_end    = col + smooth_span;
-
-				sum -= colmns[last_start];
-				sum += colmns[new_end];
-			}
-			smth_mean[col] = sum/CVtHalfLineCalib<ImageType, CoefType>::TOTAL_SPAN;
-			df[col] = smth_mean[col] - smth_mean[col-1]; // remember to ignore first diff
-		}
-		df[smooth_span] = 0; // zap bad first diff
-
-		if (colmns != NULL)
-			delete colmns;
-	}
-	///
-	// left_bmask()
-	// create bright mask. Find the region of the image which is bright
-	//
-	// This code assumes that the central section of the image is elevated above.
-	// It finds the works in from the outside edges i.e. find the two outside shoulders.
-	//
-	vt_ulong left_bmask(vt_bool mask[], const vt_double smth_mean[], const vt_double diff[], const vt_ulong width)
-	{
-		vt_ulong start_col = (m_lext_start_col > width - 1) ? (width-1) : m_lext_start_col;
-		vt_ulong end_col   = (m_lext_end_col > width - 1) ? (width-1) : m_lext_end_col;
-
-		printf( "strt col %d end col %d\n", start_col, end_col );
-
-		vt_ulong cnt = 0;
-		for (vt_ulong col = start_col; col < end_col; col++,cnt++)
-		{
-			if (diff[col] > DF_THRESH)
-				break;
-
-			mask[col] = true;
-		}
-		return cnt;
-	}
-
-	///
-	// right_bmask()
-	// create bright mask. Find the region of the image which is bright
-	//
-	// This code assumes that the central section of the image is elevated above.
-	// It finds the works in from the outside edges i.e. find the two outside shoulders.
-	//
-	vt_ulong right_bmask(vt_bool mask[], const vt_double smth_mean[], const vt_double diff[], const vt_ulong width)
-	{
-		vt_ulong start_col = (m_rext_start_col > width - 1) ? (width-1) : m_rext_start_col;
-		vt_ulong end_col   = (m_rext_end_col > width - 1) ? (width-1) : m_rext_end_col;
-
-		printf( "strt col %d end col %d\n", start_col, end_col );
-
-		vt_ulong cnt = 0;
-		for (vt_ulong col = start_col; col < end_col; col++,cnt++)
-		{
-			if (diff[col] > DF_THRESH)
-				break;
-
-			mask[col] = true;
-		}
-		return cnt;
-	}
-}; // end of line calib
-
-} // Vt namespace
-
-
-#endif // __CVTPANORAMICCALIBRATION_H__
+/** \file VTPanoramicCalibration.h
+
+	This file holds all the routines require for pano and ceph calibration.
+
+	Currently the pano and ceph systems use a flat field removal calibration approach based on 
+	gain and offset calculation. 
+
+	The calibration class contains the routines for a calibration run, and for calibration application.
+
+	@see Vt::CVtPanoramicCalibration for more details.
+
+ * Copyright (c) 2013 by
+ * All Rights Reserved
+ * REVISIONS: 
+ * $Log: VtPanoramicCalibration.h,v $
+ * Revision 1.3  2013/05/27 17:41:57  david
+ * V3
+ *
+ * Revision 1.2  2013/05/27 12:04:18  david
+ * Ver 1
+ *
+ */
+
+#ifndef __CVTPANORAMICCALIBRATION_H__
+#define __CVTPANORAMICCALIBRATION_H__
+
+
+
+//*********************************************************************
+// INCLUDES
+//*********************************************************************
+
+namespace Vt {
+
+/**
+ \brief Calculate the mean of an image
+
+ \param data a two dimensional data set which contains the image which we wish to obtain the mean values from
+*/
+template<typename T1> 
+vt_double mean(const T1** data, const vt_int width, const vt_int height)
+{
+	vt_longdouble sum=0;
+	
+	for (vt_int row=0; row<height; row++)
+	{
+		sum += line_sum( data[row], width );
+	}
+	return (vt_double)sum/((vt_double)width*height );
+}
+
+/**
+   Calculate the means of the rows on an image.
+
+	\param row_means The row mean values which are returned.
+	\param data			 The 2-dimensional input data.
+	\par 
+	The input data is assumed to be a vector of pointers to vectors of type T2. Consequently
+	individual elements of the data can be acccesed via 
+
+		- data[row][col]
+	
+	\param width		The number of columns in the two d input data
+	\param height		The number of rows in the two d intput data
+ */
+
+template<typename T1, typename T2> 
+vt_double row_mean(T1 *row_means, const T2 **data, const vt_int width, const vt_int height)
+{
+	vt_longdouble tot_sum=0;
+	
+	for (vt_int row=0; row<height; row++)
+	{
+		vt_double sum = line_sum( data[row], width );
+
+		row_means[row] = sum/(vt_double)width;
+		
+		// add to total for overall mean
+		tot_sum += sum;
+	}
+
+	return tot_sum/((vt_double)width*height);
+}
+
+
+/**
+   Calculate the column means over rows row_start to row_end.
+
+	 The rows are added in order into a line of column sums, see column_sums(), rather than
+	 walking down each column.
+ */
+template<typename T1, typename T2> 
+vt_double col_mean(T1 *col_means,const T2 **data, const vt_int width, const vt_int row_start, const vt_int row_end)
+{
+	vt_longdouble tot_sum=0;
+
+	vt_double cnt = row_end - row_start;
+
+	std::vector<vt_double> sums( width );
+	if (width > 0)
+		column_sums( &sums[0], data + row_start, row_end - row_start, 0, width );
+
+	for (vt_int col=0; col<width; col++)	
+	{
+		vt_double sum = sums[col];
+
+		col_means[col] = sum/cnt;
+		
+		// add to total for overall mean
+		tot_sum += sum;
+	}
+
+	return tot_sum/((vt_double)width*cnt);
+}
+
+template<typename T1, typename T2> 
+vt_double col_mean(T1 *col_means, const T2 **data, const vt_int width, const vt_int height)
+{
+	return col_mean( col_means, data, width, 0, height );
+}
+
+template<typename T1, typename T2> 
+vt_double row_mean(T1 *row_means,const T2 **data, const vt_int width, const vt_int row_start, const vt_int row_end)
+{
+	vt_longdouble tot_sum=0;
+
+	for (vt_int row=row_start; row<row_end; row++)
+	{
+		vt_double sum = line_sum( data[row], width );
+
+		row_means[row] = sum/width;
+		
+		// add to total for overall mean
+		tot_sum += sum;
+	}
+	vt_double cnt = row_end - row_start;
+	return tot_sum/((vt_double)width*cnt);
+}
+
+/**
+   Calculate the means of rows row_start to row_end of an image in either layout.
+
+	 A column-major image is walked a column at a time with a running sum per row. The sums
+	 of 16 bit pixels are exact so the results are identical for both layouts.
+ */
+template<typename T1, typename T2> 
+vt_double row_mean(T1 *row_means, const CVtImage<T2> &im, const vt_int row_start, const vt_int row_end)
+{
+	const vt_int width = im.width();
+
+	if (im.layout() == CVtImageBaseClass::ROW_MAJOR)
+		return row_mean( row_means, (const T2 **) im.lines(), width, row_start, row_end );
+
+	std::vector<vt_double> sums( row_end - row_start );
+	if (row_end > row_start)
+		column_sums( &sums[0], (const T2 **) im.lines(), width, row_start, row_end - row_start );
+
+	vt_longdouble tot_sum=0;
+	for (vt_int row=row_start; row<row_end; row++)
+	{
+		vt_double sum = sums[row - row_start];
+		row_means[row] = sum/width;
+		
+		// add to total for overall mean
+		tot_sum += sum;
+	}
+	vt_double cnt = row_end - row_start;
+	return tot_sum/((vt_double)width*cnt);
+}
+
+/**
+   Calculate the column means over rows row_start to row_end of an image in either layout.
+ */
+template<typename T1, typename T2> 
+vt_double col_mean(T1 *col_means, const CVtImage<T2> &im, const vt_int row_start, const vt_int row_end)
+{
+	const vt_int width = im.width();
+
+	if (im.layout() == CVtImageBaseClass::ROW_MAJOR)
+		return col_mean( col_means, (const T2 **) im.lines(), width, row_start, row_end );
+
+	vt_longdouble tot_sum=0;
+
+	vt_double cnt = row_end - row_start;
+	for (vt_int col=0; col<width; col++)	
+	{
+		vt_double sum = line_sum( im[col] + row_start, row_end - row_start );
+
+		col_means[col] = sum/cnt;
+		
+		// add to total for overall mean
+		tot_sum += sum;
+	}
+
+	return tot_sum/((vt_double)width*cnt);
+}
+
+
+
+/**
+  \image html vatech.jpg
+
+  \par REQUIREMENTS: 
+  
+	This is class which implements the panoramic and cephelometric calibration functions.
+
+	The functions may be thought of as consisting of two distince groups those realated to the calculation of the calibration data and 
+	those related to the applicaton of the calibration process to acquired images. The former set consist of routines;-
+		
+		-# for the acquisition of source data required for calibration
+
+		-# for calculation and storage of the calibration data.
+
+
+	\todo
+	Merge the CVtHalfLineCalib and the CVtLineCalib classes.
+	The CVtHalfLineCalib calibration class was created to solve a problem with asymetric x-ray power in the panoramic
+	system i.e. two separate calibrations were applied on different sides of the panoramic scan. However
+ */
+
+#define DF_THRESH 5.0
+template<typename ImageType, typename CoefType> 
+class CVtHalfLineCalib
+{
+private:
+	typedef 	ImageType IM_TYPE;
+	typedef 	CoefType  COEF_TYPE;
+
+	CVtImage<ImageType> m_bright;
+	CVtImage<ImageType> m_dark;
+
+	vt_ulong  m_chip_height;
+	vt_ulong  m_numChips;
+
+	CoefType *m_darkC;
+	CoefType *m_brightC;
+	CoefType *m_coef;
+	CoefType *m_bias;
+	vt_ulong m_bias_width;
+
+	//! per row gain and bias, (in - dark)*coef folded into in*gain + bias by fold()
+	vt_float *m_row_gain;
+	CoefType *m_row_bias;
+
+	//! threads used to apply the calibration, 0 for all of the pool
+	vt_ulong	m_threads;
+
+	//! interpolation across the tile cuts, and the frame number for its noise
+	CVtSeamRepair<ImageType> m_seams;
+	vt_ulong	m_frame;
+
+	//! per pixel calibration, used in place of the per row gain and bias when m_full_field is set
+	CVtFieldCalib<ImageType> m_field;
+	vt_bool		m_full_field;
+	vt_bool		m_use_field;
+
+	//! measure and correct the ceph AB tile offset, see set_ab_correct()
+	vt_bool		m_ab_correct;
+
+	vt_bool   m_initialised;
+	vt_bool   m_ceph_mode;
+
+	const vt_bool m_smooth;
+public:
+	CoefType  m_pedestal;
+
+  /**
+	\enum SMOOTH_SPAN
+	\brief When the calibration coefficients are recalculated there is the option to smooth the resultant
+	coefficients. i.e. to minimise the difference in applied calibration
+	*/
+	enum {
+		SMOOTH_SPAN = 5
+		, TOTAL_SPAN = 2*SMOOTH_SPAN + 1
+		, DEFAULT_PEDESTAL = 1000
+		, MAX_COEF				 = 4
+		, EDGE_SKIP				 = 400
+		, CENTRAL_EXT			 = 500
+		};
+
+  /**
+   * Constructor
+   */
+  CVtHalfLineCalib(vt_ulong height
+							, vt_ulong numChips ) 
+									: m_darkC( NULL )
+									, m_brightC( NULL )
+									, m_coef( NULL )
+									, m_chip_height( height )
+									, m_numChips( numChips )
+									, m_initialised( false )
+									, m_pedestal( (CoefType)DEFAULT_PEDESTAL )
+									, m_bias( NULL )
+									, m_row_gain( NULL )
+									, m_row_bias( NULL )
+									, m_threads( 0 )
+									, m_seams( height, true )
+									, m_frame( 0 )
+									, m_full_field( false )
+									, m_use_field( false )
+									, m_ab_correct( false )
+									, m_smooth( false )
+	{}
+
+	virtual ~CVtHalfLineCalib() 
+	{
+		if (m_darkC != NULL)
+		{
+			delete [] m_darkC;
+		}
+		if (m_brightC != NULL)
+		{
+			delete [] m_brightC;
+		}
+		if (m_coef != NULL)
+		{
+			delete [] m_coef;
+		}
+		if (m_bias != NULL)
+		{
+			delete [] m_bias;
+		}
+		if (m_row_gain != NULL)
+		{
+			delete [] m_row_gain;
+		}
+		if (m_row_bias != NULL)
+		{
+			delete [] m_row_bias;
+		}
+	}
+
+	///
+	// smooth
+	//
+	// Produces a smoothed version of the input vector
+	// Returns smoothed version as a pointer it is the calling functions responsibility to remove
+	// this vector.
+	//
+	CoefType * smooth(CoefType *vec, const vt_ulong length)
+	{
+		CoefType * smth_vec = new CoefType[length]; //larger than require
+
+		memset( smth_vec, 0 , sizeof( smth_vec[0] )*length );
+
+		if (length < TOTAL_SPAN)
+			return smth_vec;
+
+		// smooth 
+		box_filter( smth_vec, vec, length, SMOOTH_SPAN );
+
+		// deal with the beginning and end, fill with the first and last valid smoothed entries
+		for (vt_ulong idx = 0; idx < SMOOTH_SPAN; idx++)
+		{
+			smth_vec[idx]							 = smth_vec[SMOOTH_SPAN];
+			smth_vec[length - 1 - idx] = smth_vec[length - 1 - SMOOTH_SPAN];
+		}
+
+		return smth_vec;
+	}
+
+	///
+	// note set bright and dark functions merely replace the dark and bright frames
+	// whereas the update_xxxx function replace the frame and recalculate the coefficients
+	// i.e. the update functions are equivalent to a set and a recalc.
+	//
+	void set_bright(const CVtImage<ImageType>& bright_frame)
+	{
+		m_bright = bright_frame;
+	}
+
+	///
+	// set_bright frame
+	//
+	void set_dark(const CVtImage<ImageType>& dark_frame)
+	{
+		m_dark   = dark_frame;
+	}
+
+	///
+	// calculate bias correction
+	//
+	void set_bias(const vt_double *bias, const vt_ulong width)
+	{
+		m_bias_width = width;
+		if (m_bias != NULL)
+			delete [] m_bias;
+
+		m_bias = (vt_double *) bias;
+	}
+
+	//
+	// default zero bias
+	//
+	void calc_bias(const vt_ulong width)
+	{
+		m_bias_width = width;
+		if (m_bias != NULL)
+			delete [] m_bias;
+
+		m_bias = new vt_double [m_bias_width];
+		memset( m_bias, 0, m_bias_width*sizeof( m_bias[0] ) );
+	}
+
+	///
+	// access functions
+	//
+	CVtImage<ImageType>& get_bright()
+	{
+		return m_bright;
+	}
+
+	/**
+	\brief Access function for the dark frame.
+	\return the calibration dark frame.
+	*/
+	CVtImage<ImageType>& get_dark()
+	{
+			return m_dark;
+	}
+	/**
+	\brief Add a new bright frame to the calibration 
+	This function replaces the current bright frame with a new one.
+	
+	\param bright_frame the new bright frame.
+
+	*/
+	void update_bright(const CVtImage<ImageType>& bright_frame)
+	{
+		recalc(bright_frame, m_dark);
+	} 
+
+	void update_dark(const CVtImage<ImageType>& dark_frame)
+	{
+		recalc(m_bright, dark_frame);
+	} 
+
+	/**
+	\brief Recalculate the calibration coefficients.
+
+	Uses a dark fram and a bright frame to 
+
+	*/
+	void recalc()
+	{
+		recalc( m_bright, m_dark );
+	}
+
+	void recalc(const CVtImage<ImageType>& BrightFrame, const CVtImage<ImageType>& DarkFrame) 
+	{
+		m_bright = BrightFrame;
+		m_dark   = DarkFrame;
+
+		// a field corrects to the per row calibration it was made with
+		m_field.reset();
+
+		if (m_bright.height() != m_dark.height() )
+			Vt_fail( "Invalid dark bright frames" );
+
+		vt_ulong height = m_bright.height();
+
+		// allocate coefficants
+		if (m_coef != NULL)
+			delete [] m_coef;
+		
+		m_coef = new CoefType[height];
+		memset( m_coef, 0, sizeof( m_coef[0])*height  );
+
+		// note the start row is dependent on the API type
+
+		CVtAPI::API_TYPE api_type = GetAPI().get_api_type();
+		vt_ulong start_row = first_row( api_type, m_chip_height );
+		vt_ulong end_row   = m_numChips*m_chip_height;
+
+		// allocate dark field
+		if (m_darkC != NULL)
+			delete [] m_darkC;
+
+		m_darkC = new CoefType[height];
+		
+		memset( m_darkC, 0, sizeof( m_darkC[0])*height  );
+
+		vt_double mean_dark	= row_mean( m_darkC, m_dark, start_row, end_row );
+		
+		printf( "mean dark level %lf ", mean_dark );
+
+		// smooth dark values
+		if (m_smooth)
+		{
+			CoefType *smth_dark = smooth( m_darkC, end_row );
+
+			delete [] m_darkC;
+			m_darkC = smth_dark;
+
+			// fix gap
+			m_darkC[m_chip_height-1]   = m_darkC[m_chip_height-2] + (m_darkC[m_chip_height] - m_darkC[m_chip_height-2])/2;
+			m_darkC[2*m_chip_height-1] = m_darkC[2*m_chip_height-2] + (m_darkC[2*m_chip_height] - m_darkC[2*m_chip_height-2])/2;
+		}
+
+		// allocate bright field
+		if (m_brightC != NULL)
+			delete [] m_brightC;
+
+		m_brightC	= new CoefType[height];
+		
+		memset( m_brightC, 0, sizeof( m_darkC[0])*height  );
+		vt_double mean_bright = row_mean( m_brightC, m_bright, start_row, end_row );
+
+		printf( "mean bright level %lf\n", mean_bright );
+
+		vt_double	mean_signal = (mean_bright - mean_dark);
+
+		printf( "mean signal level %lf\n", mean_signal );
+
+		// smooth bright values
+		if (m_smooth)
+		{
+			CoefType *smth_bright = smooth( m_brightC, end_row );
+
+			delete [] m_brightC;
+			m_brightC = smth_bright;
+
+			// gap fix
+			m_brightC[m_chip_height-1]   = m_brightC[m_chip_height-2] + (m_brightC[m_chip_height] - m_brightC[m_chip_height-2])/2;
+			m_brightC[2*m_chip_height-1] = m_brightC[2*m_chip_height-2] + (m_brightC[2*m_chip_height] - m_brightC[2*m_chip_height-2])/2;
+		}
+
+
+		///
+		// main calculation loop
+		//
+		if (mean_signal != 0)
+		{
+			calc_coef( m_coef, m_darkC, m_brightC, start_row, end_row, mean_signal );
+		}
+		else
+		{
+			Vt_fail( "Invalid dark or bright frame" );
+		}
+		fold();
+
+		m_initialised = true;
+	}
+
+	///
+	// first_row
+	//
+	// The first row the coefficients are calculated from, pano data starts in tile B, ceph
+	// mode has actual data in 'C' hence calculation can start from row 0
+	//
+	static vt_ulong first_row(const CVtAPI::API_TYPE api, const vt_ulong chip_height)
+	{
+		return (api == CVtAPI::PANO_API) ? chip_height : 0;
+	}
+
+	///
+	// calc_coef
+	//
+	// The coefficient of each row brings its signal to the mean signal level. Rows with
+	// no signal, or which need more than MAX_COEF, are left uncalibrated i.e. 0.
+	//
+	static void calc_coef(CoefType *coef, const CoefType *darkC, const CoefType *brightC
+											, const vt_ulong start_row, const vt_ulong end_row, const vt_double mean_signal)
+	{
+		const vt_double eps = 0.000001;
+
+		for (vt_ulong row = start_row + 1; row < end_row; row++)
+		{
+			vt_double diff = brightC[row] - darkC[row];
+
+			if (diff > eps)
+			{
+				coef[row] = (CoefType) (mean_signal/diff);
+
+				// sanity check coefs
+				if (coef[row] > MAX_COEF)
+					coef[row] = 0.0;
+			}
+			else
+			{
+				coef[row] = 0.0;
+			}
+		}
+	}
+
+	///
+	// fold
+	//
+	// Fold the dark level and coefficient of each row into a single gain and bias
+	// so that applying the calibration is one multiply-add per pixel.
+	//
+	void fold()
+	{
+		const vt_ulong height = m_chip_height*m_numChips;
+
+		if (m_row_gain != NULL)
+			delete [] m_row_gain;
+		if (m_row_bias != NULL)
+			delete [] m_row_bias;
+
+		m_row_gain = new vt_float[height];
+		m_row_bias = new CoefType[height];
+
+		for (vt_ulong row = 0; row < height; row++)
+		{
+			m_row_gain[row] = (vt_float) m_coef[row];
+			m_row_bias[row] = -m_darkC[row]*(CoefType) m_row_gain[row];
+		}
+	}
+
+
+	///
+	// set_geometry()
+	// the tile height and vertical binning of the frames, this sets the rows interpolated across
+	// the tile cuts. A new tile height leaves the calibration uninitialised until rows for it
+	// are set, see set_rows(), or recalculated.
+	//
+	void set_geometry(const vt_ulong chip_height, const vt_bool vbin_flag)
+	{
+		m_seams.set_geometry( chip_height, vbin_flag );
+
+		if (chip_height != m_chip_height)
+		{
+			m_chip_height = chip_height;
+			m_initialised = false;
+			m_field.reset();
+		}
+	}
+
+	///
+	// set_full_field()
+	// calibrate with the per pixel field, when there is one for the frame size, rather than
+	// the per row gain and bias
+	//
+	void set_full_field(const vt_bool full_field)
+	{
+		m_full_field = full_field;
+	}
+
+	///
+	// set_ab_correct()
+	// correct ceph tile A by its measured offset from tile B. Off, the AB offset is 0, which
+	// is what the measurement gave before the fixes to CVtABDiff.
+	//
+	void set_ab_correct(const vt_bool ab_correct)
+	{
+		m_ab_correct = ab_correct;
+	}
+
+	///
+	// set_field()
+	// make the per pixel field from averaged dark and bright frames in the geometry of the
+	// frames to be calibrated. The per row calibration must already be calculated, the field
+	// corrects to the same signal level and takes its values where it has none of its own.
+	//
+	void set_field(const CVtImage<ImageType>& dark_frame, const CVtImage<ImageType>& bright_frame)
+	{
+		const vt_ulong height = m_chip_height*m_numChips;
+
+		Vt_precondition( m_initialised && dark_frame.height() == height
+									 , "CVtHalfLineCalib::set_field - no per row calibration for these frames" );
+
+		const vt_ulong start_row = first_row( GetAPI().get_api_type(), m_chip_height );
+
+		vt_double mean_dark		= 0.0;
+		vt_double mean_bright = 0.0;
+		if (height > start_row)
+		{
+			mean_dark		= line_sum( m_darkC + start_row, height - start_row )/(height - start_row);
+			mean_bright = line_sum( m_brightC + start_row, height - start_row )/(height - start_row);
+		}
+
+		m_field.build( dark_frame, bright_frame, mean_bright - mean_dark, start_row, m_darkC, m_coef );
+	}
+
+	///
+	// save and read the per pixel field, a field for another tile height isn't read
+	//
+	void save_field(FILE *fpout) const
+	{
+		m_field.save( fpout );
+	}
+
+	vt_bool read_field(std::istream &IS)
+	{
+		return m_field.read( IS, m_chip_height*m_numChips );
+	}
+
+	///
+	// get_rows()
+	// copy the per row calibration out, e.g. into the calibration bank
+	//
+	vt_bool get_rows(typename CVtCalibBank<CoefType>::ENTRY &entry) const
+	{
+		if (!m_initialised)
+			return false;
+
+		const vt_ulong height = m_chip_height*m_numChips;
+
+		entry.chip_height = m_chip_height;
+		entry.dark.assign( m_darkC, m_darkC + height );
+		entry.bright.assign( m_brightC, m_brightC + height );
+		entry.coef.assign( m_coef, m_coef + height );
+		entry.derived = false;
+
+		return true;
+	}
+
+	///
+	// set_rows()
+	// replace the per row calibration, the rows must be for the current tile height
+	//
+	void set_rows(const typename CVtCalibBank<CoefType>::ENTRY &entry)
+	{
+		const vt_ulong height = m_chip_height*m_numChips;
+
+		Vt_precondition( entry.chip_height == m_chip_height && entry.coef.size() == height
+									 , "CVtHalfLineCalib::set_rows - calibration is for another tile height" );
+
+		if (m_darkC != NULL)
+			delete [] m_darkC;
+		if (m_brightC != NULL)
+			delete [] m_brightC;
+		if (m_coef != NULL)
+			delete [] m_coef;
+
+		m_darkC		= new CoefType[height];
+		m_brightC = new CoefType[height];
+		m_coef		= new CoefType[height];
+
+		std::copy( entry.dark.begin(), entry.dark.end(), m_darkC );
+		std::copy( entry.bright.begin(), entry.bright.end(), m_brightC );
+		std::copy( entry.coef.begin(), entry.coef.end(), m_coef );
+
+		fold();
+
+		m_initialised = true;
+	}
+
+	///
+	// derive_binned()
+	// The calibration of the vertically binned frames from that of unbinned frames, taking a
+	// binned row as the average of a pair of unbinned rows, so its dark and bright levels are
+	// the averages of theirs. The coefficients are then calculated from these as recalc() would.
+	// This is an approximation, on-chip binning sums the charge before the ADC, so it is only
+	// used when the deriveBinned api parameter is set.
+	//
+	static void derive_binned(const typename CVtCalibBank<CoefType>::ENTRY &src
+													, typename CVtCalibBank<CoefType>::ENTRY &dst
+													, const vt_ulong numChips
+													, const CVtAPI::API_TYPE api)
+	{
+		Vt_precondition( src.chip_height % 2 == 0 && src.dark.size() == src.chip_height*numChips
+									 , "CVtHalfLineCalib::derive_binned - invalid unbinned calibration" );
+
+		const vt_ulong chip_height = src.chip_height/2;
+		const vt_ulong height			 = chip_height*numChips;
+
+		dst.chip_height = chip_height;
+		dst.derived			= true;
+		dst.dark.assign( height, 0 );
+		dst.bright.assign( height, 0 );
+		dst.coef.assign( height, 0 );
+
+		for (vt_ulong row = 0; row < height; row++)
+		{
+			dst.dark[row]		= (src.dark[2*row] + src.dark[2*row + 1])/2;
+			dst.bright[row] = (src.bright[2*row] + src.bright[2*row + 1])/2;
+		}
+
+		const vt_ulong start_row = first_row( api, chip_height );
+		vt_double			 mean_dark	 = 0.0;
+		vt_double			 mean_bright = 0.0;
+
+		if (height > start_row)
+		{
+			mean_dark		= line_sum( &dst.dark[start_row], height - start_row )/(height - start_row);
+			mean_bright = line_sum( &dst.bright[start_row], height - start_row )/(height - start_row);
+		}
+
+		const vt_double mean_signal = mean_bright - mean_dark;
+
+		Vt_precondition( mean_signal != 0, "CVtHalfLineCalib::derive_binned - invalid dark or bright levels" );
+
+		calc_coef( &dst.coef[0], &dst.dark[0], &dst.bright[0], start_row, height, mean_signal );
+	}
+
+	///
+	// noise added to the rows interpolated across the tile cuts, 0 for none. The frames
+	// calibrated after this call are numbered from 0, each draws its own noise from the seed.
+	//
+	void set_seam_noise(const vt_float sigma, const vt_ulong seed)
+	{
+		m_seams.set_noise( sigma, (vt_uint32) seed );
+		m_frame = 0;
+	}
+
+	/**
+	\brief calculate the offset between to chips, the a and b chip
+
+	The calibration procedure is not perfect, due to dark current drift after application of the 
+	calibration the 
+
+	/
+	 This merely take the average difference of a few lines above and below the chip cut line
+	*/
+	const CoefType ABoffset( const vt_ulong ab_split, CVtImage<ImageType> &out )
+	{
+		CVtABDiff<ImageType> ab_diff(  ab_split );
+
+		return ab_diff( out );
+	}
+
+	/**
+	\brief calculate the offset between to BC
+
+	The 
+	*/
+	const CoefType BCoffset( ImageType **imptr, const vt_ulong width )
+	{
+		const ImageType *prow1 = imptr[2*m_chip_height-2];
+		const ImageType *prow2 = imptr[2*m_chip_height+1];
+	
+		// the row sums are exact for 16 bit pixels
+		return (line_sum( prow2, width ) - line_sum( prow1, width ))/(CoefType)width;
+	}
+
+	/**
+	\brief The main calibration interface for the panoramic and ceph system
+
+	The function applies a gain and offset calibration to the panoramic and ceph images.
+
+	\param  InFrame the input image
+	\param  OutFrame the calibrated output image
+	\note - these should be seperate images - this function doesn't guarentee
+	in place operation
+	*/
+	void operator () (const CVtImage<ImageType>& InFrame
+										, CVtImage<ImageType>& OutFrame
+									 )
+	{
+		apply( InFrame, OutFrame, false );
+	}
+
+	//
+	// Dark frame only calibration
+	//
+	void operator () (const CVtImage<ImageType>& InFrame
+										, CVtImage<ImageType>& OutFrame
+										, vt_bool dummy
+									 )
+	{
+		apply( InFrame, OutFrame, true );
+	}
+
+	/**
+	\brief Centre and calibrate in one pass.
+
+	The output is what centring the frame and then calibrating the centred image gives, but
+	the frame is only read once. Each band of rows is copied into the output from start_col,
+	in blocks that stay in cache, and calibrated in place there.
+
+	\param AcqFrame	the acquired frame, in either layout
+	\param OutFrame	the calibrated output image, row-major, its width is the centred width
+	\param start_col the column of the acquired frame centred on the first output column
+	\param dark_only dark frame only calibration
+	*/
+	void apply_centred(const CVtImage<ImageType>& AcqFrame, CVtImage<ImageType>& OutFrame
+									 , const vt_ulong start_col, const vt_bool dark_only)
+	{
+		apply( AcqFrame, OutFrame, start_col, dark_only );
+	}
+
+	///
+	// set the number of threads used to apply the calibration, 0 for all of them
+	//
+	void set_threads(const vt_ulong threads)
+	{
+		m_threads = threads;
+	}
+
+private:
+	enum {
+		ROW_BLOCK = 64	//!< rows copied and calibrated together by apply_centred()
+	};
+
+	///
+	// the input rows [first, last) of a calibration. A row-major frame of the output size is
+	// used as it is. Otherwise the rows are copied into the output from start_col, with the
+	// columns past the end of the frame set to 0 as centring leaves them, for calibration in place.
+	//
+	static const ImageType **stage_rows(const CVtImage<ImageType>& InFrame, CVtImage<ImageType>& OutFrame
+																		, const vt_ulong start_col, const vt_ulong first, const vt_ulong last)
+	{
+		const vt_ulong width = OutFrame.width();
+
+		if (InFrame.layout() == CVtImageBaseClass::ROW_MAJOR && start_col == 0 && InFrame.width() == width)
+			return (const ImageType **) InFrame.lines();
+
+		vt_ulong cols = (InFrame.width() > start_col) ? InFrame.width() - start_col : 0;
+		if (cols > width)
+			cols = width;
+
+		if (cols > 0)
+		{
+			if (InFrame.layout() == CVtImageBaseClass::COL_MAJOR)
+				transpose_lines( OutFrame.lines() + first, InFrame.lines() + start_col, first, last - first, cols );
+			else
+				copy_region( InFrame, Diff2D( start_col, first ), OutFrame, Diff2D( 0, first ), Diff2D( cols, last - first ) );
+		}
+
+		for (vt_ulong row = first; row < last; row++)
+		{
+			std::fill( OutFrame[row] + cols, OutFrame[row] + width, (ImageType) 0 );
+		}
+		return (const ImageType **) OutFrame.lines();
+	}
+
+	///
+	// calibrate one row, with the offset of the tile it ends up in
+	//
+	void calibrate_row(const ImageType **inptr, ImageType **outptr, const vt_ulong row, const vt_ulong width
+										, const CoefType offset, const vt_bool dark_only) const
+	{
+		CoefType actual_offset = m_pedestal + offset;
+
+		if (m_use_field)
+			m_field.apply_row( outptr[row], inptr[row], row, width, (vt_float) actual_offset );
+		else if (dark_only)
+			gain_bias_row( outptr[row], inptr[row], width, 1.0f, (vt_float) actual_offset );
+		else
+			gain_bias_row( outptr[row], inptr[row], width, m_row_gain[row], (vt_float) (m_row_bias[row] + actual_offset) );
+	}
+
+	///
+	// calibrates a band of rows, run by the thread pool
+	//
+	struct CALIB_TASK : public CVtTask
+	{
+		const CVtHalfLineCalib	*calib;
+		const CVtImage<ImageType> *in;
+		CVtImage<ImageType>			*out;
+		vt_ulong								start_col;
+		vt_ulong								width;
+		vt_bool									dark_only;
+		CoefType								ab_offset;
+		CoefType								bc_offset;
+
+		virtual void run(const vt_ulong first, const vt_ulong last)
+		{
+			const vt_ulong chip_height = calib->m_chip_height;
+			ImageType			 **outptr			 = out->lines();
+
+			for (vt_ulong block = first; block < last; block += ROW_BLOCK)
+			{
+				const vt_ulong	 block_end = (block + ROW_BLOCK < last) ? block + ROW_BLOCK : last;
+				const ImageType **inptr		 = stage_rows( *in, *out, start_col, block, block_end );
+
+				for (vt_ulong row = block; row < block_end; row++)
+				{
+					CoefType offset = 0.0;
+
+					if (row < chip_height)
+						offset = ab_offset;
+					else if (row < 2*chip_height)
+						offset = bc_offset;
+
+					calib->calibrate_row( inptr, outptr, row, width, offset, dark_only );
+				}
+			}
+		}
+	};
+
+	///
+	// apply the calibration
+	//
+	// The tiles are offset to match across the cuts, tile C is the reference. The offsets
+	// are measured first, on the few rows either side of each cut calibrated as they will
+	// be in the final image, then every row is calibrated in bands across the thread pool.
+	// Each row only depends on the offsets so the output doesn't depend on the thread count.
+	//
+	// The input rows come from stage_rows(), a frame which isn't the row-major input of the
+	// same size is centred from start_col on the way, see apply_centred().
+	//
+	void apply(const CVtImage<ImageType>& InFrame, CVtImage<ImageType>& OutFrame, const vt_bool dark_only)
+	{
+		apply( InFrame, OutFrame, 0, dark_only );
+	}
+
+	void apply(const CVtImage<ImageType>& InFrame, CVtImage<ImageType>& OutFrame, const vt_ulong start_col, const vt_bool dark_only)
+	{
+		if (!m_initialised)
+		{
+			// nothing to calibrate with, the output may come from an allocator which doesn't clear it
+			for (vt_ulong line = 0; line < OutFrame.num_lines(); line++)
+			{
+				std::fill( OutFrame.lines()[line], OutFrame.lines()[line] + OutFrame.line_length(), (ImageType) 0 );
+			}
+			return;
+		}
+
+		vt_ulong				width    = OutFrame.width();	
+		Vt_precondition( OutFrame.layout() == CVtImageBaseClass::ROW_MAJOR && OutFrame.height() == InFrame.height()
+									 , "CVtHalfLineCalib::operator() - calibration works on row-major images" );
+
+		const ImageType **inptr  = NULL;
+		ImageType				**outptr = OutFrame.lines();
+
+		// the per pixel field replaces the per row gain and bias, dark frames are offset only
+		m_use_field = m_full_field && !dark_only && m_field.valid( width, InFrame.height() );
+
+		///
+		// BC offset - the rows either side of the BC cut without an offset
+		//
+		inptr = stage_rows( InFrame, OutFrame, start_col, 2*m_chip_height-2, 2*m_chip_height-1 );
+		calibrate_row( inptr, outptr, 2*m_chip_height-2, width, 0.0, dark_only );
+		inptr = stage_rows( InFrame, OutFrame, start_col, 2*m_chip_height+1, 2*m_chip_height+2 );
+		calibrate_row( inptr, outptr, 2*m_chip_height+1, width, 0.0, dark_only );
+
+		CoefType bc_offset = BCoffset( outptr, width );
+
+		///
+		// AB offset - ceph only, the rows either side of the AB cut with the BC offset
+		//
+		CoefType ab_offset = 0.0;
+
+		if ( m_ab_correct && GetAPI().get_api_type() != CVtAPI::PANO_API )
+		{
+			const vt_ulong span = CVtRectPairs::RECT_SIZE + CVtRectPairs::OFFSET;
+
+			inptr = stage_rows( InFrame, OutFrame, start_col, m_chip_height - span, m_chip_height + span );
+			for (vt_ulong row = m_chip_height - span; row < m_chip_height + span; row++)
+			{
+				calibrate_row( inptr, outptr, row, width, bc_offset, dark_only );
+			}
+
+			// note we skip a larger boundary with initial tile, the rows either side
+			// were measured with the BC offset so tile A needs that as well
+			ab_offset = bc_offset + ABoffset( m_chip_height, OutFrame );
+		}
+
+		///
+		// apply calibration
+		//
+		CALIB_TASK task;
+
+		task.calib		 = this;
+		task.in				 = &InFrame;
+		task.out			 = &OutFrame;
+		task.start_col = start_col;
+		task.width		 = width;
+		task.dark_only = dark_only;
+		task.ab_offset = ab_offset;
+		task.bc_offset = bc_offset;
+
+		thread_pool().run( task, 0, m_chip_height*m_numChips, m_threads );
+
+		//
+		// fix the gaps
+		//
+		m_seams( outptr, width, m_chip_height*m_numChips, m_frame++ );
+	}
+
+public:
+
+	///
+	// save calibration coefficients
+	//
+	void save( std::string fname )
+	{
+		FILE *fpout = fopen( fname.c_str(), "wb" );
+
+		Vt_precondition(fpout != NULL, "CvtHalfLineCalib::save failed to open output file\n" );
+
+		fwrite( (const char *) m_darkC,		sizeof( m_darkC[0] ), m_chip_height*m_numChips, fpout );
+		fwrite( (const char *) m_brightC, sizeof( m_brightC[0] ), m_chip_height*m_numChips, fpout );
+		fwrite( (const char *) m_coef,		sizeof( m_coef[0] ), m_chip_height*m_numChips, fpout );
+
+		fclose(fpout);
+	}
+
+	///
+	// save calibration coefficients
+	//
+	void save( FILE *fpout )
+	{
+		Vt_precondition(fpout != NULL, "CvtHalfLineCalib::save failed to open output file\n" );
+
+		fwrite( (const char *) m_darkC,		sizeof( m_darkC[0] ), m_chip_height*m_numChips, fpout );
+		fwrite( (const char *) m_brightC, sizeof( m_brightC[0] ), m_chip_height*m_numChips, fpout );
+		fwrite( (const char *) m_coef,		sizeof( m_coef[0] ), m_chip_height*m_numChips, fpout );
+	}
+
+  ///
+  // istream operator
+  //
+  friend std::istream& operator >> (std::istream& IS, CVtHalfLineCalib<ImageType, CoefType>& Object)
+  {
+    Vt_precondition(IS.good() ? true : false, "CvtHalfLineCalib::operator >> - Failed to open input file");
+	
+    // Read the header data
+		if (Object.m_darkC != NULL)
+		{
+			delete [] Object.m_darkC;
+		}
+
+		Object.m_darkC = new CoefType[ Object.m_chip_height*Object.m_numChips ];
+		IS.read( (char *) Object.m_darkC,   Object.m_chip_height*Object.m_numChips*sizeof(CoefType) );
+
+		// allocate and read
+		if (Object.m_brightC != NULL)
+		{
+			delete [] Object.m_brightC;
+		}
+		Object.m_brightC = new CoefType[ Object.m_chip_height*Object.m_numChips ];
+		IS.read( (char *) Object.m_brightC, Object.m_chip_height*Object.m_numChips*sizeof(CoefType)  );
+		
+		// allocate and read
+		if (Object.m_coef != NULL)
+		{
+			delete [] Object.m_coef;
+		}
+		Object.m_coef = new CoefType[ Object.m_chip_height*Object.m_numChips ];
+		IS.read( (char *) Object.m_coef,   Object.m_chip_height*Object.m_numChips*sizeof(CoefType) );
+
+		Object.fold();
+
+		Object.m_initialised = true;
+
+    return IS;
+  }
+};
+
+
+
+/**
+ *  $Author: david $
+ *  $Revision: 1.3 $
+ *  $Date: 2013/05/27 17:41:57 $
+ *
+ * REQUIREMENTS: 
+
+ * 
+ * SPECIFICATIONS: 
+
+ * 
+ * DESIGN NOTES: 
+
+ *
+ */
+
+template<typename ImageType, typename CoefType> 
+class CVtLineCalib
+{
+	///
+	// Bias direction check
+	//
+	enum {
+		BIAS_ROW_OFFSET = 100 // we use the bottom x rows for checking the bias direction
+		, DEFAULT_BIAS_LEADER = 300
+	};
+
+	typedef vt_double *vt_double_ptr;	
+public:
+	///
+	// bright extraction - not these values are also used for the
+	// left right bias check averaging
+	//
+	// Note these figures assume single binning. If the binning mode is changed
+	// to double binning in the column direction these figures will have to change
+	// This is not good. However, no time to do it the right way.
+	//
+	enum {
+		SKIP_COUNT	  		 = 160
+		, PANO_EXT				 = 600
+		, P_LEXT_START_COL = 140
+		, P_LEXT_END_COL	 = P_LEXT_START_COL + PANO_EXT
+		, P_REXT_START_COL = 2140
+		, P_REXT_END_COL   = P_REXT_START_COL + PANO_EXT
+
+		, CEPH_EXT				 = 500
+		, C_LEXT_START_COL = 600 
+		, C_LEXT_END_COL	 = C_LEXT_START_COL + CEPH_EXT
+		, C_REXT_START_COL = 1700 
+		, C_REXT_END_COL	 = C_REXT_START_COL + CEPH_EXT
+	};
+
+	vt_ulong		m_skip_count;
+	vt_ulong		m_lext_start_col;
+	vt_ulong		m_lext_end_col;
+	vt_ulong		m_rext_start_col;
+	vt_ulong		m_rext_end_col;
+
+	CVtHalfLineCalib<ImageType, CoefType>		m_calib;
+
+	vt_ulong																m_chip_height;
+	vt_ulong																m_numChips;
+
+	//! running sums of the dark and bright frames of a calibration run
+	CVtFrameAccumulator<ImageType>					m_dark_acc;
+	CVtFrameAccumulator<ImageType>					m_bright_acc;
+
+												
+	CVtLineCalib(const vt_ulong height
+							, const vt_ulong numChips
+							, const vt_bool hbin_flag
+							, const CVtAPI::API_TYPE api ) : m_calib( height, numChips )
+																						, m_chip_height( height )
+																						, m_numChips( numChips )
+	{
+		set_hbin( hbin_flag, api );
+	}
+
+	///
+	// set_hbin()
+	// turn on or off horizontal binning mode
+	//
+	void set_hbin(const vt_bool hbin_flag, const CVtAPI::API_TYPE api)
+	{
+		if (api == CVtAPI::PANO_API)
+		{
+			if (hbin_flag)
+			{
+				// hbin true i.e. there is horizontal binning
+				m_skip_count			=	SKIP_COUNT;
+				m_lext_start_col	= P_LEXT_START_COL;
+				m_lext_end_col		= P_LEXT_END_COL;
+				m_rext_start_col	= P_REXT_START_COL;
+				m_rext_end_col		= P_REXT_END_COL;
+			}
+			else
+			{
+				// hbin false i.e. no horizontal binning
+				m_skip_count			=	SKIP_COUNT;
+				m_lext_start_col	= 2*P_LEXT_START_COL;
+				m_lext_end_col		= 2*P_LEXT_END_COL;
+				m_rext_start_col	= 2*P_REXT_START_COL;
+				m_rext_end_col		= 2*P_REXT_END_COL;
+			}
+		}
+		else
+		{
+			if (hbin_flag)
+			{
+				// hbin true i.e. there is horizontal binning
+				m_skip_count			=	SKIP_COUNT;
+				m_lext_start_col	= C_LEXT_START_COL;
+				m_lext_end_col		= C_LEXT_END_COL;
+				m_rext_start_col	= C_REXT_START_COL;
+				m_rext_end_col		= C_REXT_END_COL;
+			}
+			else
+			{
+				// hbin false i.e. no horizontal binning
+				m_skip_count			=	SKIP_COUNT;
+				m_lext_start_col	= 2*C_LEXT_START_COL;
+				m_lext_end_col		= 2*C_LEXT_END_COL;
+				m_rext_start_col	= 2*C_REXT_START_COL;
+				m_rext_end_col		= 2*C_REXT_END_COL;
+			}
+		}
+	}
+
+	///
+	// Do coefficients calculation and calibration
+	//
+	// Try this version based on mean signal level.
+	// could try an alternative based on absolute differences.
+	//
+	void recalc()
+	{
+		m_calib.recalc();
+	}
+
+	///
+	// access functions
+	//
+	void set_dark(const CVtImage<ImageType>& dark_frame)
+	{
+		m_calib.set_dark(dark_frame);
+	}
+
+
+	void set_bright(const CVtImage<ImageType>& bright_frame, const vt_ulong half_index)
+	{
+		set_single_bright(bright_frame);
+	}
+
+	///
+	// accumulate dark and bright frames, the frames aren't kept. set_accumulated()
+	// makes the mean of the frames added the dark and bright frames.
+	//
+	void add_dark_frame(const CVtImage<ImageType>& dark_frame)
+	{
+		m_dark_acc.add( dark_frame );
+	}
+
+	void add_bright_frame(const CVtImage<ImageType>& bright_frame)
+	{
+		m_bright_acc.add( bright_frame );
+	}
+
+	const CVtFrameAccumulator<ImageType>& dark_accumulator() const
+	{
+		return m_dark_acc;
+	}
+
+	const CVtFrameAccumulator<ImageType>& bright_accumulator() const
+	{
+		return m_bright_acc;
+	}
+
+	void set_accumulated(const vt_ulong half_index)
+	{
+		if (m_dark_acc.count() > 0)
+		{
+			CVtImage<ImageType> *dark = m_dark_acc.mean();
+			set_dark( *dark );
+			delete dark;
+		}
+		if (m_bright_acc.count() > 0)
+		{
+			CVtImage<ImageType> *bright = m_bright_acc.mean();
+			set_bright( *bright, half_index );
+			delete bright;
+		}
+		m_dark_acc.reset();
+		m_bright_acc.reset();
+	}
+
+
+	///
+	// set the number of threads used to apply the calibration, 0 for all of them
+	//
+	void set_threads(const vt_ulong threads)
+	{
+		m_calib.set_threads( threads );
+	}
+
+	///
+	// set_geometry()
+	// the tile height and vertical binning mode of the frames
+	//
+	void set_geometry(const vt_ulong chip_height, const vt_bool vbin_flag)
+	{
+		m_chip_height = chip_height;
+		m_calib.set_geometry( chip_height, vbin_flag );
+	}
+
+	///
+	// store_in_bank()
+	// keep the current calibration in the calibration bank as the calibration for an api and
+	// binning mode. With derive_binned set a calibration of unbinned rows also gives the
+	// vertically binned modes, see derive_binned(). Returns true if binned modes were derived.
+	//
+	vt_bool store_in_bank(const CVtAPI::API_TYPE api, const BIN_MODE mode, const vt_bool derive_binned)
+	{
+		typedef CVtCalibBank<CoefType> BANK;
+
+		typename BANK::ENTRY entry;
+		if (!m_calib.get_rows( entry ))
+			return false;
+
+		BANK &bank = calib_bank<CoefType>();
+
+		bank.store( api, mode, entry );
+
+		if (!derive_binned || BANK::vbin( mode ))
+			return false;
+
+		typename BANK::ENTRY binned;
+		CVtHalfLineCalib<ImageType, CoefType>::derive_binned( entry, binned, m_numChips, api );
+
+		bank.store( api, BANK::with_vbin( mode, true ), binned );
+		return true;
+	}
+
+	///
+	// select_from_bank()
+	// use the calibration held in the bank for an api and binning mode, the geometry must
+	// already be set for the mode. Returns false if the bank has no calibration for it.
+	//
+	vt_bool select_from_bank(const CVtAPI::API_TYPE api, const BIN_MODE mode)
+	{
+		typename CVtCalibBank<CoefType>::ENTRY entry;
+
+		if (!calib_bank<CoefType>().find( api, mode, entry ) || entry.chip_height != m_chip_height)
+			return false;
+
+		m_calib.set_rows( entry );
+		return true;
+	}
+
+	///
+	// noise added to the rows interpolated across the tile cuts, 0 for none
+	//
+	void set_seam_noise(const vt_float sigma, const vt_ulong seed)
+	{
+		m_calib.set_seam_noise( sigma, seed );
+	}
+
+	///
+	// use the per pixel field, when there is one, in place of the per row calibration
+	//
+	void set_full_field(const vt_bool full_field)
+	{
+		m_calib.set_full_field( full_field );
+	}
+
+	///
+	// correct the ceph AB tile offset
+	//
+	void set_ab_correct(const vt_bool ab_correct)
+	{
+		m_calib.set_ab_correct( ab_correct );
+	}
+
+	///
+	// set_field()
+	// make the per pixel field from averaged acquisition frames. The frames are centred on
+	// half_index as the images to be calibrated are, see CVtpcImpAPI::centre(), columns
+	// outside the frames take the per row calibration. recalc() must have been called.
+	//
+	void set_field(const CVtImage<ImageType>& dark_frame
+								, const CVtImage<ImageType>& bright_frame
+								, const vt_ulong half_index
+								, const vt_ulong out_width)
+	{
+		CVtImage<ImageType> dark( out_width, dark_frame.height() );
+		CVtImage<ImageType> bright( out_width, bright_frame.height() );
+
+		centre( dark_frame, dark, half_index );
+		centre( bright_frame, bright, half_index );
+
+		m_calib.set_field( dark, bright );
+	}
+
+	///
+	// save and read the per pixel field
+	//
+	void save_field( std::string fname )
+	{
+		FILE *fpout = fopen( fname.c_str(), "wb" );
+
+		Vt_precondition(fpout != NULL, "CVtLineCalib::save_field failed to open output file\n" );
+
+		m_calib.save_field( fpout );
+
+		fclose(fpout);
+	}
+
+	vt_bool read_field(std::istream &IS)
+	{
+		return m_calib.read_field( IS );
+	}
+
+	///
+	// OK - these are the main application of the calibration functions
+	//
+	void operator () (const CVtImage<ImageType>& InFrame
+										, CVtImage<ImageType>& OutFrame
+										, const vt_ulong half_position
+										, const vt_bool dark_frame_calib
+										)
+	{
+		m_calib( InFrame, OutFrame, true );
+	}
+
+	///
+	// OK - these are the main application of the calibration functions
+	//
+	void operator () (const CVtImage<ImageType>& InFrame
+										, CVtImage<ImageType>& OutFrame
+										, const vt_ulong half_position
+										)
+	{
+		m_calib( InFrame, OutFrame );
+	}
+
+	///
+	// centre an acquired frame on half_position and calibrate it in one pass, OutFrame is the
+	// size of the centred image, see CVtHalfLineCalib::apply_centred()
+	//
+	void centre_calibrate(const CVtImage<ImageType>& AcqFrame
+											, CVtImage<ImageType>& OutFrame
+											, const vt_ulong half_position
+											, const vt_bool dark_frame_calib
+											)
+	{
+		vt_long start_idx = (vt_long) half_position - (vt_long) OutFrame.width()/2;
+		if (start_idx < 0)
+			start_idx = 0;
+
+		m_calib.apply_centred( AcqFrame, OutFrame, (vt_ulong) start_idx, dark_frame_calib );
+	}
+
+	///
+	// save calibration coefficients
+	//
+	void save( std::string fname )
+	{
+		FILE *fpout = fopen( fname.c_str(), "wb" );
+
+		Vt_precondition(fpout != NULL, "CVtLineCalib::save failed to open output file\n" );
+
+		m_calib.save(fpout);
+
+		fclose(fpout);
+	}
+
+  ///
+  // istream operator
+  //
+  friend std::istream& operator >> (std::istream& IS, CVtLineCalib<ImageType, CoefType>& Object)
+  {
+    Vt_precondition(IS.good() ? true : false, "CVtLineCalib::operator >> - Failed to open input file");
+	
+		// OK stream out left and right
+		IS >> Object.m_calib;
+
+    return IS;
+  }
+
+private:
+	///
+	// copy the columns of a frame either side of half_index into a row-major frame
+	//
+	static void centre(const CVtImage<ImageType>& frame, CVtImage<ImageType>& out, const vt_ulong half_index)
+	{
+		vt_long start_idx = (vt_long) half_index - (vt_long) out.width()/2;
+		if (start_idx < 0)
+			start_idx = 0;
+
+		vt_long cols = (vt_long) frame.width() - start_idx;
+		if (cols > (vt_long) out.width())
+			cols = out.width();
+
+		if (cols > 0)
+			copy_region( frame, Diff2D( start_idx, 0 ), out, Diff2D( 0, 0 ), Diff2D( cols, frame.height() ) );
+	}
+
+	void set_single_bright(const CVtImage<ImageType>& bright_frame)
+	{
+		double *smth_mean;
+		double *diff;
+
+		vt_ulong frm_chip_height = bright_frame.height();
+		vt_ulong frm_width = bright_frame.width();
+
+		smooth(bright_frame, smth_mean, diff);
+
+		vt_bool *mask = new vt_bool[frm_width];
+		memset( mask, false, sizeof(vt_bool) * frm_width );
+		vt_ulong cols = left_bmask( mask, smth_mean, diff, frm_width);
+    cols += right_bmask( mask, smth_mean, diff, frm_width);
+
+		// allocate first half image
+		CVtImage<ImageType> *brtp = new CVtImage<ImageType> ( cols, frm_chip_height );
+		CVtImage<ImageType> &brt  = *brtp;
+		//
+		// copy image
+		//
+		vt_ulong cnt = 0;
+		for (vt_ulong col = 0; col < frm_width; col++)
+		{
+			if (mask[col])
+			{
+				for (vt_ulong row = 0; row < frm_chip_height; row++)
+				{
+					ImageType data = bright_frame(col, row); 
+					brt[row][cnt] = data;
+				}
+				cnt++;
+			}
+		}
+		m_calib.set_bright(brt);
+
+		// clean up
+		if (mask != NULL)
+			delete [] mask;
+		if (smth_mean != NULL)
+			delete [] smth_mean;
+		if (diff != NULL)
+			delete [] diff;
+		if( brtp != NULL )
+			delete brtp; // delete this as copied to bright frame
+	}
+
+	///
+	//
+	// smooth
+	//
+	// calculate smoothed difference vector - returns 2 vectors
+	// these should be deleted in the calling function.
+	//
+	void smooth(const CVtImage<ImageType>& bright, vt_double_ptr &smth_mean, vt_double_ptr &df)
+	{
+		double *colmns = new double[bright.width()];
+		double bright_mn = col_mean(colmns, bright, m_chip_height, bright.height() );
+
+		smth_mean = new double[bright.width()]; //larger than require
+
+		memset( smth_mean, 0 , sizeof( smth_mean[0] )*bright.width() );
+
+		df = new double[bright.width()]; //larger than require
+		memset( df, 0 , sizeof( df[0] )*bright.width() );
+
+		// smooth colmeans
+		const vt_ulong smooth_span = CVtHalfLineCalib<ImageType, CoefType>::SMOOTH_SPAN;
+		if (bright.width() > 2*smooth_span)
+		{
+			box_filter( smth_mean, colmns, bright.width(), smooth_span );
+
+			// the first diff is left at 0
+			for( vt_ulong col = smooth_span + 1; col < bright.width() - smooth_span; col++ )
+			{
+				df[col] = smth_mean[col] - smth_mean[col-1];
+			}
+		}
+
+		delete [] colmns;
+	}
+	///
+	// left_bmask()
+	// create bright mask. Find the region of the image which is bright
+	//
+	// This code assumes that the central section of the image is elevated above.
+	// It finds the works in from the outside edges i.e. find the two outside shoulders.
+	//
+	vt_ulong left_bmask(vt_bool mask[], const vt_double smth_mean[], const vt_double diff[], const vt_ulong width)
+	{
+		vt_ulong start_col = (m_lext_start_col > width - 1) ? (width-1) : m_lext_start_col;
+		vt_ulong end_col   = (m_lext_end_col > width - 1) ? (width-1) : m_lext_end_col;
+
+		printf( "strt col %d end col %d\n", start_col, end_col );
+
+		vt_ulong cnt = 0;
+		for (vt_ulong col = start_col; col < end_col; col++,cnt++)
+		{
+			if (diff[col] > DF_THRESH)
+				break;
+
+			mask[col] = true;
+		}
+		return cnt;
+	}
+
+	///
+	// right_bmask()
+	// create bright mask. Find the region of the image which is bright
+	//
+	// This code assumes that the central section of the image is elevated above.
+	// It finds the works in from the outside edges i.e. find the two outside shoulders.
+	//
+	vt_ulong right_bmask(vt_bool mask[], const vt_double smth_mean[], const vt_double diff[], const vt_ulong width)
+	{
+		vt_ulong start_col = (m_rext_start_col > width - 1) ? (width-1) : m_rext_start_col;
+		vt_ulong end_col   = (m_rext_end_col > width - 1) ? (width-1) : m_rext_end_col;
+
+		printf( "strt col %d end col %d\n", start_col, end_col );
+
+		vt_ulong cnt = 0;
+		for (vt_ulong col = start_col; col < end_col; col++,cnt++)
+		{
+			if (diff[col] > DF_THRESH)
+				break;
+
+			mask[col] = true;
+		}
+		return cnt;
+	}
+}; // end of line calib
+
+} // Vt namespace
+
+
+#endif // __CVTPANORAMICCALIBRATION_H__
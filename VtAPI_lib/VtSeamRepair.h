@@ -0,0 +1,224 @@
+/** \file VtSeamRepair.h
+
+	\brief Interpolation across the gaps between the tiles of the pano and ceph sensors.
+
+	The sensor is made of three tiles, A, B and C, and the rows either side of each cut
+	don't see a full pixel. After calibration these rows are replaced by interpolating
+	between the good rows on either side. The Vt::CVtSeamRepair class holds the rows to
+	replace and the weight of each, worked out once for the tile height, and applies them
+	a whole row at a time with the kernels in VtKernels.h.
+
+	The interpolated rows are smoother than their neighbours. Optionally noise can be added
+	to them, it is drawn from a generator seeded for each frame so a given seed and frame
+	number always give the same image.
+
+ * Copyright (c) 2013 by
+ * All Rights Reserved
+ * REVISIONS:
+ * $Log: $
+ *
+ */
+
+#ifndef __CVTSEAMREPAIR_H__
+#define __CVTSEAMREPAIR_H__
+
+#include <vector>
+#include "VtSysdefs.h"
+#include "VtErrors.h"
+#include "VtKernels.h"
+
+namespace Vt {
+
+/**
+	\brief A small random number generator with the same sequence on every build.
+
+	A 32 bit linear congruential generator, only its top 16 bits are used. The normal values
+	are the sum of four uniform values, scaled to unit variance, which is close enough to
+	gaussian for noise and has no library maths in it.
+*/
+class CVtRandom
+{
+	vt_uint32 m_state;
+
+public:
+	explicit CVtRandom(const vt_uint32 seed = 0) : m_state( seed )
+	{}
+
+	void seed(const vt_uint32 seed)
+	{
+		m_state = seed;
+	}
+
+	//! the next 16 bit uniform value
+	vt_uint32 next()
+	{
+		m_state = m_state*1664525u + 1013904223u;
+		return m_state >> 16;
+	}
+
+	//! the next value from an approximately normal distribution, mean 0 standard deviation 1
+	vt_float normal()
+	{
+		const vt_uint32 total = next() + next() + next() + next();
+
+		// each uniform value has mean 32767.5 and variance 65536^2/12
+		return ((vt_float) total - 131070.0f)*(1.7320508f/65536.0f);
+	}
+};
+
+/**
+	\brief Replaces the rows either side of the tile cuts with interpolated values.
+
+	Each seam has two anchor rows, M above and P below, and every row replaced is
+	(wm*M + wp*P)/(wm + wp) for weights precomputed for that row. The weighted sum is exact
+	and the division is correctly rounded, so the result is the exact integer interpolation
+	whichever kernel is used.
+
+	Rows are replaced from the bottom of each seam up, the AB seam replaces its own M row and
+	that is written last so every row is interpolated from the original anchors.
+*/
+template<typename ImageType>
+class CVtSeamRepair
+{
+	struct SEAM_ROW
+	{
+		vt_ulong	row;
+		vt_ushort wm;
+		vt_ushort wp;
+	};
+
+	struct SEAM
+	{
+		vt_ulong							m_row;
+		vt_ulong							p_row;
+		std::vector<SEAM_ROW>	rows;
+	};
+
+	std::vector<SEAM>		m_seams;
+	vt_ulong						m_last_row;
+
+	vt_float						m_noise;
+	vt_uint32						m_seed;
+	std::vector<vt_float> m_noise_row;
+
+	//
+	// rows [first, p_row) interpolated between m_row and p_row, row r has wp = r - m_row + shift
+	//
+	void add_seam(const vt_ulong m_row, const vt_ulong p_row, const vt_ulong first, const vt_ulong shift)
+	{
+		SEAM seam;
+
+		seam.m_row = m_row;
+		seam.p_row = p_row;
+
+		const vt_ulong total = p_row - m_row;
+		for (vt_ulong row = first; row < p_row; row++)
+		{
+			SEAM_ROW r;
+
+			r.row = row;
+			r.wp	= (vt_ushort) (row - m_row + shift);
+			r.wm	= (vt_ushort) (total - r.wp);
+
+			seam.rows.push_back( r );
+		}
+
+		m_seams.push_back( seam );
+
+		if (p_row > m_last_row)
+			m_last_row = p_row;
+	}
+
+public:
+	CVtSeamRepair(const vt_ulong chip_height, const vt_bool vbin_flag) : m_last_row( 0 )
+																																		 , m_noise( 0.0f )
+																																		 , m_seed( 0 )
+	{
+		set_geometry( chip_height, vbin_flag );
+	}
+
+	virtual ~CVtSeamRepair() {}
+
+	/**
+	\brief Work out the seam rows and weights for a tile height and vertical binning.
+
+	The seam rows are the ones gap_fixAB() and gap_fix() used, measured on 2x vertically
+	binned frames. There are no measured seam positions for unbinned frames, so they get
+	the same rows, as they always have.
+
+	\param chip_height	the number of rows per tile
+	\param vbin_flag		true if the rows are binned in pairs
+	*/
+	void set_geometry(const vt_ulong chip_height, const vt_bool vbin_flag)
+	{
+		const vt_ulong ab	 = chip_height;
+		const vt_ulong bc	 = 2*chip_height;
+
+		Vt_precondition( chip_height > 9, "CVtSeamRepair::set_geometry - tiles too small" );
+
+		m_seams.clear();
+		m_last_row = 0;
+
+		// AB - a ramp from two rows above the cut onto the seventh row below it
+		add_seam( ab - 2, ab + 7, ab - 2, 1 );
+
+		// BC - the row above the cut from the rows either side of it
+		add_seam( bc - 2, bc, bc - 1, 0 );
+	}
+
+	/**
+	\brief Noise added to the interpolated rows.
+
+	\param sigma	standard deviation of the noise, 0 for none
+	\param seed		the seed, each frame number draws from its own sequence from this seed
+	*/
+	void set_noise(const vt_float sigma, const vt_uint32 seed)
+	{
+		m_noise = sigma;
+		m_seed	= seed;
+	}
+
+	/**
+	\brief Replace the seam rows of a row-major frame.
+
+	\param lines	the rows of the frame
+	\param width	the number of columns
+	\param height the number of rows
+	\param frame	the frame number, selects the noise sequence
+	*/
+	void operator () (ImageType **lines, const vt_ulong width, const vt_ulong height, const vt_ulong frame)
+	{
+		Vt_precondition( m_last_row < height, "CVtSeamRepair - frame too small for the seams" );
+
+		CVtRandom gen( m_seed ^ ((vt_uint32) frame*0x9E3779B9u) );
+
+		const vt_float *noise = NULL;
+		if (m_noise > 0.0f)
+		{
+			m_noise_row.resize( width );
+			noise = &m_noise_row[0];
+		}
+
+		for (vt_ulong idx = 0; idx < m_seams.size(); idx++)
+		{
+			const SEAM &seam = m_seams[idx];
+
+			for (vt_ulong r = seam.rows.size(); r-- > 0; )
+			{
+				const SEAM_ROW &row = seam.rows[r];
+
+				if (noise != NULL)
+				{
+					for (vt_ulong col = 0; col < width; col++)
+						m_noise_row[col] = m_noise*gen.normal();
+				}
+
+				lerp_row( lines[row.row], lines[seam.m_row], lines[seam.p_row], width, row.wm, row.wp, noise );
+			}
+		}
+	}
+};
+
+} // Vt namespace
+
+#endif // __CVTSEAMREPAIR_H__
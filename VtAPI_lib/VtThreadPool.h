@@ -0,0 +1,402 @@
+/** \file VtThreadPool.h
+
+	\brief A small pool of worker threads for splitting pixel processing into row bands.
+
+	Most of the calibration stages treat every row of a frame independently. The
+	Vt::CVtThreadPool class splits a range of rows into equal bands and runs one band on each
+	worker thread, the calling thread takes the first band itself. The band boundaries only
+	depend on the range and the number of bands, so a task which writes each row on its own
+	gives the same result whatever the number of threads.
+
+ * Copyright (c) 2013 by
+ * All Rights Reserved
+ * REVISIONS:
+ * $Log: $
+ *
+ */
+
+#ifndef __CVTTHREADPOOL_H__
+#define __CVTTHREADPOOL_H__
+
+#include <windows.h>
+#include <process.h>
+#include <exception>
+#include <string>
+#include <vector>
+#include "VtSysdefs.h"
+#include "VtErrors.h"
+#include "VtKernels.h"
+
+namespace Vt {
+
+/**
+	\brief A unit of work run by the thread pool over a band of rows.
+*/
+class CVtTask
+{
+public:
+	virtual ~CVtTask() {}
+
+	/**
+	\brief process rows [first, last)
+	*/
+	virtual void run(const vt_ulong first, const vt_ulong last) = 0;
+};
+
+/**
+	\brief Fixed set of worker threads which run a CVtTask over row bands.
+
+	One job runs at a time, run() returns when every band is complete. Each worker has its
+	own start event and only ever runs the band it is given, so there is no sharing of work
+	between threads and no ordering to get wrong.
+*/
+class CVtThreadPool
+{
+	struct WORKER
+	{
+		CVtThreadPool *pool;
+		vt_ulong			 index;
+		HANDLE				 thread;
+		HANDLE				 start;
+	};
+
+	std::vector<WORKER>	m_workers;
+	HANDLE							m_done;
+	CRITICAL_SECTION		m_lock;
+
+	// the current job
+	CVtTask							*m_task;
+	vt_ulong						m_first;
+	vt_ulong						m_last;
+	vt_ulong						m_bands;
+	volatile LONG				m_pending;
+	volatile LONG				m_failed;
+	std::string					m_error;		//!< what() of the first band to fail
+	vt_bool							m_stop;
+
+	CVtThreadPool(const CVtThreadPool &);
+	CVtThreadPool &operator=(const CVtThreadPool &);
+
+	//! first row of band number band
+	vt_ulong band_start(const vt_ulong band) const
+	{
+		return m_first + ((m_last - m_first)*band)/m_bands;
+	}
+
+	//! record a failed band, only the first failure keeps its message
+	void band_failed(const char *what)
+	{
+		if (::InterlockedCompareExchange( &m_failed, 1, 0 ) == 0)
+			m_error = what;
+	}
+
+	void run_band(const vt_ulong band)
+	{
+		try
+		{
+			m_task->run( band_start( band ), band_start( band + 1 ) );
+		}
+		catch(const std::exception &e)
+		{
+			band_failed( e.what() );
+		}
+		catch(...)
+		{
+			band_failed( "unknown exception" );
+		}
+
+		if (::InterlockedDecrement( &m_pending ) == 0)
+			::SetEvent( m_done );
+	}
+
+	static unsigned __stdcall worker(void *arg)
+	{
+		WORKER *self = (WORKER *) arg;
+
+		for (;;)
+		{
+			::WaitForSingleObject( self->start, INFINITE );
+
+			if (self->pool->m_stop)
+				break;
+
+			self->pool->run_band( self->index );
+		}
+		return 0;
+	}
+
+public:
+	/**
+	\brief Create the pool
+
+	\param num_threads the total number of threads including the caller, 0 for one per processor
+	*/
+	explicit CVtThreadPool(vt_ulong num_threads = 0)
+		: m_task( NULL )
+		, m_first( 0 )
+		, m_last( 0 )
+		, m_bands( 0 )
+		, m_pending( 0 )
+		, m_failed( 0 )
+		, m_stop( false )
+	{
+		if (num_threads == 0)
+		{
+			SYSTEM_INFO info;
+			::GetSystemInfo( &info );
+			num_threads = info.dwNumberOfProcessors;
+		}
+		if (num_threads == 0)
+			num_threads = 1;
+
+		::InitializeCriticalSection( &m_lock );
+		m_done = ::CreateEvent( NULL, FALSE, FALSE, NULL );
+
+		kernels(); // choose the kernels before there are threads to use them
+
+		// the caller is thread 0
+		m_workers.resize( num_threads - 1 );
+		for (vt_ulong idx = 0; idx < m_workers.size(); idx++)
+		{
+			WORKER &w = m_workers[idx];
+
+			w.pool	 = this;
+			w.index	 = idx + 1;
+			w.start	 = ::CreateEvent( NULL, FALSE, FALSE, NULL );
+			w.thread = (HANDLE) ::_beginthreadex( NULL, 0, worker, &w, 0, NULL );
+
+			Vt_precondition( w.start != NULL && w.thread != NULL, "CVtThreadPool - failed to start worker thread" );
+		}
+	}
+
+	/**
+	\brief Stop and release the workers.
+
+	Waits for every worker thread to exit, so none is still inside a band when the pool
+	is freed.
+	*/
+	virtual ~CVtThreadPool()
+	{
+		m_stop = true;
+		for (vt_ulong idx = 0; idx < m_workers.size(); idx++)
+		{
+			::SetEvent( m_workers[idx].start );
+		}
+		for (vt_ulong idx = 0; idx < m_workers.size(); idx++)
+		{
+			::WaitForSingleObject( m_workers[idx].thread, INFINITE );
+			::CloseHandle( m_workers[idx].thread );
+			::CloseHandle( m_workers[idx].start );
+		}
+		::CloseHandle( m_done );
+		::DeleteCriticalSection( &m_lock );
+	}
+
+	/**
+	\brief number of threads, including the caller
+	*/
+	vt_ulong size() const
+	{
+		return m_workers.size() + 1;
+	}
+
+	/**
+	\brief Run task over rows [first, last) split into equal bands.
+
+	\param task				the work to do, run() is called once per band
+	\param first			the first row
+	\param last				one past the last row
+	\param max_bands	upper limit on the number of bands, 0 for one per pool thread
+	*/
+	void run(CVtTask &task, const vt_ulong first, const vt_ulong last, const vt_ulong max_bands = 0)
+	{
+		vt_ulong bands = size();
+		if (max_bands != 0 && max_bands < bands)
+			bands = max_bands;
+		if (last - first < bands)
+			bands = last - first;
+
+		if (bands <= 1)
+		{
+			if (last > first)
+				task.run( first, last );
+			return;
+		}
+
+		::EnterCriticalSection( &m_lock );
+
+		m_task		= &task;
+		m_first		= first;
+		m_last		= last;
+		m_bands		= bands;
+		m_failed	= 0;
+		::InterlockedExchange( &m_pending, (LONG) bands );
+		::InterlockedIncrement( &kernel_users() );
+
+		for (vt_ulong band = 1; band < bands; band++)
+		{
+			::SetEvent( m_workers[band - 1].start );
+		}
+
+		run_band( 0 );
+
+		::WaitForSingleObject( m_done, INFINITE );
+
+		const vt_bool failed = (m_failed != 0);
+		const std::string error = "CVtThreadPool::run - task failed: " + m_error;
+		m_task = NULL;
+		m_error.erase();
+		::InterlockedDecrement( &kernel_users() );
+
+		::LeaveCriticalSection( &m_lock );
+
+		if (failed)
+		{
+			Vt_fail( error.c_str() );
+		}
+	}
+};
+
+/**
+	\brief A thread which runs one task in the background while the caller gets on with something else.
+
+	post() starts a task and returns at once, wait() returns when it is complete. post() waits
+	for the previous task first, so a capture loop can transfer one frame while the last one is
+	processed, with no queue and never more than one frame in hand.
+*/
+class CVtWorker
+{
+	HANDLE				m_thread;
+	HANDLE				m_start;
+	HANDLE				m_done;
+
+	// the current task
+	CVtTask				*m_task;
+	vt_ulong			m_first;
+	vt_ulong			m_last;
+	volatile LONG	m_failed;
+	std::string		m_error;	//!< what() of the failed task
+	vt_bool				m_busy;
+	vt_bool				m_stop;
+
+	CVtWorker(const CVtWorker &);
+	CVtWorker &operator=(const CVtWorker &);
+
+	static unsigned __stdcall worker(void *arg)
+	{
+		CVtWorker *self = (CVtWorker *) arg;
+
+		for (;;)
+		{
+			::WaitForSingleObject( self->m_start, INFINITE );
+
+			if (self->m_stop)
+				break;
+
+			try
+			{
+				self->m_task->run( self->m_first, self->m_last );
+			}
+			catch(const std::exception &e)
+			{
+				self->m_error = e.what();
+				::InterlockedExchange( &self->m_failed, 1 );
+			}
+			catch(...)
+			{
+				self->m_error = "unknown exception";
+				::InterlockedExchange( &self->m_failed, 1 );
+			}
+
+			::SetEvent( self->m_done );
+		}
+		return 0;
+	}
+
+public:
+	CVtWorker() : m_task( NULL )
+							, m_first( 0 )
+							, m_last( 0 )
+							, m_failed( 0 )
+							, m_busy( false )
+							, m_stop( false )
+	{
+		kernels(); // choose the kernels before there is a thread to use them
+
+		m_start	 = ::CreateEvent( NULL, FALSE, FALSE, NULL );
+		m_done	 = ::CreateEvent( NULL, FALSE, FALSE, NULL );
+		m_thread = (HANDLE) ::_beginthreadex( NULL, 0, worker, this, 0, NULL );
+
+		Vt_precondition( m_start != NULL && m_done != NULL && m_thread != NULL, "CVtWorker - failed to start thread" );
+	}
+
+	/**
+	\brief Finish the current task and stop the thread.
+	*/
+	virtual ~CVtWorker()
+	{
+		if (m_busy)
+		{
+			::WaitForSingleObject( m_done, INFINITE );
+			::InterlockedDecrement( &kernel_users() );
+		}
+
+		m_stop = true;
+		::SetEvent( m_start );
+		::WaitForSingleObject( m_thread, INFINITE );
+
+		::CloseHandle( m_thread );
+		::CloseHandle( m_start );
+		::CloseHandle( m_done );
+	}
+
+	/**
+	\brief Run task over rows [first, last) in the background, once the previous task is complete.
+	*/
+	void post(CVtTask &task, const vt_ulong first = 0, const vt_ulong last = 1)
+	{
+		wait();
+
+		m_task	= &task;
+		m_first = first;
+		m_last	= last;
+		m_busy	= true;
+		::InterlockedIncrement( &kernel_users() );
+
+		::SetEvent( m_start );
+	}
+
+	/**
+	\brief Wait for the current task, if there is one, to complete.
+	*/
+	void wait()
+	{
+		if (!m_busy)
+			return;
+
+		::WaitForSingleObject( m_done, INFINITE );
+		m_busy = false;
+		::InterlockedDecrement( &kernel_users() );
+
+		if (::InterlockedExchange( &m_failed, 0 ) != 0)
+		{
+			const std::string error = "CVtWorker - background task failed: " + m_error;
+			m_error.erase();
+
+			Vt_fail( error.c_str() );
+		}
+	}
+};
+
+/**
+	\brief The thread pool shared by the processing stages, one thread per processor
+*/
+inline CVtThreadPool &thread_pool()
+{
+	static CVtThreadPool pool;
+	return pool;
+}
+
+} // Vt namespace
+
+#endif // __CVTTHREADPOOL_H__
@@ -1,829 +1,1783 @@
-/** \file VthdsCalib.h
-
-	The calibration class for the hds sensor.
-
-	This class contains the main functions for performing capturing data, calculating the calibration 
-	coefficients and storing the calibration coefficients for the hds sensor.
-
-	Currently the calibration process for the hds sensor consists of two polynomial fits.
-
-* Copyright (c) 2013 by
-* All Rights Reserved
-* REVISIONS: 
-* $Log:  $
-*
-*/
-
-#ifndef __CVTHDSCALIB_H__
-#define __CVTHDSCALIB_H__
-
-namespace Vt {
-	
-/**
-* Big endian swapping
-*/
-template<typename T>
-	swap_bytes(T *inbuf, vt_ulong n1)
-{
-	int i;
-	vt_char *buf;
-	vt_char apu1,apu2,apu3,apu4;
-	
-	buf = (vt_char *)inbuf;
-	for(i=0;i<n1;i++)
-	{
-		apu1 = *buf++;
-		apu2 = *buf++;
-		apu3 = *buf++;
-		apu4 = *buf--;
-		buf--;
-		buf--;
-		*buf++ = apu4;
-		*buf++ = apu3;
-		*buf++ = apu2;
-		*buf++ = apu1;
-	}
-} 
-
-	
-template<typename SumType, typename ImageType>
-void sum(CVtImage<SumType>& out, const CVtImage<ImageType>& in )
-{
-	for(vt_ulong row = 0; row < in.height(); row++)
-	{
-		for(vt_ulong col = 0; col < in.width(); col++)
-		{
-			out[row][col] += in[row][col];
-		}
-	}
-}
-
-template<typename ImageType>
-void divide(CVtImage<ImageType>& im, const vt_double divisor )
-{
-	for(vt_ulong row = 0; row < im.height(); row++)
-	{
-		for(vt_ulong col = 0; col < im.width(); col++)
-		{
-			im[row][col] /= divisor;
-		}
-	}
-}
-	
-
-/**
-	When the calibration dark frames are acquired the reset voltage is varied. This defines the initial
-	reset voltage.
-*/
-#define START_CALIB_VOLTAGE			"VR_RESET_VOLTAGES_1_9V"
-
-/**
-	When the calibration dark frames are acquired the reset voltage is varied. 
-	This defines the final reset voltage.
-*/
-
-#define END_CALIB_VOLTAGE				"VR_RESET_VOLTAGES_3_9V"
-
-class CVthdsImpAPI;
-
-/**
-  \image html vatech.jpg
-
-	\brief 	The calibration class for the hds sensor.
-
-  \par REQUIREMENTS: 
-
-	This class contains the main functions for performing capturing data, calculating the calibration 
-	coefficients and storing the calibration coefficients for the hds sensor.
-
-	Currently the calibration process for the hds sensor consists of two polynomial fits.
-  
-	This is class which implements the hds calibration functions. It is a templatized class. The 
-	respective template parameters are
-		-# ImageType which holds the type for the images which are to be calibrated-
-		-# CoefType  this holds the type for the calibration coefficients.
-		-# MaskType  this holds the type for the bad pixel mask.
-*/
-
-template<typename ImageType
-					, typename CoefType
-					, typename MaskType	>
-class CVthdsCalib
-{
-public:
-	SENSOR_INFO m_hw_info;
-
-	typedef CVthdsLineParser::DATASET_ENTRY_TYPE DATASET_ENTRY_TYPE;
-
-	typedef std::multimap<std::string, std::string>	REFE_FNAMES;
-	/**
-	\brief The filenames for the intermediate data files.
-
-	This structure is initialised on construction by the routine init_fnames();
-
-	@see init_fnames();
-	*/
-	REFE_FNAMES m_refe_fnames;
-
-	typedef std::multimap<vt_ulong, vt_ulong>	FILTER_AVES;
-	/**
-	\typedef The collection class which holds the association between the filter number and the
-	number of bright frames acquire. e.g. the for the first filter type, filter number 0, requres 
-	4 images say.
-	*/
-	FILTER_AVES m_filt_nums;
-
-	/**
-	\typedef bright_names
-	The file names for the acquire bright images are stored in triples, two 
-	bright frame file names and one dark frame filename.
-	*/
-	typedef struct {
-		std::string data1;
-		std::string data2;
-		std::string refe;
-	} bright_names;
-
-	/**
-	\typedef BRIGHT_NAMES
-	This defines collection class where the bright filenames are stored.
-	*/
-	typedef std::multimap<vt_ulong, bright_names>	BRIGHT_FNAMES;
-	
-	/**
-	\var m_bright_names
-	This is the variable which holds the names for bright files.
-	*/
-
-	BRIGHT_FNAMES m_bright_fnames;
-
-	enum {
-		DARK_IMAGES_PER_AVE			= 20 //!< How many dark frames are averaged for each frame actually written out.
-		, BRIGHT_FILTERS				= 5  //!< How many bright filters are used to acquire the bright images.
-	};
-	/**
-	\brief The type for the 5th order polynomial coefficient.
-	*/
-	typedef vt_double POLY5COEF[6]; 
-	/**
-	\brief The type for the 3rd order polynomial coefficient.
-	*/
-	typedef vt_double POLY3COEF[3];
-
-	/**
-	\brief A 5th order polynomial coefficient image.
-	Each pixel of the m_cal5 image is a POLY5COEF type. Hence accessing the (row, col) pixel of such an image
-	actually references a vector or polynomial coefficients. Hence the following progressive dereferences 
-	are possible.
-	
-	\code
-	CoefType rowvec* m_cal[row];
-
-	CoefType coefs[] = rowvec[col];
-	\endcode
-
-	or alternatively
-
-	\code
-	poly( data, m_cal5[row][col], 5 );
-	\endcode
-	
-	@see poly.
-	*/
-	CVtImage<POLY5COEF>	m_cal5;
-
-	/**
-	\brief A 3rd order polynomial coefficient image.
-	Each pixel of the m_cal3 image is a POLY3COEF type. Hence accessing the (row, col) pixel of such an image
-	actually references a vector or polynomial coefficients. Hence the following progressive dereferences 
-	are possible.
-	
-	\code
-	CoefType rowvec* m_cal[row];
-
-	CoefType coefs[] = rowvec[col];
-	\endcode
-
-	or alternatively
-
-	\code
-	poly( data, m_cal3[row][col], 3 )
-	\endcode
-	
-	@see poly.
-	*/
-	CVtImage<POLY3COEF>	m_cal3;
-
-
-	CVtImage<ImageType>						 &m_dark;
-	CVtImage<MaskType>						 &m_mask;
-	CVtDataset<DATASET_ENTRY_TYPE> &m_data;
-
-	/**
-		\brief Hds calibration destructor
-
-		Currently just a place holder.
-	*/
-	virtual ~CVthdsCalib()	{}
-	
-	/**
-	 \brief hds calibration constructor
-	
-		\param data A reference to the system dataset. This object is actually owned by the system parser.
-		\param dark A reference to the most recent dark frame, this is currently owned by the api object.
-		\param mask A reference to the good pixel mask, this is currently owned by the api object.
-	*/
-	CVthdsCalib(CVtDataset<DATASET_ENTRY_TYPE> &data
-												, CVtImage<ImageType> &dark
-												, CVtImage<MaskType> &mask ) 
-												: m_data( data )
-												, m_dark( dark )
-												, m_mask( mask ) 
-	{
-		init_fnames();
-	}
-	/**
-	\brief Main calibration calculation routine.
-
-	The hds calibration process consists of the application of two polynomial fits. This function uses the information
-	stored in various intermediate files to calculate these polynomial coefficients.
-	*/
-	void recalc()
-	{
-	}
-
-	/**
-	\brief Add all the images together in the associated dataset
-
-	Because this routine has a reference the current system dataset object. It is possible 
-	to iterate through the dataset adding together all the images.
-
-	\param out the summed image.
-	*/
-
-	void sum(CVtImage<CoefType>& out )
-	{
-		for( CVtDataset<DATASET_ENTRY_TYPE>::iterator it = m_data.begin();
-				  it != m_data.end(); it++ 
-				)
-		{
-			CVtImage<vt_acq_im_type> *im = dynamic_cast<CVtImage<vt_acq_im_type>*>((*it).second);
-			if (im == NULL)
-				continue; // image incorrect type
-
-			Vt::sum( out, *im );
-		}
-	}
-
-	/**
-	\brief Capture bright frames
-
-	 During the calculation of the calibration coefficients a number of bright frames are 
-	 acquired. This code acquires each of the bright frame data sets and saves the data after
-	 each acquisition.
-
-	 Currently the code assumes that each bright dataset consists of three images. Two bright images 
-	 and one dark. The number of bright frames acquired various depending on the filter used.
-	 The number of bright frame acquire for a particular filter is stored tin the variable m_filt_nums.
-
-	 \sa m_filt_nums
-	*/
-	void bright_frames(CVthdsImpAPI& API)
-	{
-		printf( "BRIGHT FRAMES\n" );
-
-		vt_ulong image_height = API.image_height();
-		vt_ulong image_width  = API.image_width();
-
-		vt_ulong imno = 0;
-		API.m_dataset_size = 2;
-		for(vt_ulong filtno=0; filtno < BRIGHT_FILTERS; filtno++)
-		{
-			FILTER_AVES::iterator it = m_filt_nums.find( filtno );
-
-			vt_ulong  num_bright_aves = (*it).second;
-			printf( "Place Filter Number %d in place\n", filtno );
-			getchar();
-
-			for(vt_ulong idx = 0; idx < num_bright_aves; idx++)
-			{
-				// capture
-				API.capture();
-
-				// save the current data set
-				save_bright( imno++, API );
-			}
-		}
-		API.set_api_params(); // return dataset size to default
-	}
- 
-
-	/**
-	\brief Save bright frames
-	
-	 During the calculation of the calibration coefficients a number of bright frames are 
-	 acquired. This code saves the data set associated with each bright frame.
-	 The code assumes that the bright frame data sets contain three images, two bright frames and
-	 a single dark frame.
-
-	*/
-	void save_bright( const vt_ulong imageno, CVthdsImpAPI& API )
-	{
-	
-		CVtDataset<DATASET_ENTRY_TYPE>::iterator it = m_data.begin();
-		CVtImage<vt_acq_im_type> *refe  = dynamic_cast<CVtImage<vt_acq_im_type>*>((*it).second); it++;
-		CVtImage<vt_acq_im_type> *data1 = dynamic_cast<CVtImage<vt_acq_im_type>*>((*it).second); it++;
-		CVtImage<vt_acq_im_type> *data2 = dynamic_cast<CVtImage<vt_acq_im_type>*>((*it).second); 
-		
-		if (refe == NULL  || data1 == NULL  || data2 == NULL  )
-			// should we throw and exception here?
-			return;
-
-		BRIGHT_FNAMES::iterator bfnames_it = m_bright_fnames.find( imageno );
-		
-		std::string fname_base( HDS_CALIB_BRIGHT_FNAME_BASE );
-		std::string fname( fname_base );
-
-		fname.append( (*bfnames_it++).second.refe );
-		API.save_imfile( refe->lines(), sizeof( vt_acq_im_type )
-											, refe->width()
-											, refe->height()
-											, fname
-											, false );			
-
-		fname = fname_base;
-		fname.append( (*bfnames_it++).second.data1 );
-		API.save_imfile( data1->lines(), sizeof( vt_acq_im_type )
-											, data1->width()
-											, data1->height()
-											, fname
-											, false );			
-
-		fname = fname_base;
-		fname.append( (*bfnames_it).second.data2 );
-		API.save_imfile( data2->lines(), sizeof( vt_acq_im_type )
-											, data2->width()
-											, data2->height()
-											, fname
-											, false );			
-
-	}
-
-	/**
-		\brief Capture dark frames
-		This routine can be used to calculate the 
-	*/
-	void dark_frames(CVthdsImpAPI& API)
-	{
-		printf( "DARK FRAMES\n" );
-		API.send_command( std::string( HDS_DEFAULT_RESET_VOLTAGE ) );		
-
-		vt_ulong image_height = API.image_height();
-		vt_ulong image_width  = API.image_width();
-		
-    CVthdsImpAPI::CODE_PAIRS::iterator start = API.m_codes.find( START_CALIB_VOLTAGE );
-    CVthdsImpAPI::CODE_PAIRS::iterator end   = API.m_codes.find( END_CALIB_VOLTAGE );
-
-		CVtImage<CoefType> ave( image_width, image_height );    
-		for( CVthdsImpAPI::CODE_PAIRS::iterator it = start;
-				 it != end; 
-				 it++
-			 )
-		{
-			std::string command_str( (*it).first );
-
-			// prepare to capture data
-			API.arm( DARK_IMAGES_PER_AVE );
-
-			// software trigger
-			API.soft_trigger();
-
-			for(vt_ulong idx = 0; idx < DARK_IMAGES_PER_AVE; idx++)
-			{
-				// set reset voltage
-				API.send_command( command_str );
-
-				printf( "\n" );
-
-				// capture
-				API.m_driver.read_pipe();
-
-				// calculate average
-				sum( ave );
-
-				// remove currently acquired images
-				API.delete_dataset();
-			}
-			// divide image
-			divide( ave, DARK_IMAGES_PER_AVE );
-
-			// OK read the info
-			API.reset();
-
-			// save image
-			REFE_FNAMES::iterator it = m_refe_fnames.find( (*it).first );
-
-			if (it != m_refe_fnames.end() )
-			{
-				API.save_imfile( ave.lines(), sizeof( CoefType ), image_width, image_height, (*it).second, false );
-			}
-		}
-	}
-
-
-	/**
-	\brief Main calibration run
-
-	The calibration class contains functions to calculate the calibration coefficient and contains functions 
-	to apply the calibration coefficients. This the main function for calculation of the calibration coefficients.
-	
-	Currently the algorithm for this is;-
-		-# Acquire dark frames,
-	\code 
-			for start_reset_voltage to end_reset_voltage,
-			{
-				for number of dark frame averages
-				{
-					Acquire dark frames
-					Sum dark frame 
-				}
-
-				Save averaged dark frame for this reset volatage.
-			}
-	\endcode			
-		-# Acquire bright frames
-	\code 
-			for start_filter to end_filter
-			{
-				externally change filter 
-				for number of frame bright averages
-				{
-					Acquire bright frames
-					Sum dark frame 
-				}
-
-				Save averaged bright frame for this filter setting
-			}
-	\endcode			
-		-# Calculate calibration coefficients
-
-	*/
-
-	void calibration_run(CVthdsImpAPI& API)
-	{
-		// capture dark frames
-		dark_frames( API );
-
-		// capture bright frames
-		bright_frames( API );
-		
-		// calculate calibration coefficients
-		recalc(); 
-	}
-
-	/**
-	\brief polynomial expansion
-
-	The application of the calibration process to the acquire data involves the use of various calibration
-	coefficients.
-	*/
-	template<typename T>
-	vt_double poly(const T data, const CoefType *coefs, const vt_ulong order )
-	{
-		vt_double val = coefs[1] + coefs[0]*data;
-		for(vt_ulong coefno=2; coefno < order; coefno++)
-		{
-			val = coefs[coefno] + data*val;
-		}
-		val *= data;
-
-		return val;
-	}
-
-	
-	/**
-	  \brief Main application of calibration routine
-
-		This is the routine that is called after acquiring a dataset to produce a calibrated image.
-
-		\param out The calibrated image.
-		\param num_images The calibration process operates on a number of input images to produce an output image. This
-		parameter determines how many input images are used.
-	*/
-	void operator()( CVtImage<ImageType>& out, const vt_ulong num_images ) // how many images to use
-	{
-		Vt_precondition( m_data.size() == 0, "No images present" );
-		
-		// extract pointer from the various datasets
-		
-		CoefType *val3  = new CoefType [num_images-1];
-		CoefType *val5  = new CoefType [num_images-1];
-
-		for(vt_ulong row=0; row< m_mask.height();row++)
-		{
-			for(vt_ulong col=0; col< m_mask.width();col++)
-			{
-				CoefType dark = poly( m_dark[row][col], m_cal5[row][col], 5 );
-				CoefType sum  = 0.0;
-
-				CVtDataset<DATASET_ENTRY_TYPE>::iterator it = m_data.begin();
-				for(vt_ulong idx=0; it != m_data.end(); it++, idx++)
-				{
-					CVtImage<ImageType> *imp = dynamic_cast<CVtImage<ImageType>*>((*it).second);			
-					CVtImage<ImageType>& im  = *imp;
-					
-					ImageType data = im[row][col];
-								
-					CoefType I =  
-					sum += poly( data, m_cal5[row][col], 5 ) - dark;
-				}
-				CoefType ave = sum/num_images;
-				//
-				// calculate final image value
-				//
-				out[row][col] = (ImageType) poly( ave, m_cal3[row][col], 3 );
-			}
-		}
-		// tidy
-		if (val3 != NULL)
-			delete val3;
-		if (val5 != NULL)
-			delete val5;
-
-	}
-
-	/**
-	\brief Save calibration coefficients
-
-	Once calculated the calibrationcoefficients can be saved out to disk. The name of the calibration
-	coefficient file is saved in the hds API definition file VthdsAPI.h.
-
-	The calibration coefficients 
-	*/
-	void save( std::string fname )
-	{
-		FILE *fpout = fopen( fname.c_str(), "wb" );
-		
-		Vt_precondition(fpout != NULL, "CVthdsCalib::save failed to open output file\n" );
-		
-		// Read the header data
-		vt_ulong num_pix = GetAPI().image_height()*GetAPI().image_width();
-
-		fwrite( (const char *) m_hw_info.begin(), sizeof( vt_byte ), m_hw_info.length(), fpout );
-		fwrite( (const char *) m_cal5.begin(), sizeof( CoefType ), num_pix, fpout );
-		fwrite( (const char *) m_cal3.begin(), sizeof( CoefType ), num_pix, fpout );
-		fwrite( (const char *) m_mask.begin(), sizeof( MaskType ), num_pix, fpout );
-		
-		fclose(fpout);
-	}
-	
-	/**
-	\brief istream operator for the hds Calibration object.
-
-	This function allows the hds calibration object to tbe streamed in from disk.
-	Defined merely for convenience. This will normally be called from the hds implementation api
-	object (Vt::CVthdsImpAPI) init function.
-
-	\sa Vt::CVthdsImpAPI
-	*/
-
-	friend std::istream& operator >> (std::istream& IS
-																		, CVthdsCalib<ImageType, CoefType, MaskType>& Object)
-	{
-		CVtAPI &API = GetAPI();
-		
-		Vt_precondition(IS.good() ? true : false, "CVthdsCalib::operator >> - Failed to open input file");
-		
-		// Read the header data
-		vt_ulong width	 = API.image_width();
-		vt_ulong height  = API.image_height();
-		vt_ulong num_pix = width*height;
-		
-		//
-		// read in information about the current hardware
-		//
-		vt_ulong hwinfo_len = Object.m_hw_info.length();
-
-		vt_byte *hw_info_buf = new vt_byte[ hwinfo_len ];
-		IS.read( (char *) hw_info_buf, hwinfo_len );
-		Object.m_hw_info = hw_info_buf;
-
-		//
-		// read in 5th order coefficients
-		//
-		CoefType *ptr = (CoefType *) new vt_byte[ 6*num_pix*sizeof(CoefType) ];
-		IS.read( (char *) ptr, num_pix*sizeof(CoefType) );
-		
-		Object.m_cal5.resizeCopy( width, height, (POLY5COEF *)ptr );
-		
-		//
-		// read in 3rd order coefficients
-		//
-		ptr = (CoefType *) new vt_byte[ 3*num_pix*sizeof(CoefType) ];
-		IS.read( (char *) ptr, num_pix*sizeof(CoefType) );
-    
-		Object.m_cal3.resizeCopy( width, height, (POLY3COEF *)ptr );
-		
-		//
-		// read mask
-		//
-		MaskType *mask = new vt_byte[ num_pix*sizeof(MaskType) ];
-		IS.read( (char *) mask, num_pix*sizeof(MaskType) );
-		
-		Object.m_mask.resizeCopy( width, height, (MaskType *) mask );
-		
-		return IS;
-	}
-
-	/**
-	\brief Initialise the filenames used for 
-
-	The calibration process involves saving a number of intermediate files. This function initialises the 
-	file names that will be used for these intermediate files. The names are currently chosen to be consistent with
-	the labview implementation.
-	*/
-	void init_fnames()
-	{
-		std::pair<std::string, std::string>  refe_fname;
-
-		// dark image filenames
-		refe_fname.first  = "VR_RESET_VOLTAGES_1_8V";
-		refe_fname.second = "refe180.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_1_9V";
-		refe_fname.second = "refe190.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_2_0V";
-		refe_fname.second = "refe200.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_2_1V";
-		refe_fname.second = "refe210.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_2_2V";
-		refe_fname.second = "refe220.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_2_3V";
-		refe_fname.second = "refe230.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_2_4V";
-		refe_fname.second = "refe240.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_2_5V";
-		refe_fname.second = "refe250.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_2_6V";
-		refe_fname.second = "refe260.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_2_7V";
-		refe_fname.second = "refe270.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_2_8V";
-		refe_fname.second = "refe280.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_2_9V";
-		refe_fname.second = "refe290.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_3_0V";
-		refe_fname.second = "refe300.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_3_1V";
-		refe_fname.second = "refe310.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_3_2V";
-		refe_fname.second = "refe320.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_3_3V";
-		refe_fname.second = "refe330.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_3_4V";
-		refe_fname.second = "refe340.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_3_5V";
-		refe_fname.second = "refe350.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_3_6V";
-		refe_fname.second = "refe360.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_3_7V";
-		refe_fname.second = "refe370.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_3_8V";
-		refe_fname.second = "refe380.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_3_9V";
-		refe_fname.second = "refe390.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_4_0V";
-		refe_fname.second = "refe400.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_4_1V";
-		refe_fname.second = "refe410.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_4_2V";
-		refe_fname.second = "refe420.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_4_3V";
-		refe_fname.second = "refe430.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_4_4V";
-		refe_fname.second = "refe440.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		refe_fname.first  = "VR_RESET_VOLTAGES_4_5V";
-		refe_fname.second = "refe450.raw";
-		m_refe_fnames.insert(refe_fname);
-
-		// number of images used for each filter setting
-		std::pair<vt_ulong, vt_ulong>  filts;
-		filts.first  = 0; // filter number
-		filts.second = 4; // number of files bright images
-		m_filt_nums.insert(filts);
-
-		filts.first  = 1;
-		filts.second = 6;
-		m_filt_nums.insert(filts);
-
-		filts.first  = 2;
-		filts.second = 8;
-		m_filt_nums.insert(filts);
-
-		filts.first  = 3;
-		filts.second = 12;
-		m_filt_nums.insert(filts);
-
-		filts.first  = 4;
-		filts.second = 20;
-		m_filt_nums.insert(filts);
-
-		// filename for bright images
-		std::vector<std::string> suffix;
-		suffix.push_back( "r" );
-		suffix.push_back( "s" );
-		suffix.push_back( "t" );
-		suffix.push_back( "u" );
-		suffix.push_back( "v" );
-
-		vt_ulong cnt = 0;
-		vt_ulong idx = 0;
-
-		bright_names bfnames;
-
-		for(std::vector<std::string>::iterator sfx = suffix.begin(); sfx != suffix.end(); sfx++ )
-		{
-			FILTER_AVES::iterator num_filt_it = m_filt_nums.find( idx++ );
-			vt_ulong filt_num = (*num_filt_it).second;
-		
-			std::string data1( "data1." ); 
-			data1.append( (*sfx) );
-
-			std::string data2( "data2." ); 
-			data2.append( *sfx );
-			
-			std::string refe(  "refe." ) ;		
-			refe.append( *sfx );
-
-			for( vt_ulong filtno = 0; filtno < filt_num; filtno++, cnt++ )
-			{
-				char num_str[256];
-				std::string data1_fname( data1 ); data1_fname.append( itoa( filtno, num_str, 10 ) );
-				std::string data2_fname( data2 ); data2_fname.append( itoa( filtno, num_str, 10 ) );
-				std::string refe_fname( refe );		refe_fname.append( itoa( filtno, num_str, 10 ) );
-
-				bfnames.data1 = data1_fname;
-				bfnames.data2 = data2_fname;
-				bfnames.refe  = refe_fname;
-
-				m_bright_fnames.insert( std::pair<vt_ulong, bright_names>( cnt, bfnames)  );
-			}
-		}
-	}
-};
-
-} // Vt namespace
-#endif // __CVTHDSCALIB_H__
+/** \file VthdsCalib.h
+
+	The calibration class for the hds sensor.
+
+	This class contains the main functions for performing capturing data, calculating the calibration 
+	coefficients and storing the calibration coefficients for the hds sensor.
+
+	Currently the calibration process for the hds sensor consists of two polynomial fits.
+
+* Copyright (c) 2013 by
+* All Rights Reserved
+* REVISIONS: 
+* $Log:  $
+*
+*/
+
+#ifndef __CVTHDSCALIB_H__
+#define __CVTHDSCALIB_H__
+
+namespace Vt {
+	
+/**
+* Big endian swapping
+*/
+template<typename T>
+	swap_bytes(T *inbuf, vt_ulong n1)
+{
+	int i;
+	vt_char *buf;
+	vt_char apu1,apu2,apu3,apu4;
+	
+	buf = (vt_char *)inbuf;
+	for(i=0;i<n1;i++)
+	{
+		apu1 = *buf++;
+		apu2 = *buf++;
+		apu3 = *buf++;
+		apu4 = *buf--;
+		buf--;
+		buf--;
+		*buf++ = apu4;
+		*buf++ = apu3;
+		*buf++ = apu2;
+		*buf++ = apu1;
+	}
+} 
+
+	
+/**
+	\brief Add an image to a running sum, out += in, a line at a time with the kernels in VtKernels.h
+*/
+template<typename SumType, typename ImageType>
+void sum(CVtImage<SumType>& out, const CVtImage<ImageType>& in )
+{
+	Vt_precondition( out.layout() == in.layout() 
+								&& out.num_lines() == in.num_lines() && out.line_length() == in.line_length()
+								 , "sum - image geometry differs" );
+
+	for(vt_ulong line = 0; line < in.num_lines(); line++)
+	{
+		add_line( out[line], in[line], in.line_length() );
+	}
+}
+
+/**
+	\brief Divide every pixel of an image, im /= divisor
+*/
+template<typename ImageType>
+void divide(CVtImage<ImageType>& im, const vt_double divisor )
+{
+	for(vt_ulong line = 0; line < im.num_lines(); line++)
+	{
+		divide_line( im[line], im.line_length(), divisor );
+	}
+}
+	
+
+/**
+	When the calibration dark frames are acquired the reset voltage is varied. This defines the initial
+	reset voltage.
+*/
+#define START_CALIB_VOLTAGE			"VR_RESET_VOLTAGES_1_9V"
+
+/**
+	When the calibration dark frames are acquired the reset voltage is varied. 
+	This defines the final reset voltage.
+*/
+
+#define END_CALIB_VOLTAGE				"VR_RESET_VOLTAGES_3_9V"
+
+class CVthdsImpAPI;
+
+/**
+  \image html vatech.jpg
+
+	\brief 	The calibration class for the hds sensor.
+
+  \par REQUIREMENTS: 
+
+	This class contains the main functions for performing capturing data, calculating the calibration 
+	coefficients and storing the calibration coefficients for the hds sensor.
+
+	Currently the calibration process for the hds sensor consists of two polynomial fits.
+  
+	This is class which implements the hds calibration functions. It is a templatized class. The 
+	respective template parameters are
+		-# ImageType which holds the type for the images which are to be calibrated-
+		-# CoefType  this holds the type for the calibration coefficients.
+		-# MaskType  this holds the type for the bad pixel mask.
+*/
+
+template<typename ImageType
+					, typename CoefType
+					, typename MaskType	>
+class CVthdsCalib : public CVtDatasetConsumer
+{
+public:
+	SENSOR_INFO m_hw_info;
+
+	typedef CVthdsLineParser::DATASET_ENTRY_TYPE DATASET_ENTRY_TYPE;
+
+	typedef std::multimap<std::string, std::string>	REFE_FNAMES;
+	/**
+	\brief The filenames for the intermediate data files.
+
+	This structure is initialised on construction by the routine init_fnames();
+
+	@see init_fnames();
+	*/
+	REFE_FNAMES m_refe_fnames;
+
+	typedef std::multimap<vt_ulong, vt_ulong>	FILTER_AVES;
+	/**
+	\typedef The collection class which holds the association between the filter number and the
+	number of bright frames acquire. e.g. the for the first filter type, filter number 0, requres 
+	4 images say.
+	*/
+	FILTER_AVES m_filt_nums;
+
+	/**
+	\typedef bright_names
+	The file names for the acquire bright images are stored in triples, two 
+	bright frame file names and one dark frame filename.
+	*/
+	typedef struct {
+		std::string data1;
+		std::string data2;
+		std::string refe;
+	} bright_names;
+
+	/**
+	\typedef BRIGHT_NAMES
+	This defines collection class where the bright filenames are stored.
+	*/
+	typedef std::multimap<vt_ulong, bright_names>	BRIGHT_FNAMES;
+	
+	/**
+	\var m_bright_names
+	This is the variable which holds the names for bright files.
+	*/
+
+	BRIGHT_FNAMES m_bright_fnames;
+
+	enum {
+		DARK_IMAGES_PER_AVE			= 20 //!< How many dark frames are averaged for each frame actually written out.
+		, BRIGHT_FILTERS				= 5  //!< How many bright filters are used to acquire the bright images.
+	};
+	/**
+	\brief The number of coefficients of each polynomial, neither has a constant term.
+	*/
+	enum {
+		POLY5_ORDER							= 5		//!< Coefficients of the 5th order polynomial.
+		, POLY3_ORDER						= 3		//!< Coefficients of the 3rd order polynomial.
+		, MAX_SIGNAL						= 4095	//!< The largest 12 bit pixel value, the top of the range checked by coef_error().
+		, NUM_PLANES						= POLY5_ORDER + POLY3_ORDER	//!< The coefficient planes of a cache entry, see to_cache().
+	};
+	/**
+	\brief The coefficients of a pixel's 5th order polynomial as held in a calibration file.
+
+	The sixth value is not used.
+	*/
+	typedef vt_double POLY5COEF[6]; 
+	/**
+	\brief The coefficients of a pixel's 3rd order polynomial as held in a calibration file.
+	*/
+	typedef vt_double POLY3COEF[3];
+
+	/**
+	\brief The 5th order polynomial coefficients, a single precision plane for each coefficient.
+
+	Plane k holds coefficient k of every pixel, highest power first, so a line of pixels is
+	evaluated with one load from each plane, see poly_line(). The calibration files hold the
+	coefficients of each pixel together in double precision, they are converted once when
+	read, see set_coefs().
+	*/
+	CVtImage<vt_float>	m_cal5[POLY5_ORDER];
+
+	/**
+	\brief The 3rd order polynomial coefficients, a single precision plane for each coefficient.
+	*/
+	CVtImage<vt_float>	m_cal3[POLY3_ORDER];
+
+	/**
+	\brief The largest difference, in output levels, made by holding the coefficients in single precision.
+
+	\sa set_coefs(), coef_error()
+	*/
+	vt_double						m_coef_error;
+
+	/**
+	\brief The pixels of m_mask marked bad, replaced in each calibrated image by their good neighbours.
+
+	Made from the mask whenever the coefficients are set, see set_coefs().
+	*/
+	CVtDefectList				m_defects;
+
+	CVtImage<ImageType>						 &m_dark;
+	CVtImage<MaskType>						 &m_mask;
+	CVtDataset<DATASET_ENTRY_TYPE> &m_data;
+
+	vt_ulong												m_threads;	//!< threads used by operator(), 0 for one per processor
+
+	//
+	// the running sums of begin_stream(), fold() and end_stream()
+	//
+	std::vector<vt_float>						m_stream_sum;		//!< p5(frame) - p5(dark) summed over the frames
+	std::vector<vt_float>						m_stream_dark;	//!< p5(dark)
+	vt_ulong												m_stream_width;
+	vt_ulong												m_stream_height;
+	vt_ulong												m_stream_count;
+
+	/**
+		\brief Hds calibration destructor
+
+		Currently just a place holder.
+	*/
+	virtual ~CVthdsCalib()	{}
+	
+	/**
+	 \brief hds calibration constructor
+	
+		\param data A reference to the system dataset. This object is actually owned by the system parser.
+		\param dark A reference to the most recent dark frame, this is currently owned by the api object.
+		\param mask A reference to the good pixel mask, this is currently owned by the api object.
+	*/
+	CVthdsCalib(CVtDataset<DATASET_ENTRY_TYPE> &data
+												, CVtImage<ImageType> &dark
+												, CVtImage<MaskType> &mask ) 
+												: m_data( data )
+												, m_dark( dark )
+												, m_mask( mask ) 
+												, m_threads( 0 )
+												, m_stream_width( 0 )
+												, m_stream_height( 0 )
+												, m_stream_count( 0 )
+												, m_coef_error( 0.0 )
+	{
+		init_fnames();
+	}
+	/**
+	\brief A set of frames, all the same size.
+	*/
+	typedef std::vector<const CVtImage<ImageType>*> FRAMES;
+
+	/**
+	\brief The points of a set of fits, a row-major plane of points for each value fitted to.
+	*/
+	typedef std::vector< std::vector<vt_float> > POINTS;
+
+	/**
+	\brief The averaged dark frame of each reset voltage of the last sweep, see dark_frames().
+	*/
+	POINTS								 m_dark_points;
+	std::vector<vt_double> m_dark_means;		//!< the mean of each averaged dark frame
+
+	/**
+	\brief The averaged signal under each bright filter, see bright_frames().
+	*/
+	POINTS								 m_bright_points;
+
+	//
+	// the coefficient records between fit_dark() and fit_bright()
+	//
+	std::vector<vt_double> m_fit5;
+	std::vector<vt_double> m_fit3;
+
+	/**
+	\brief Main calibration calculation routine.
+
+	The hds calibration process consists of the application of two polynomial fits. This function uses the information
+	stored in various intermediate files to calculate these polynomial coefficients, calibration_run() fits the
+	frames it has just captured without reading them back.
+
+	The 5th order polynomial of each pixel maps its averaged dark frame at each reset voltage
+	of the sweep, START_CALIB_VOLTAGE up to but not including END_CALIB_VOLTAGE as dark_frames()
+	captures them, onto the mean of that frame over the sensor. The 3rd order polynomial then maps the pixel's signal under each bright filter,
+	p5(bright) - p5(dark) averaged over the filter's frames, onto the mean signal of the good
+	pixels. Both are least squares fits, made for a row of pixels at a time from the sums of
+	their normal equations and shared between the threads of the pool. A pixel whose fits
+	can't be solved is marked bad in m_mask.
+	*/
+	void recalc()
+	{
+		const vt_ulong width	 = GetAPI().image_width();
+		const vt_ulong height	 = GetAPI().image_height();
+		const vt_ulong num_pix = width*height;
+
+		//
+		// the dark frames of the reset voltage sweep
+		//
+		const REFE_FNAMES::iterator start = m_refe_fnames.lower_bound( START_CALIB_VOLTAGE );
+		const REFE_FNAMES::iterator end		= m_refe_fnames.lower_bound( END_CALIB_VOLTAGE );
+
+		m_dark_points.clear();
+		m_dark_means.clear();
+		m_dark_points.reserve( m_refe_fnames.size() );
+
+		for (REFE_FNAMES::iterator it = start; it != end; it++)
+		{
+			CVtImage<CoefType> ave( width, height, CVtImageBaseClass::COL_MAJOR );
+			if (!read_imfile( ave, (*it).second ))
+				continue;
+
+			m_dark_points.resize( m_dark_points.size() + 1 );
+
+			std::vector<vt_float> &points = m_dark_points.back();
+			points.resize( num_pix );
+
+			vt_double total = 0.0;
+			for (vt_ulong col = 0; col < width; col++)
+			{
+				const CoefType *src = ave[col];
+				for (vt_ulong row = 0; row < height; row++)
+				{
+					points[row*width + col] = (vt_float) src[row];
+					total += src[row];
+				}
+			}
+			m_dark_means.push_back( total/num_pix );
+		}
+
+		fit_dark( width, height );
+
+		//
+		// the signal under each bright filter
+		//
+		CVtImage<ImageType> refe( width, height );
+		CVtImage<ImageType> data1( width, height );
+		CVtImage<ImageType> data2( width, height );
+
+		FRAMES frames;
+		frames.push_back( &data1 );
+		frames.push_back( &data2 );
+
+		m_bright_points.assign( BRIGHT_FILTERS, std::vector<vt_float>() );
+
+		vt_ulong imno = 0;
+		for (vt_ulong filtno = 0; filtno < BRIGHT_FILTERS; filtno++)
+		{
+			const vt_ulong num_bright_aves = (*m_filt_nums.find( filtno )).second;
+
+			std::vector<vt_float> &signal = m_bright_points[filtno];
+			signal.assign( num_pix, 0.0f );
+
+			for (vt_ulong idx = 0; idx < num_bright_aves; idx++, imno++)
+			{
+				const bright_names &names = (*m_bright_fnames.find( imno )).second;
+				const std::string		fname_base( HDS_CALIB_BRIGHT_FNAME_BASE );
+
+				if (!read_frame( refe, fname_base + names.refe ) 
+				 || !read_frame( data1, fname_base + names.data1 ) 
+				 || !read_frame( data2, fname_base + names.data2 ))
+				{
+					Vt_fail( "CVthdsCalib::recalc - missing bright frame" );
+				}
+
+				add_signal( &signal[0], refe, frames );
+			}
+			divide_line( &signal[0], num_pix, 2.0*num_bright_aves );
+		}
+
+		fit_bright( width, height );
+	}
+
+	/**
+	\brief Fit the 5th order polynomials to m_dark_points and m_dark_means.
+
+	The mask is reset, p3 is left as p3(x) = x until fit_bright() and the dark points are released.
+	*/
+	void fit_dark(const vt_ulong width, const vt_ulong height)
+	{
+		const vt_ulong num_pix = width*height;
+
+		Vt_precondition( m_dark_points.size() > POLY5_ORDER && m_dark_points.size() == m_dark_means.size()
+									 , "CVthdsCalib::fit_dark - too few dark frames for the 5th order fit" );
+
+		m_mask.resize( width, height );
+		for (vt_ulong row = 0; row < height; row++)
+			memset( m_mask[row], 1, width*sizeof( MaskType ) );
+
+		m_fit5.assign( 6*num_pix, 0.0 );
+		m_fit3.assign( 3*num_pix, 0.0 );
+
+		fit( &m_fit5[0], 6, POLY5_ORDER, m_dark_points, m_dark_means, width, height );
+		POINTS().swap( m_dark_points );
+
+		// p3(x) = x until it is fitted
+		for (vt_ulong pix = 0; pix < num_pix; pix++)
+			m_fit3[3*pix + POLY3_ORDER - 1] = 1.0;
+
+		set_coefs( width, height, (const POLY5COEF *) &m_fit5[0], (const POLY3COEF *) &m_fit3[0] );
+	}
+
+	/**
+	\brief Fit the 3rd order polynomials to m_bright_points, after fit_dark().
+
+	Each filter's signal is fitted to its mean over the pixels with a good 5th order fit.
+	*/
+	void fit_bright(const vt_ulong width, const vt_ulong height)
+	{
+		Vt_precondition( m_fit5.size() == 6*width*height && m_bright_points.size() == BRIGHT_FILTERS
+									 , "CVthdsCalib::fit_bright - no 5th order fit or bright frames" );
+
+		std::vector<vt_double> bright_means;
+
+		for (vt_ulong filtno = 0; filtno < m_bright_points.size(); filtno++)
+		{
+			const std::vector<vt_float> &signal = m_bright_points[filtno];
+
+			vt_double total = 0.0;
+			vt_ulong	count = 0;
+			for (vt_ulong row = 0; row < height; row++)
+			{
+				const MaskType *good = m_mask[row];
+				for (vt_ulong col = 0; col < width; col++)
+				{
+					if (good[col])
+					{
+						total += signal[row*width + col];
+						count++;
+					}
+				}
+			}
+			bright_means.push_back( (count > 0) ? total/count : 0.0 );
+		}
+
+		fit( &m_fit3[0], 3, POLY3_ORDER, m_bright_points, bright_means, width, height );
+
+		set_coefs( width, height, (const POLY5COEF *) &m_fit5[0], (const POLY3COEF *) &m_fit3[0] );
+
+		POINTS().swap( m_bright_points );
+		std::vector<vt_double>().swap( m_fit5 );
+		std::vector<vt_double>().swap( m_fit3 );
+	}
+
+	/**
+	\brief The least squares fits of a band of rows, run on the thread pool by fit().
+	*/
+	struct FIT_TASK : public CVtTask
+	{
+		const POINTS								 *points;
+		const std::vector<vt_double> *targets;
+		vt_double										 *coefs;
+		vt_ulong											coef_stride;
+		vt_ulong											order;
+		vt_double											scale;
+		vt_ulong											width;
+		CVtImage<MaskType>					 *mask;
+
+		virtual void run(const vt_ulong first, const vt_ulong last)
+		{
+			const vt_ulong planes = 3*order - 1;
+
+			std::vector<vt_double> sums( planes*width );
+			std::vector<vt_byte>	 good( width );
+
+			for (vt_ulong row = first; row < last; row++)
+			{
+				sums.assign( planes*width, 0.0 );
+
+				for (vt_ulong idx = 0; idx < points->size(); idx++)
+				{
+					poly_sums_line( &sums[0], width, &(*points)[idx][row*width], (*targets)[idx], scale, order, width );
+				}
+
+				fit_poly_line( coefs + row*width*coef_stride, coef_stride, &sums[0], width, scale, order, width, &good[0] );
+
+				MaskType *pmask = (*mask)[row];
+				for (vt_ulong col = 0; col < width; col++)
+				{
+					if (!good[col])
+						pmask[col] = 0;
+				}
+			}
+		}
+	};
+
+	/**
+	\brief Fit a polynomial for every pixel, p(points[i]) = targets[i] in the least squares sense.
+
+	\param coefs				a record of coefficients for each pixel, highest power first
+	\param coef_stride	the size of each record
+	\param order				the number of coefficients
+	\param points			a plane of points for each target
+	\param targets			the values to fit to
+	\param width				the image width
+	\param height			the image height
+	*/
+	void fit(vt_double *coefs, const vt_ulong coef_stride, const vt_ulong order
+				 , const POINTS &points, const std::vector<vt_double> &targets
+				 , const vt_ulong width, const vt_ulong height)
+	{
+		// keep the powers near 1
+		vt_double range = 0.0;
+		for (vt_ulong idx = 0; idx < targets.size(); idx++)
+		{
+			if (fabs( targets[idx] ) > range)
+				range = fabs( targets[idx] );
+		}
+
+		FIT_TASK task;
+
+		task.points			 = &points;
+		task.targets		 = &targets;
+		task.coefs			 = coefs;
+		task.coef_stride = coef_stride;
+		task.order			 = order;
+		task.scale			 = (range > 0.0) ? 1.0/range : 1.0;
+		task.width			 = width;
+		task.mask				 = &m_mask;
+
+		thread_pool().run( task, 0, height, m_threads );
+	}
+
+	/**
+	\brief The signal of a set of frames added to a plane, run on the thread pool by add_signal().
+	*/
+	struct SIGNAL_TASK : public CVtTask
+	{
+		const CVthdsCalib					*calib;
+		const CVtImage<ImageType> *dark;
+		const FRAMES							*frames;
+		vt_float									*signal;
+
+		virtual void run(const vt_ulong first, const vt_ulong last)
+		{
+			const vt_ulong width = dark->width();
+
+			std::vector<vt_float> dark_sig( width );
+
+			const vt_float *cal5[POLY5_ORDER];
+			const vt_float *cal3[POLY3_ORDER];
+
+			for (vt_ulong row = first; row < last; row++)
+			{
+				calib->coef_lines( cal5, cal3, row );
+
+				add_signal_line( signal + row*width, &dark_sig[0], cal5, (*dark)[row], *frames, row, width );
+			}
+		}
+	};
+
+	/**
+	\brief Add the signal of a set of frames, p5(frame) - p5(dark) for each, to a row-major plane.
+	*/
+	void add_signal(vt_float *signal, const CVtImage<ImageType> &dark, const FRAMES &frames)
+	{
+		SIGNAL_TASK task;
+
+		task.calib	= this;
+		task.dark		= &dark;
+		task.frames = &frames;
+		task.signal = signal;
+
+		thread_pool().run( task, 0, dark.height(), m_threads );
+	}
+
+	/**
+	\brief Read an image file written by CVtAPI::save_imfile() a column at a time.
+
+	\param im			a column-major image of the size of the file
+	\param fname	the file
+	\return false if the file is missing or too short
+	*/
+	template<typename T>
+	static vt_bool read_imfile(CVtImage<T> &im, const std::string &fname)
+	{
+		Vt_precondition( im.layout() == CVtImageBaseClass::COL_MAJOR, "CVthdsCalib::read_imfile - image must be column-major" );
+
+		FILE *fpin = fopen( fname.c_str(), "rb" );
+		if (fpin == NULL)
+			return false;
+
+		const vt_ulong num = im.width()*im.height();
+		const vt_ulong got = fread( (char *) im.begin(), sizeof( T ), num, fpin );
+
+		fclose( fpin );
+		return got == num;
+	}
+
+	/**
+	\brief Read a frame written a column at a time into a row-major image of the same size.
+	*/
+	static vt_bool read_frame(CVtImage<ImageType> &im, const std::string &fname)
+	{
+		CVtImage<ImageType> cols( im.width(), im.height(), CVtImageBaseClass::COL_MAJOR, uninit_allocator() );
+
+		if (!read_imfile( cols, fname ))
+			return false;
+
+		transpose_lines( im.lines(), cols.lines(), 0, im.height(), im.width() );
+		return true;
+	}
+
+	/**
+	\brief Add all the images together in the associated dataset
+
+	Because this routine has a reference the current system dataset object. It is possible 
+	to iterate through the dataset adding together all the images.
+
+	\param out the summed image.
+	*/
+
+	void sum(CVtImage<CoefType>& out )
+	{
+		for( CVtDataset<DATASET_ENTRY_TYPE>::iterator it = m_data.begin();
+				  it != m_data.end(); it++ 
+				)
+		{
+			CVtImage<vt_acq_im_type> *im = dynamic_cast<CVtImage<vt_acq_im_type>*>(m_data.fetch( it ));
+			if (im == NULL)
+				continue; // image incorrect type
+
+			Vt::sum( out, *im );
+		}
+	}
+
+	/**
+	\brief Capture bright frames
+
+	 During the calculation of the calibration coefficients a number of bright frames are 
+	 acquired. This code acquires each of the bright frame data sets and saves the data after
+	 each acquisition.
+
+	 Currently the code assumes that each bright dataset consists of three images. Two bright images 
+	 and one dark. The number of bright frames acquired various depending on the filter used.
+	 The number of bright frame acquire for a particular filter is stored tin the variable m_filt_nums.
+
+	 The frames are taken from the dataset after each capture, so streamCalib is turned off for
+	 the sweep and restored afterwards, see STREAM_OFF.
+
+	 \sa m_filt_nums
+	*/
+	void bright_frames(CVthdsImpAPI& API)
+	{
+		printf( "BRIGHT FRAMES\n" );
+
+		STREAM_OFF stream_off( API.m_streamCalib );
+
+		const vt_ulong num_pix = API.image_width()*API.image_height();
+
+		m_bright_points.assign( BRIGHT_FILTERS, std::vector<vt_float>() );
+
+		BRIGHT_TASK task;
+		task.calib = this;
+
+		// after the task, so a throw waits for the worker before the task goes
+		CVtWorker		worker;
+
+		vt_ulong imno = 0;
+		API.m_dataset_size = 3; // a dark frame and two bright frames
+		for(vt_ulong filtno=0; filtno < BRIGHT_FILTERS; filtno++)
+		{
+			FILTER_AVES::iterator it = m_filt_nums.find( filtno );
+
+			vt_ulong  num_bright_aves = (*it).second;
+
+			// the last set of the previous filter is added while the filter is changed
+			printf( "Place Filter Number %d in place\n", filtno );
+			getchar();
+
+			worker.wait();
+			if (filtno > 0)
+				divide_line( &m_bright_points[filtno - 1][0], num_pix, 2.0*(*m_filt_nums.find( filtno - 1 )).second );
+
+			m_bright_points[filtno].assign( num_pix, 0.0f );
+
+			for(vt_ulong idx = 0; idx < num_bright_aves; idx++)
+			{
+				// capture, while the last set is added to the signal
+				API.capture();
+
+				// save the current data set
+				save_bright( imno++, API );
+
+				worker.wait();
+
+				// hand the set over to the worker, it deletes the frames
+				task.data2	= pop_frame( API );
+				task.data1	= pop_frame( API );
+				task.refe		= pop_frame( API );
+				task.signal = &m_bright_points[filtno][0];
+
+				worker.post( task );
+
+				// remove anything else acquired
+				API.delete_dataset();
+			}
+		}
+		worker.wait();
+		divide_line( &m_bright_points[BRIGHT_FILTERS - 1][0], num_pix, 2.0*(*m_filt_nums.find( BRIGHT_FILTERS - 1 )).second );
+
+		API.set_api_params(); // return dataset size to default
+	}
+ 
+	/**
+	\brief Turns streamCalib off while it is in scope and restores it after, even when an exception is thrown.
+
+	With streamCalib set CVthdsImpAPI::capture() folds the frames into the calibrated image
+	and doesn't keep them, the calibration sweep needs the frames themselves.
+	*/
+	struct STREAM_OFF
+	{
+		vt_bool				&flag;
+		const vt_bool	saved;
+
+		explicit STREAM_OFF(vt_bool &stream_calib) : flag( stream_calib ), saved( stream_calib )
+		{
+			flag = false;
+		}
+
+		~STREAM_OFF()
+		{
+			flag = saved;
+		}
+
+	private:
+		STREAM_OFF &operator=(const STREAM_OFF &);
+	};
+
+	/**
+	\brief A set of bright frames added to the signal of a filter, run by bright_frames() on a CVtWorker.
+
+	The task owns the frames and deletes them once they are added.
+	*/
+	struct BRIGHT_TASK : public CVtTask
+	{
+		CVthdsCalib					*calib;
+		CVtImage<ImageType> *refe;
+		CVtImage<ImageType> *data1;
+		CVtImage<ImageType> *data2;
+		vt_float						*signal;
+
+		BRIGHT_TASK() : calib( NULL ), refe( NULL ), data1( NULL ), data2( NULL ), signal( NULL )
+		{}
+
+		virtual ~BRIGHT_TASK()
+		{
+			release();
+		}
+
+		void release()
+		{
+			delete refe;
+			delete data1;
+			delete data2;
+
+			refe	= NULL;
+			data1 = NULL;
+			data2 = NULL;
+		}
+
+		virtual void run(const vt_ulong, const vt_ulong)
+		{
+			FRAMES frames;
+			frames.push_back( data1 );
+			frames.push_back( data2 );
+
+			calib->add_signal( signal, *refe, frames );
+			release();
+		}
+	};
+
+	/**
+	\brief The frames of one reset voltage added to the sums, run by dark_frames() on a CVtWorker.
+
+	The task owns the frame and deletes it once it is added.
+	*/
+	struct DARK_TASK : public CVtTask
+	{
+		CVtFrameAccumulator<ImageType> *acc;
+		CVtImage<ImageType>						 *frame;
+
+		DARK_TASK() : acc( NULL ), frame( NULL )
+		{}
+
+		virtual ~DARK_TASK()
+		{
+			delete frame;
+		}
+
+		virtual void run(const vt_ulong, const vt_ulong)
+		{
+			acc->add( *frame );
+
+			delete frame;
+			frame = NULL;
+		}
+	};
+
+	/**
+	\brief Take the last acquired frame out of the dataset, the caller owns it.
+	*/
+	static CVtImage<ImageType> *pop_frame(CVthdsImpAPI& API)
+	{
+		CVtImageBaseClass		*im		 = API.pop_back( CVtAPI::ACQ_IM ).second;
+		CVtImage<ImageType> *frame = dynamic_cast<CVtImage<ImageType>*>( im );
+
+		if (frame == NULL)
+		{
+			delete im;
+			Vt_fail( "CVthdsCalib::pop_frame - acquired frame of the wrong type" );
+		}
+
+		Vt_precondition( frame->layout() == CVtImageBaseClass::ROW_MAJOR, "CVthdsCalib::pop_frame - acquired frame must be row-major" );
+		return frame;
+	}
+
+	/**
+	\brief Save bright frames
+	
+	 During the calculation of the calibration coefficients a number of bright frames are 
+	 acquired. This code saves the data set associated with each bright frame.
+	 The code assumes that the bright frame data sets contain three images, two bright frames and
+	 a single dark frame.
+
+	*/
+	void save_bright( const vt_ulong imageno, CVthdsImpAPI& API )
+	{
+	
+		CVtDataset<DATASET_ENTRY_TYPE>::iterator it = m_data.begin();
+		CVtImage<vt_acq_im_type> *refe  = dynamic_cast<CVtImage<vt_acq_im_type>*>(m_data.fetch( it )); it++;
+		CVtImage<vt_acq_im_type> *data1 = dynamic_cast<CVtImage<vt_acq_im_type>*>(m_data.fetch( it )); it++;
+		CVtImage<vt_acq_im_type> *data2 = dynamic_cast<CVtImage<vt_acq_im_type>*>(m_data.fetch( it )); 
+		
+		if (refe == NULL  || data1 == NULL  || data2 == NULL  )
+			// should we throw and exception here?
+			return;
+
+		BRIGHT_FNAMES::iterator bfnames_it = m_bright_fnames.find( imageno );
+		
+		std::string fname_base( HDS_CALIB_BRIGHT_FNAME_BASE );
+		std::string fname( fname_base );
+
+		fname.append( (*bfnames_it).second.refe );
+		API.save_imfile( *refe, fname, false );			
+
+		fname = fname_base;
+		fname.append( (*bfnames_it).second.data1 );
+		API.save_imfile( *data1, fname, false );			
+
+		fname = fname_base;
+		fname.append( (*bfnames_it).second.data2 );
+		API.save_imfile( *data2, fname, false );			
+
+	}
+
+	/**
+	\brief Capture dark frames
+
+	DARK_IMAGES_PER_AVE frames are averaged at each reset voltage of the sweep. Each frame is
+	added to the sums on a CVtWorker while the next is transferred, so the sweep takes no
+	longer than its transfers. The averages are kept in m_dark_points for fit_dark() and
+	written to the m_refe_fnames files for recalc().
+	*/
+	void dark_frames(CVthdsImpAPI& API)
+	{
+		printf( "DARK FRAMES\n" );
+		API.send_command( std::string( HDS_DEFAULT_RESET_VOLTAGE ) );		
+
+		vt_ulong image_height = API.image_height();
+		vt_ulong image_width  = API.image_width();
+		
+    CVthdsImpAPI::CODE_PAIRS::iterator start = API.m_codes.find( START_CALIB_VOLTAGE );
+    CVthdsImpAPI::CODE_PAIRS::iterator end   = API.m_codes.find( END_CALIB_VOLTAGE );
+
+		m_dark_points.clear();
+		m_dark_means.clear();
+		m_dark_points.reserve( m_refe_fnames.size() );
+
+		CVtFrameAccumulator<ImageType>	acc;
+		DARK_TASK												task;
+		task.acc = &acc;
+
+		// after the task and the sums, so a throw waits for the worker before they go
+		CVtWorker												worker;
+
+		CVtImage<CoefType> ave( image_width, image_height );    
+		for( CVthdsImpAPI::CODE_PAIRS::iterator it = start;
+				 it != end; 
+				 it++
+			 )
+		{
+			std::string command_str( (*it).first );
+
+			acc.reset();
+
+			// prepare to capture data
+			API.arm( DARK_IMAGES_PER_AVE );
+
+			// software trigger
+			API.soft_trigger();
+
+			for(vt_ulong idx = 0; idx < DARK_IMAGES_PER_AVE; idx++)
+			{
+				// set reset voltage
+				API.send_command( command_str );
+
+				// capture, while the last frame is added to the sums
+				API.m_driver.read_pipe();
+
+				worker.wait();
+				task.frame = pop_frame( API );
+				worker.post( task );
+
+				// remove anything else acquired
+				API.delete_dataset();
+			}
+			worker.wait();
+
+			// OK read the info
+			API.reset();
+
+			// the average for the fit
+			m_dark_points.resize( m_dark_points.size() + 1 );
+
+			std::vector<vt_float> &points = m_dark_points.back();
+			points.resize( image_width*image_height );
+			acc.mean_values( &points[0] );
+
+			vt_double total = 0.0;
+			for (vt_ulong pix = 0; pix < points.size(); pix++)
+				total += points[pix];
+			m_dark_means.push_back( total/points.size() );
+
+			// save image
+			REFE_FNAMES::iterator fit = m_refe_fnames.find( (*it).first );
+
+			if (fit != m_refe_fnames.end() )
+			{
+				for (vt_ulong row = 0; row < image_height; row++)
+				{
+					CoefType			 *dst = ave[row];
+					const vt_float *src = &points[row*image_width];
+
+					for (vt_ulong col = 0; col < image_width; col++)
+						dst[col] = src[col];
+				}
+				API.save_imfile( ave, (*fit).second, false );
+			}
+		}
+	}
+
+
+	/**
+	\brief Main calibration run
+
+	The calibration class contains functions to calculate the calibration coefficient and contains functions 
+	to apply the calibration coefficients. This the main function for calculation of the calibration coefficients.
+	
+	Currently the algorithm for this is;-
+		-# Acquire dark frames,
+	\code 
+			for start_reset_voltage to end_reset_voltage,
+			{
+				for number of dark frame averages
+				{
+					Acquire dark frames
+					Sum dark frame 
+				}
+
+				Save averaged dark frame for this reset volatage.
+			}
+	\endcode			
+		-# Fit the 5th order polynomials to the averaged dark frames, held in memory
+		-# Acquire bright frames
+	\code 
+			for start_filter to end_filter
+			{
+				externally change filter 
+				for number of frame bright averages
+				{
+					Acquire bright frames
+					Sum dark frame 
+				}
+
+				Save averaged bright frame for this filter setting
+			}
+	\endcode			
+		-# Fit the 3rd order polynomials to the bright signal, held in memory
+
+	Each frame is added in the background while the next is captured. The frames are also
+	saved, so recalc() can repeat the fits later from the files.
+
+	*/
+
+	void calibration_run(CVthdsImpAPI& API)
+	{
+		const vt_ulong width	= API.image_width();
+		const vt_ulong height = API.image_height();
+
+		// capture dark frames and fit the 5th order polynomials, the bright signal needs them
+		dark_frames( API );
+		fit_dark( width, height );
+
+		// capture bright frames and fit the 3rd order polynomials
+		bright_frames( API );
+		fit_bright( width, height );
+	}
+
+	/**
+	\brief polynomial expansion
+
+	The application of the calibration process to the acquire data involves the use of various calibration
+	coefficients.
+	*/
+	template<typename T>
+	vt_double poly(const T data, const CoefType *coefs, const vt_ulong order )
+	{
+		vt_double val = coefs[1] + coefs[0]*data;
+		for(vt_ulong coefno=2; coefno < order; coefno++)
+		{
+			val = coefs[coefno] + data*val;
+		}
+		val *= data;
+
+		return val;
+	}
+
+	/**
+	\brief poly() in single precision, the sums done by poly_line() for each pixel.
+	*/
+	static vt_float fpoly(const vt_float data, const vt_float *coefs, const vt_ulong order )
+	{
+		vt_float val = coefs[1] + coefs[0]*data;
+		for(vt_ulong coefno=2; coefno < order; coefno++)
+		{
+			val = coefs[coefno] + data*val;
+		}
+		val *= data;
+
+		return val;
+	}
+
+	
+	/**
+	\brief Add the signal of a row of frames, sig += p5(frame) - p5(dark) for each frame.
+
+	\param sig				the row of sums
+	\param dark_sig	a row of workspace, left holding p5(dark)
+	\param cal5			the 5th order coefficient lines of the row
+	\param dark			the row of the dark frame
+	\param frames		the frames
+	\param row				the row
+	\param width			the number of pixels in the row
+	*/
+	static void add_signal_line(vt_float *sig, vt_float *dark_sig, const vt_float *const *cal5
+														, const ImageType *dark, const FRAMES &frames, const vt_ulong row, const vt_ulong width)
+	{
+		poly_line( dark_sig, dark, cal5, POLY5_ORDER, width );
+
+		for (vt_ulong idx = 0; idx < frames.size(); idx++)
+		{
+			poly_line( sig, (*frames[idx])[row], cal5, POLY5_ORDER, width, dark_sig );
+		}
+	}
+
+	/**
+	\brief Make a row of the calibrated image from a row of signal sums, p3(sig/num).
+
+	\param out	the calibrated row
+	\param sig	the sums, left holding the unclamped result
+	\param cal3	the 3rd order coefficient lines of the row
+	\param num	the number of frames summed
+	\param width	the number of pixels in the row
+	*/
+	static void finish_line(ImageType *out, vt_float *sig, const vt_float *const *cal3, const vt_double num, const vt_ulong width)
+	{
+		divide_line( sig, width, num );
+
+		poly_line( sig, sig, cal3, POLY3_ORDER, width );
+		clamp_line( out, sig, width );
+	}
+
+	/**
+	\brief The calibration of a band of rows, run on the thread pool by operator().
+
+	Each row is worked on whole, one frame after another, so the coefficients of a row are
+	read once per frame from cache rather than once per frame from memory.
+	*/
+	struct APPLY_TASK : public CVtTask
+	{
+		const CVthdsCalib	 *calib;
+		FRAMES							frames;
+		CVtImage<ImageType> *out;
+
+		virtual void run(const vt_ulong first, const vt_ulong last)
+		{
+			const vt_ulong	width = out->width();
+			const vt_double num		= (vt_double) frames.size();
+
+			std::vector<vt_float> dark( width );
+			std::vector<vt_float> ave( width );
+
+			const vt_float *cal5[POLY5_ORDER];
+			const vt_float *cal3[POLY3_ORDER];
+
+			for (vt_ulong row = first; row < last; row++)
+			{
+				calib->coef_lines( cal5, cal3, row );
+
+				ave.assign( width, 0.0f );
+				add_signal_line( &ave[0], &dark[0], cal5, calib->m_dark[row], frames, row, width );
+
+				finish_line( (*out)[row], &ave[0], cal3, num, width );
+			}
+		}
+	};
+
+	/**
+	  \brief Main application of calibration routine
+
+		This is the routine that is called after acquiring a dataset to produce a calibrated image.
+
+		Each pixel of each frame is put through the 5th order polynomial of the pixel and the dark
+		frame's value is subtracted, the average over the frames is then put through the 3rd order
+		polynomial. The frames are looked up once, and the rows are shared between the threads of
+		the pool.
+
+		\param out The calibrated image.
+		\param num_images The calibration process operates on a number of input images to produce an output image. This
+		parameter determines how many input images are used.
+	*/
+	void operator()( CVtImage<ImageType>& out, const vt_ulong num_images ) // how many images to use
+	{
+		Vt_precondition( m_data.size() > 0, "No images present" );
+
+		// extract pointer from the various datasets
+		APPLY_TASK task;
+
+		task.calib = this;
+		task.out	 = &out;
+
+		for( CVtDataset<DATASET_ENTRY_TYPE>::iterator it = m_data.begin();
+				 it != m_data.end() && task.frames.size() < num_images; it++ )
+		{
+			if ((*it).first.type != CVtAPI::ACQ_IM)
+				continue;
+
+			CVtImage<ImageType> *im = dynamic_cast<CVtImage<ImageType>*>(m_data.fetch( it ));
+			if (im == NULL)
+				continue; // image incorrect type
+
+			Vt_precondition( im->layout() == CVtImageBaseClass::ROW_MAJOR && im->width() >= out.width() && im->height() >= out.height()
+										 , "CVthdsCalib::operator() - frame smaller than the calibrated image" );
+
+			task.frames.push_back( im );
+		}
+
+		Vt_precondition( task.frames.size() > 0 && out.layout() == CVtImageBaseClass::ROW_MAJOR
+									 , "CVthdsCalib::operator() - no acquired frames" );
+		Vt_precondition( m_cal5[0].width() >= out.width() && m_cal5[0].height() >= out.height()
+									 && m_dark.width() >= out.width() && m_dark.height() >= out.height()
+									 , "CVthdsCalib::operator() - calibration smaller than the calibrated image" );
+
+		thread_pool().run( task, 0, out.height(), m_threads );
+
+		correct_defects( out );
+	}
+
+	/**
+	\brief Replace the bad pixels of a calibrated image, if the mask is for images of its size.
+	*/
+	void correct_defects(CVtImage<ImageType> &out) const
+	{
+		if (m_defects.valid( out.width(), out.height() ))
+			m_defects.apply( out );
+	}
+
+	/**
+	\brief The rows of a frame folded into the stream sums, run on the thread pool by fold().
+	*/
+	struct FOLD_TASK : public CVtTask
+	{
+		CVthdsCalib								*calib;
+		const CVtImage<ImageType> *frame;
+
+		virtual void run(const vt_ulong first, const vt_ulong last)
+		{
+			const vt_ulong width = calib->m_stream_width;
+
+			const vt_float *cal5[POLY5_ORDER];
+			const vt_float *cal3[POLY3_ORDER];
+
+			for (vt_ulong row = first; row < last; row++)
+			{
+				calib->coef_lines( cal5, cal3, row );
+
+				poly_line( &calib->m_stream_sum[row*width], (*frame)[row], cal5, POLY5_ORDER, width, &calib->m_stream_dark[row*width] );
+			}
+		}
+	};
+
+	/**
+	\brief Start calibrating frames one at a time as they arrive, rather than from the dataset.
+
+	Each frame given to fold() is added to running sums of p5(frame) - p5(dark) straight
+	away, so a capture needs memory for one frame and the sums whatever the number of frames.
+	end_stream() makes the calibrated image, the same image operator() makes from the frames.
+
+	\param width	the width of the calibrated image
+	\param height the height of the calibrated image
+	*/
+	void begin_stream(const vt_ulong width, const vt_ulong height)
+	{
+		Vt_precondition( m_cal5[0].width() >= width && m_cal5[0].height() >= height
+									 && m_dark.width() >= width && m_dark.height() >= height
+									 , "CVthdsCalib::begin_stream - calibration smaller than the calibrated image" );
+
+		m_stream_width	= width;
+		m_stream_height = height;
+		m_stream_count	= 0;
+
+		m_stream_sum.assign( width*height, 0.0f );
+		m_stream_dark.resize( width*height );
+
+		const vt_float *cal5[POLY5_ORDER];
+		const vt_float *cal3[POLY3_ORDER];
+
+		for (vt_ulong row = 0; row < height; row++)
+		{
+			coef_lines( cal5, cal3, row );
+			poly_line( &m_stream_dark[row*width], m_dark[row], cal5, POLY5_ORDER, width );
+		}
+	}
+
+	/**
+	\brief Add a frame to the stream sums, see begin_stream().
+	*/
+	void fold(const CVtImage<ImageType> &frame)
+	{
+		Vt_precondition( m_stream_sum.size() > 0, "CVthdsCalib::fold - no stream begun" );
+		Vt_precondition( frame.layout() == CVtImageBaseClass::ROW_MAJOR && frame.width() >= m_stream_width && frame.height() >= m_stream_height
+									 , "CVthdsCalib::fold - frame smaller than the calibrated image" );
+
+		FOLD_TASK task;
+
+		task.calib = this;
+		task.frame = &frame;
+
+		thread_pool().run( task, 0, m_stream_height, m_threads );
+
+		m_stream_count++;
+	}
+
+	/**
+	\brief Make the calibrated image from the frames folded since begin_stream() and release the sums.
+	*/
+	void end_stream(CVtImage<ImageType> &out)
+	{
+		Vt_precondition( m_stream_count > 0, "CVthdsCalib::end_stream - no frames folded" );
+		Vt_precondition( out.layout() == CVtImageBaseClass::ROW_MAJOR && out.width() == m_stream_width && out.height() == m_stream_height
+									 , "CVthdsCalib::end_stream - output image is not the size of the stream" );
+
+		const vt_float *cal5[POLY5_ORDER];
+		const vt_float *cal3[POLY3_ORDER];
+
+		for (vt_ulong row = 0; row < m_stream_height; row++)
+		{
+			coef_lines( cal5, cal3, row );
+			finish_line( out[row], &m_stream_sum[row*m_stream_width], cal3, (vt_double) m_stream_count, m_stream_width );
+		}
+		correct_defects( out );
+
+		std::vector<vt_float>().swap( m_stream_sum );
+		std::vector<vt_float>().swap( m_stream_dark );
+		m_stream_count = 0;
+	}
+
+	//! number of frames folded since begin_stream()
+	vt_ulong stream_count() const
+	{
+		return m_stream_count;
+	}
+
+	/**
+	\brief Fold acquired frames added to the dataset while it has this object as the consumer.
+	*/
+	virtual void consume(const CVtAPI::IM_TYPE im_type, CVtImageBaseClass *im)
+	{
+		CVtImage<ImageType> *frame = dynamic_cast<CVtImage<ImageType>*>( im );
+
+		if (im_type != CVtAPI::ACQ_IM || frame == NULL)
+		{
+			delete im;
+			Vt_fail( "CVthdsCalib::consume - not an acquired frame" );
+		}
+
+		try
+		{
+			fold( *frame );
+		}
+		catch(...)
+		{
+			delete frame;
+			throw;
+		}
+		delete frame;
+	}
+
+	///
+	// set the number of threads used to apply the calibration, 0 for all of them
+	//
+	void set_threads(const vt_ulong threads)
+	{
+		m_threads = threads;
+	}
+
+	/**
+	\brief The coefficient lines of a row, for poly_line().
+	*/
+	void coef_lines(const vt_float **cal5, const vt_float **cal3, const vt_ulong row) const
+	{
+		for (vt_ulong k = 0; k < POLY5_ORDER; k++)
+			cal5[k] = m_cal5[k][row];
+
+		for (vt_ulong k = 0; k < POLY3_ORDER; k++)
+			cal3[k] = m_cal3[k][row];
+	}
+
+	/**
+	\brief Set the coefficient planes from the double precision coefficients of each pixel.
+
+	The single precision planes are compared with the double precision coefficients as they
+	are converted. Each pixel's calibration, the 3rd order polynomial of the 5th, is evaluated
+	both ways at signals spread over [0, MAX_SIGNAL] and the largest difference over the pixels
+	of m_mask is kept for coef_error(). The bad pixels of m_mask are listed in m_defects.
+
+	\param width		the image width
+	\param height	the image height
+	\param cal5		the 5th order coefficients, a record for each pixel in row order
+	\param cal3		the 3rd order coefficients, a record for each pixel in row order
+	*/
+	void set_coefs(const vt_ulong width, const vt_ulong height, const POLY5COEF *cal5, const POLY3COEF *cal3)
+	{
+		for (vt_ulong k = 0; k < POLY5_ORDER; k++)
+			m_cal5[k].resize( width, height );
+
+		for (vt_ulong k = 0; k < POLY3_ORDER; k++)
+			m_cal3[k].resize( width, height );
+
+		const vt_ulong num_signals = 9;
+		const vt_bool	 masked			 = (m_mask.width() == width && m_mask.height() == height);
+
+		m_coef_error = 0.0;
+		for (vt_ulong row = 0; row < height; row++)
+		{
+			for (vt_ulong col = 0; col < width; col++)
+			{
+				const POLY5COEF &c5 = cal5[row*width + col];
+				const POLY3COEF &c3 = cal3[row*width + col];
+
+				vt_float f5[POLY5_ORDER];
+				vt_float f3[POLY3_ORDER];
+
+				for (vt_ulong k = 0; k < POLY5_ORDER; k++)
+					m_cal5[k][row][col] = f5[k] = (vt_float) c5[k];
+
+				for (vt_ulong k = 0; k < POLY3_ORDER; k++)
+					m_cal3[k][row][col] = f3[k] = (vt_float) c3[k];
+
+				// pixels masked out are never used
+				if (masked && !m_mask[row][col])
+					continue;
+
+				for (vt_ulong idx = 0; idx < num_signals; idx++)
+				{
+					const vt_double signal = (vt_double) (idx*MAX_SIGNAL)/(num_signals - 1);
+
+					const vt_double exact	 = poly( poly( signal, c5, POLY5_ORDER ), c3, POLY3_ORDER );
+					const vt_double single = fpoly( fpoly( (vt_float) signal, f5, POLY5_ORDER ), f3, POLY3_ORDER );
+					const vt_double error	 = fabs( exact - single );
+
+					if (error > m_coef_error)
+						m_coef_error = error;
+				}
+			}
+		}
+
+		if (masked)
+			m_defects.build( m_mask );
+		else
+			m_defects.reset();
+	}
+
+	/**
+	\brief The coefficient planes, mask and sensor information as a calibration cache entry.
+
+	The planes are the 5th order planes then the 3rd order planes, NUM_PLANES in all.
+	*/
+	void to_cache(CVthdsCalibCache::ENTRY &entry)
+	{
+		const vt_ulong width	 = m_cal5[0].width();
+		const vt_ulong height	 = m_cal5[0].height();
+		const vt_ulong num_pix = width*height;
+
+		Vt_precondition( num_pix > 0 && m_mask.width() == width && m_mask.height() == height
+									 , "CVthdsCalib::to_cache - no coefficients or mask" );
+
+		entry.width			 = width;
+		entry.height		 = height;
+		entry.coef_error = m_coef_error;
+		memcpy( entry.hw_info, m_hw_info.begin(), m_hw_info.length() );
+
+		entry.planes.resize( NUM_PLANES*num_pix );
+		entry.mask.resize( num_pix*sizeof( MaskType ) );
+
+		for (vt_ulong row = 0; row < height; row++)
+		{
+			for (vt_ulong k = 0; k < NUM_PLANES; k++)
+			{
+				const vt_float *src = (k < POLY5_ORDER) ? m_cal5[k][row] : m_cal3[k - POLY5_ORDER][row];
+				memcpy( &entry.planes[k*num_pix + row*width], src, width*sizeof( vt_float ) );
+			}
+			memcpy( &entry.mask[row*width*sizeof( MaskType )], m_mask[row], width*sizeof( MaskType ) );
+		}
+	}
+
+	/**
+	\brief Make a calibration cache entry the current calibration, see to_cache().
+	*/
+	void from_cache(const CVthdsCalibCache::ENTRY &entry)
+	{
+		const vt_ulong width	 = entry.width;
+		const vt_ulong height	 = entry.height;
+		const vt_ulong num_pix = width*height;
+
+		Vt_precondition( entry.planes.size() == NUM_PLANES*num_pix && entry.mask.size() == num_pix*sizeof( MaskType )
+									 , "CVthdsCalib::from_cache - entry is not an hds calibration" );
+
+		for (vt_ulong k = 0; k < POLY5_ORDER; k++)
+			m_cal5[k].resize( width, height );
+
+		for (vt_ulong k = 0; k < POLY3_ORDER; k++)
+			m_cal3[k].resize( width, height );
+
+		m_mask.resize( width, height );
+
+		for (vt_ulong row = 0; row < height; row++)
+		{
+			for (vt_ulong k = 0; k < NUM_PLANES; k++)
+			{
+				vt_float *dst = (k < POLY5_ORDER) ? m_cal5[k][row] : m_cal3[k - POLY5_ORDER][row];
+				memcpy( dst, &entry.planes[k*num_pix + row*width], width*sizeof( vt_float ) );
+			}
+			memcpy( m_mask[row], &entry.mask[row*width*sizeof( MaskType )], width*sizeof( MaskType ) );
+		}
+
+		vt_byte hw_info[SENSOR_INFO_SIZE];
+		memcpy( hw_info, entry.hw_info, sizeof( hw_info ) );
+
+		m_hw_info		 = hw_info;
+		m_coef_error = entry.coef_error;
+
+		m_defects.build( m_mask );
+	}
+
+	/**
+	\brief The largest difference between a calibration with the single precision coefficient planes
+	and one with the double precision coefficients they were made from, in output levels.
+
+	Output pixels are truncated to whole levels, so a difference well under 1 only changes the
+	few pixels which lie close to a level boundary, and those by one level.
+	*/
+	vt_double coef_error() const
+	{
+		return m_coef_error;
+	}
+
+	/**
+	\brief Save calibration coefficients
+
+	Once calculated the calibrationcoefficients can be saved out to disk. The name of the calibration
+	coefficient file is saved in the hds API definition file VthdsAPI.h.
+
+	The calibration coefficients are written in the file format, a POLY5COEF record for every
+	pixel followed by a POLY3COEF record for every pixel, both in double precision.
+	*/
+	void save( std::string fname )
+	{
+		FILE *fpout = fopen( fname.c_str(), "wb" );
+		
+		Vt_precondition(fpout != NULL, "CVthdsCalib::save failed to open output file\n" );
+		
+		// Read the header data
+		vt_ulong width	 = GetAPI().image_width();
+		vt_ulong height  = GetAPI().image_height();
+		vt_ulong num_pix = width*height;
+
+		Vt_precondition( m_cal5[0].width() == width && m_cal5[0].height() == height
+									 , "CVthdsCalib::save - no coefficients for the image size" );
+
+		//
+		// back to a record for each pixel
+		//
+		std::vector<vt_double> cal5( 6*num_pix, 0.0 );
+		std::vector<vt_double> cal3( 3*num_pix, 0.0 );
+
+		for (vt_ulong row = 0; row < height; row++)
+		{
+			for (vt_ulong col = 0; col < width; col++)
+			{
+				const vt_ulong pix = row*width + col;
+
+				for (vt_ulong k = 0; k < POLY5_ORDER; k++)
+					cal5[6*pix + k] = m_cal5[k][row][col];
+
+				for (vt_ulong k = 0; k < POLY3_ORDER; k++)
+					cal3[3*pix + k] = m_cal3[k][row][col];
+			}
+		}
+
+		fwrite( (const char *) m_hw_info.begin(), sizeof( vt_byte ), m_hw_info.length(), fpout );
+		fwrite( (const char *) &cal5[0], sizeof( vt_double ), cal5.size(), fpout );
+		fwrite( (const char *) &cal3[0], sizeof( vt_double ), cal3.size(), fpout );
+		fwrite( (const char *) m_mask.begin(), sizeof( MaskType ), num_pix, fpout );
+		
+		fclose(fpout);
+	}
+	
+	/**
+	\brief istream operator for the hds Calibration object.
+
+	This function allows the hds calibration object to tbe streamed in from disk.
+	Defined merely for convenience. This will normally be called from the hds implementation api
+	object (Vt::CVthdsImpAPI) init function.
+
+	\sa Vt::CVthdsImpAPI
+	*/
+
+	friend std::istream& operator >> (std::istream& IS
+																		, CVthdsCalib<ImageType, CoefType, MaskType>& Object)
+	{
+		CVtAPI &API = GetAPI();
+		
+		Vt_precondition(IS.good() ? true : false, "CVthdsCalib::operator >> - Failed to open input file");
+		
+		// Read the header data
+		vt_ulong width	 = API.image_width();
+		vt_ulong height  = API.image_height();
+		vt_ulong num_pix = width*height;
+		
+		//
+		// read in information about the current hardware
+		//
+		std::vector<vt_byte> hw_info_buf( Object.m_hw_info.length() );
+		IS.read( (char *) &hw_info_buf[0], hw_info_buf.size() );
+		Object.m_hw_info = &hw_info_buf[0];
+
+		//
+		// read in 5th and 3rd order coefficients, a record of each for every pixel
+		//
+		std::vector<vt_double> cal5( 6*num_pix );
+		IS.read( (char *) &cal5[0], cal5.size()*sizeof( vt_double ) );
+
+		std::vector<vt_double> cal3( 3*num_pix );
+		IS.read( (char *) &cal3[0], cal3.size()*sizeof( vt_double ) );
+
+		//
+		// read mask
+		//
+		Object.m_mask.resize( width, height );
+		IS.read( (char *) Object.m_mask.begin(), num_pix*sizeof(MaskType) );
+
+		Vt_precondition( IS.good() ? true : false, "CVthdsCalib::operator >> - calibration file too short" );
+
+		Object.set_coefs( width, height, (const POLY5COEF *) &cal5[0], (const POLY3COEF *) &cal3[0] );
+		
+		return IS;
+	}
+
+	/**
+	\brief Initialise the filenames used for 
+
+	The calibration process involves saving a number of intermediate files. This function initialises the 
+	file names that will be used for these intermediate files. The names are currently chosen to be consistent with
+	the labview implementation.
+	*/
+	void init_fnames()
+	{
+		std::pair<std::string, std::string>  refe_fname;
+
+		// dark image filenames
+		refe_fname.first  = "VR_RESET_VOLTAGES_1_8V";
+		refe_fname.second = "refe180.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_1_9V";
+		refe_fname.second = "refe190.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_2_0V";
+		refe_fname.second = "refe200.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_2_1V";
+		refe_fname.second = "refe210.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_2_2V";
+		refe_fname.second = "refe220.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_2_3V";
+		refe_fname.second = "refe230.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_2_4V";
+		refe_fname.second = "refe240.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_2_5V";
+		refe_fname.second = "refe250.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_2_6V";
+		refe_fname.second = "refe260.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_2_7V";
+		refe_fname.second = "refe270.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_2_8V";
+		refe_fname.second = "refe280.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_2_9V";
+		refe_fname.second = "refe290.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_3_0V";
+		refe_fname.second = "refe300.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_3_1V";
+		refe_fname.second = "refe310.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_3_2V";
+		refe_fname.second = "refe320.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_3_3V";
+		refe_fname.second = "refe330.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_3_4V";
+		refe_fname.second = "refe340.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_3_5V";
+		refe_fname.second = "refe350.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_3_6V";
+		refe_fname.second = "refe360.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_3_7V";
+		refe_fname.second = "refe370.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_3_8V";
+		refe_fname.second = "refe380.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_3_9V";
+		refe_fname.second = "refe390.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_4_0V";
+		refe_fname.second = "refe400.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_4_1V";
+		refe_fname.second = "refe410.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_4_2V";
+		refe_fname.second = "refe420.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_4_3V";
+		refe_fname.second = "refe430.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_4_4V";
+		refe_fname.second = "refe440.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		refe_fname.first  = "VR_RESET_VOLTAGES_4_5V";
+		refe_fname.second = "refe450.raw";
+		m_refe_fnames.insert(refe_fname);
+
+		// number of images used for each filter setting
+		std::pair<vt_ulong, vt_ulong>  filts;
+		filts.first  = 0; // filter number
+		filts.second = 4; // number of files bright images
+		m_filt_nums.insert(filts);
+
+		filts.first  = 1;
+		filts.second = 6;
+		m_filt_nums.insert(filts);
+
+		filts.first  = 2;
+		filts.second = 8;
+		m_filt_nums.insert(filts);
+
+		filts.first  = 3;
+		filts.second = 12;
+		m_filt_nums.insert(filts);
+
+		filts.first  = 4;
+		filts.second = 20;
+		m_filt_nums.insert(filts);
+
+		// filename for bright images
+		std::vector<std::string> suffix;
+		suffix.push_back( "r" );
+		suffix.push_back( "s" );
+		suffix.push_back( "t" );
+		suffix.push_back( "u" );
+		suffix.push_back( "v" );
+
+		vt_ulong cnt = 0;
+		vt_ulong idx = 0;
+
+		bright_names bfnames;
+
+		for(std::vector<std::string>::iterator sfx = suffix.begin(); sfx != suffix.end(); sfx++ )
+		{
+			FILTER_AVES::iterator num_filt_it = m_filt_nums.find( idx++ );
+			vt_ulong filt_num = (*num_filt_it).second;
+		
+			std::string data1( "data1." ); 
+			data1.append( (*sfx) );
+
+			std::string data2( "data2." ); 
+			data2.append( *sfx );
+			
+			std::string refe(  "refe." ) ;		
+			refe.append( *sfx );
+
+			for( vt_ulong filtno = 0; filtno < filt_num; filtno++, cnt++ )
+			{
+				char num_str[256];
+				std::string data1_fname( data1 ); data1_fname.append( itoa( filtno, num_str, 10 ) );
+				std::string data2_fname( data2 ); data2_fname.append( itoa( filtno, num_str, 10 ) );
+				std::string refe_fname( refe );		refe_fname.append( itoa( filtno, num_str, 10 ) );
+
+				bfnames.data1 = data1_fname;
+				bfnames.data2 = data2_fname;
+				bfnames.refe  = refe_fname;
+
+				m_bright_fnames.insert( std::pair<vt_ulong, bright_names>( cnt, bfnames)  );
+			}
+		}
+	}
+};
+
+} // Vt namespace
+#endif // __CVTHDSCALIB_H__
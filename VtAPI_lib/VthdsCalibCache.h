@@ -0,0 +1,419 @@
+/** \file VthdsCalibCache.h
+
+	\brief Ready to use hds calibrations, kept by sensor serial number.
+
+	An hds calibration file holds each pixel's coefficients in double precision, tens of MB
+	which take a full parse and a conversion to single precision planes, see
+	Vt::CVthdsCalib::set_coefs(), every time a sensor is connected. Sensors are moved between
+	rooms, so the same few sensors come back again and again.
+
+	Vt::CVthdsCalibCache keeps the converted planes of each calibration it has seen, keyed by
+	the serial number of the sensor, in memory and in a cache directory on disk. A sensor seen
+	before is ready after a lookup and one read of its planes, whether or not its calibration
+	file is still there. Each entry notes the size and time of the file it was made from, see
+	Vt::file_stamp(), so a calibration file rewritten since is parsed again rather than hidden
+	by the cache. The directory holds the MAX_FILES sensors used last. A cache file whose
+header doesn't match its size or the number of planes is ignored and parsed again.
+
+ * Copyright (c) 2013 by
+ * All Rights Reserved
+ * REVISIONS:
+ * $Log: $
+ *
+ */
+
+#ifndef __CVTHDSCALIBCACHE_H__
+#define __CVTHDSCALIBCACHE_H__
+
+#include <stdio.h>
+#include <string.h>
+#include <windows.h>
+#include <algorithm>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+#include "VtSysdefs.h"
+#include "VtErrors.h"
+
+namespace Vt {
+
+/**
+	\brief The size and last write time of a file, as one number which changes when the file is rewritten.
+
+	\return the stamp, 0 if the file isn't there
+*/
+inline vt_uint64 file_stamp(const std::string &fname)
+{
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if (!::GetFileAttributesEx( fname.c_str(), GetFileExInfoStandard, &data ))
+		return 0;
+
+	// 64 bit FNV-1a over the size and the time
+	const vt_uint64 prime = ((vt_uint64) 0x00000100 << 32) | 0x000001b3;
+	vt_uint64				stamp = ((vt_uint64) 0xcbf29ce4 << 32) | 0x84222325;
+
+	const DWORD fields[4] = { data.nFileSizeHigh, data.nFileSizeLow
+													, data.ftLastWriteTime.dwHighDateTime, data.ftLastWriteTime.dwLowDateTime };
+
+	const vt_byte *bytes = (const vt_byte *) fields;
+	for (size_t idx = 0; idx < sizeof( fields ); idx++)
+	{
+		stamp ^= bytes[idx];
+		stamp *= prime;
+	}
+
+	return (stamp == 0) ? 1 : stamp;
+}
+
+/**
+	\brief Converted hds calibrations keyed by sensor serial number.
+
+	The memory cache holds the last MAX_ENTRIES calibrations used. Every calibration stored
+	is also written to the cache directory, so a new process finds it there, and the files
+	of the sensors used longest ago go once there are more than MAX_FILES.
+*/
+class CVthdsCalibCache
+{
+public:
+	enum {
+		MAX_ENTRIES = 4		//!< calibrations held in memory
+		, MAX_FILES = 16	//!< calibrations kept in the cache directory
+	};
+
+	/**
+	\brief A calibration ready for use.
+	*/
+	struct ENTRY
+	{
+		vt_uint32							width;
+		vt_uint32							height;
+		vt_double							coef_error;								//!< see CVthdsCalib::coef_error()
+		vt_uint64							stamp;										//!< the file_stamp() of the calibration file it was made from
+		vt_byte								hw_info[SENSOR_INFO_SIZE];	//!< the sensor information of the calibration
+		std::vector<vt_float> planes;										//!< the coefficient planes one after another, row-major
+		std::vector<vt_byte>	mask;											//!< the mask, row-major
+
+		ENTRY() : width( 0 ), height( 0 ), coef_error( 0.0 ), stamp( 0 )
+		{
+			memset( hw_info, 0, sizeof( hw_info ) );
+		}
+	};
+
+private:
+	typedef vt_uint32							KEY;		//!< the sensor serial number
+	typedef std::map<KEY, ENTRY>	ENTRIES;
+
+	//
+	// the header of a cache file, the planes and then the mask follow it
+	//
+	struct HEADER
+	{
+		vt_uint32 magic;
+		vt_uint32 version;
+		vt_uint32 serial;
+		vt_uint32 width;
+		vt_uint64 stamp;
+		vt_uint32 height;
+		vt_uint32 num_planes;
+		vt_uint32 mask_size;
+		vt_uint32 reserved;
+		vt_double coef_error;
+		vt_byte		hw_info[SENSOR_INFO_SIZE];
+	};
+
+	enum {
+		MAGIC		 = 0x43485456	//!< "VTHC"
+		, VERSION = 2
+	};
+
+	ENTRIES						m_entries;
+	std::list<KEY>		m_order;		//!< the keys of m_entries, least recently used first
+	std::string				m_dir;
+	CRITICAL_SECTION	m_lock;
+
+	CVthdsCalibCache(const CVthdsCalibCache &);
+	CVthdsCalibCache &operator=(const CVthdsCalibCache &);
+
+	std::string fname(const KEY &key) const
+	{
+		char name[64];
+		sprintf( name, "hds_%08lx.hcc", (unsigned long) key );
+
+		return m_dir + name;
+	}
+
+	//
+	// mark a cache file as used now, the directory is trimmed by last use
+	//
+	void touch_file(const KEY &key) const
+	{
+		HANDLE file = ::CreateFile( fname( key ).c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+		if (file == INVALID_HANDLE_VALUE)
+			return;
+
+		FILETIME now;
+		::GetSystemTimeAsFileTime( &now );
+		::SetFileTime( file, NULL, &now, &now );
+		::CloseHandle( file );
+	}
+
+	//
+	// remove the cache files used longest ago until there are at most MAX_FILES
+	//
+	void trim_dir() const
+	{
+		typedef std::pair<vt_uint64, std::string> USED;
+
+		std::vector<USED> files;
+
+		WIN32_FIND_DATA found;
+		HANDLE find = ::FindFirstFile( (m_dir + "hds_*.hcc").c_str(), &found );
+		if (find == INVALID_HANDLE_VALUE)
+			return;
+
+		do
+		{
+			const vt_uint64 used = ((vt_uint64) found.ftLastWriteTime.dwHighDateTime << 32) | found.ftLastWriteTime.dwLowDateTime;
+			files.push_back( USED( used, m_dir + found.cFileName ) );
+		}
+		while (::FindNextFile( find, &found ));
+
+		::FindClose( find );
+
+		if (files.size() <= MAX_FILES)
+			return;
+
+		std::sort( files.begin(), files.end() );
+		for (size_t idx = 0; idx + MAX_FILES < files.size(); idx++)
+		{
+			remove( files[idx].second.c_str() );
+		}
+	}
+
+	void touch(const KEY &key)
+	{
+		m_order.remove( key );
+		m_order.push_back( key );
+	}
+
+	void keep(const KEY &key, const ENTRY &entry)
+	{
+		m_entries[key] = entry;
+		touch( key );
+
+		while (m_order.size() > MAX_ENTRIES)
+		{
+			m_entries.erase( m_order.front() );
+			m_order.pop_front();
+		}
+	}
+
+	//
+	// read a cache file, false if it isn't there or its header doesn't describe a
+	// calibration of num_planes planes filling the rest of the file
+	//
+	vt_bool read(const KEY &key, const vt_ulong num_planes, ENTRY &entry) const
+	{
+		if (m_dir.empty())
+			return false;
+
+		const std::string name( fname( key ) );
+
+		WIN32_FILE_ATTRIBUTE_DATA data;
+		if (!::GetFileAttributesEx( name.c_str(), GetFileExInfoStandard, &data ))
+			return false;
+
+		const vt_uint64 file_size = ((vt_uint64) data.nFileSizeHigh << 32) | data.nFileSizeLow;
+
+		FILE *fpin = fopen( name.c_str(), "rb" );
+		if (fpin == NULL)
+			return false;
+
+		HEADER header;
+		vt_bool ok = fread( &header, sizeof( header ), 1, fpin ) == 1
+							&& header.magic == MAGIC && header.version == VERSION
+							&& header.serial == key && header.num_planes == num_planes
+							&& header.width > 0 && header.height > 0
+							&& header.mask_size % ((vt_uint64) header.width*header.height) == 0
+							&& file_size == sizeof( header ) + (vt_uint64) header.width*header.height*header.num_planes*sizeof( vt_float ) + header.mask_size;
+
+		if (ok)
+		{
+			const vt_ulong num_pix = header.width*header.height;
+
+			entry.width			 = header.width;
+			entry.height		 = header.height;
+			entry.coef_error = header.coef_error;
+			entry.stamp			 = header.stamp;
+			memcpy( entry.hw_info, header.hw_info, sizeof( entry.hw_info ) );
+
+			entry.planes.resize( header.num_planes*num_pix );
+			entry.mask.resize( header.mask_size );
+
+			ok = fread( &entry.planes[0], sizeof( vt_float ), entry.planes.size(), fpin ) == entry.planes.size()
+				&& (entry.mask.empty() || fread( &entry.mask[0], 1, entry.mask.size(), fpin ) == entry.mask.size());
+		}
+
+		fclose( fpin );
+
+		if (ok)
+			touch_file( key );
+		return ok;
+	}
+
+	void write(const KEY &key, const ENTRY &entry, const vt_ulong num_planes) const
+	{
+		if (m_dir.empty())
+			return;
+
+		::CreateDirectory( m_dir.c_str(), NULL );
+
+		const std::string name( fname( key ) );
+
+		FILE *fpout = fopen( name.c_str(), "wb" );
+		if (fpout == NULL)
+			return;		// the cache is only an optimisation
+
+		HEADER header;
+		memset( &header, 0, sizeof( header ) );
+
+		header.magic			= MAGIC;
+		header.version		= VERSION;
+		header.serial			= key;
+		header.stamp			= entry.stamp;
+		header.width			= entry.width;
+		header.height			= entry.height;
+		header.num_planes = num_planes;
+		header.mask_size	= entry.mask.size();
+		header.coef_error = entry.coef_error;
+		memcpy( header.hw_info, entry.hw_info, sizeof( header.hw_info ) );
+
+		vt_bool ok = fwrite( &header, sizeof( header ), 1, fpout ) == 1
+							&& fwrite( &entry.planes[0], sizeof( vt_float ), entry.planes.size(), fpout ) == entry.planes.size()
+							&& (entry.mask.empty() || fwrite( &entry.mask[0], 1, entry.mask.size(), fpout ) == entry.mask.size());
+
+		if (fclose( fpout ) != 0 || !ok)
+			remove( name.c_str() );
+
+		trim_dir();
+	}
+
+public:
+	CVthdsCalibCache()
+	{
+		::InitializeCriticalSection( &m_lock );
+	}
+
+	virtual ~CVthdsCalibCache()
+	{
+		::DeleteCriticalSection( &m_lock );
+	}
+
+	/**
+	\brief The cache directory, ending in a separator, empty to keep the calibrations in memory only.
+	*/
+	void set_dir(const std::string &dir)
+	{
+		::EnterCriticalSection( &m_lock );
+		m_dir = dir;
+		::LeaveCriticalSection( &m_lock );
+	}
+
+	/**
+	\brief Copy out the calibration of a sensor.
+
+	A calibration found only on disk is read into memory. The entry is copied rather than
+	pointed to, since another session may replace or drop it once the lock is released.
+
+	\param serial			the sensor serial number
+	\param num_planes	the number of planes the calibration must have
+	\param entry			the calibration, left as it was if there is none
+	\return false if there is no calibration of num_planes planes for the sensor
+	*/
+	vt_bool find(const vt_uint32 serial, const vt_ulong num_planes, ENTRY &entry)
+	{
+		const KEY key( serial );
+		vt_bool		found = false;
+
+		::EnterCriticalSection( &m_lock );
+		try
+		{
+			ENTRIES::iterator it = m_entries.find( key );
+			if (it != m_entries.end() && it->second.planes.size() == num_planes*it->second.width*it->second.height)
+			{
+				touch( key );
+				entry = it->second;
+				found = true;
+			}
+			else
+			{
+				ENTRY read_entry;
+				if (read( key, num_planes, read_entry ))
+				{
+					keep( key, read_entry );
+					entry = read_entry;
+					found = true;
+				}
+			}
+		}
+		catch(...)
+		{
+			::LeaveCriticalSection( &m_lock );
+			throw;
+		}
+		::LeaveCriticalSection( &m_lock );
+
+		return found;
+	}
+
+	/**
+	\brief Keep the calibration of a sensor, in memory and on disk, in place of any it had.
+
+	\param num_planes the number of planes in entry.planes
+	*/
+	void store(const vt_uint32 serial, const ENTRY &entry, const vt_ulong num_planes)
+	{
+		Vt_precondition( entry.planes.size() == num_planes*entry.width*entry.height && entry.planes.size() > 0
+									 , "CVthdsCalibCache::store - planes don't match the calibration size" );
+
+		const KEY key( serial );
+
+		::EnterCriticalSection( &m_lock );
+		try
+		{
+			keep( key, entry );
+			write( key, entry, num_planes );
+		}
+		catch(...)
+		{
+			::LeaveCriticalSection( &m_lock );
+			throw;
+		}
+		::LeaveCriticalSection( &m_lock );
+	}
+
+	/**
+	\brief Forget the calibrations held in memory, the cache directory is left as it is.
+	*/
+	void clear()
+	{
+		::EnterCriticalSection( &m_lock );
+		m_entries.clear();
+		m_order.clear();
+		::LeaveCriticalSection( &m_lock );
+	}
+};
+
+/**
+	\brief The hds calibration cache shared by every hds session in the process, each call takes its lock
+*/
+inline CVthdsCalibCache &hds_calib_cache()
+{
+	static CVthdsCalibCache cache;
+	return cache;
+}
+
+} // Vt namespace
+
+#endif // __CVTHDSCALIBCACHE_H__
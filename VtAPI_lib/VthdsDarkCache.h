@@ -0,0 +1,217 @@
+/** \file VthdsDarkCache.h
+
+	\brief Reuse of the hds dark frame between captures.
+
+	Every hds capture needs a dark frame, read with the sensor unexposed, to take the offset out
+	of the exposure. Reading one for each capture doubles the time from trigger to image, yet
+	the offset drifts slowly: a dark frame a few seconds old, read at the same reset voltage and
+	readout frequency, is as good as a new one.
+
+	Vt::CVthdsDarkCache holds the last dark frame read, with what it was read under, and says
+	whether it is still valid for a capture: not too old, not used for too many captures, and
+	read with the same settings. A fresh dark frame can be read into it in the background
+	between exposures, it replaces the cached one only when it is complete. The hds api reads
+	it under its device lock, so no other call drives the sensor meanwhile, see
+	CVthdsImpAPI::start_dark_refresh().
+
+ * Copyright (c) 2013 by
+ * All Rights Reserved
+ * REVISIONS:
+ * $Log: $
+ *
+ */
+
+#ifndef __CVTHDSDARKCACHE_H__
+#define __CVTHDSDARKCACHE_H__
+
+#include <math.h>
+#include <time.h>
+#include <string>
+#include "VtSysdefs.h"
+#include "VtErrors.h"
+#include "VtImage.h"
+
+namespace Vt {
+
+/**
+	\brief The last hds dark frame read, and whether it may be used again.
+
+	A dark frame is read into the cache by handing it to consume(), as the parser does while the
+	cache is its sink, between begin() and commit(). commit() makes it the cached frame.
+*/
+class CVthdsDarkCache : public CVtDatasetConsumer
+{
+public:
+	/**
+	\brief What a dark frame was read under, a frame is only used under the same conditions.
+	*/
+	struct KEY
+	{
+		std::string reset_voltage;	//!< the reset voltage command
+		std::string readout;				//!< the readout frequency command, empty for the sensor's own
+		vt_bool			has_temperature;
+		vt_float		temperature;		//!< the sensor temperature, if has_temperature
+
+		KEY() : has_temperature( false ), temperature( 0.0f ) {}
+	};
+
+private:
+	CVtImage<vt_acq_im_type>	 m_frame;
+	KEY												 m_key;
+	clock_t										 m_taken;		//!< when m_frame was read
+	vt_ulong									 m_uses;		//!< the captures m_frame has been used for
+	vt_bool										 m_valid;
+
+	// the limits
+	vt_double									 m_max_age;
+	vt_ulong									 m_max_uses;
+	vt_float									 m_max_drift;
+
+	// a frame being read
+	CVtImage<vt_acq_im_type>	*m_pending;
+	KEY												 m_pending_key;
+	clock_t										 m_pending_taken;
+
+	CVthdsDarkCache(const CVthdsDarkCache &);
+	CVthdsDarkCache &operator=(const CVthdsDarkCache &);
+
+	static vt_double age(const clock_t taken)
+	{
+		return ((vt_double) (clock() - taken))/CLOCKS_PER_SEC;
+	}
+
+public:
+	CVthdsDarkCache() : m_taken( 0 )
+										, m_uses( 0 )
+										, m_valid( false )
+										, m_max_age( 0.0 )
+										, m_max_uses( 0 )
+										, m_max_drift( 1.0f )
+										, m_pending( NULL )
+										, m_pending_taken( 0 )
+	{}
+
+	virtual ~CVthdsDarkCache()
+	{
+		delete m_pending;
+	}
+
+	/**
+	\brief How long a dark frame stays valid.
+
+	\param max_age		seconds a frame is used for, 0 not to reuse frames at all
+	\param max_uses		captures a frame is used for, 0 for no limit
+	\param max_drift	the temperature change a frame is used over, when the temperature is known
+	*/
+	void set_validity(const vt_double max_age, const vt_ulong max_uses, const vt_float max_drift = 1.0f)
+	{
+		m_max_age		= max_age;
+		m_max_uses	= max_uses;
+		m_max_drift = max_drift;
+	}
+
+	//! true if frames are reused at all
+	vt_bool enabled() const
+	{
+		return m_max_age > 0.0;
+	}
+
+	/**
+	\brief true if the cached frame can be used for a capture under key.
+	*/
+	vt_bool valid(const KEY &key) const
+	{
+		if (!m_valid || !enabled())
+			return false;
+
+		if (key.reset_voltage != m_key.reset_voltage || key.readout != m_key.readout)
+			return false;
+
+		if (key.has_temperature != m_key.has_temperature)
+			return false;
+
+		if (key.has_temperature && fabs( key.temperature - m_key.temperature ) > m_max_drift)
+			return false;
+
+		return age( m_taken ) <= m_max_age && (m_max_uses == 0 || m_uses < m_max_uses);
+	}
+
+	/**
+	\brief The cached frame, counted as used for one more capture.
+	*/
+	const CVtImage<vt_acq_im_type> &use()
+	{
+		Vt_precondition( m_valid, "CVthdsDarkCache::use - no dark frame cached" );
+
+		m_uses++;
+		return m_frame;
+	}
+
+	/**
+	\brief Forget the cached frame, and any being read.
+	*/
+	void invalidate()
+	{
+		m_valid = false;
+
+		delete m_pending;
+		m_pending = NULL;
+	}
+
+	/**
+	\brief Start reading a dark frame under key, see consume() and commit().
+	*/
+	void begin(const KEY &key)
+	{
+		delete m_pending;
+		m_pending = NULL;
+
+		m_pending_key		= key;
+		m_pending_taken = clock();
+	}
+
+	/**
+	\brief Take a dark frame read since begin(), the last one taken is kept.
+	*/
+	virtual void consume(CVtAPI::IM_TYPE type, CVtImageBaseClass *im)
+	{
+		CVtImage<vt_acq_im_type> *frame = dynamic_cast<CVtImage<vt_acq_im_type>*>( im );
+		if (frame == NULL)
+		{
+			delete im;
+			Vt_fail( "CVthdsDarkCache::consume - unexpected image type" );
+		}
+
+		delete m_pending;
+		m_pending = frame;
+	}
+
+	/**
+	\brief Make the frame read since begin() the cached one.
+
+	\return false if no frame was read, the cached frame is then no longer valid
+	*/
+	vt_bool commit()
+	{
+		if (m_pending == NULL)
+		{
+			m_valid = false;
+			return false;
+		}
+
+		m_frame = *m_pending;
+		m_key		= m_pending_key;
+		m_taken = m_pending_taken;
+		m_uses	= 0;
+		m_valid = true;
+
+		delete m_pending;
+		m_pending = NULL;
+
+		return true;
+	}
+};
+
+} // Vt namespace
+
+#endif // __CVTHDSDARKCACHE_H__
@@ -1,1339 +1,2094 @@
-/** \file VthdsImpAPI.h
-
-* Copyright (c) 2013 by
-* All Rights Reserved
-*
-* REVISIONS: 
-* $Log:$
-*
-*/
-
-#ifndef __CVTHDSIMPAPI_H__
-#define __CVTHDSIMPAPI_H__
-
-
-
-#include "../../HDSUSB2/Command.h" //!< \file ../../hdsusb2/command.h the command file for the hds commands only commands 
-
-namespace Vt {
- 
-/**
-  \image html vatech.jpg
-
-  \par REQUIREMENTS: 
-  
-	This is class which implements the hds sensor interface. 
-
-  \par SPECIFICATIONS: 
-  
-	
-	Once created this class provide the interface to allow data to be acquire and passed to
-	outside world. 
-
-	This class uses to main classes for access to data and for manipulation of acquired data. The
-	driver class (CVtUSBDriver) and the calibration class (VthdsCalib). 
-
-	This class defines the nature of the data acquired for the hds sensor which is to be filled in by 
-	the parser i.e. the type of data contained in the "dataset". A dataset is a unit of information
-	which hold all the information from one data acquisition run. Consequently, for the hds sensor
-	the dataset contains all the information relating to one output image. Which will be several bright 
-	frames and a single dark frame.
-
-	Initialisation. The objects returned by the system object are not automatically initialised. 
-	It is the responsibility of the class user to initialise the objects. Consequently, any attempt to use this 
-	class should first be proceed by a call to the generic API.init() function.
-
-
-  \note
-	Error handling is managed via the Vt_fail expception path. Hence, any object calling a function
-	on this interface should catch any potential exceptions. 
-
-	
-	The class cannot be created directly, it can only be obained by calling GetAPI() with an appropiate 
-	api specification type e.g.
-
-	\code
-	CVtAPI &API = GetAPI( CVtAPI::HDS15_API );
-	CVtAPI &API = GetAPI( CVtAPI::HDS20_API );
-	\endcode
-
-	Data is acquired in a hierarchy in the system, the rawdata object (VtPipeData), object is filled 
-	by the driver opject (VtDriver). Once the data has been acquire the data is formated into image data by 
-	the parser object (VthdsLineParser).
-*/
-
-class CVthdsImpAPI : public CVtAPI
-{
-	friend class CVtSys;				// let the system access protected stuff
-	friend class CVthdsCalib;		// let the calibation system access stuff in this class
-
-public:
-	/**
-	The parser defines the dataset type, the implementation api merely typedef a copy of this
-	definition for convenience.
-
-	The dataset entry type refers to the type of data stored which is associated with an individual dataset image
-	e.g.
-	\code
-	typedef struct 
-	{
-		CVtAPI::IM_TYPE type;
-	}	DATASET_ENTRY_TYPE;
-	\endcode
-	*/
-	typedef CVthdsLineParser::DATASET_ENTRY_TYPE	DATASET_ENTRY_TYPE;
-
-	/**
-	The Dataset entry is an alias for the, actual individual item which is stored in the dataset, normally
-	this would be an association between the data set entry type and the dataset image e.g.
-	\code
-	typedef std::pair<T, CVtImageBaseClass*>	DATASET_ENTRY;
-	\endcode
-	*/
-	typedef CVthdsLineParser::DATASET_ENTRY				DATASET_ENTRY;
-	
-	/**
-	The Dataset is an alias for the dataset structure itself. Normally this would be some kind of collection class e.g.
-	\code
-	typedef	std::vector<DATASET_ENTRY >	DATASET;
-	\endcode
-	*/
-	typedef CVthdsLineParser::DATASET							DATASET;
-	
-	//! This is reference to the dataset contained and owned by the parser.
-	CVtDataset<DATASET_ENTRY_TYPE>								&m_dataset;
-
-	//! This is a reference to the one and only driver object, this is owned by the singleton system object.
-	CVtUsbDriver																	&m_driver;
-
-	/**
-	The firmware has a set of commands associated with each interface, the code pair structure associates the
-	numeric code values with a symbolic string name representing the command. 
-	*/
-	typedef std::pair<std::string, vt_ulong>			CODE_PAIR_ENTRY;
-
-	/**
-	The associations of symbolic names are stored in a map. Which is initialised when the object is created.
-	This allows for the use of more  meaningful code, such as;-
-
-	\code
-	send_command( std::string( "VR_SOFTWARE_TRIGGER" ) );
-	\endcode
-	
-	The send_command(std::string&) function can "lookup" the appropriate numeric value from the table.
-	*/
-	typedef std::map<std::string, vt_ulong>				CODE_PAIRS;
-	
-	CODE_PAIRS m_codes; //!< The table of command associations.
-
-	/**
-	A darkframe (a frame which was capture when the sensor was not illuminated by x-rays) is included in 
-	each hds dataset acquired. The most recently acquired dark frame is held in this top level
-	API object for convenience. Currently they are not used at this level. It may make sense to move this 
-	dark frame object down to the calibration object level in the future.
-	\todo
-	Review moving this object down to the calibration level
-	*/
-	CVtImage<vt_acq_im_type>				m_dark; //!< The current dark frame
-
-	/**
-	When each hds sensor is calibrated a boolean mask image is created indicating where the 
-	each hds dataset acquired. The most recently acquired dark frame is held in this top level
-	API object for convenience. Currently they are not used at this level. It may make sense to move this 
-	dark frame object down to the calibration object level in the future.
-	\todo
-	Review moving this object down to the calibration level
-	*/
-
-	CVtImage<vt_byte>								m_mask; //!< The current mask frame
-	
-	CVthdsCalib<vt_acq_im_type, vt_double	, vt_byte>						m_calib;
-
-	//
-	// Initialise reconstruction and globals in base class
-	//
-	CVthdsImpAPI(const API_TYPE api
-							, CVtUsbDriver &driver
-							, CVtDataset<DATASET_ENTRY_TYPE>   &dataset
-							) : CVtAPI( api )
-								, m_driver( driver )
-								, m_dataset( dataset )
-								, m_calib( m_dataset, m_dark, m_mask )
-	{
-		set_api_params();			// parameters which depend on api
-		Vt_postcondition( _CrtCheckMemory() == TRUE, "Capture:::Memory problem detected\n" );
-	}
-  ///
-  // Destructor
-  //
-  virtual ~CVthdsImpAPI() {}
-
-  //
-  // Initialise the system
-	// Note all the main objects for the system should be initialised at this level
-	// even the object embedded in other objects such as the driver object.
-	//
-  //
-  virtual vt_bool init()
-  {
-		static vt_bool initialised = false;
-
-		delete_dataset(); // get rid of previous images
-
-		if (initialised) // only initialise a system once
-			return true;
-
-		initialised = true;
-
-
-		Vt_postcondition( _CrtCheckMemory() == TRUE, "Capture:::Memory problem detected\n" );		
-		///
-		// initialise the driver stuff
-		//
-		m_driver.init(this);
-
-		///
-		// read in calibration stuff
-		//
-		try {
-				std::ifstream CalDataStream( get_calib_fname(), std::ios_base::binary );
-
-				Vt_precondition(CalDataStream.good() ? true : false, "CVthdsCalib::operator >> - Failed to open input file");
-				if (!m_quiet)
-				{
-					if (m_apiType == HDS15_API)
-						printf( "Read hds 1.5 calibration data....\n" );
-					else
-						printf( "Read hds 2.0 calibration data....\n" );
-				}
-
-				CalDataStream >> m_calib; // read in calibration data
-				
-				// Close the new file stream
-				CalDataStream.close();
-		}
-		catch (std::exception &)
-		{
-			// could trap this here if reqd
-			Vt_fail( "no calibration file available. A calibration run must be performed to obtain calibrated images" );
-		}
-
-
-		// OK compare hardware info read from calibration to hardware info read from hardware
-		get_hw_info(); // read hardware info from eprom
-
-
-		// uncommment next two lines if we wish to force current calibration files to match 
-		// current sensor info.
-		
-		// debug m_calib.m_hw_info = m_hw_info; // copy current hw_info just optained
-		// debug m_calib.save( get_calib_fname() ); // save same to disk
-
-		if (m_hw_info != m_calib.m_hw_info)
-			Vt_fail( "Calibration file hardware information does not match EPROM hardware information\n" );
-
-
-		// initialise main listening pipe
-		if (!m_quiet)
-			printf( "Initialising pipe data....\n" );
-
-		return true;
-	}
-
-	/**
-	 simulate capture based on file image rather than grabbed from system.
-	*/
-	virtual void capture(std::string& fname)
-	{
-		// TODO implementation of file input
-	}
-
-	virtual void capture_dark()
-	{
-		// Capture dark frame
-		// read dark frame
-		// send I want one frame command
-		arm( 1 );
-
-		// send a software trigger to cause dark frame to be readout
-		soft_trigger();
-
-		// read image data
-//		m_driver.read_pipe(); // read one image
-		
-		// OK reset FPGA
-		reset();
-	}
-
-	virtual void capture_bright()
-	{
-		arm( m_dataset_size );
-
-		// capturing bright frames
-		soft_trigger();  // this would not normally  be here - trigger for bright 
-										 // frames normally from x-ray.
-		// wait for tx when data acquired
-		wait_for_start();
-
-		// OK read n images worth all at the same time
-		m_driver.read_pipe( m_dataset_size ); // read n frame and add to dataset
-
-		// OK read the info
-		reset();
-	}
-
-	/**
-	\brief Main capture routine
-	*/
-	virtual void capture()
-	{
-		Vt_postcondition( _CrtCheckMemory() == TRUE, "Capture::Memory problem detected\n" );
-		Vt_precondition( m_driver.driver_handle() != NULL, "Device not initialised can't query ready status\n" );
-
-		// set the reset voltage
-		reset(); send_command( std::string( HDS_DEFAULT_RESET_VOLTAGE	) );
-
-		capture_dark();
-
-		capture_bright();
-
-		if (!m_quiet)
-			printf( "Control Port is %x\n",ctrl_port());
-	}
-
-	/**
-	\brief Apply calibration to acquired dataset
-
-	The calibration routines have direct access to the dataset via the reference to the current
-	dataset which is held in this class. 
-	*/
-	
-	virtual void calibrate()
-	{
-		// OK apply calibration to each line
-		CVtImage<vt_out_im_type>* cal_im = new CVtImage<vt_out_im_type>(m_out_width, m_image_height);
-
-		m_calib( *cal_im, m_dataset_size ); // currently default to using all the images.
-
-		set_hw_info( m_calib.m_hw_info );
-	}
-
-	/**	
-	
-	A utility function used to print a particular byte as a series of 1 and 0
-	
-	*/
-	void print_byte(const vt_byte val)
-	{
-		for(vt_ulong bit=0; bit < 8; bit++)
-		{
-			if (bit == 4) 
-				printf( " " );
-
-			if ((val << bit) & 0x80 )
-				printf( "1" );
-			else
-				printf( "0" );
-		}
-	}
-	/**
-		Debug code
-	
-		Currently this routine is merely a place holder for any debugging code.
-
-	*/
-	void test( const CODE_PAIRS::iterator &cmd )
-	{
-		std::string cmd_str = (*cmd).first;
-		vt_ulong	  cmd_code = (*cmd).second;
-
-		// print out command string
-		printf( "Command %s  ", cmd_str.c_str() );
-
-		// print out command code
-		printf( " %0x ", cmd_code ); print_byte( cmd_code );
-
-		// send command to USB
-		if (send_command( cmd_str ))
-		{
-			printf( " returned OK " );
-		}
-		else
-		{
-			printf( " problem " );
-		}
-		// print value of port
-		vt_ulong ctrl = ctrl_port();
-		print_byte( ctrl );
-
-		if (ctrl != cmd_code )
-		{
-			printf( " mismatch!!" );
-			send_command( cmd_str ); // try again
-		}
-		printf( "\n" );
-	}
-
-	/**
-	The overall interface model is extremely simple
-
-	acquire
-	process
-	save
-
-	This function should be used to implement the process part.
-
-	Currently its doing debug duty.
-	*/
-
-	virtual void process()
-	{
-		printf( "Initial interface test\n" );
-		capture();
-
-		arm( 0 );
-
-		vt_byte port_a = m_driver.hs_port();
-
-		printf( "port A %0x ", port_a ); print_byte( port_a ); printf( "\n");
-
-		for (vt_byte val = 0; val < 0xff; val++)
-		{
-			set_port( val, 0xa );
-			
-			vt_byte port_a = m_driver.hs_port();
-
-			printf( "val %0x port A %0x ", val, port_a ); print_byte( port_a ); printf( "\n");
-
-			set_port( val, 0xe );
-			
-			vt_byte port_e = m_driver.data_port();
-
-			printf( "val %0x port E %0x ", val, port_e ); print_byte( port_e ); printf( "\n");
-			getchar();
-		}
-
-		wait_for_start();
-		capture();
-
-		for(CODE_PAIRS::iterator it = m_codes.begin();	 it != m_codes.end();  ++it )
-		{
-			if ( !(*it).first.empty())
-			{
-				test( it );
-				getchar();
-			}
-		}
-
-	}
-
-	/**
-	Main processing function
-
-	Currently this merely consist of application of the calibration routines for the 
-	intra-oral.
-
-	\param imtype - this is not really applicable for intra-oral as they will alway be the acquired image
-	types.
-	*/
-	virtual void process(IM_TYPE imtype)
-	{
-		if (!m_quiet)
-			std::cout << "OK - images acquired" << std::endl;
-		
-		calibrate();
-	}
-
-	/**
-	 main calibration run
-	*/
-	void calibration_run()
-	{
-		m_calib.calibration_run( *this );
-	}
-
-	/**
-	 set the api to have required characteristics
-	 for the current binning mode and api type
-	*/
-	virtual void set_api_params()
-	{
-		m_fname_base = HDS_DEFAULT_BASE_DIR;
-		switch(m_apiType)
-		{
-			case HDS15_API:
-				m_out_width			= HDS15_SIZE_WIDTH;
-				m_image_height	= HDS15_SIZE_HEIGHT;
-				m_dataset_size  = HDS15_DATASET_SIZE;
-				break;
-			case HDS20_API:
-				m_out_width			= HDS20_SIZE_WIDTH;
-				m_image_height	= HDS20_SIZE_HEIGHT;
-				m_dataset_size  = HDS20_DATASET_SIZE;
-				break;
-			default:
-				Vt_fail( "Invalid API type\n" );
-				break;
-		}
-
-		set_num_pkts();
-		set_calib_fname();
-		set_command_codes();
-	}
-
-	/**
-	interface type accessor
-	*/
-	virtual API_TYPE get_api_type()
-	{
-		return m_apiType;
-	}
-	
-	/**
-	 what does the hardware think that the device is?
-	*/
-	virtual API_TYPE  hw_device_type() 
-	{
-		return m_driver.hw_device_type();
-	}
-
-	virtual char * get_fwfname()
-	{
-		return HDS_DEFAULT_HEX_FW_FNAME;
-	}
-
-	/**
-	General control port access functions
-	*/
-	virtual vt_byte ctrl_port() 
-	{
-		return m_driver.ctrl_port();
-	}
-
-	virtual vt_byte hs_port() 
-	{
-		return m_driver.hs_port();
-	}
-
-	virtual vt_byte data_port() 
-	{
-		return m_driver.data_port();
-	}
-
-	/**
-	\brief Arm the sensor ready to receive x-rays
-	*/ 
-	virtual vt_bool arm(const vt_ulong frames )
-	{
-		vt_ulong cmd = get_command( std::string( "VR_ARM_INF" ) ) + frames;
-		return send_command( cmd );
-	}
-
-	/**
-	\brief Send the a software trigger to the sensor.
-	*/ 
-	virtual vt_bool soft_trigger()
-	{
-		return send_command( std::string( "VR_SOFTWARE_TRIGGER" ) );
-	}
-
-	/**
-	\brief Send the a software trigger to the sensor.
-	*/ 
-	virtual vt_bool reset()
-	{
-		return send_command( std::string( "VR_IUSBI_RESET" ) );
-	}
-
-	/**
-	\brief Send the a command to set a port to a particular value
-	*/ 
-	virtual vt_bool set_port(const vt_byte val, const vt_byte port )
-	{ 
-		return send_command( get_command( std::string( "VR_SET_PORT" ) ), val + ( port << 8 ) );
-	}
-
-	/**
-	\brief Get information about the current sensor status
-	
-	The sensor contains an Eprom which is initialised as calibration time to contain certain information.
-	This routine downloads this information from the sensor and saves the information in the member variable
-	m_hw_info.
-	*/
-	virtual vt_bool get_hw_info()
-	{
-		vt_byte buffer[16];
-		vt_byte					CommandCode		 = get_command( std::string( "VR_GET_SENSOR_INFO" )  );
-		const vt_uint16 SubCommandCode = DEFAULT_SUB;
-
-		vt_bool ret_code = send_command( (vt_byte *) buffer, CommandCode, SubCommandCode );
-		m_hw_info =  buffer; 
-
-		return ret_code;
-	}
-
-	/**
-	\brief Set information about the current sensor status
-	
-	The routine initializes the sensor Eprom at calibration time to contain information about the hardware.
-	This routine uploads this information to the sensor from that stored in m_hw_info; 
-	m_hw_info.
-	*/
-	virtual vt_bool set_hw_info()
-	{
-		return m_driver.send_data((const vt_byte *) m_hw_info
-														, SENSOR_INFO_SIZE
-														, get_command( std::string( "VR_SET_SENSOR_INFO" ) ) 
-														);
-	}
-
-	virtual vt_bool set_hw_info(SENSOR_INFO &hw_info )
-	{
-		m_hw_info = hw_info;
-		return m_driver.send_data((const vt_byte *) m_hw_info
-														, SENSOR_INFO_SIZE
-														, get_command( std::string( "VR_SET_SENSOR_INFO" ) ) 
-														);
-	}
-
-
-	/**
-	 get image height - returns image height
-	 currently all the images are the same height
-	*/
-	virtual vt_ulong image_width()
-	{
-		return m_out_width;
-	}
-
-	virtual vt_ulong image_width(IM_TYPE im_type) 
-	{
-		return m_dataset.image_width( im_type );
-	}
-
-	virtual vt_ulong image_height()
-	{
-		return m_image_height;
-	}
-
-	virtual vt_ulong image_height(IM_TYPE im_type) 
-	{
-		return m_dataset.image_height( im_type );
-	}
-
-public:
-	/************************************
-		 DATASET Manipulation
-	************************************/
-
-	virtual vt_bool delete_dataset()
-	{
-		return m_dataset.delete_dataset();
-	}
-
-	virtual vt_bool delete_image(IM_TYPE im_type)
-	{
-		return m_dataset.delete_image(im_type);
-	}
-
-	///
-	// image data accessors
-	//
-	virtual vt_ushort * image_ptr()
-	{
-		return m_dataset.image_ptr();
-	}
-
-	virtual vt_ushort * image_ptr(IM_TYPE im_type)
-	{
-		return m_dataset.image_ptr(im_type);
-	}
-
-	virtual vt_ushort ** image_ptrs(IM_TYPE im_type)
-	{
-		return m_dataset.image_ptrs(im_type);
-	}
-
-
-	///
-	// dataset manipulation
-	//
-	// Datasets can be any 2d set of data.
-	//
-	void add_dataset( DATASET_ENTRY_TYPE ent_type, CVtImageBaseClass *pdata )
-	{
-		m_dataset.add_dataset( ent_type, pdata );
-	}
-
-	DATASET_ENTRY pop_back( const IM_TYPE im_type )
-	{
-		return m_dataset.pop_back( im_type );
-	}
-
-	DATASET_ENTRY get_back( const IM_TYPE im_type )
-	{
-		return m_dataset.get_back( im_type );
-	}
-
-	///
-	// save
-	//
-	// This merely saves the data captured and processed above.
-	//
-	template<typename T>
-	void save_imfile(T **pdata, vt_ulong pixel_size, vt_ulong width, vt_ulong height, std::string &fname, vt_bool row_wise )
-	{
-		FILE *fpout = fopen( fname.c_str(), "wb" );
-
-		if (fpout != NULL)
-		{
-			if (row_wise)
-			{
-				///
-				// store data row wise
-				// Note the following assumes that the data is stores as one contigous buffer
-				// with a row pointer vector allocated and pointing into this buffer. See the definition
-				// of VtImage .
-				//
-				fwrite( (const char *) pdata[0], pixel_size, height*width, fpout );
-			}
-			else
-			{
-				// store column wise
-				T *colbuf = new T[height];
-
-				for( vt_ulong col=0; col < width; col++)
-				{
-					for( vt_ulong row=0; row < height; row++)
-					{
-						colbuf[row] = pdata[row][col];
-					}
-
-					fwrite( (const char *) colbuf, pixel_size, height, fpout );
-				}
-
-				delete colbuf;
-			}
-		}
-		else
-		{
-			Vt_fail( "Failed to open output file\n" );
-		}
-
-		fclose(fpout);
-	}
-
-	virtual void save()
-	{
-		std::string fname_base( HDS_DEFAULT_BASE_FNAME );
-
-		vt_ulong fname_cnt = 1;
-
-		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++, fname_cnt++)
-		{
-			vt_ulong pixel_size = 0;
-
-			switch((*it).first.type)
-			{
-				case ACQ_IM:
-				{
-					std::cout << "Saving acquired image" << std::endl;
-					CVtImage<vt_acq_im_type> *im = dynamic_cast<CVtImage<vt_acq_im_type>*>((*it).second);
-					if (im == NULL)
-					{
-						Vt_fail( "Unexpected image type" );
-					}
-					save_imfile( im->lines()
-									, sizeof( vt_acq_im_type)
-									, im->width()
-									, im->height()
-									, Fname(fname_base, fname_cnt)
-									, false ); 	
-				}
-				break;
-				case CENTRE_IM:
-				{
-					std::cout << "Saving centred image" << std::endl;
-					CVtImage<vt_centre_im_type>* im = dynamic_cast<CVtImage<vt_centre_im_type>*>((*it).second);
-					if (im == NULL)
-					{
-						Vt_fail( "Unexpected image type" );
-					}
-					save_imfile( im->lines()
-									, sizeof( vt_centre_im_type)
-									, im->width()
-									, im->height()
-									, Fname(fname_base, fname_cnt)
-									, false ); 	
-					break;
-				}
-				case CALIB_IM:
-				{
-					std::cout << "Saving calibrated image" << std::endl;
-					CVtImage<vt_calib_im_type>* im = dynamic_cast<CVtImage<vt_calib_im_type>*>((*it).second);
-					if (im == NULL)
-					{
-						Vt_fail( "Unexpected image type" );
-					}
-					save_imfile( im->lines()
-									, sizeof( vt_calib_im_type)
-									, im->width()
-									, im->height()
-									, Fname(fname_base, fname_cnt)
-									, false ); 	
-					break;
-				}
-				case RECON_IM:
-				{
-					std::cout << "Saving recon image" << std::endl;
-					CVtImage<vt_recon_im_type>* im = dynamic_cast<CVtImage<vt_recon_im_type>*>((*it).second);
-					if (im == NULL)
-					{
-						Vt_fail( "Unexpected image type" );
-					}
-					save_imfile( im->lines()
-									, sizeof( vt_recon_im_type)
-									, im->width()
-									, im->height()
-									, Fname(fname_base, fname_cnt)
-									, false ); 	
-					break;
-				}
-				case OUTPUT_IM:
-				{
-					std::cout << "Saving output image" << std::endl;
-					CVtImage<vt_out_im_type>* im = dynamic_cast<CVtImage<vt_out_im_type>*>((*it).second);
-					if (im == NULL)
-					{
-						Vt_fail( "Unexpected image type" );
-					}
-					save_imfile( im->lines()
-									, sizeof( vt_out_im_type)
-									, im->width()
-									, im->height()
-									, Fname(fname_base, fname_cnt)
-									, false ); 	
-					break;
-				}
-				default:
-					std::cout << "Invalid image type" << std::endl;
-			}
-		}
-	}
-	
-	//
-	// save data for a particular image type
-	//
-	virtual void save(IM_TYPE imtype, std::string &fname_base)
-	{
-		vt_ulong fname_cnt = 1;
-		
-		DATASET::iterator it = m_dataset.end(); it--;
-		for(;; it--, fname_cnt++)
-		{
-			if ( (*it).first.type == imtype)
-			{
-				switch(imtype)
-				{
-					case ACQ_IM:
-					{
-						CVtImage<vt_acq_im_type>* im = dynamic_cast<CVtImage<vt_acq_im_type>*>((*it).second);
-						if (im == NULL)
-						{
-							Vt_fail( "Unexpected image type" );
-						}
-						save_imfile( im->lines()
-										, sizeof( vt_acq_im_type)
-										, im->width()
-										, im->height()
-										, Fname(fname_base, fname_cnt)
-										, false ); 	
-						break;
-					}
-					case CENTRE_IM:
-					{
-						CVtImage<vt_centre_im_type>* im = dynamic_cast<CVtImage<vt_centre_im_type>*>((*it).second);
-						if (im == NULL)
-						{
-							Vt_fail( "Unexpected image type" );
-						}
-						save_imfile( im->lines()
-										, sizeof( vt_centre_im_type)
-										, im->width()
-										, im->height()
-										, Fname(fname_base, fname_cnt)
-										, false ); 	
-						break;
-					}
-					case CALIB_IM:
-					{
-						CVtImage<vt_calib_im_type>* im = dynamic_cast<CVtImage<vt_calib_im_type>*>((*it).second);
-						if (im == NULL)
-						{
-							Vt_fail( "Unexpected image type" );
-						}
-						save_imfile( im->lines()
-										, sizeof( vt_calib_im_type)
-										, im->width()
-										, im->height()
-										, Fname(fname_base, fname_cnt)
-										, false ); 	
-						break;
-					}
-					case OUTPUT_IM:
-					{
-						CVtImage<vt_out_im_type>* im = dynamic_cast<CVtImage<vt_out_im_type>*>((*it).second);
-						if (im == NULL)
-						{
-							Vt_fail( "Unexpected image type" );
-						}
-						save_imfile( im->lines()
-										, sizeof( vt_out_im_type)
-										, im->width()
-										, im->height()
-										, Fname(fname_base, fname_cnt)
-										, false ); 	
-						break;
-					}
-					case RECON_IM:
-					{
-						CVtImage<vt_recon_im_type>* im = dynamic_cast<CVtImage<vt_recon_im_type>*>((*it).second);
-						if (im == NULL)
-						{
-							Vt_fail( "Unexpected image type" );
-						}
-						save_imfile( im->lines()
-										, sizeof( vt_recon_im_type)
-										, im->width()
-										, im->height()
-										, Fname(fname_base, fname_cnt)
-										, false ); 	
-						break;
-					}
-				}
-			}
-
-			if (it == m_dataset.begin())
-				return;
-		}
-		Vt_precondition( _CrtCheckMemory() == TRUE, "image_ptr::Memory problem detected\n" );
-	}
-	
-	
-	///
-	// HARDWARE CTRL ROUTINES
-	//
-	//
-	// note: currently start is active low on the a paritcular pin of the usb
-	// Hence the following code merely polls the pin looking for the active low state.
-	//
-	virtual START_SIG  wait_for_start(const vt_double wait_time, const vt_double min_wait_time = 0.0 )
-	{
-		Vt_precondition( m_driver.driver_handle() != NULL, "Device not initialised can't query ready status\n" );
-		clock_t start = clock();
-
-		while( !m_driver.hds_start() ) // active high
-		{
-			clock_t end = clock();
-			double time_taken = ((double)(end - start))/CLOCKS_PER_SEC;
-
-			if (time_taken > wait_time)
-				return START_SIG_TIMEOUT;
-
-			if (!m_quiet)
-				rotator();
-		}
-		if (!m_quiet)
-			printf( "OK\n" );
-
-		return START_SIG_RECEIVED;
-	}
-
-	virtual START_SIG  wait_for_start() // in milliseconds
-	{
-		return wait_for_start( 1000000 );
-	}
-
-	///
-	// The amount of data to skip at the beginning of acquiring each image. On the current 
-	// TDI mode ccd sensor the initial frames are saturated and hence should be discarded.
-	//
-	virtual vt_ulong get_header_size()
-	{
-		return HDS_DEFAULT_HDR_SIZE;
-	}
-
-	//
-	// command codes
-	//
-	CODE_PAIRS& get_command_codes()
-	{
-		return m_codes;
-	}
-	
-	//
-	// HARDWARE COMMS ROUTINES
-	//
-	/**
-	\brief utility used by send command
-	*/
-	vt_byte get_command(const std::string &cmd )
-	{
-		CODE_PAIRS::iterator it = m_codes.find( cmd );
-		
-		return(*it).second;
-	}
-
-	virtual vt_bool send_command(vt_byte status[16]
-									 , const vt_byte CommandCode
-									 , const vt_uint16 SubCommandCode )
-	{
-		return m_driver.send_command( status, CommandCode, SubCommandCode );
-	}
-
-	virtual vt_bool send_command(const std::string &cmd )
-	{
-		vt_byte status[16];
-		
-		vt_byte					CommandCode		 = get_command( cmd );
-		const vt_uint16 SubCommandCode = DEFAULT_SUB;
-
-		return send_command( status, CommandCode, SubCommandCode );
-	}
-
-	virtual vt_bool send_command( const vt_byte CommandCode, const vt_uint16 SubCommandCode = DEFAULT_SUB )
-	{
-		vt_byte status[16];
-		return m_driver.send_command( status, CommandCode, SubCommandCode );
-	}
-
-	//
-	// bin mode effectively set the height and width of the image
-	//
-	virtual void set_calib_fname()
-	{
-		m_calibFname = (m_apiType == HDS15_API) ? HDS_DEFAULT_HDS15_CALIB_FNAME : HDS_DEFAULT_HDS20_CALIB_FNAME;
-	}
-	
-	virtual char* get_calib_fname()
-	{
-		set_calib_fname(); //  make sure name is set to default for acquisition mode
-		return m_calibFname;
-	}
-
-	///
-	// private funcs - not exposed through API but useable
-	//
-	virtual vt_ulong get_num_pkts()
-	{
-		set_num_pkts(); // ensure that the number of packets is set to the default for the acqusition mode
-		return m_numPkts;
-	}
-	virtual void set_num_pkts(vt_ulong num_pkts) // explicitly set num pkts
-	{
-		m_numPkt_override = true;
-		m_numPkts = num_pkts;
-	}
-	virtual void set_num_pkts(vt_bool dummy) // turn off override and set default num pkts
-	{
-		m_numPkt_override = false;
-		set_num_pkts();
-	}
-	virtual void set_num_pkts() // set default num pkts
-	{
-		if (m_numPkt_override)
-			return;
-
-		if (m_calibFlag)
-		{
-			m_numPkts = (m_apiType == HDS15_API) ? HDS15_CALIB_NUM_PKTS : HDS20_CALIB_NUM_PKTS;
-		}
-		else
-		{
-			m_numPkts = (m_apiType == HDS15_API) ? HDS15_NUM_PKTS : HDS20_NUM_PKTS;
-		}
-	}
-private:
-	//
-	// set_interface_codes
-	//
-	void set_command_codes()
-	{
-		CODE_PAIR_ENTRY myPair;
-		//
-		// reset frequencies
-		//
-		myPair.first  = "VR_READOUT_FREQUENCY_2_0MHZ";
-		myPair.second = VR_READOUT_FREQUENCY_2_0MHZ;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_READOUT_FREQUENCY_2_5MHZ";
-		myPair.second = VR_READOUT_FREQUENCY_2_5MHZ;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_READOUT_FREQUENCY_3_0MHZ";
-		myPair.second = VR_READOUT_FREQUENCY_3_0MHZ;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_READOUT_FREQUENCY_3_5MHZ";
-		myPair.second = VR_READOUT_FREQUENCY_3_5MHZ;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_READOUT_FREQUENCY_4_0MHZ";
-		myPair.second = VR_READOUT_FREQUENCY_4_0MHZ;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_READOUT_FREQUENCY_4_5MHZ";
-		myPair.second = VR_READOUT_FREQUENCY_4_5MHZ;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_READOUT_FREQUENCY_5_0MHZ";
-		myPair.second = VR_READOUT_FREQUENCY_5_0MHZ;
-		m_codes.insert(myPair);
-		//
-		// ARM
-		//
-		myPair.first  = "VR_ARM_INF";
-		myPair.second = VR_ARM_INF;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_ARM_1";
-		myPair.second = VR_ARM_1;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_ARM_2";
-		myPair.second = VR_ARM_2;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_ARM_3";
-		myPair.second = VR_ARM_3;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_ARM_4";
-		myPair.second = VR_ARM_4;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_ARM_5";
-		myPair.second = VR_ARM_5;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_ARM_6";
-		myPair.second = VR_ARM_6;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_ARM_7";
-		myPair.second = VR_ARM_7;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_ARM_8";
-		myPair.second = VR_ARM_8;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_ARM_9";
-		myPair.second = VR_ARM_9;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_ARM_10";
-		myPair.second = VR_ARM_10;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_ARM_11";
-		myPair.second = VR_ARM_11;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_ARM_12";
-		myPair.second = VR_ARM_12;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_ARM_13";
-		myPair.second = VR_ARM_13;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_ARM_14";
-		myPair.second = VR_ARM_14;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_ARM_15";
-		myPair.second = VR_ARM_15;
-		m_codes.insert(myPair);
-		//
-		// general codes
-		//
-		myPair.first  = "VR_SOFTWARE_TRIGGER";
-		myPair.second = VR_SOFTWARE_TRIGGER;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_SHUTDOWN";
-		myPair.second = VR_SHUTDOWN;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_WRITE_SENSOR_INFO";
-		myPair.second = VR_WRITE_SENSOR_INFO;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_ABORT";
-		myPair.second = VR_ABORT;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_GET_SENSOR_INFO";
-		myPair.second = VR_GET_SENSOR_INFO;
-		m_codes.insert(myPair);
-		//
-		// reset voltages
-		//
-		myPair.first  = "VR_RESET_VOLTAGES_1_8V";
-		myPair.second = VR_RESET_VOLTAGES_1_8V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_1_9V";
-		myPair.second = VR_RESET_VOLTAGES_1_9V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_2_0V";
-		myPair.second = VR_RESET_VOLTAGES_2_0V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_2_1V";
-		myPair.second = VR_RESET_VOLTAGES_2_1V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_2_2V";
-		myPair.second = VR_RESET_VOLTAGES_2_2V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_2_3V";
-		myPair.second = VR_RESET_VOLTAGES_2_3V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_2_4V";
-		myPair.second = VR_RESET_VOLTAGES_2_4V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_2_5V";
-		myPair.second = VR_RESET_VOLTAGES_2_5V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_2_6V";
-		myPair.second = VR_RESET_VOLTAGES_2_6V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_2_7V";
-		myPair.second = VR_RESET_VOLTAGES_2_7V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_2_8V";
-		myPair.second = VR_RESET_VOLTAGES_2_8V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_2_9V";
-		myPair.second = VR_RESET_VOLTAGES_2_9V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_3_0V";
-		myPair.second = VR_RESET_VOLTAGES_3_0V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_3_1V";
-		myPair.second = VR_RESET_VOLTAGES_3_1V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_3_2V";
-		myPair.second = VR_RESET_VOLTAGES_3_2V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_3_3V";
-		myPair.second = VR_RESET_VOLTAGES_3_3V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_3_4V";
-		myPair.second = VR_RESET_VOLTAGES_3_4V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_3_5V";
-		myPair.second = VR_RESET_VOLTAGES_3_5V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_3_6V";
-		myPair.second = VR_RESET_VOLTAGES_3_6V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_3_7V";
-		myPair.second = VR_RESET_VOLTAGES_3_7V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_3_8V";
-		myPair.second = VR_RESET_VOLTAGES_3_8V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_3_9V";
-		myPair.second = VR_RESET_VOLTAGES_3_9V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_4_0V";
-		myPair.second = VR_RESET_VOLTAGES_4_0V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_4_1V";
-		myPair.second = VR_RESET_VOLTAGES_4_1V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_4_2V";
-		myPair.second = VR_RESET_VOLTAGES_4_2V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_4_3V";
-		myPair.second = VR_RESET_VOLTAGES_4_3V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_4_4V";
-		myPair.second = VR_RESET_VOLTAGES_4_4V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_RESET_VOLTAGES_4_5V";
-		myPair.second = VR_RESET_VOLTAGES_4_5V;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_IUSBI_TEST";
-		myPair.second = VR_IUSBI_TEST;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_IUSBI_RENUM";
-		myPair.second = VR_IUSBI_RENUM;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_IUSBI_GET_USB_STATE";
-		myPair.second = VR_IUSBI_GET_USB_STATE;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_IUSBI_INITIALISE";
-		myPair.second = VR_IUSBI_INITIALISE;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_IUSBI_RESET";
-		myPair.second = VR_IUSBI_RESET;
-		m_codes.insert(myPair);
-
-		//
-		// port commands
-		//
-		myPair.first  = "VR_SET_PORT";
-		myPair.second = VR_SET_PORT;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_CLEAR_A";
-		myPair.second = VR_CLEAR_A;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_CLEAR_C";
-		myPair.second = VR_CLEAR_C;
-		m_codes.insert(myPair);
-
-		myPair.first  = "VR_CLEAR_E";
-		myPair.second = VR_CLEAR_E;
-		m_codes.insert(myPair);
-
-	}
-};
-} // end Vt namespace
-
-#endif // __CVTHDSIMPAPI_H__
+/** \file VthdsImpAPI.h
+
+* Copyright (c) 2013 by
+* All Rights Reserved
+*
+* REVISIONS: 
+* $Log:$
+*
+*/
+
+#ifndef __CVTHDSIMPAPI_H__
+#define __CVTHDSIMPAPI_H__
+
+
+
+#include "../../HDSUSB2/Command.h" //!< \file ../../hdsusb2/command.h the command file for the hds commands only commands 
+
+namespace Vt {
+ 
+/**
+  \image html vatech.jpg
+
+  \par REQUIREMENTS: 
+  
+	This is class which implements the hds sensor interface. 
+
+  \par SPECIFICATIONS: 
+  
+	
+	Once created this class provide the interface to allow data to be acquire and passed to
+	outside world. 
+
+	This class uses to main classes for access to data and for manipulation of acquired data. The
+	driver class (CVtUSBDriver) and the calibration class (VthdsCalib). 
+
+	This class defines the nature of the data acquired for the hds sensor which is to be filled in by 
+	the parser i.e. the type of data contained in the "dataset". A dataset is a unit of information
+	which hold all the information from one data acquisition run. Consequently, for the hds sensor
+	the dataset contains all the information relating to one output image. Which will be several bright 
+	frames and a single dark frame.
+
+	Initialisation. The objects returned by the system object are not automatically initialised. 
+	It is the responsibility of the class user to initialise the objects. Consequently, any attempt to use this 
+	class should first be proceed by a call to the generic API.init() function.
+
+
+  \note
+	Error handling is managed via the Vt_fail expception path. Hence, any object calling a function
+	on this interface should catch any potential exceptions. 
+
+	
+	The class cannot be created directly, it can only be obained by calling GetAPI() with an appropiate 
+	api specification type e.g.
+
+	\code
+	CVtAPI &API = GetAPI( CVtAPI::HDS15_API );
+	CVtAPI &API = GetAPI( CVtAPI::HDS20_API );
+	\endcode
+
+	Data is acquired in a hierarchy in the system, the rawdata object (VtPipeData), object is filled 
+	by the driver opject (VtDriver). Once the data has been acquire the data is formated into image data by 
+	the parser object (VthdsLineParser).
+*/
+
+class CVthdsImpAPI : public CVtAPI
+{
+	friend class CVtSys;				// let the system access protected stuff
+	friend class CVthdsCalib;		// let the calibation system access stuff in this class
+
+public:
+	/**
+	The parser defines the dataset type, the implementation api merely typedef a copy of this
+	definition for convenience.
+
+	The dataset entry type refers to the type of data stored which is associated with an individual dataset image
+	e.g.
+	\code
+	typedef struct 
+	{
+		CVtAPI::IM_TYPE type;
+	}	DATASET_ENTRY_TYPE;
+	\endcode
+	*/
+	typedef CVthdsLineParser::DATASET_ENTRY_TYPE	DATASET_ENTRY_TYPE;
+
+	/**
+	The Dataset entry is an alias for the, actual individual item which is stored in the dataset, normally
+	this would be an association between the data set entry type and the dataset image e.g.
+	\code
+	typedef std::pair<T, CVtImageBaseClass*>	DATASET_ENTRY;
+	\endcode
+	*/
+	typedef CVthdsLineParser::DATASET_ENTRY				DATASET_ENTRY;
+	
+	/**
+	The Dataset is an alias for the dataset structure itself. Normally this would be some kind of collection class e.g.
+	\code
+	typedef	std::vector<DATASET_ENTRY >	DATASET;
+	\endcode
+	*/
+	typedef CVthdsLineParser::DATASET							DATASET;
+	
+	//! This is reference to the dataset contained and owned by the parser.
+	CVtDataset<DATASET_ENTRY_TYPE>								&m_dataset;
+
+	//! This is a reference to the one and only driver object, this is owned by the singleton system object.
+	CVtUsbDriver																	&m_driver;
+
+	//! The parser the driver feeds, file captures are replayed through it, see capture(std::string&).
+	CVthdsLineParser															&m_parser;
+
+	/**
+	The firmware has a set of commands associated with each interface, the code pair structure associates the
+	numeric code values with a symbolic string name representing the command. 
+	*/
+	typedef std::pair<std::string, vt_ulong>			CODE_PAIR_ENTRY;
+
+	/**
+	The associations of symbolic names are stored in a map. Which is initialised when the object is created.
+	This allows for the use of more  meaningful code, such as;-
+
+	\code
+	send_command( std::string( "VR_SOFTWARE_TRIGGER" ) );
+	\endcode
+	
+	The send_command(std::string&) function can "lookup" the appropriate numeric value from the table.
+	*/
+	typedef std::map<std::string, vt_ulong>				CODE_PAIRS;
+	
+	CODE_PAIRS m_codes; //!< The table of command associations.
+
+	/**
+	A darkframe (a frame which was capture when the sensor was not illuminated by x-rays) is included in 
+	each hds dataset acquired. The most recently acquired dark frame is held in this top level
+	API object for convenience. Currently they are not used at this level. It may make sense to move this 
+	dark frame object down to the calibration object level in the future.
+	\todo
+	Review moving this object down to the calibration level
+	*/
+	CVtImage<vt_acq_im_type>				m_dark; //!< The current dark frame
+
+	/**
+	When each hds sensor is calibrated a boolean mask image is created indicating where the 
+	each hds dataset acquired. The most recently acquired dark frame is held in this top level
+	API object for convenience. Currently they are not used at this level. It may make sense to move this 
+	dark frame object down to the calibration object level in the future.
+	\todo
+	Review moving this object down to the calibration level
+	*/
+
+	CVtImage<vt_byte>								m_mask; //!< The current mask frame
+	
+	CVthdsCalib<vt_acq_im_type, vt_double	, vt_byte>						m_calib;
+
+	//
+	// the sensor and calibration file m_calib was last loaded for, see load_calib()
+	//
+	vt_uint32												m_calib_serial;
+	vt_uint64												m_calib_stamp;
+
+	//! The readout frequency command chosen by probe_readout(), empty to leave the sensor's own.
+	std::string											m_readout;
+
+	//! The highest rate in MHz the link was seen to deliver by probe_readout(), 0 if it hasn't been probed.
+	vt_double												m_link_mhz;
+
+	//! The last dark frame read, reused by capture_dark() while it is valid.
+	CVthdsDarkCache									m_dark_cache;
+
+	/**
+	\brief Held by every call which drives the sensor through the driver.
+
+	A background dark frame read, see start_dark_refresh(), holds it for the whole read, so
+	a command, port access or capture from the caller's thread waits for the read rather
+	than cutting into it. A critical section may be entered again by the thread holding it,
+	so calls which make other locked calls are fine.
+	*/
+	CRITICAL_SECTION								m_device_lock;
+
+	//
+	// m_device_lock held until the end of the scope
+	//
+	struct DEVICE_LOCK
+	{
+		CRITICAL_SECTION &lock;
+
+		DEVICE_LOCK(CRITICAL_SECTION &device_lock) : lock( device_lock )
+		{
+			::EnterCriticalSection( &lock );
+		}
+
+		~DEVICE_LOCK()
+		{
+			::LeaveCriticalSection( &lock );
+		}
+
+	private:
+		DEVICE_LOCK &operator=(const DEVICE_LOCK &);
+	};
+
+	/**
+	\brief Read a dark frame into the dark cache, see start_dark_refresh().
+	*/
+	struct DARK_TASK : public CVtTask
+	{
+		CVthdsImpAPI *api;
+
+		virtual void run(const vt_ulong first, const vt_ulong last)
+		{
+			api->read_dark();
+		}
+	};
+
+	DARK_TASK												m_dark_task;
+	vt_bool													m_dark_refreshing;
+	CVtWorker												m_dark_worker;		//!< destroyed first, it waits for a refresh to finish
+
+	/**
+	\brief The sensor as seen by the readout probe, the frames are read through the driver.
+
+	The test frames are taken from the parser and dropped as they arrive, the dataset and the
+	images in it are left alone. The rate the frames arrive at is noted, the highest is what
+	the link is known to carry, see link_mhz().
+	*/
+	class CHardwareLink : public CVthdsSensorLink, public CVtDatasetConsumer
+	{
+		CVthdsImpAPI &m_api;
+		vt_ulong			m_frames;			//!< frames received by the current stream()
+		vt_double			m_link_mhz;
+
+	public:
+		CHardwareLink(CVthdsImpAPI &api) : m_api( api )
+																		 , m_frames( 0 )
+																		 , m_link_mhz( 0.0 ) {}
+
+		virtual vt_bool set_readout(const std::string &command)
+		{
+			return m_api.send_command( command );
+		}
+
+		virtual void consume(const IM_TYPE im_type, CVtImageBaseClass *im)
+		{
+			delete im;
+			m_frames++;
+		}
+
+		virtual vt_ulong stream(const vt_ulong num_frames)
+		{
+			DEVICE_LOCK device( m_api.m_device_lock );
+
+			m_frames = 0;
+
+			m_api.arm( num_frames );
+			m_api.soft_trigger();
+			m_api.wait_for_start();
+
+			m_api.m_parser.set_sink( this );
+
+			const clock_t start = clock();
+			try
+			{
+				m_api.m_driver.read_pipe( num_frames );
+			}
+			catch(...)
+			{
+				m_api.m_parser.set_sink( NULL );
+				m_api.reset();
+				throw;
+			}
+			const vt_double seconds = ((vt_double) (clock() - start))/CLOCKS_PER_SEC;
+
+			m_api.m_parser.set_sink( NULL );
+			m_api.reset();
+
+			// values delivered a second, the readout rate while the link keeps up with it
+			if (seconds > 0.0)
+			{
+				const vt_double mhz = (vt_double) m_frames*m_api.m_out_width*(m_api.m_image_height + 2)/seconds*1.0e-6;
+				if (mhz > m_link_mhz)
+					m_link_mhz = mhz;
+			}
+
+			return m_frames;
+		}
+
+		virtual vt_double link_mhz() const
+		{
+			return m_link_mhz;
+		}
+
+		//! the driver's pipe buffers, which the host falls behind into, in lines
+		virtual vt_ulong fifo_lines() const
+		{
+			const CVtUSBPipeData::BUFFERS bufs = m_api.m_parser.pipe_buffers();
+
+			return (bufs.buffers == NULL) ? 0 : bufs.size*bufs.numbufs/(m_api.m_image_height + 2);
+		}
+	};
+
+	//
+	// Initialise reconstruction and globals in base class
+	//
+	CVthdsImpAPI(const API_TYPE api
+							, CVtUsbDriver &driver
+							, CVthdsLineParser &parser
+							) : CVtAPI( api )
+								, m_driver( driver )
+								, m_parser( parser )
+								, m_dataset( parser.get_dataset() )
+								, m_calib( m_dataset, m_dark, m_mask )
+								, m_calib_serial( 0 )
+								, m_calib_stamp( 0 )
+								, m_link_mhz( 0.0 )
+								, m_dark_refreshing( false )
+	{
+		::InitializeCriticalSection( &m_device_lock );
+		m_dark_task.api = this;
+
+		set_api_params();			// parameters which depend on api
+
+		// stage relations, used when the dataset is trimmed to the memory budget
+		m_dataset.set_input( CALIB_IM, ACQ_IM );
+		m_dataset.set_pinned( CALIB_IM );
+		Vt_postcondition( _CrtCheckMemory() == TRUE, "Capture:::Memory problem detected\n" );
+	}
+  ///
+  // Destructor
+  //
+  virtual ~CVthdsImpAPI()
+	{
+		try
+		{
+			finish_dark_refresh();
+		}
+		catch(...)
+		{
+		}
+		::DeleteCriticalSection( &m_device_lock );
+	}
+
+  //
+  // Initialise the system
+	// Note all the main objects for the system should be initialised at this level
+	// even the object embedded in other objects such as the driver object.
+	//
+  //
+  virtual vt_bool init()
+  {
+		static vt_bool initialised = false;
+
+		finish_dark_refresh();
+		m_dark_cache.invalidate(); // the sensor may have changed
+
+		delete_dataset(); // get rid of previous images
+
+		if (!initialised) // only initialise the driver once
+		{
+			initialised = true;
+
+			Vt_postcondition( _CrtCheckMemory() == TRUE, "Capture:::Memory problem detected\n" );		
+			///
+			// initialise the driver stuff
+			//
+			DEVICE_LOCK device( m_device_lock );
+			m_driver.init(this);
+		}
+
+		// the sensor may have been swapped since the last init, its serial number picks the calibration
+		get_hw_info(); // read hardware info from eprom
+
+		load_readout();
+
+		///
+		// read in calibration stuff
+		//
+		try {
+				load_calib();
+		}
+		catch (std::exception &)
+		{
+			// could trap this here if reqd
+			Vt_fail( "no calibration file available. A calibration run must be performed to obtain calibrated images" );
+		}
+
+		// uncommment next two lines if we wish to force current calibration files to match 
+		// current sensor info.
+		
+		// debug m_calib.m_hw_info = m_hw_info; // copy current hw_info just optained
+		// debug m_calib.save( get_calib_fname() ); // save same to disk
+
+		// OK compare hardware info read from calibration to hardware info read from hardware
+		if (m_hw_info != m_calib.m_hw_info)
+			Vt_fail( "Calibration file hardware information does not match EPROM hardware information\n" );
+
+
+		// initialise main listening pipe
+		if (!m_quiet)
+			printf( "Initialising pipe data....\n" );
+
+		return true;
+	}
+
+	/**
+	\brief Select the readout frequency last chosen by probe_readout(), if there is one.
+	*/
+	void load_readout()
+	{
+		std::ifstream cfile( HDS_READOUT_FNAME );
+
+		std::string command;
+		if (!(cfile >> command) || m_codes.find( command ) == m_codes.end())
+			return;
+
+		m_readout = command;
+		send_command( m_readout );
+
+		if (!(cfile >> m_link_mhz))
+			m_link_mhz = 0.0;
+
+		if (!m_quiet)
+			printf( "Readout frequency %s\n", m_readout.c_str() );
+	}
+
+	/**
+	\brief Find the highest readout frequency the host keeps up with, see CVthdsReadoutProbe.
+
+	The frequency found on the sensor is selected and kept in HDS_READOUT_FNAME, with the
+	rate the link was seen to carry, and init() selects it again in later sessions. The
+	emulated sensor is given that link rate and the driver's buffering as its FIFO, so it
+	loses lines where the hardware would.
+	*/
+	virtual vt_bool probe_readout(const vt_bool emulate = false)
+	{
+		finish_dark_refresh();
+		m_dark_cache.invalidate(); // the dark frame depends on the readout frequency
+
+		CVthdsReadoutProbe probe( m_parser, m_out_width, m_image_height );
+		CHardwareLink			 link( *this );
+
+		vt_long best;
+		if (emulate)
+		{
+			CVthdsEmulatedSensor sensor( m_parser, m_out_width, m_image_height );
+
+			const vt_ulong fifo_lines = link.fifo_lines();
+			sensor.set_link( m_link_mhz, (fifo_lines > 0) ? fifo_lines : sensor.fifo_lines() );
+
+			if (m_link_mhz <= 0.0 && !m_quiet)
+				printf( "The link rate hasn't been probed on the sensor, the emulation has no link limit\n" );
+
+			best = probe.run( sensor );
+		}
+		else
+		{
+			best = probe.run( link );
+			m_link_mhz = link.link_mhz();
+		}
+
+		if (!m_quiet)
+			probe.print();
+
+		if (best < 0)
+		{
+			// the probe leaves the last frequency it tried, go back to the one in use before
+			if (!emulate)
+				send_command( m_readout.empty() ? std::string( HDS_DEFAULT_READOUT ) : m_readout );
+
+			return false;
+		}
+
+		if (!emulate)
+		{
+			m_readout = gHdsReadouts[best].command;
+			send_command( m_readout );
+
+			std::ofstream cfile( HDS_READOUT_FNAME );
+			cfile << m_readout << " " << m_link_mhz << std::endl;
+		}
+
+		if (!m_quiet)
+			printf( "Highest sustained readout frequency %.1fMHz\n", gHdsReadouts[best].mhz );
+
+		return true;
+	}
+
+	/**
+	\brief Make the calibration of the connected sensor the current one.
+
+	The calibration cache is looked up with the serial number of the sensor. Its calibration
+	is used if the calibration file is the one it was made from, or if there is no file, so
+	the file isn't read at all. Otherwise the file is parsed and, if it is the calibration of
+	this sensor, stored in the cache. A file for another sensor is used as it always was when
+	there is nothing cached for this one, but isn't cached under it.
+	Nothing is done if the calibration is already current.
+	*/
+	void load_calib()
+	{
+		const std::string fname( get_calib_fname() );
+		const vt_uint32		serial = m_hw_info.serial_number;
+		const vt_uint64		stamp	 = file_stamp( fname );
+
+		if (m_calib_serial == serial && m_calib_stamp == stamp && stamp != 0)
+			return;
+
+		CVthdsCalibCache &cache = hds_calib_cache();
+		cache.set_dir( HDS_CALIB_CACHE_DIR );
+
+		CVthdsCalibCache::ENTRY entry;
+		const vt_bool						cached = cache.find( serial, m_calib.NUM_PLANES, entry );
+		if (cached && (stamp == 0 || entry.stamp == stamp))
+		{
+			m_calib.from_cache( entry );
+
+			if (!m_quiet)
+				printf( "Read calibration data for sensor %08lx from the cache....\n", (unsigned long) serial );
+		}
+		else
+		{
+			std::ifstream CalDataStream( fname.c_str(), std::ios_base::binary );
+
+			Vt_precondition( stamp != 0 && CalDataStream.good(), "CVthdsImpAPI::load_calib - Failed to open calibration file" );
+			if (!m_quiet)
+			{
+				if (m_apiType == HDS15_API)
+					printf( "Read hds 1.5 calibration data....\n" );
+				else
+					printf( "Read hds 2.0 calibration data....\n" );
+			}
+
+			CalDataStream >> m_calib; // read in calibration data
+
+			// Close the new file stream
+			CalDataStream.close();
+
+			if (m_calib.m_hw_info.serial_number == serial)
+			{
+				CVthdsCalibCache::ENTRY made;
+				m_calib.to_cache( made );
+				made.stamp = stamp;
+
+				cache.store( serial, made, m_calib.NUM_PLANES );
+			}
+			else
+			{
+				if (!m_quiet)
+					printf( "Calibration file %s is for sensor %08lx, not the connected sensor %08lx\n"
+								, fname.c_str(), (unsigned long) m_calib.m_hw_info.serial_number, (unsigned long) serial );
+
+				if (cached)
+				{
+					m_calib.from_cache( entry );
+					if (!m_quiet)
+						printf( "Using the cached calibration of sensor %08lx\n", (unsigned long) serial );
+				}
+			}
+		}
+
+		m_calib_serial = serial;
+		m_calib_stamp	 = stamp;
+
+		if (!m_quiet)
+		{
+			printf( "Single precision coefficients within %.3g levels of double precision\n", m_calib.coef_error() );
+			printf( "%lu defective pixels corrected\n", m_calib.m_defects.size() );
+		}
+	}
+
+	/**
+	\brief Capture from a file rather than the sensor.
+
+	The file is either a raw stream recorded from the sensor, its lines with their headers, or
+	a set of acquired frames as written by save(), one after another, raw or packed (a .p12
+	file). Either way it is mapped and read in place. A raw stream goes through the parser just as a live capture does, a
+	frame set is transposed straight from the file into the frames. With m_streamCalib set the
+	frames are calibrated as they are read, as they would be by capture_bright().
+
+	The frames are calibrated with the dark frame saved beside them, see save_dark(). The dark
+	of the connected sensor is not theirs, so without a saved dark the frames can be read but
+	not calibrated.
+	*/
+	virtual void capture(std::string& fname)
+	{
+		finish_dark_refresh(); // the parser is in use until it is done
+
+		CVtMappedFile file;
+
+		if (!file.open( fname ))
+		{
+			Vt_fail( "failed to open input image"  );
+		}
+
+		if (!m_quiet)
+			std::cout << "replaying input file...." << std::endl;
+
+		if (!load_dark( fname ))
+		{
+			m_dark.resize( 0, 0 );
+
+			if (!m_quiet)
+				printf( "No dark frame saved with %s, the frames can't be calibrated\n", fname.c_str() );
+		}
+
+		const vt_bool packed = is_packed12_fname( fname );
+
+		if (m_streamCalib)
+		{
+			stream_bright( &file, packed );
+		}
+		else
+		{
+			replay( file, packed );
+		}
+
+		trim_dataset();
+	}
+
+	/**
+	\brief The file the dark frame of a capture is saved in, in the same directory as the capture.
+	*/
+	static std::string dark_fname(const std::string &fname)
+	{
+		const std::string::size_type sep = fname.find_last_of( "\\/" );
+
+		return (sep == std::string::npos ? std::string() : fname.substr( 0, sep + 1 )) + HDS_SAVED_DARK_FNAME;
+	}
+
+	/**
+	\brief Save m_dark beside a saved capture, a column at a time like the frames.
+
+	\param fname	the name of one of the capture's files
+	*/
+	void save_dark(const std::string &fname)
+	{
+		if (m_dark.width() != m_out_width || m_dark.height() != m_image_height)
+			return;
+
+		if (!m_quiet)
+			std::cout << "Saving dark frame" << std::endl;
+
+		save_imfile( m_dark, dark_fname( fname ), false );
+	}
+
+	/**
+	\brief Make the dark frame saved beside a capture file m_dark, see save_dark().
+
+	\return false if there is no saved dark frame of the image size
+	*/
+	vt_bool load_dark(const std::string &fname)
+	{
+		CVtMappedFile file;
+
+		if (!file.open( dark_fname( fname ) ) || file.size() != m_out_width*m_image_height*sizeof( vt_ushort ))
+			return false;
+
+		const vt_ushort *data = (const vt_ushort *) file.data();
+
+		std::vector<const vt_ushort *> cols( m_out_width );
+		for (vt_ulong col = 0; col < m_out_width; col++)
+			cols[col] = data + col*m_image_height;
+
+		m_dark.resize( m_out_width, m_image_height );
+		transpose_lines( m_dark.lines(), &cols[0], 0, m_image_height, m_out_width );
+
+		return true;
+	}
+
+	/**
+	\brief Add the frames of a mapped capture file to the dataset, see capture(std::string&).
+
+	\param packed	the file holds packed 12-bit frames, see save_packed()
+	\return the number of frames added
+	*/
+	vt_ulong replay(CVtMappedFile &file, const vt_bool packed = false)
+	{
+		if (packed)
+			return replay_packed( file.data(), file.size() );
+
+		vt_ushort			*data = (vt_ushort *) file.data();
+		const vt_ulong size = file.size()/sizeof( vt_ushort );
+
+		const vt_ulong frame_size = m_out_width*m_image_height;
+
+		// a saved frame has no line headers
+		vt_bool frame_set = (size % frame_size == 0);
+		for (vt_ulong idx = 0; frame_set && idx < m_image_height; idx++)
+		{
+			frame_set = (data[idx] & CVthdsLineParser::HDR_MASK) == 0;
+		}
+
+		if (frame_set)
+			return replay_frames( data, size/frame_size );
+
+		return replay_stream( data, size );
+	}
+
+	/**
+	\brief Add saved frames, each written a column at a time, to the dataset.
+	*/
+	vt_ulong replay_frames(const vt_ushort *data, const vt_ulong num)
+	{
+		std::vector<const vt_ushort *> cols( m_out_width );
+
+		for (vt_ulong frame = 0; frame < num; frame++, data += m_out_width*m_image_height)
+		{
+			for (vt_ulong col = 0; col < m_out_width; col++)
+				cols[col] = data + col*m_image_height;
+
+			CVtImage<vt_acq_im_type> *im = new CVtImage<vt_acq_im_type>( m_out_width, m_image_height
+																																	 , CVtImageBaseClass::ROW_MAJOR, pool_allocator() );
+			transpose_lines( im->lines(), &cols[0], 0, m_image_height, m_out_width );
+
+			m_parser.add_image( im );
+		}
+
+		return num;
+	}
+
+	/**
+	\brief Add saved packed frames, each written a column at a time, to the dataset.
+	*/
+	vt_ulong replay_packed(const vt_byte *data, const vt_ulong size)
+	{
+		const vt_ulong line_bytes	= packed12_bytes( m_image_height );
+		const vt_ulong frame_bytes = line_bytes*m_out_width;
+
+		if (size == 0 || size % frame_bytes != 0)
+		{
+			Vt_fail( "input file is not a set of packed hds frames" );
+		}
+
+		std::vector<vt_ushort> frame( m_out_width*m_image_height );
+
+		const vt_ulong num = size/frame_bytes;
+		for (vt_ulong idx = 0; idx < num; idx++, data += frame_bytes)
+		{
+			for (vt_ulong col = 0; col < m_out_width; col++)
+				unpack12( &frame[col*m_image_height], data + col*line_bytes, m_image_height );
+
+			replay_frames( &frame[0], 1 );
+		}
+
+		return num;
+	}
+
+	/**
+	\brief Parse a recorded raw stream, adding each complete frame to the dataset.
+
+	The parser reads the stream where it lies, a frame is m_out_width lines. A partial frame
+	at the end of the stream is dropped. The parser goes back to the driver's buffers before
+	returning, the stream is unmapped once it has been read.
+	*/
+	vt_ulong replay_stream(vt_ushort *data, const vt_ulong size)
+	{
+		const CVtUSBPipeData::BUFFERS driver_buffers = m_parser.pipe_buffers();
+
+		m_parser.reset_view( data, size );
+
+		vt_ulong num = 0;
+		try
+		{
+			num = parse_stream();
+		}
+		catch(...)
+		{
+			m_parser.end_view( driver_buffers );
+			throw;
+		}
+		m_parser.end_view( driver_buffers );
+
+		if (!m_quiet)
+			printf( "%lu frames replayed\n", num );
+
+		return num;
+	}
+
+	//
+	// parse the view the parser was given by replay_stream() into frames
+	//
+	vt_ulong parse_stream()
+	{
+		try
+		{
+			m_parser.sync_data( 0 );
+		}
+		catch (std::exception &)
+		{
+			Vt_fail( "no hds lines found in input file" );
+		}
+
+		vt_ulong num = 0;
+		for (vt_bool more = true; more; )
+		{
+			CVtImage<vt_acq_im_type> *im = new CVtImage<vt_acq_im_type>( m_out_width, m_image_height
+																																	 , m_parser.acq_layout(), pool_allocator() );
+			vt_ulong col = 0;
+			try
+			{
+				for (; col < m_out_width && (more = m_parser.get_line()); col++)
+					m_parser.save_image_line( *im, col );
+			}
+			catch(...)
+			{
+				delete im;
+				throw;
+			}
+
+			if (col < m_out_width)
+			{
+				delete im;
+				break;
+			}
+
+			m_parser.add_image( im );
+			num++;
+		}
+
+		return num;
+	}
+
+	/**
+	\brief Make m_dark the dark frame for this capture.
+
+	The cached dark frame is used if it is still valid, see m_darkMaxAge and m_darkMaxUses,
+	otherwise a new one is read.
+	*/
+	virtual void capture_dark()
+	{
+		finish_dark_refresh();
+
+		m_dark_cache.set_validity( m_darkMaxAge, m_darkMaxUses );
+
+		if (!m_dark_cache.valid( dark_key() ))
+		{
+			read_dark();
+
+			if (!m_dark_cache.commit())
+				Vt_fail( "capture_dark - no dark frame read" );
+		}
+		else if (!m_quiet)
+		{
+			printf( "Using cached dark frame\n" );
+		}
+
+		m_dark = m_dark_cache.use();
+	}
+
+	/**
+	\brief What the dark frame read now would be read under.
+
+	The sensor doesn't report its temperature, the frames are matched on its settings.
+	*/
+	CVthdsDarkCache::KEY dark_key() const
+	{
+		CVthdsDarkCache::KEY key;
+
+		key.reset_voltage = HDS_DEFAULT_RESET_VOLTAGE;
+		key.readout				= m_readout;
+
+		return key;
+	}
+
+	/**
+	\brief Read a dark frame from the sensor into the dark cache, commit() makes it the cached frame.
+	*/
+	void read_dark()
+	{
+		DEVICE_LOCK device( m_device_lock );
+
+		m_dark_cache.begin( dark_key() );
+
+		// send I want one frame command
+		arm( 1 );
+
+		// send a software trigger to cause dark frame to be readout
+		soft_trigger();
+
+		// read image data, straight into the cache rather than the dataset
+		m_parser.set_sink( &m_dark_cache );
+		try
+		{
+			m_driver.read_pipe(); // read one image
+		}
+		catch(...)
+		{
+			m_parser.set_sink( NULL );
+			reset();
+			throw;
+		}
+		m_parser.set_sink( NULL );
+
+		// OK reset FPGA
+		reset();
+	}
+
+	/**
+	\brief Read a fresh dark frame in the background, ready for the next capture.
+
+	Nothing is done unless dark frames are reused and m_darkRefresh is set. The read holds
+	m_device_lock, the parser is in use until finish_dark_refresh().
+	*/
+	void start_dark_refresh()
+	{
+		if (!m_darkRefresh || !m_dark_cache.enabled())
+			return;
+
+		m_dark_worker.post( m_dark_task );
+		m_dark_refreshing = true;
+	}
+
+	/**
+	\brief Wait for a background dark frame, and cache it.
+
+	A refresh which failed only costs the cached frame, the next capture reads its own.
+	*/
+	void finish_dark_refresh()
+	{
+		if (!m_dark_refreshing)
+			return;
+
+		m_dark_refreshing = false;
+
+		try
+		{
+			m_dark_worker.wait();
+			m_dark_cache.commit();
+		}
+		catch (std::exception &)
+		{
+			m_dark_cache.invalidate();
+		}
+	}
+
+	virtual void capture_bright()
+	{
+		DEVICE_LOCK device( m_device_lock );
+
+		arm( m_dataset_size );
+
+		// capturing bright frames
+		soft_trigger();  // this would not normally  be here - trigger for bright 
+										 // frames normally from x-ray.
+		// wait for tx when data acquired
+		wait_for_start();
+
+		if (m_streamCalib)
+		{
+			stream_bright();
+		}
+		else
+		{
+			// OK read n images worth all at the same time
+			m_driver.read_pipe( m_dataset_size ); // read n frame and add to dataset
+		}
+
+		// OK read the info
+		reset();
+	}
+
+	/**
+	\brief Read the bright frames from the pipe, calibrating each one as it is parsed.
+
+	The calibration consumes the frames instead of the dataset, so only one frame is held
+	however many are read, and the calibrated image is ready once the last has arrived.
+	calibrate() finds it in the dataset and has nothing more to do.
+
+	\param file		replay the frames of a mapped capture file rather than read the pipe
+	\param packed	the file holds packed 12-bit frames
+	*/
+	void stream_bright(CVtMappedFile *file = NULL, const vt_bool packed = false)
+	{
+		Vt_precondition( m_dark.width() == m_out_width && m_dark.height() == m_image_height
+									 , "CVthdsImpAPI::stream_bright - no dark frame, a replayed capture needs the dark saved with it" );
+
+		m_calib.set_threads( m_numThreads );
+		m_calib.begin_stream( m_out_width, m_image_height );
+
+		m_dataset.set_consumer( ACQ_IM, &m_calib );
+		try
+		{
+			if (file != NULL)
+				replay( *file, packed );
+			else
+				m_driver.read_pipe( m_dataset_size ); // read n frame and fold them into the calibration
+		}
+		catch(...)
+		{
+			m_dataset.set_consumer( ACQ_IM, NULL );
+			throw;
+		}
+		m_dataset.set_consumer( ACQ_IM, NULL );
+
+		// owned here until it is in the dataset, end_stream() can throw
+		std::auto_ptr< CVtImage<vt_out_im_type> > cal_im( new CVtImage<vt_out_im_type>(m_out_width, m_image_height, CVtImageBaseClass::ROW_MAJOR, uninit_allocator()) );
+
+		m_calib.end_stream( *cal_im );
+		add_calib( cal_im.release() );
+	}
+
+	/**
+	\brief Add a calibrated image to the dataset, replacing any from an earlier pass.
+	*/
+	void add_calib(CVtImage<vt_out_im_type>* cal_im)
+	{
+		while (m_dataset.delete_image( CALIB_IM ))
+			;
+
+		DATASET_ENTRY_TYPE ent_type;
+		ent_type.type = CALIB_IM;
+		add_dataset( ent_type, cal_im );
+	}
+
+	/**
+	\brief Main capture routine
+	*/
+	virtual void capture()
+	{
+		Vt_postcondition( _CrtCheckMemory() == TRUE, "Capture::Memory problem detected\n" );
+		Vt_precondition( m_driver.driver_handle() != NULL, "Device not initialised can't query ready status\n" );
+
+		finish_dark_refresh();
+
+		// set the reset voltage
+		reset(); send_command( std::string( HDS_DEFAULT_RESET_VOLTAGE	) );
+
+		capture_dark();
+
+		capture_bright();
+
+		trim_dataset();
+
+		start_dark_refresh();
+
+		if (!m_quiet)
+			printf( "Control Port is %x\n",ctrl_port());
+	}
+
+	/**
+	\brief Apply the memory budget to the dataset
+	*/
+	void trim_dataset()
+	{
+		m_dataset.set_budget( m_memBudget );
+		m_dataset.trim();
+	}
+
+	/**
+	\brief Apply calibration to acquired dataset
+
+	The calibration routines have direct access to the dataset via the reference to the current
+	dataset which is held in this class. 
+	*/
+	
+	virtual void calibrate()
+	{
+		// a streamed capture was calibrated as it arrived
+		if (!m_dataset.present( ACQ_IM ) && m_dataset.present( CALIB_IM ))
+		{
+			set_hw_info( m_calib.m_hw_info );
+			return;
+		}
+
+		Vt_precondition( m_dark.width() == m_out_width && m_dark.height() == m_image_height
+									 , "CVthdsImpAPI::calibrate - no dark frame, a replayed capture needs the dark saved with it" );
+
+		// frames kept packed from a previous pass
+		m_dataset.unpack( ACQ_IM );
+
+		// OK apply calibration to each line, the image is owned here until it is in the dataset
+		std::auto_ptr< CVtImage<vt_out_im_type> > cal_im( new CVtImage<vt_out_im_type>(m_out_width, m_image_height, CVtImageBaseClass::ROW_MAJOR, uninit_allocator()) );
+
+		m_calib.set_threads( m_numThreads );
+		m_calib( *cal_im, m_dataset_size ); // currently default to using all the images.
+
+		// the calibrated image replaces any from an earlier pass
+		add_calib( cal_im.release() );
+
+		// the acquired frames are only kept for saving or recalibration from here on
+		if (m_packed12)
+			m_dataset.pack( ACQ_IM );
+
+		trim_dataset();
+
+		set_hw_info( m_calib.m_hw_info );
+	}
+
+	/**	
+	
+	A utility function used to print a particular byte as a series of 1 and 0
+	
+	*/
+	void print_byte(const vt_byte val)
+	{
+		for(vt_ulong bit=0; bit < 8; bit++)
+		{
+			if (bit == 4) 
+				printf( " " );
+
+			if ((val << bit) & 0x80 )
+				printf( "1" );
+			else
+				printf( "0" );
+		}
+	}
+	/**
+		Debug code
+	
+		Currently this routine is merely a place holder for any debugging code.
+
+	*/
+	void test( const CODE_PAIRS::iterator &cmd )
+	{
+		std::string cmd_str = (*cmd).first;
+		vt_ulong	  cmd_code = (*cmd).second;
+
+		// print out command string
+		printf( "Command %s  ", cmd_str.c_str() );
+
+		// print out command code
+		printf( " %0x ", cmd_code ); print_byte( cmd_code );
+
+		// send command to USB
+		if (send_command( cmd_str ))
+		{
+			printf( " returned OK " );
+		}
+		else
+		{
+			printf( " problem " );
+		}
+		// print value of port
+		vt_ulong ctrl = ctrl_port();
+		print_byte( ctrl );
+
+		if (ctrl != cmd_code )
+		{
+			printf( " mismatch!!" );
+			send_command( cmd_str ); // try again
+		}
+		printf( "\n" );
+	}
+
+	/**
+	The overall interface model is extremely simple
+
+	acquire
+	process
+	save
+
+	This function should be used to implement the process part.
+
+	Currently its doing debug duty.
+	*/
+
+	virtual void process()
+	{
+		printf( "Initial interface test\n" );
+		capture();
+
+		arm( 0 );
+
+		vt_byte port_a = hs_port();
+
+		printf( "port A %0x ", port_a ); print_byte( port_a ); printf( "\n");
+
+		for (vt_byte val = 0; val < 0xff; val++)
+		{
+			set_port( val, 0xa );
+			
+			vt_byte port_a = hs_port();
+
+			printf( "val %0x port A %0x ", val, port_a ); print_byte( port_a ); printf( "\n");
+
+			set_port( val, 0xe );
+			
+			vt_byte port_e = data_port();
+
+			printf( "val %0x port E %0x ", val, port_e ); print_byte( port_e ); printf( "\n");
+			getchar();
+		}
+
+		wait_for_start();
+		capture();
+
+		for(CODE_PAIRS::iterator it = m_codes.begin();	 it != m_codes.end();  ++it )
+		{
+			if ( !(*it).first.empty())
+			{
+				test( it );
+				getchar();
+			}
+		}
+
+	}
+
+	/**
+	Main processing function
+
+	Currently this merely consist of application of the calibration routines for the 
+	intra-oral.
+
+	\param imtype - this is not really applicable for intra-oral as they will alway be the acquired image
+	types.
+	*/
+	virtual void process(IM_TYPE imtype)
+	{
+		if (!m_quiet)
+			std::cout << "OK - images acquired" << std::endl;
+		
+		calibrate();
+	}
+
+	/**
+	 main calibration run
+	*/
+	void calibration_run()
+	{
+		finish_dark_refresh();
+		m_dark_cache.invalidate(); // the sweep leaves the reset voltage changed
+
+		m_calib.calibration_run( *this );
+
+		// the new coefficients are for this sensor. They are saved beside the installed
+		// calibration rather than over it, the file has to be copied over the .hcl to be used
+		m_calib.m_hw_info = m_hw_info;
+
+		const std::string fname = std::string( get_calib_fname() ) + HDS_NEW_CALIB_EXT;
+		m_calib.save( fname );
+
+		if (!m_quiet)
+			printf( "New calibration saved to %s, copy it over %s to use it\n", fname.c_str(), get_calib_fname() );
+	}
+
+	/**
+	 set the api to have required characteristics
+	 for the current binning mode and api type
+	*/
+	virtual void set_api_params()
+	{
+		m_fname_base = HDS_DEFAULT_BASE_DIR;
+		switch(m_apiType)
+		{
+			case HDS15_API:
+				m_out_width			= HDS15_SIZE_WIDTH;
+				m_image_height	= HDS15_SIZE_HEIGHT;
+				m_dataset_size  = HDS15_DATASET_SIZE;
+				break;
+			case HDS20_API:
+				m_out_width			= HDS20_SIZE_WIDTH;
+				m_image_height	= HDS20_SIZE_HEIGHT;
+				m_dataset_size  = HDS20_DATASET_SIZE;
+				break;
+			default:
+				Vt_fail( "Invalid API type\n" );
+				break;
+		}
+
+		set_num_pkts();
+		set_calib_fname();
+		set_command_codes();
+	}
+
+	/**
+	interface type accessor
+	*/
+	virtual API_TYPE get_api_type()
+	{
+		return m_apiType;
+	}
+	
+	/**
+	 what does the hardware think that the device is?
+	*/
+	virtual API_TYPE  hw_device_type() 
+	{
+		DEVICE_LOCK device( m_device_lock );
+		return m_driver.hw_device_type();
+	}
+
+	virtual char * get_fwfname()
+	{
+		return HDS_DEFAULT_HEX_FW_FNAME;
+	}
+
+	/**
+	General control port access functions
+	*/
+	virtual vt_byte ctrl_port() 
+	{
+		DEVICE_LOCK device( m_device_lock );
+		return m_driver.ctrl_port();
+	}
+
+	virtual vt_byte hs_port() 
+	{
+		DEVICE_LOCK device( m_device_lock );
+		return m_driver.hs_port();
+	}
+
+	virtual vt_byte data_port() 
+	{
+		DEVICE_LOCK device( m_device_lock );
+		return m_driver.data_port();
+	}
+
+	/**
+	\brief Arm the sensor ready to receive x-rays
+	*/ 
+	virtual vt_bool arm(const vt_ulong frames )
+	{
+		vt_ulong cmd = get_command( std::string( "VR_ARM_INF" ) ) + frames;
+		return send_command( cmd );
+	}
+
+	/**
+	\brief Send the a software trigger to the sensor.
+	*/ 
+	virtual vt_bool soft_trigger()
+	{
+		return send_command( std::string( "VR_SOFTWARE_TRIGGER" ) );
+	}
+
+	/**
+	\brief Send the a software trigger to the sensor.
+	*/ 
+	virtual vt_bool reset()
+	{
+		return send_command( std::string( "VR_IUSBI_RESET" ) );
+	}
+
+	/**
+	\brief Send the a command to set a port to a particular value
+	*/ 
+	virtual vt_bool set_port(const vt_byte val, const vt_byte port )
+	{ 
+		return send_command( get_command( std::string( "VR_SET_PORT" ) ), val + ( port << 8 ) );
+	}
+
+	/**
+	\brief Get information about the current sensor status
+	
+	The sensor contains an Eprom which is initialised as calibration time to contain certain information.
+	This routine downloads this information from the sensor and saves the information in the member variable
+	m_hw_info.
+	*/
+	virtual vt_bool get_hw_info()
+	{
+		DEVICE_LOCK device( m_device_lock );
+
+		vt_byte buffer[16];
+		vt_byte					CommandCode		 = get_command( std::string( "VR_GET_SENSOR_INFO" )  );
+		const vt_uint16 SubCommandCode = DEFAULT_SUB;
+
+		vt_bool ret_code = send_command( (vt_byte *) buffer, CommandCode, SubCommandCode );
+		m_hw_info =  buffer; 
+
+		return ret_code;
+	}
+
+	/**
+	\brief Set information about the current sensor status
+	
+	The routine initializes the sensor Eprom at calibration time to contain information about the hardware.
+	This routine uploads this information to the sensor from that stored in m_hw_info; 
+	m_hw_info.
+	*/
+	virtual vt_bool set_hw_info()
+	{
+		DEVICE_LOCK device( m_device_lock );
+		return m_driver.send_data((const vt_byte *) m_hw_info
+														, SENSOR_INFO_SIZE
+														, get_command( std::string( "VR_SET_SENSOR_INFO" ) ) 
+														);
+	}
+
+	virtual vt_bool set_hw_info(SENSOR_INFO &hw_info )
+	{
+		DEVICE_LOCK device( m_device_lock );
+
+		m_hw_info = hw_info;
+		return m_driver.send_data((const vt_byte *) m_hw_info
+														, SENSOR_INFO_SIZE
+														, get_command( std::string( "VR_SET_SENSOR_INFO" ) ) 
+														);
+	}
+
+
+	/**
+	 get image height - returns image height
+	 currently all the images are the same height
+	*/
+	virtual vt_ulong image_width()
+	{
+		return m_out_width;
+	}
+
+	virtual vt_ulong image_width(IM_TYPE im_type) 
+	{
+		return m_dataset.image_width( im_type );
+	}
+
+	virtual vt_ulong image_height()
+	{
+		return m_image_height;
+	}
+
+	virtual vt_ulong image_height(IM_TYPE im_type) 
+	{
+		return m_dataset.image_height( im_type );
+	}
+
+	virtual CVtImageBaseClass::LAYOUT image_layout(IM_TYPE im_type) 
+	{
+		return m_dataset.image_layout( im_type );
+	}
+
+public:
+	/************************************
+		 DATASET Manipulation
+	************************************/
+
+	virtual vt_bool delete_dataset()
+	{
+		return m_dataset.delete_dataset();
+	}
+
+	virtual vt_bool delete_image(IM_TYPE im_type)
+	{
+		return m_dataset.delete_image(im_type);
+	}
+
+	///
+	// image data accessors
+	//
+	virtual vt_ushort * image_ptr()
+	{
+		return m_dataset.image_ptr();
+	}
+
+	virtual vt_ushort * image_ptr(IM_TYPE im_type)
+	{
+		return m_dataset.image_ptr(im_type);
+	}
+
+	virtual vt_ushort ** image_ptrs(IM_TYPE im_type)
+	{
+		return m_dataset.image_ptrs(im_type);
+	}
+
+
+	///
+	// dataset manipulation
+	//
+	// Datasets can be any 2d set of data.
+	//
+	void add_dataset( DATASET_ENTRY_TYPE ent_type, CVtImageBaseClass *pdata )
+	{
+		m_dataset.add_dataset( ent_type, pdata );
+	}
+
+	DATASET_ENTRY pop_back( const IM_TYPE im_type )
+	{
+		return m_dataset.pop_back( im_type );
+	}
+
+	DATASET_ENTRY get_back( const IM_TYPE im_type )
+	{
+		return m_dataset.get_back( im_type );
+	}
+
+	/**
+	 Save an acquired frame as a packed 12-bit file if it is held packed or packing
+	 is selected. Returns false if the frame should be saved as an ordinary image.
+	 The file is written a column at a time like the raw files, see replay_packed().
+	*/
+	vt_bool save_packed(CVtImageBaseClass *frame, const std::string &fname )
+	{
+		CVtPacked12Image *packed = dynamic_cast<CVtPacked12Image*>( frame );
+		if (packed != NULL)
+		{
+			packed->save( packed12_fname( fname ), CVtImageBaseClass::COL_MAJOR );
+			return true;
+		}
+
+		CVtImage<vt_acq_im_type> *im = dynamic_cast<CVtImage<vt_acq_im_type>*>( frame );
+		if (im != NULL && m_packed12)
+		{
+			CVtPacked12Image( *im ).save( packed12_fname( fname ), CVtImageBaseClass::COL_MAJOR );
+			return true;
+		}
+
+		return false;
+	}
+
+	virtual void save()
+	{
+		std::string fname_base( HDS_DEFAULT_BASE_FNAME );
+
+		vt_ulong fname_cnt = 1;
+
+		if (m_dataset.present( ACQ_IM ))
+			save_dark( Fname( fname_base, fname_cnt ) );
+
+		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++, fname_cnt++)
+		{
+			vt_ulong pixel_size = 0;
+
+			switch((*it).first.type)
+			{
+				case ACQ_IM:
+				{
+					std::cout << "Saving acquired image" << std::endl;
+					if (save_packed( m_dataset.fetch( it ), Fname(fname_base, fname_cnt) ))
+						break;
+
+					CVtImage<vt_acq_im_type> *im = dynamic_cast<CVtImage<vt_acq_im_type>*>(m_dataset.fetch( it ));
+					if (im == NULL)
+					{
+						Vt_fail( "Unexpected image type" );
+					}
+					save_imfile( *im
+									, Fname(fname_base, fname_cnt)
+									, false ); 	
+				}
+				break;
+				case CENTRE_IM:
+				{
+					std::cout << "Saving centred image" << std::endl;
+					CVtImage<vt_centre_im_type>* im = dynamic_cast<CVtImage<vt_centre_im_type>*>(m_dataset.fetch( it ));
+					if (im == NULL)
+					{
+						Vt_fail( "Unexpected image type" );
+					}
+					save_imfile( *im
+									, Fname(fname_base, fname_cnt)
+									, false ); 	
+					break;
+				}
+				case CALIB_IM:
+				{
+					std::cout << "Saving calibrated image" << std::endl;
+					CVtImage<vt_calib_im_type>* im = dynamic_cast<CVtImage<vt_calib_im_type>*>(m_dataset.fetch( it ));
+					if (im == NULL)
+					{
+						Vt_fail( "Unexpected image type" );
+					}
+					save_imfile( *im
+									, Fname(fname_base, fname_cnt)
+									, false ); 	
+					break;
+				}
+				case RECON_IM:
+				{
+					std::cout << "Saving recon image" << std::endl;
+					CVtImage<vt_recon_im_type>* im = dynamic_cast<CVtImage<vt_recon_im_type>*>(m_dataset.fetch( it ));
+					if (im == NULL)
+					{
+						Vt_fail( "Unexpected image type" );
+					}
+					save_imfile( *im
+									, Fname(fname_base, fname_cnt)
+									, false ); 	
+					break;
+				}
+				case OUTPUT_IM:
+				{
+					std::cout << "Saving output image" << std::endl;
+					CVtImage<vt_out_im_type>* im = dynamic_cast<CVtImage<vt_out_im_type>*>(m_dataset.fetch( it ));
+					if (im == NULL)
+					{
+						Vt_fail( "Unexpected image type" );
+					}
+					save_imfile( *im
+									, Fname(fname_base, fname_cnt)
+									, false ); 	
+					break;
+				}
+				default:
+					std::cout << "Invalid image type" << std::endl;
+			}
+		}
+	}
+	
+	//
+	// save data for a particular image type
+	//
+	virtual void save(IM_TYPE imtype, std::string &fname_base)
+	{
+		vt_ulong fname_cnt = 1;
+
+		if (imtype == ACQ_IM && m_dataset.present( ACQ_IM ))
+			save_dark( Fname( fname_base, fname_cnt ) );
+		
+		DATASET::iterator it = m_dataset.end(); it--;
+		for(;; it--, fname_cnt++)
+		{
+			if ( (*it).first.type == imtype)
+			{
+				switch(imtype)
+				{
+					case ACQ_IM:
+					{
+						if (save_packed( m_dataset.fetch( it ), Fname(fname_base, fname_cnt) ))
+							break;
+
+						CVtImage<vt_acq_im_type>* im = dynamic_cast<CVtImage<vt_acq_im_type>*>(m_dataset.fetch( it ));
+						if (im == NULL)
+						{
+							Vt_fail( "Unexpected image type" );
+						}
+						save_imfile( *im
+										, Fname(fname_base, fname_cnt)
+										, false ); 	
+						break;
+					}
+					case CENTRE_IM:
+					{
+						CVtImage<vt_centre_im_type>* im = dynamic_cast<CVtImage<vt_centre_im_type>*>(m_dataset.fetch( it ));
+						if (im == NULL)
+						{
+							Vt_fail( "Unexpected image type" );
+						}
+						save_imfile( *im
+										, Fname(fname_base, fname_cnt)
+										, false ); 	
+						break;
+					}
+					case CALIB_IM:
+					{
+						CVtImage<vt_calib_im_type>* im = dynamic_cast<CVtImage<vt_calib_im_type>*>(m_dataset.fetch( it ));
+						if (im == NULL)
+						{
+							Vt_fail( "Unexpected image type" );
+						}
+						save_imfile( *im
+										, Fname(fname_base, fname_cnt)
+										, false ); 	
+						break;
+					}
+					case OUTPUT_IM:
+					{
+						CVtImage<vt_out_im_type>* im = dynamic_cast<CVtImage<vt_out_im_type>*>(m_dataset.fetch( it ));
+						if (im == NULL)
+						{
+							Vt_fail( "Unexpected image type" );
+						}
+						save_imfile( *im
+										, Fname(fname_base, fname_cnt)
+										, false ); 	
+						break;
+					}
+					case RECON_IM:
+					{
+						CVtImage<vt_recon_im_type>* im = dynamic_cast<CVtImage<vt_recon_im_type>*>(m_dataset.fetch( it ));
+						if (im == NULL)
+						{
+							Vt_fail( "Unexpected image type" );
+						}
+						save_imfile( *im
+										, Fname(fname_base, fname_cnt)
+										, false ); 	
+						break;
+					}
+				}
+			}
+
+			if (it == m_dataset.begin())
+				return;
+		}
+		Vt_precondition( _CrtCheckMemory() == TRUE, "image_ptr::Memory problem detected\n" );
+	}
+	
+	
+	///
+	// HARDWARE CTRL ROUTINES
+	//
+	//
+	// note: currently start is active low on the a paritcular pin of the usb
+	// Hence the following code merely polls the pin looking for the active low state.
+	//
+	virtual START_SIG  wait_for_start(const vt_double wait_time, const vt_double min_wait_time = 0.0 )
+	{
+		Vt_precondition( m_driver.driver_handle() != NULL, "Device not initialised can't query ready status\n" );
+
+		DEVICE_LOCK device( m_device_lock );
+		clock_t start = clock();
+
+		while( !m_driver.hds_start() ) // active high
+		{
+			clock_t end = clock();
+			double time_taken = ((double)(end - start))/CLOCKS_PER_SEC;
+
+			if (time_taken > wait_time)
+				return START_SIG_TIMEOUT;
+
+			if (!m_quiet)
+				rotator();
+		}
+		if (!m_quiet)
+			printf( "OK\n" );
+
+		return START_SIG_RECEIVED;
+	}
+
+	virtual START_SIG  wait_for_start() // in milliseconds
+	{
+		return wait_for_start( 1000000 );
+	}
+
+	///
+	// The amount of data to skip at the beginning of acquiring each image. On the current 
+	// TDI mode ccd sensor the initial frames are saturated and hence should be discarded.
+	//
+	virtual vt_ulong get_header_size()
+	{
+		return HDS_DEFAULT_HDR_SIZE;
+	}
+
+	//
+	// command codes
+	//
+	CODE_PAIRS& get_command_codes()
+	{
+		return m_codes;
+	}
+	
+	//
+	// HARDWARE COMMS ROUTINES
+	//
+	/**
+	\brief utility used by send command
+	*/
+	vt_byte get_command(const std::string &cmd )
+	{
+		CODE_PAIRS::iterator it = m_codes.find( cmd );
+		
+		return(*it).second;
+	}
+
+	virtual vt_bool send_command(vt_byte status[16]
+									 , const vt_byte CommandCode
+									 , const vt_uint16 SubCommandCode )
+	{
+		DEVICE_LOCK device( m_device_lock );
+		return m_driver.send_command( status, CommandCode, SubCommandCode );
+	}
+
+	virtual vt_bool send_command(const std::string &cmd )
+	{
+		vt_byte status[16];
+		
+		vt_byte					CommandCode		 = get_command( cmd );
+		const vt_uint16 SubCommandCode = DEFAULT_SUB;
+
+		return send_command( status, CommandCode, SubCommandCode );
+	}
+
+	virtual vt_bool send_command( const vt_byte CommandCode, const vt_uint16 SubCommandCode = DEFAULT_SUB )
+	{
+		vt_byte status[16];
+
+		DEVICE_LOCK device( m_device_lock );
+		return m_driver.send_command( status, CommandCode, SubCommandCode );
+	}
+
+	//
+	// bin mode effectively set the height and width of the image
+	//
+	virtual void set_calib_fname()
+	{
+		m_calibFname = (m_apiType == HDS15_API) ? HDS_DEFAULT_HDS15_CALIB_FNAME : HDS_DEFAULT_HDS20_CALIB_FNAME;
+	}
+	
+	virtual char* get_calib_fname()
+	{
+		set_calib_fname(); //  make sure name is set to default for acquisition mode
+		return m_calibFname;
+	}
+
+	///
+	// private funcs - not exposed through API but useable
+	//
+	virtual vt_ulong get_num_pkts()
+	{
+		set_num_pkts(); // ensure that the number of packets is set to the default for the acqusition mode
+		return m_numPkts;
+	}
+	virtual void set_num_pkts(vt_ulong num_pkts) // explicitly set num pkts
+	{
+		m_numPkt_override = true;
+		m_numPkts = num_pkts;
+	}
+	virtual void set_num_pkts(vt_bool dummy) // turn off override and set default num pkts
+	{
+		m_numPkt_override = false;
+		set_num_pkts();
+	}
+	virtual void set_num_pkts() // set default num pkts
+	{
+		if (m_numPkt_override)
+			return;
+
+		if (m_calibFlag)
+		{
+			m_numPkts = (m_apiType == HDS15_API) ? HDS15_CALIB_NUM_PKTS : HDS20_CALIB_NUM_PKTS;
+		}
+		else
+		{
+			m_numPkts = (m_apiType == HDS15_API) ? HDS15_NUM_PKTS : HDS20_NUM_PKTS;
+		}
+	}
+private:
+	//
+	// set_interface_codes
+	//
+	void set_command_codes()
+	{
+		CODE_PAIR_ENTRY myPair;
+		//
+		// reset frequencies
+		//
+		myPair.first  = "VR_READOUT_FREQUENCY_2_0MHZ";
+		myPair.second = VR_READOUT_FREQUENCY_2_0MHZ;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_READOUT_FREQUENCY_2_5MHZ";
+		myPair.second = VR_READOUT_FREQUENCY_2_5MHZ;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_READOUT_FREQUENCY_3_0MHZ";
+		myPair.second = VR_READOUT_FREQUENCY_3_0MHZ;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_READOUT_FREQUENCY_3_5MHZ";
+		myPair.second = VR_READOUT_FREQUENCY_3_5MHZ;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_READOUT_FREQUENCY_4_0MHZ";
+		myPair.second = VR_READOUT_FREQUENCY_4_0MHZ;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_READOUT_FREQUENCY_4_5MHZ";
+		myPair.second = VR_READOUT_FREQUENCY_4_5MHZ;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_READOUT_FREQUENCY_5_0MHZ";
+		myPair.second = VR_READOUT_FREQUENCY_5_0MHZ;
+		m_codes.insert(myPair);
+		//
+		// ARM
+		//
+		myPair.first  = "VR_ARM_INF";
+		myPair.second = VR_ARM_INF;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_ARM_1";
+		myPair.second = VR_ARM_1;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_ARM_2";
+		myPair.second = VR_ARM_2;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_ARM_3";
+		myPair.second = VR_ARM_3;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_ARM_4";
+		myPair.second = VR_ARM_4;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_ARM_5";
+		myPair.second = VR_ARM_5;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_ARM_6";
+		myPair.second = VR_ARM_6;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_ARM_7";
+		myPair.second = VR_ARM_7;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_ARM_8";
+		myPair.second = VR_ARM_8;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_ARM_9";
+		myPair.second = VR_ARM_9;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_ARM_10";
+		myPair.second = VR_ARM_10;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_ARM_11";
+		myPair.second = VR_ARM_11;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_ARM_12";
+		myPair.second = VR_ARM_12;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_ARM_13";
+		myPair.second = VR_ARM_13;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_ARM_14";
+		myPair.second = VR_ARM_14;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_ARM_15";
+		myPair.second = VR_ARM_15;
+		m_codes.insert(myPair);
+		//
+		// general codes
+		//
+		myPair.first  = "VR_SOFTWARE_TRIGGER";
+		myPair.second = VR_SOFTWARE_TRIGGER;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_SHUTDOWN";
+		myPair.second = VR_SHUTDOWN;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_WRITE_SENSOR_INFO";
+		myPair.second = VR_WRITE_SENSOR_INFO;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_ABORT";
+		myPair.second = VR_ABORT;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_GET_SENSOR_INFO";
+		myPair.second = VR_GET_SENSOR_INFO;
+		m_codes.insert(myPair);
+		//
+		// reset voltages
+		//
+		myPair.first  = "VR_RESET_VOLTAGES_1_8V";
+		myPair.second = VR_RESET_VOLTAGES_1_8V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_1_9V";
+		myPair.second = VR_RESET_VOLTAGES_1_9V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_2_0V";
+		myPair.second = VR_RESET_VOLTAGES_2_0V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_2_1V";
+		myPair.second = VR_RESET_VOLTAGES_2_1V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_2_2V";
+		myPair.second = VR_RESET_VOLTAGES_2_2V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_2_3V";
+		myPair.second = VR_RESET_VOLTAGES_2_3V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_2_4V";
+		myPair.second = VR_RESET_VOLTAGES_2_4V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_2_5V";
+		myPair.second = VR_RESET_VOLTAGES_2_5V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_2_6V";
+		myPair.second = VR_RESET_VOLTAGES_2_6V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_2_7V";
+		myPair.second = VR_RESET_VOLTAGES_2_7V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_2_8V";
+		myPair.second = VR_RESET_VOLTAGES_2_8V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_2_9V";
+		myPair.second = VR_RESET_VOLTAGES_2_9V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_3_0V";
+		myPair.second = VR_RESET_VOLTAGES_3_0V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_3_1V";
+		myPair.second = VR_RESET_VOLTAGES_3_1V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_3_2V";
+		myPair.second = VR_RESET_VOLTAGES_3_2V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_3_3V";
+		myPair.second = VR_RESET_VOLTAGES_3_3V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_3_4V";
+		myPair.second = VR_RESET_VOLTAGES_3_4V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_3_5V";
+		myPair.second = VR_RESET_VOLTAGES_3_5V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_3_6V";
+		myPair.second = VR_RESET_VOLTAGES_3_6V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_3_7V";
+		myPair.second = VR_RESET_VOLTAGES_3_7V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_3_8V";
+		myPair.second = VR_RESET_VOLTAGES_3_8V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_3_9V";
+		myPair.second = VR_RESET_VOLTAGES_3_9V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_4_0V";
+		myPair.second = VR_RESET_VOLTAGES_4_0V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_4_1V";
+		myPair.second = VR_RESET_VOLTAGES_4_1V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_4_2V";
+		myPair.second = VR_RESET_VOLTAGES_4_2V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_4_3V";
+		myPair.second = VR_RESET_VOLTAGES_4_3V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_4_4V";
+		myPair.second = VR_RESET_VOLTAGES_4_4V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_RESET_VOLTAGES_4_5V";
+		myPair.second = VR_RESET_VOLTAGES_4_5V;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_IUSBI_TEST";
+		myPair.second = VR_IUSBI_TEST;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_IUSBI_RENUM";
+		myPair.second = VR_IUSBI_RENUM;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_IUSBI_GET_USB_STATE";
+		myPair.second = VR_IUSBI_GET_USB_STATE;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_IUSBI_INITIALISE";
+		myPair.second = VR_IUSBI_INITIALISE;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_IUSBI_RESET";
+		myPair.second = VR_IUSBI_RESET;
+		m_codes.insert(myPair);
+
+		//
+		// port commands
+		//
+		myPair.first  = "VR_SET_PORT";
+		myPair.second = VR_SET_PORT;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_CLEAR_A";
+		myPair.second = VR_CLEAR_A;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_CLEAR_C";
+		myPair.second = VR_CLEAR_C;
+		m_codes.insert(myPair);
+
+		myPair.first  = "VR_CLEAR_E";
+		myPair.second = VR_CLEAR_E;
+		m_codes.insert(myPair);
+
+	}
+};
+} // end Vt namespace
+
+#endif // __CVTHDSIMPAPI_H__
@@ -0,0 +1,393 @@
+/** \file VthdsReadoutProbe.h
+
+	\brief Selection of the fastest hds readout frequency the host keeps up with.
+
+	The hds sensor reads out at 2.0 to 5.0MHz, see the VR_READOUT_FREQUENCY commands. Read out
+	faster than the host can take and parse the data and lines are lost; read out slower and
+	every exposure takes longer than it need. Vt::CVthdsReadoutProbe streams test frames at
+	each frequency in turn, lowest first, and checks that every frame arrives with its lines
+	whole and numbered in sequence. The highest frequency with no loss is the one to use.
+
+	The probe talks to the sensor through a Vt::CVthdsSensorLink, which is either the sensor
+	itself, see CVthdsImpAPI::probe_readout(), or the in-process Vt::CVthdsEmulatedSensor.
+
+ * Copyright (c) 2013 by
+ * All Rights Reserved
+ * REVISIONS:
+ * $Log: $
+ *
+ */
+
+#ifndef __CVTHDSREADOUTPROBE_H__
+#define __CVTHDSREADOUTPROBE_H__
+
+#include <time.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "VtSysdefs.h"
+#include "VtErrors.h"
+
+namespace Vt {
+
+/**
+	\brief The readout frequency commands, slowest first.
+*/
+struct HDS_READOUT
+{
+	const vt_char *command;
+	vt_double			 mhz;
+};
+
+static const HDS_READOUT gHdsReadouts[] = {
+	{ "VR_READOUT_FREQUENCY_2_0MHZ", 2.0 }
+	, { "VR_READOUT_FREQUENCY_2_5MHZ", 2.5 }
+	, { "VR_READOUT_FREQUENCY_3_0MHZ", 3.0 }
+	, { "VR_READOUT_FREQUENCY_3_5MHZ", 3.5 }
+	, { "VR_READOUT_FREQUENCY_4_0MHZ", 4.0 }
+	, { "VR_READOUT_FREQUENCY_4_5MHZ", 4.5 }
+	, { "VR_READOUT_FREQUENCY_5_0MHZ", 5.0 }
+};
+
+const vt_ulong gNumHdsReadouts = sizeof( gHdsReadouts )/sizeof( gHdsReadouts[0] );
+
+/**
+	\brief Where the probe's test frames come from.
+
+	stream() delivers the frames through the parser, which counts the lines which arrive
+	broken or out of sequence.
+*/
+class CVthdsSensorLink
+{
+public:
+	virtual ~CVthdsSensorLink() {}
+
+	/**
+	\brief Select a readout frequency.
+
+	\param command	one of the gHdsReadouts commands
+	\return false if the frequency can't be selected
+	*/
+	virtual vt_bool set_readout(const std::string &command) = 0;
+
+	/**
+	\brief Get ready to stream a number of frames, the time this takes is not measured.
+	*/
+	virtual void prepare(const vt_ulong num_frames)
+	{}
+
+	/**
+	\brief Read out a number of frames at the selected frequency.
+
+	\return the number of whole frames received
+	*/
+	virtual vt_ulong stream(const vt_ulong num_frames) = 0;
+
+	//! the fastest readout in MHz the link carries in full, 0 if it isn't known
+	virtual vt_double link_mhz() const
+	{
+		return 0.0;
+	}
+
+	//! the lines the link holds while the host catches up
+	virtual vt_ulong fifo_lines() const = 0;
+};
+
+/**
+	\brief An hds sensor emulated in process, for running the probe without the hardware.
+
+	The frames are made in the sensor's line format by prepare(), and parsed where they lie when
+	they are streamed. The emulation loses lines the way the sensor does:
+
+	- a link slower than the readout, see set_link(), drops lines evenly through the stream.
+	- a host which parses more slowly than the sensor reads out falls behind until its FIFO
+	  overflows, the frames it couldn't have taken in time are not delivered.
+
+	With no link limit and the default FIFO the parser in process keeps up at every frequency,
+	so set_link() should be given what the real link was seen to do, see CVthdsImpAPI::probe_readout().
+*/
+class CVthdsEmulatedSensor : public CVthdsSensorLink
+{
+	enum {
+		SOL_HDR = 0x8000		//!< start of line header, ORed with the line number
+		, EOL_HDR = 0xc000	//!< end of line header, ORed with the line number
+		, LEAD_IN = 3				//!< words of FIFO residue before the first line
+	};
+
+	CVthdsLineParser			&m_parser;
+	vt_ulong							 m_width;			//!< lines per frame
+	vt_ulong							 m_height;		//!< values per line
+	vt_ulong							 m_fifo_lines;
+	vt_double							 m_link_mhz;
+
+	vt_double							 m_mhz;				//!< the selected readout frequency
+	vt_ulong							 m_num_frames;	//!< the frames in m_stream
+	std::vector<vt_ushort> m_stream;
+	std::vector<vt_ushort> m_column;
+
+	void make_stream(const vt_ulong num_frames)
+	{
+		m_num_frames = num_frames;
+		m_stream.clear();
+		m_stream.reserve( LEAD_IN + (num_frames*m_width + 1)*(m_height + 2) );
+
+		for (vt_ulong idx = 0; idx < LEAD_IN; idx++)
+			m_stream.push_back( (vt_ushort) (rand() & CVthdsLineParser::CHIP_DATA_MASK) );
+
+		// sync_data() counts the header which ends a line as part of it, it locks on to a line
+		// one value short
+		m_stream.push_back( SOL_HDR );
+		for (vt_ulong row = 1; row < m_height; row++)
+			m_stream.push_back( 0 );
+		m_stream.push_back( EOL_HDR );
+
+		const vt_double lost = (m_link_mhz > 0.0 && m_mhz > m_link_mhz) ? 1.0 - m_link_mhz/m_mhz : 0.0;
+		vt_double				drop = 0.0;
+
+		for (vt_ulong frame = 0; frame < num_frames; frame++)
+		{
+			for (vt_ulong line = 0; line < m_width; line++)
+			{
+				drop += lost;
+				if (drop >= 1.0)
+				{
+					drop -= 1.0;
+					continue;
+				}
+
+				m_stream.push_back( (vt_ushort) (SOL_HDR | line) );
+				for (vt_ulong row = 0; row < m_height; row++)
+					m_stream.push_back( (vt_ushort) ((frame + 7*line + row) & CVthdsLineParser::CHIP_DATA_MASK) );
+				m_stream.push_back( (vt_ushort) (EOL_HDR | line) );
+			}
+		}
+	}
+
+public:
+	/**
+	\param parser			the parser the frames are streamed through, initialised for lines of height values
+	\param width			lines per frame
+	\param height			values per line
+	\param fifo_lines	the lines the sensor's FIFO holds while the host catches up
+	\param link_mhz		the fastest readout the link carries in full, 0 for no limit
+	*/
+	CVthdsEmulatedSensor(CVthdsLineParser &parser
+										 , const vt_ulong width
+										 , const vt_ulong height
+										 , const vt_ulong fifo_lines = 64
+										 , const vt_double link_mhz = 0.0
+										 ) : m_parser( parser )
+											 , m_width( width )
+											 , m_height( height )
+											 , m_fifo_lines( fifo_lines )
+											 , m_link_mhz( link_mhz )
+											 , m_mhz( 0.0 )
+											 , m_num_frames( 0 )
+											 , m_column( height )
+	{
+		Vt_precondition( width > 0 && width <= CVthdsLineParser::FRAME_LINE_INFO_MASK && height > 1
+									 , "CVthdsEmulatedSensor - invalid frame size" );
+	}
+
+	/**
+	\brief Emulate a link with the given rate and FIFO depth.
+
+	\param link_mhz		the fastest readout the link carries in full, 0 for no limit
+	\param fifo_lines	the lines the sensor's FIFO holds while the host catches up
+	*/
+	void set_link(const vt_double link_mhz, const vt_ulong fifo_lines)
+	{
+		Vt_precondition( link_mhz >= 0.0 && fifo_lines > 0, "CVthdsEmulatedSensor::set_link - invalid link" );
+
+		m_link_mhz	 = link_mhz;
+		m_fifo_lines = fifo_lines;
+		m_num_frames = 0;		// the lines dropped depend on the link
+	}
+
+	virtual vt_double link_mhz() const
+	{
+		return m_link_mhz;
+	}
+
+	virtual vt_ulong fifo_lines() const
+	{
+		return m_fifo_lines;
+	}
+
+	virtual vt_bool set_readout(const std::string &command)
+	{
+		for (vt_ulong idx = 0; idx < gNumHdsReadouts; idx++)
+		{
+			if (command == gHdsReadouts[idx].command)
+			{
+				m_mhz = gHdsReadouts[idx].mhz;
+				m_num_frames = 0;		// remade for the new frequency
+				return true;
+			}
+		}
+		return false;
+	}
+
+	virtual void prepare(const vt_ulong num_frames)
+	{
+		Vt_precondition( m_mhz > 0.0, "CVthdsEmulatedSensor::prepare - no readout frequency selected" );
+
+		if (m_num_frames != num_frames)
+			make_stream( num_frames );
+	}
+
+	virtual vt_ulong stream(const vt_ulong num_frames)
+	{
+		prepare( num_frames );
+
+		// the stream is parsed where it lies, the parser goes back to the driver's buffers after
+		const CVtUSBPipeData::BUFFERS driver_buffers = m_parser.pipe_buffers();
+
+		m_parser.reset_view( &m_stream[0], m_stream.size() );
+
+		clock_t start = clock();
+
+		vt_ulong lines = 0;
+		try
+		{
+			m_parser.sync_data( 0 );
+
+			while (m_parser.get_line())
+			{
+				m_parser.save_column( &m_column[0] );
+				lines++;
+			}
+		}
+		catch(...)
+		{
+			m_parser.end_view( driver_buffers );
+			throw;
+		}
+		m_parser.end_view( driver_buffers );
+
+		const vt_double parse_time = ((vt_double) (clock() - start))/CLOCKS_PER_SEC;
+
+		// the time the sensor takes to read the frames out, and the slack its FIFO gives the host
+		const vt_double words			= (vt_double) num_frames*m_width*(m_height + 2);
+		const vt_double readout_time = words/(m_mhz*1.0e6);
+		const vt_double slack			= (vt_double) m_fifo_lines*(m_height + 2)/(m_mhz*1.0e6);
+
+		vt_ulong frames = lines/m_width;
+		if (parse_time > readout_time + slack)
+			frames = (vt_ulong) (frames*(readout_time + slack)/parse_time);
+
+		return frames;
+	}
+};
+
+/**
+	\brief Find the highest readout frequency streamed without loss.
+
+	A frequency is sustained if every frame arrives, with no line broken or out of sequence.
+	The frequencies are tried slowest first and the probe stops at the first one which is not
+	sustained.
+*/
+class CVthdsReadoutProbe
+{
+public:
+	/**
+	\brief What was seen at one frequency.
+	*/
+	struct RESULT
+	{
+		std::string command;
+		vt_double		mhz;
+		vt_ulong		frames;		//!< whole frames received
+		vt_ulong		errors;		//!< lines of the wrong length
+		vt_ulong		gaps;			//!< breaks in the line numbering
+		vt_double		rate;			//!< pixels received a second
+		vt_bool			sustained;
+	};
+
+	std::vector<RESULT> m_results;		//!< the frequencies tried by the last run()
+
+private:
+	CVthdsLineParser &m_parser;
+	vt_ulong					m_width;
+	vt_ulong					m_height;
+	vt_ulong					m_num_frames;
+
+public:
+	/**
+	\param parser			the parser the link delivers through
+	\param width			lines per frame
+	\param height			values per line
+	\param num_frames	frames streamed at each frequency
+	*/
+	CVthdsReadoutProbe(CVthdsLineParser &parser
+									 , const vt_ulong width
+									 , const vt_ulong height
+									 , const vt_ulong num_frames = 8
+									 ) : m_parser( parser )
+										 , m_width( width )
+										 , m_height( height )
+										 , m_num_frames( num_frames )
+	{}
+
+	/**
+	\brief Try each frequency in turn.
+
+	\return the index in gHdsReadouts of the highest frequency sustained, -1 if none was
+	*/
+	vt_long run(CVthdsSensorLink &link)
+	{
+		m_results.clear();
+
+		vt_long best = -1;
+		for (vt_ulong idx = 0; idx < gNumHdsReadouts; idx++)
+		{
+			RESULT res;
+
+			res.command = gHdsReadouts[idx].command;
+			res.mhz			= gHdsReadouts[idx].mhz;
+
+			if (!link.set_readout( res.command ))
+				break;
+
+			link.prepare( m_num_frames );
+			m_parser.reset_counts();
+
+			clock_t start = clock();
+			res.frames = link.stream( m_num_frames );
+			const vt_double seconds = ((vt_double) (clock() - start))/CLOCKS_PER_SEC;
+
+			res.errors		= m_parser.m_errCount;
+			res.gaps			= m_parser.m_gapCount;
+			res.rate			= (seconds > 0.0) ? (vt_double) res.frames*m_width*m_height/seconds : 0.0;
+			res.sustained = res.frames == m_num_frames && res.errors == 0 && res.gaps == 0;
+
+			m_results.push_back( res );
+
+			if (!res.sustained)
+				break;
+
+			best = (vt_long) idx;
+		}
+
+		return best;
+	}
+
+	/**
+	\brief Print the results of the last run().
+	*/
+	void print() const
+	{
+		for (vt_ulong idx = 0; idx < m_results.size(); idx++)
+		{
+			const RESULT &res = m_results[idx];
+
+			printf( "%.1fMHz : %lu/%lu frames %lu short %lu gaps %.1f Mpixel/s %s\n"
+						, res.mhz, res.frames, m_num_frames, res.errors, res.gaps, res.rate*1.0e-6
+						, res.sustained ? "OK" : "LOST" );
+		}
+	}
+};
+
+} // Vt namespace
+
+#endif // __CVTHDSREADOUTPROBE_H__
@@ -1,1184 +1,1562 @@
-/** \file VtpcImpAPI.h
-
-The main implementaion file for pano ceph API interface.
-*
-* Copyright (c) 2013 by
-* All Rights Reserved
-*
-* REVISIONS: 
-* $Log:$
-*
-*/
-
-#ifndef __CVTPCIMPAPI_H__
-#define __CVTPCIMPAPI_H__
-
-
-#include "../../IUSBI2/Command.h"
-
-
-namespace Vt 
-{
-/**
- $Author: david $
- $Revision: 1.3 $
- $Date: 2013/05/27 17:41:57 $
-
-	\class CVtpcImpAPI
- 
-	This class provide the implementation details for the pano ceph API interface.
-
-*/
-class CVtSys;
-
-class CVtpcImpAPI : public CVtAPI // implementation
-{
-	friend class CVtSys;					 					 // let the system access private stuff
-
-	typedef enum
-	{
-		TRANSFER_TIMEOUT = INFINITE
-	} TIMEOUT;
-
-public:
-	typedef CVtpcLineParser::DATASET_ENTRY_TYPE DATASET_ENTRY_TYPE;
-	typedef CVtpcLineParser::DATASET_ENTRY			DATASET_ENTRY;
-	typedef CVtpcLineParser::DATASET						DATASET;
-		
-	//! The dataset is defined and owned by the parser, however a copy is kept here for convenience.
-
-	CVtDataset<DATASET_ENTRY_TYPE>	&m_dataset;
-	CVtUsbDriver										&m_driver;
-
-	//! The pano ceph flat field correction calibration object
-	CVtLineCalib<vt_acq_im_type, vt_double>	m_calib;
-
-	/**
-	 For the out width is the the number of colunns of the final out image. This value depends on the API type.
-	 The value is defined in the Vt::CVtpcAPI header file VtpcAPI.h
-	*/
-	vt_ulong												m_out_width;
-	//! The height of an individual sensor, this value will depend on the binning mode selected,
-	vt_ulong												m_chip_height;
-
-	//! If we decide the save the contents of a dataset to disk as raw data files then this
-	std::string											m_fname_base;
-
-	/**
-	\brief The main constructor for this pc API object.
-
-	\par
-	This is the version of the constructor called by the single instance system class. 
-	This construtor merely sets up the reference to the main system driver object and the dataset object.
-	It uses the reference to the driver object to control the hardware. The data acquired through the
-	driver object can then be accessed via the dataset object. 
-
-	This constructor also setup any interface parameters which depend on the api or binmode.
-
-	\note
-	The main api implementation classes don't need actual access to the pipedata object where the raw data is acquire. Hence
-	The driver will capture the data and place it into the pipe data the parser will turn this into intelligible data and the 
-	driver will then add it to the dataset object.
-
-	\param api the type of api to be instantiated, must be PANO_API or CEPH_API
-	\param bin_mode the binning mode, this must be 1x1 1x2 2x1 2x2
-	\param driver		a reference to the single system driver object, own and held by the singleton system object
-	\param dataset	a reference to the dataset object owned by the parser. The parser knows about the kind of data that held
-	should be held by the dataset. Hence this object owns and holds the current dataset object. However, the
-	driver, and main api objects know when data has been acqiured or manipulated. Hence they should be responsible for
-	adding data to this object. Keeping this separation allows the driver object to behave generically with regard to the
-	data. Hence obviating the need for multiple hds and pc specific driver classes.
-	
-	*/
-	CVtpcImpAPI(const API_TYPE api
-							, const BIN_MODE bin_mode
-							, CVtUsbDriver									 &driver
-							, CVtDataset<DATASET_ENTRY_TYPE> &dataset
-							) : CVtAPI( api, bin_mode )
-						, m_driver( driver )
-						, m_dataset( dataset )
-						, m_fname_base( DEFAULT_BASE_FNAME )
-						, m_out_width( PANO_DEFAULT_OUT_IMAGE_WIDTH_BINx2 )
-						, m_chip_height( DEFAULT_IMAGE_HEIGHT )
-						, m_calib( m_chip_height, m_numChips, true, api ) // default height number of chips and binning mode
-	{
-		set_binmode_params(); // parameters which depend on binning mode
-		set_api_params();			// parameters which depend on api
-	}
-
-
-
-  /**
-  \brief Virtual place holder to enable correct destructor called
-
-	Currently doesn't have anything to do.
-  */
-  virtual ~CVtpcImpAPI()
-  {
-	}
-
-  /**
-  \brief This is the main api initialisation function. 
-	
-	This function must always be called prior to using any of the api function. Currently, this function is exposed 
-	to allow for the future inclusion of parameters to the initialisation sequence. If no parameters are required, 
-	it might be sensible to call this function from the object creation code.
-
-	This function currently has the following algorithmic structure
-			-# delete any data which could be around from a previous instantiation.
-			-# read in dark and bright frames. Currently, the calibration process uses a dark image and a bright image. For
-			debugging purposes the code allows these images to be read in from existing files. Hence, the code looks for two
-			files of the correct name in the correct directory. The filename and directory names are defined in the header file
-			VtpcAPI.h, using the constants DEFAULT_DARK_FNAME and DEFAULT_BRIGHT_FNAME. If these files are present the data is read
-			in and the calibration coefficients are automatically recalculated and saved to the default calibration filename.
-			-# read in calibration files. If the dark and bright frames are not present the calibration coefficients are read in
-			from a file.
-  */
-  virtual vt_bool init()
-  {
-		static vt_bool initialised = false;
-
-		delete_dataset(); // get rid of previous images
-
-		if (initialised) // only initialise a system once
-			return true;
-
-		initialised = true;
-
-		///
-		// read in calibration stuff
-		//
-		try {
-			///
-			// read in dark and bright frames and use these as the basis of the calibration
-			// if they are available
-			//
-			if (read_darkbright())
-			{
-				if (!m_quiet)
-					printf( "Recalculating coefficients....\n" );
-
-				m_calib.recalc();
-
-				if (!m_quiet)
-					printf( "Saving coefficients...\n" );
-
-				m_calib.save( get_calib_fname() );
-			}
-			else
-			{
-				std::ifstream CalDataStream( get_calib_fname(), std::ios_base::binary );
-				if (!m_quiet)
-				{
-					if (m_apiType == PANO_API)
-						printf( "Read pano calibration data....\n" );
-					else
-						printf( "Read ceph calibration data....\n" );
-				}
-
-				CalDataStream >> m_calib; // read in calibration data
-				
-				// Close the new file stream
-				CalDataStream.close();
-			}
-		}
-		catch (std::exception &)
-		{
-			// could trap this here if reqd
-			Vt_fail( "no calibration file available. A calibration run must be performed to obtain calibrated images" );
-		}
-
-		// initialise main listening pipe
-		if (!m_quiet)
-			printf( "Initialising pipe data....\n" );
-
-		return true;
-	}
-
-	//! Merely an access function for the current firmware filename.
-	virtual char * get_fwfname()
-	{
-		return DEFAULT_HEX_FW_FNAME;
-	}
-
-	//
-	// general control port access functions
-	//
-	virtual vt_byte ctrl_port() 
-	{
-		Vt_precondition( m_driver.driver_handle() != NULL, "Device not initialised can't query ready status\n" );
-
-		return m_driver.ctrl_port();
-	}
-
-	virtual vt_ulong half() 
-	{
-		return m_driver.half();
-	}
-
-	///
-	// The amount of data to skip at the beginning of acquiring each image. On the current 
-	// TDI mode ccd sensor the initial frames are saturated and hence should be discarded.
-	//
-	virtual vt_ulong get_header_size()
-	{
-		return DEFAULT_HDR_SIZE;
-	}
-	///
-	// note: currently start is active low on the a paritcular pin of the usb
-	// Hence the following code merely polls the pin looking for the active low state.
-	//
-	virtual CVtAPI::START_SIG  wait_for_start(const vt_double wait_time, const vt_double min_wait_time ) // in milliseconds
-	{
-		Vt_precondition( m_driver.driver_handle() != NULL, "Device not initialised can't query ready status\n" );
-
-		clock_t start = clock();
-
-		double time_taken = 0.0;
-		while( m_driver.pc_start() )
-		{
-			clock_t end = clock();
-			time_taken = ((double)(end - start))/CLOCKS_PER_SEC;
-
-			if (time_taken > wait_time)
-				return CVtAPI::START_SIG_TIMEOUT;
-		}
-	
-		// time taken must be more than min
-		if (time_taken < min_wait_time)
-			return CVtAPI::START_SIG_TOOQUICK;
-
-		if (!m_quiet)
-			BUGOUT( stderr, "Control port is %x\n", ctrl_port() );
-
-		return CVtAPI::START_SIG_RECEIVED;
-	}
-		
-
-	virtual CVtAPI::START_SIG  wait_for_start() // in milliseconds
-	{
-		// default wait a long time, in this case a long time is 
-		// about 16-17 mins.
-		//
-		return wait_for_start(1000000.0, 0.0); 
-	}
-
-	///
-	// Inverse of above
-	//
-	virtual vt_bool  wait_for_not_start(const vt_double wait_time)
-	{
-		Vt_precondition( m_driver.driver_handle() != NULL, "Device not initialised can't query ready status\n" );
-		clock_t start = clock();
-
-		while( ! m_driver.pc_start() )
-		{
-			clock_t end = clock();
-			double time_taken = ((double)(end - start))/CLOCKS_PER_SEC;
-
-			if (time_taken > wait_time)
-				return false;
-
-			if (!m_quiet)
-				rotator();
-		}
-		if (!m_quiet)
-			printf( "OK\n" );
-
-		return true;
-	}
-	virtual vt_bool  wait_for_not_start()
-	{
-		return wait_for_not_start( 40000 );
-	}
-
-
-	//----------------------------------------------------------
-	// Main PanoCapture Interface routines Start
-	//-----------------------------------------------------------
-	///
-	// main run thread
-	//
-	virtual void run()
-	{
-		Vt_precondition( m_driver.driver_handle() != NULL, "Device not initialised can't query ready status\n" );
-	
-		m_driver.read_pipe();
-
-		// reset the device - we don't actually want to reset the device now
-		// vt_byte status[16];
-		// send_command( status, m_driver.driver_handle(), VR_IUSBI_NOT_ACK, DEFAULT_SUB );
-		if (!m_quiet)
-			printf( "Control Port is %x\n",ctrl_port() );
-	}
-
-	template<typename T> 
-	CVtImage<T>* transpose_lineim( CVtImage<T>& lineim )
-	{
-		//
-		// transpose data
-		//
-		vt_long width = lineim.height(); // the output width is the input height
-		CVtImage<vt_acq_im_type> *pim = new CVtImage<vt_acq_im_type> (width, m_chip_height*m_numChips);
-		CVtImage<vt_acq_im_type> &im  = *pim;
-		
-		for( vt_ulong lineno = 0; lineno < width; lineno++)
-		{
-			vt_acq_im_type  *inptr  = lineim[lineno];
-
-			vt_ulong row = 0;
-			// tile a
-			for(row = 0; row < m_chip_height; row++)
-			{
-				im[row][lineno] = *inptr++;
-			}
-			// tile b
-			for(row = m_chip_height; row < 2*m_chip_height; row++)
-			{
-				im[row][lineno] = *inptr++;
-			}
-			// tile c
-			if (m_invertC)
-			{
-				inptr += m_chip_height-1;
-				for(row = 2*m_chip_height; row < 3*m_chip_height; row++)
-				{
-					im[row][lineno] = *inptr--;
-				}
-			}
-			else
-			{
-				for(row = 2*m_chip_height; row < 3*m_chip_height; row++)
-				{
-					im[row][lineno] = *inptr++;
-				}
-			}
-		}
-		return pim;
-	}
-	///
-	// main capture thread
-	//
-	// currently merely an alias for run
-	//
-	virtual void capture()
-	{
-		run();
-		Vt_postcondition( _CrtCheckMemory() == TRUE, "Capture:::Memory problem detected\n" );
-	}
-
-	///
-	// simulate capture based on file image rather than grabbed from system.
-	//
-	virtual void capture(std::string& fname)
-	{
-		vt_ulong width;
-		if (get_filesize(fname.c_str(), sizeof( vt_acq_im_type), width) == true)
-		{
-			std::ifstream cfile( fname.c_str(), std::ios::binary | std::ios::in );
-
-			// opened file
-			if (cfile.is_open())
-			{
-				if (!m_quiet)
-					std::cout << "opened input file" << std::endl;
-
-				///
-				// estimate image size
-				//
-				CVtImage<vt_acq_im_type> *plineim = new CVtImage<vt_acq_im_type> (m_chip_height*m_numChips, width );
-				CVtImage<vt_acq_im_type> &lineim  = *plineim;
-				if (!m_quiet)
-					std::cout << "reading input file...." << std::endl;
-
-
-				// read in data 
-				cfile.read( (char *) lineim.begin(), sizeof( vt_acq_im_type )*width*m_chip_height*m_numChips );
-
-				if (!m_quiet)
-					std::cout << "transposing data...." << std::endl;
-
-				// transpose readin data
-				CVtImage<vt_acq_im_type> *im = transpose_lineim( lineim );
-				
-				delete plineim;
-				//
-				DATASET_ENTRY_TYPE ent_type;
-				ent_type.type			= ACQ_IM;
-				ent_type.half_idx = m_out_width/2;  // !!!!! cheat value
-
-				add_dataset( ent_type, im );
-			}
-			else
-			{
-				Vt_fail( "failed to open input image"  );
-			}
-		}
-	}
-
-
-	///
-	// PROCESSING ROUTINES
-	//
-	// This is were the main data processing routines go. 
-	// Currently this is merely reconstruction and calibration
-	//
-	//
-	virtual void calibrate()
-	{
-		///
-		// for each data set current stored
-		//
-		DATASET::iterator end = m_dataset.end(); // save current end - this allows us to add more
-																							// entries in loop
-		for(DATASET::iterator it = m_dataset.begin(); it != end; it++)
-		{
-			if ( (*it).first.type == CENTRE_IM )
-			{
-				CVtImage<vt_centre_im_type>* im = dynamic_cast<CVtImage<vt_centre_im_type>*>((*it).second);
-
-				// OK apply calibration to each line
-				CVtImage<vt_out_im_type>* cal_im = new CVtImage<vt_out_im_type>(im->width(), im->height());
-				//
-				// do calibration
-				//
-				if (m_darkFrameCal)
-					m_calib( *im, *cal_im, (*it).first.half_idx, true );
-				else
-					m_calib( *im, *cal_im, (*it).first.half_idx );
-		
-				DATASET_ENTRY_TYPE ent_type( (*it).first );
-				ent_type.type = OUTPUT_IM;
-
-				add_dataset( ent_type, cal_im );
-			}
-		}
-
-		Vt_postcondition( _CrtCheckMemory() == TRUE, "Calibrate::Memory problem detected\n" );
-	}
-
-
-	///
-	// centres specific image types - let templates do the work
-	// of generating the code for the different versions.
-	//
-	template<typename T>
-	centre(const CVtImage<T>& im, const vt_ulong half_idx)
-	{
-		///
-		// allocate output image
-		//
-		CVtImage<vt_out_im_type> *outimp = new CVtImage<vt_out_im_type>(m_out_width, im.height());
-		CVtImage<vt_out_im_type>& outim  = *outimp;
-
-		///
-		// half index is relative to acquired image, the output image will be narrower than this
-		// hence we wish to come back from the centre line by half the output image width.
-		//
-		vt_long start_idx = (vt_long)half_idx-(vt_long)m_out_width/2;
-
-		if (start_idx < 0 )
-		{
-			start_idx = 0;
-		}
-
-		///
-		// centred update the dataset
-		//
-		for( vt_ulong row = 0; row< im.height(); row++ )
-		{
-			const vt_calib_im_type *vec  = im[row];
-			vt_out_im_type *outvec = outim[row];
-
-			for( vt_ulong col = 0; col < m_out_width; col++)
-			{
-				if (col+start_idx >= im.width()) // note im.width is note necessarily m_out_width - it will
-																				 // probably be larger depending on the number of packets that 
-																				 // we have chosen to collect.
-					break;
-				
-				outvec[col] = vec[col+start_idx];
-			}
-		}
-
-		// OK complete - add dataset
-		DATASET_ENTRY_TYPE ent_type;
-		ent_type.type			= CENTRE_IM;
-		ent_type.half_idx = half_idx;
-
-		add_dataset( ent_type, outimp );
-	}
-
-
-	///
-	// Centre the image
-	// Centre takes an image type. However, currently
-	// it only centres calib_ims and recon_ims
-	//
-	virtual void centre(IM_TYPE im_type)
-	{
-		///
-		// for each calibrated image - produce a centred image
-		//
-		DATASET::iterator end = m_dataset.end(); // save current end - this allows us to add more
-																							// entries in loop
-		for(DATASET::iterator it = m_dataset.begin(); it != end; it++)
-		{
-			if ((*it).first.type == im_type)
-			{
-				switch(im_type)
-				{
-				case ACQ_IM:
-					centre(*dynamic_cast<CVtImage<vt_acq_im_type>*>((*it).second), (*it).first.half_idx );
-					break;
-
-				case CALIB_IM:
-					centre(*dynamic_cast<CVtImage<vt_calib_im_type>*>((*it).second), (*it).first.half_idx );
-					break;
-				default:
-					Vt_fail( "Invalid image type for centring" );
-					break;
-				}
-			}
-		}
-		Vt_postcondition( _CrtCheckMemory() == TRUE, "Centre::Memory problem detected\n" );
-	}
-
-	//
-	// generic process function this contains all the default
-	// processing applied to a particular image
-	//
-	// currently not doing reconstruction process. The processing merely consists
-	// of calibration and data access,
-	//
-	virtual void process()
-	{
-		calibrate();
-	}
-
-	virtual void process(IM_TYPE imtype)
-	{
-		if (!m_quiet)
-			std::cout << "OK" << std::endl;
-		
-		centre(imtype); // centring before calib
-
-		if (!m_quiet)
-			std::cout << "Calibrating data set..." << std::endl;
-		
-		calibrate();
-	}
-
-	///
-	// calibrate
-	//
-	virtual void calibration_run()
-	{
-		////
-		// dark frames
-		//
-		printf( "\nCAPTURE DARK FRAMES :: Press return when ready - will wait for start\n\n" );
-		getchar();
-
-		wait_for_start();
-		printf( "START...\n" );
-		capture();
-		DATASET_ENTRY dark_entry = pop_back( ACQ_IM );
-
-		CVtImage<vt_acq_im_type>* dark_ptr = dynamic_cast<CVtImage<vt_acq_im_type>*>( dark_entry.second );
-		Vt_postcondition( dark_ptr != NULL, "failed to obtain a valid imahe in calibration calculation routine" );
-		m_calib.set_dark( *dark_ptr );
-
-		////
-		// bright frames
-		//
-		printf( "Waiting for stable position\n" );
-		wait_for_not_start();
-		printf( "CAPTURE BRIGHT FRAMES:: Press return when ready - will wait for start\n\n" );
-		getchar();
-		
-		wait_for_start();
-		printf( "START...\n" );
-		capture();
-
-		DATASET_ENTRY bright_entry  = pop_back( ACQ_IM );
-		CVtImage<vt_acq_im_type> *bright_ptr = dynamic_cast<CVtImage<vt_acq_im_type>*>( bright_entry.second );
-
-		printf( "Calculating the appropriate regions of the bright image to use....\n" );
-
-		m_calib.set_bright( *bright_ptr, bright_entry.first.half_idx );
-
-		printf( "OK\n" );
-		///
-		// calculation
-		//
-		printf( "Recalculating coefficients...\n" );
-
-		m_calib.recalc();
-
-		////
-		// save
-		//
-		printf( "Saving coefficients...\n" );
-
-		m_calib.save( get_calib_fname() );
-
-		printf( "New coefficients writen to file %s\n" , get_calib_fname() );
-
-		save(); // save source images
-	}
-
-  ///
-  // Close the system safely
-  //
-  virtual vt_bool close_system()
-  {
-    return true;
-  }
-private:
-	///
-	// send a command to the device
-	//
-	void send_command(vt_byte status[16]
-									 , vt_byte CommandCode
-									 , vt_uint16 SubCommandCode )
-	{
-		m_driver.send_command(status, CommandCode, SubCommandCode );
-	}
-
-	////
-	// Send reset command
-	//
-	// Note - send command throws and exception if it doesn't receive expected 
-	// return from transmitting data.
-	//
-	void Reset(const HANDLE hDevice)
-	{
-			vt_byte status[16];
-			send_command( status, VR_IUSBI_RESET, DEFAULT_SUB );
-	}
-
-	////
-	// Send ready command
-	//
-	void Ready(const HANDLE hDevice)
-	{
-			vt_byte status[16];
-			send_command( status, VR_IUSBI_READY, DEFAULT_SUB );
-	}
-
-	////
-	// Send not ready command
-	//
-	void NotReady(const HANDLE hDevice)
-	{
-			vt_byte status[16];
-			send_command( status, VR_IUSBI_NOT_READY, DEFAULT_SUB );
-	}
-
-	//----------------------------------------------------------
-	// Main PanoCapture Interface routines Start
-	//-----------------------------------------------------------
-	//
-	// bin mode effectively set the height and width of the image
-	//
-	virtual vt_ulong get_num_pkts()
-	{
-		set_num_pkts(); // ensure that the number of packets is set to the default for the acqusition mode
-		return m_numPkts;
-	}
-
-	virtual void set_calib_fname()
-	{
-		m_calibFname = (m_apiType == PANO_API) ? DEFAULT_PANO_CALIB_FNAME : DEFAULT_CEPH_CALIB_FNAME;
-	}
-
-	virtual char* get_calib_fname()
-	{
-		set_calib_fname(); //  make sure name is set to default for acquisition mode
-		return m_calibFname;
-	}
-
-	// interface type accessor
-	virtual API_TYPE get_api_type()
-	{
-		return m_apiType;
-	}
-
-
-	///
-	// what does the hardware think that the device is?
-	//
-	virtual API_TYPE  hw_device_type() 
-	{
-		Vt_precondition( m_driver.driver_handle() != NULL, "Device not initialised can't query ready status\n" );
-
-		return m_driver.hw_device_type();
-	}
-
-	///
-	// private funcs - not exposed through API but useable
-	//
-	virtual void set_num_pkts(vt_ulong num_pkts) // explicitly set num pkts
-	{
-		m_numPkt_override = true;
-		m_numPkts = num_pkts;
-	}
-	virtual void set_num_pkts(vt_bool dummy) // turn off override and set default num pkts
-	{
-		m_numPkt_override = false;
-		set_num_pkts();
-	}
-	virtual void set_num_pkts() // set default num pkts
-	{
-		if (m_numPkt_override)
-			return;
-
-		if (m_calibFlag)
-		{
-			m_numPkts = (m_apiType == PANO_API) ? PANO_CALIB_NUM_PKTS : CEPH_CALIB_NUM_PKTS;
-		}
-		else
-		{
-			m_numPkts = (m_apiType == PANO_API) ? PANO_NUM_PKTS : CEPH_NUM_PKTS;
-		}
-		// are we horizontal binning
-		if ( (m_bin_mode == BIN1x1) || (m_bin_mode == BIN2x1) )
-		{
-			// not hbinning
-			m_numPkts *= 2;
-		}
-		// else do nothing for binned case
-
-	}
-
-protected:
-	///
-	// setup all the params which depend on the current binning mode
-	//
-	virtual vt_bool set_binmode_params(const vt_ulong vert, const vt_ulong horiz)
-	{
-		if (vert == 1)
-		{	
-			m_chip_height = 2*DEFAULT_CHIP_HEIGHT_BIN2x;
-		}	
-		else
-		{	
-			m_chip_height = DEFAULT_CHIP_HEIGHT_BIN2x;
-		}	
-		m_image_height = m_numChips*m_chip_height;
-
-		if (m_apiType == PANO_API)
-		{
-			if (horiz == 1)
-			{	
-				m_out_width = 2*PANO_DEFAULT_OUT_IMAGE_WIDTH_BINx2;
-
-				///
-				// we are not binning in the horizontal direction - tell the calibration
-				// it needs to know this so that it can work out were to take the bright 
-				// regions from
-				//
-				m_calib.set_hbin( false, m_apiType );
-			}	
-			else
-			{	
-				m_out_width = PANO_DEFAULT_OUT_IMAGE_WIDTH_BINx2;
-				///
-				// we are binning in the horizontal direction - tell the calibration
-				// it needs to know this so that it can work out were to take the bright 
-				// regions from
-				//
-				m_calib.set_hbin( true, m_apiType );
-			}	
-		}
-		else
-		{
-			// ceph mode
-			if (horiz == 1)
-			{	
-				//  not binned
-				m_out_width = 2*CEPH_DEFAULT_OUT_IMAGE_WIDTH_BINx2;
-
-				///
-				// we are not binning in the horizontal direction - tell the calibration
-				// it needs to know this so that it can work out were to take the bright 
-				// regions from
-				//
-				m_calib.set_hbin( false, m_apiType );
-			}	
-			else
-			{	
-				m_out_width = CEPH_DEFAULT_OUT_IMAGE_WIDTH_BINx2;
-				///
-				// we are binning in the horizontal direction - tell the calibration
-				// it needs to know this so that it can work out were to take the bright 
-				// regions from
-				//
-				m_calib.set_hbin( true, m_apiType );
-			}	
-		}
-
-		return true;
-	}
-
-	virtual vt_bool set_binmode_params()
-	{
-		switch(m_bin_mode)
-		{
-		case BIN2x2:
-			return set_binmode_params(2,2);
-
-		case BIN2x1:
-			return set_binmode_params(2,1);
-
-		case BIN1x2:
-			return set_binmode_params(1,2);
-
-		case BIN1x1:
-			return set_binmode_params(1,1);
-		}
-		return true;
-	}
-
-	///
-	// set the api to have required characteristics
-	// for the current binning mode and api type
-	//
-	virtual void set_api_params()
-	{
-		set_num_pkts();
-		set_calib_fname();
-	}
-
-	/************************************
-		 DATASET Manipulation
-	************************************/
-	///
-	// IMAGE PROPERTY
-	//
-	///
-	// Default image width is out image width
-	//
-	virtual vt_ulong image_width()
-	{
-		return m_out_width;
-	}
-	/// 
-	// image information access functions
-	//
-	virtual vt_ulong image_width(IM_TYPE im_type)
-	{
-		return m_dataset.image_width(im_type);
-	}
-
-	///
-	// get image height - returns image height
-	// currently all the images are the same height
-	//
-	virtual vt_ulong image_height() 
-	{
-		return m_image_height;
-	}
-	virtual vt_ulong image_height(IM_TYPE) // arg not used
-	{
-		return m_image_height;
-	}
-
-
-	virtual vt_bool delete_dataset()
-	{
-		return m_dataset.delete_dataset();
-	}
-
-	virtual vt_bool delete_image(IM_TYPE im_type)
-	{
-		return m_dataset.delete_image(im_type);
-	}
-
-	///
-	// image data accessors
-	//
-	virtual vt_ushort * image_ptr()
-	{
-		return m_dataset.image_ptr();
-	}
-
-	virtual vt_ushort * image_ptr(IM_TYPE im_type)
-	{
-		return m_dataset.image_ptr(im_type);
-	}
-
-	virtual vt_ushort ** image_ptrs(IM_TYPE im_type)
-	{
-		return m_dataset.image_ptrs(im_type);
-	}
-
-
-	///
-	// dataset manipulation
-	//
-	// Datasets can be any 2d set of data. If we are in non-sync
-	// mode then Dataset 0 is usually the raw input data buffers.
-	//
-	virtual void add_dataset( DATASET_ENTRY_TYPE ent_type, CVtImageBaseClass *pdata )
-	{
-		m_dataset.add_dataset( ent_type, pdata );
-	}
-
-	virtual DATASET_ENTRY pop_back( const IM_TYPE im_type )
-	{
-		return m_dataset.pop_back( im_type );
-	}
-
-	virtual DATASET_ENTRY get_back( const IM_TYPE im_type )
-	{
-		return m_dataset.get_back( im_type );
-	}
-
-	///
-	// save
-	//
-	// This merely saves the data captured and processed above.
-	//
-	template<typename T>
-	void save_imfile(T **pdata, vt_ulong pixel_size, vt_ulong width, vt_ulong height, std::string &fname, vt_bool row_wise )
-	{
-		FILE *fpout = fopen( fname.c_str(), "wb" );
-
-		if (fpout != NULL)
-		{
-			if (row_wise)
-			{
-				///
-				// store data row wise
-				// Note the following assumes that the data is stores as one contigous buffer
-				// with a row pointer vector allocated and pointing into this buffer. See the definition
-				// of VtImage .
-				//
-				fwrite( (const char *) pdata[0], pixel_size, height*width, fpout );
-			}
-			else
-			{
-				// store column wise
-				T *colbuf = new T[height];
-
-				for( vt_ulong col=0; col < width; col++)
-				{
-					for( vt_ulong row=0; row < height; row++)
-					{
-						colbuf[row] = pdata[row][col];
-					}
-
-					fwrite( (const char *) colbuf, pixel_size, height, fpout );
-				}
-
-				delete colbuf;
-			}
-		}
-		else
-		{
-			Vt_fail( "Failed to open output file\n" );
-		}
-
-		fclose(fpout);
-	}
-
-	virtual void save()
-	{
-		std::string fname_base( HDS_DEFAULT_BASE_DIR );
-
-		vt_ulong fname_cnt = 1;
-
-		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
-		{
-			vt_ulong pixel_size = 0;
-
-			switch((*it).first.type)
-			{
-				case ACQ_IM:
-				{
-					std::cout << "Saving acquired image" << std::endl;
-					CVtImage<vt_acq_im_type> *im = dynamic_cast<CVtImage<vt_acq_im_type>*>((*it).second);
-					if (im == NULL)
-					{
-						Vt_fail( "Unexpected image type" );
-					}
-					save_imfile( im->lines()
-									, sizeof( vt_acq_im_type)
-									, im->width()
-									, im->height()
-									, Fname(fname_base, fname_cnt)
-									, false ); 	
-				}
-				break;
-				case CENTRE_IM:
-				{
-					std::cout << "Saving centred image" << std::endl;
-					CVtImage<vt_centre_im_type>* im = dynamic_cast<CVtImage<vt_centre_im_type>*>((*it).second);
-					if (im == NULL)
-					{
-						Vt_fail( "Unexpected image type" );
-					}
-					save_imfile( im->lines()
-									, sizeof( vt_centre_im_type)
-									, im->width()
-									, im->height()
-									, Fname(fname_base, fname_cnt)
-									, false ); 	
-					break;
-				}
-				case CALIB_IM:
-				{
-					std::cout << "Saving calibrated image" << std::endl;
-					CVtImage<vt_calib_im_type>* im = dynamic_cast<CVtImage<vt_calib_im_type>*>((*it).second);
-					if (im == NULL)
-					{
-						Vt_fail( "Unexpected image type" );
-					}
-					save_imfile( im->lines()
-									, sizeof( vt_calib_im_type)
-									, im->width()
-									, im->height()
-									, Fname(fname_base, fname_cnt)
-									, false ); 	
-					break;
-				}
-				case RECON_IM:
-				{
-					std::cout << "Saving recon image" << std::endl;
-					CVtImage<vt_recon_im_type>* im = dynamic_cast<CVtImage<vt_recon_im_type>*>((*it).second);
-					if (im == NULL)
-					{
-						Vt_fail( "Unexpected image type" );
-					}
-					save_imfile( im->lines()
-									, sizeof( vt_recon_im_type)
-									, im->width()
-									, im->height()
-									, Fname(fname_base, fname_cnt)
-									, false ); 	
-					break;
-				}
-				case OUTPUT_IM:
-				{
-					std::cout << "Saving output image" << std::endl;
-					CVtImage<vt_out_im_type>* im = dynamic_cast<CVtImage<vt_out_im_type>*>((*it).second);
-					if (im == NULL)
-					{
-						Vt_fail( "Unexpected image type" );
-					}
-					save_imfile( im->lines()
-									, sizeof( vt_out_im_type)
-									, im->width()
-									, im->height()
-									, Fname(fname_base, fname_cnt)
-									, false ); 	
-					break;
-				}
-				default:
-					std::cout << "Invalid image type" << std::endl;
-			}
-		}
-	}
-	///
-	// small utility to return the size of a particular file
-	//
-	vt_bool get_filesize( const std::string &fname, const vt_ulong pixel_size, vt_ulong &width )
-	{
-			vt_ulong fsize = 0;
-			vt_bool  ret_code = false;
-			
-			width = 0;
-			HANDLE handle = ::CreateFile(fname.c_str()
-																	, GENERIC_READ
-																	, FILE_SHARE_READ
-																	, NULL
-																	, OPEN_EXISTING
-																	, 0
-																	, NULL );
-
-			if (handle != INVALID_HANDLE_VALUE)
-			{
-				fsize = ::GetFileSize(handle, NULL);
-				::CloseHandle( handle );
-
-				ret_code = true;
-				width		 = fsize/(m_chip_height*m_numChips*pixel_size);
-			}
-
-			return ret_code;
-	}
-
-	///
-	// read_darkbright()
-	//
-	// read in dark and bright frames and use this as the basis of the calibration
-	//
-	vt_bool read_darkbright()
-	{
-		vt_bool read_dark = false;
-		vt_bool read_bright = false;
-		if (file_exists( DEFAULT_DARK_FNAME ) && file_exists( DEFAULT_DARK_FNAME ) )
-		{
-			///
-			// OK if the bright and dark frames are available open these and recalculate the
-			// coeficients. If these are not available then look for the calibration file
-			// .cal
-			//
-			vt_ulong dark_width = 0;
-			if (get_filesize(DEFAULT_DARK_FNAME, sizeof(vt_acq_im_type), dark_width) == true)
-			{
-				if (!m_quiet)
-					printf( "Dark frame found....\n" );
-
-				std::ifstream darkframe_strm(DEFAULT_DARK_FNAME, std::ios_base::binary );
-				CVtImage<vt_acq_im_type> *pdarkline = new CVtImage<vt_acq_im_type>(m_chip_height*m_numChips, dark_width);
-				CVtImage<vt_acq_im_type> &darkline = *pdarkline;
-				
-				darkframe_strm.read( (char *) darkline.begin(), dark_width*m_chip_height*m_numChips*sizeof(vt_acq_im_type) );
-
-				CVtImage<vt_acq_im_type> *im = transpose_lineim( darkline );
-				
-				delete pdarkline;
-
-				m_calib.set_dark( *im );
-
-				delete im;
-				read_dark = true;
-			}
-
-			vt_ulong bright_width = 0;
-			if (get_filesize(DEFAULT_BRIGHT_FNAME, sizeof( vt_acq_im_type), bright_width) == true)
-			{
-				if (!m_quiet)
-					printf( "Bright frame found....\n" );
-
-				std::ifstream brightframe_strm(DEFAULT_BRIGHT_FNAME, std::ios_base::binary );
-				CVtImage<vt_acq_im_type> *pbrightline = new CVtImage<vt_acq_im_type>(m_chip_height*m_numChips, bright_width);
-				CVtImage<vt_acq_im_type> &brightline = *pbrightline;				
-
-				brightframe_strm.read( (char *) brightline.begin(), bright_width*m_chip_height*m_numChips*sizeof(vt_acq_im_type));
-
-				CVtImage<vt_acq_im_type> *im = transpose_lineim( brightline );
-				
-				delete pbrightline;
-
-				m_calib.set_bright( *im, m_out_width/2 );
-
-				delete im;
-				read_bright = true;
-			}
-		}
-		else
-		{
-			return false;
-		}
-
-		return (read_dark && read_bright);
-	}
-};
-
-} // end Vt namespace
-
-#endif // __CVTPCIMAPI_H__
+/** \file VtpcImpAPI.h
+
+The main implementaion file for pano ceph API interface.
+*
+* Copyright (c) 2013 by
+* All Rights Reserved
+*
+* REVISIONS: 
+* $Log:$
+*
+*/
+
+#ifndef __CVTPCIMPAPI_H__
+#define __CVTPCIMPAPI_H__
+
+
+#include "../../IUSBI2/Command.h"
+
+
+namespace Vt 
+{
+/**
+ $Author: david $
+ $Revision: 1.3 $
+ $Date: 2013/05/27 17:41:57 $
+
+	\class CVtpcImpAPI
+ 
+	This class provide the implementation details for the pano ceph API interface.
+
+*/
+class CVtSys;
+
+class CVtpcImpAPI : public CVtAPI // implementation
+									, public CVtDatasetProducer
+{
+	friend class CVtSys;					 					 // let the system access private stuff
+
+	typedef enum
+	{
+		TRANSFER_TIMEOUT = INFINITE
+	} TIMEOUT;
+
+public:
+	typedef CVtpcLineParser::DATASET_ENTRY_TYPE DATASET_ENTRY_TYPE;
+	typedef CVtpcLineParser::DATASET_ENTRY			DATASET_ENTRY;
+	typedef CVtpcLineParser::DATASET						DATASET;
+		
+	//! The dataset is defined and owned by the parser, however a copy is kept here for convenience.
+
+	CVtDataset<DATASET_ENTRY_TYPE>	&m_dataset;
+	CVtUsbDriver										&m_driver;
+
+	//! The pano ceph flat field correction calibration object
+	CVtLineCalib<vt_acq_im_type, vt_double>	m_calib;
+
+	/**
+	 For the out width is the the number of colunns of the final out image. This value depends on the API type.
+	 The value is defined in the Vt::CVtpcAPI header file VtpcAPI.h
+	*/
+	vt_ulong												m_out_width;
+	//! The height of an individual sensor, this value will depend on the binning mode selected,
+	vt_ulong												m_chip_height;
+
+	//! If we decide the save the contents of a dataset to disk as raw data files then this
+	std::string											m_fname_base;
+
+	//! The image type centred images are made from, set by process()
+	IM_TYPE													m_centre_src;
+	//! process() has been asked for, the output images are made on demand
+	vt_bool													m_process_pending;
+
+	/**
+	\brief The main constructor for this pc API object.
+
+	\par
+	This is the version of the constructor called by the single instance system class. 
+	This construtor merely sets up the reference to the main system driver object and the dataset object.
+	It uses the reference to the driver object to control the hardware. The data acquired through the
+	driver object can then be accessed via the dataset object. 
+
+	This constructor also setup any interface parameters which depend on the api or binmode.
+
+	\note
+	The main api implementation classes don't need actual access to the pipedata object where the raw data is acquire. Hence
+	The driver will capture the data and place it into the pipe data the parser will turn this into intelligible data and the 
+	driver will then add it to the dataset object.
+
+	\param api the type of api to be instantiated, must be PANO_API or CEPH_API
+	\param bin_mode the binning mode, this must be 1x1 1x2 2x1 2x2
+	\param driver		a reference to the single system driver object, own and held by the singleton system object
+	\param dataset	a reference to the dataset object owned by the parser. The parser knows about the kind of data that held
+	should be held by the dataset. Hence this object owns and holds the current dataset object. However, the
+	driver, and main api objects know when data has been acqiured or manipulated. Hence they should be responsible for
+	adding data to this object. Keeping this separation allows the driver object to behave generically with regard to the
+	data. Hence obviating the need for multiple hds and pc specific driver classes.
+	
+	*/
+	CVtpcImpAPI(const API_TYPE api
+							, const BIN_MODE bin_mode
+							, CVtUsbDriver									 &driver
+							, CVtDataset<DATASET_ENTRY_TYPE> &dataset
+							) : CVtAPI( api, bin_mode )
+						, m_driver( driver )
+						, m_dataset( dataset )
+						, m_fname_base( DEFAULT_BASE_FNAME )
+						, m_out_width( PANO_DEFAULT_OUT_IMAGE_WIDTH_BINx2 )
+						, m_chip_height( DEFAULT_IMAGE_HEIGHT )
+						, m_centre_src( ACQ_IM )
+						, m_process_pending( false )
+						, m_calib( DEFAULT_CHIP_HEIGHT_BIN2x, m_numChips, true, api ) // default height number of chips and binning mode
+	{
+		set_binmode_params(); // parameters which depend on binning mode
+		set_api_params();			// parameters which depend on api
+
+		// stage relations, used when the dataset is trimmed to the memory budget
+		m_dataset.set_input( CENTRE_IM, ACQ_IM );
+		m_dataset.set_input( OUTPUT_IM, CENTRE_IM );
+		m_dataset.set_evictable( CENTRE_IM );
+		m_dataset.set_pinned( OUTPUT_IM );
+
+		// centred and output images are made on first access
+		m_dataset.set_producer( CENTRE_IM, this );
+		m_dataset.set_producer( OUTPUT_IM, this );
+	}
+
+
+
+  /**
+  \brief Virtual place holder to enable correct destructor called
+
+	Unregisters this object as the producer of the derived dataset images.
+  */
+  virtual ~CVtpcImpAPI()
+  {
+		m_dataset.set_producer( CENTRE_IM, NULL );
+		m_dataset.set_producer( OUTPUT_IM, NULL );
+	}
+
+  /**
+  \brief This is the main api initialisation function. 
+	
+	This function must always be called prior to using any of the api function. Currently, this function is exposed 
+	to allow for the future inclusion of parameters to the initialisation sequence. If no parameters are required, 
+	it might be sensible to call this function from the object creation code.
+
+	This function currently has the following algorithmic structure
+			-# delete any data which could be around from a previous instantiation.
+			-# read in dark and bright frames. Currently, the calibration process uses a dark image and a bright image. For
+			debugging purposes the code allows these images to be read in from existing files. Hence, the code looks for two
+			files of the correct name in the correct directory. The filename and directory names are defined in the header file
+			VtpcAPI.h, using the constants DEFAULT_DARK_FNAME and DEFAULT_BRIGHT_FNAME. If these files are present the data is read
+			in and the calibration coefficients are automatically recalculated and saved to the default calibration filename.
+			-# read in calibration files. If the dark and bright frames are not present the calibration coefficients are read in
+			from a file.
+
+	The calibration is kept in the calibration bank, see VtCalibBank.h, for every binning mode it covers. The files are
+	only read the first time, an api created later in any of these modes takes its calibration from the bank.
+  */
+  virtual vt_bool init()
+  {
+		delete_dataset(); // get rid of previous images
+
+		if (m_calib.select_from_bank( m_apiType, m_bin_mode )) // only initialise a system once
+		{
+			read_field();
+			return true;
+		}
+
+		///
+		// read in calibration stuff
+		//
+		try {
+			///
+			// read in dark and bright frames and use these as the basis of the calibration
+			// if they are available
+			//
+			if (read_darkbright())
+			{
+				if (!m_quiet)
+					printf( "Recalculating coefficients....\n" );
+
+				m_calib.recalc();
+
+				if (!m_quiet)
+					printf( "Saving coefficients...\n" );
+
+				save_calib();
+
+				calib_bank<vt_double>().clear( m_apiType );
+				store_in_bank( m_bin_mode );
+			}
+			else
+			{
+				std::ifstream CalDataStream( get_calib_fname(), std::ios_base::binary );
+				if (!m_quiet)
+				{
+					if (m_apiType == PANO_API)
+						printf( "Read pano calibration data....\n" );
+					else
+						printf( "Read ceph calibration data....\n" );
+				}
+
+				read_calib( CalDataStream ); // read in calibration data
+				
+				// Close the new file stream
+				CalDataStream.close();
+			}
+		}
+		catch (std::exception &)
+		{
+			// could trap this here if reqd
+			Vt_fail( "no calibration file available. A calibration run must be performed to obtain calibrated images" );
+		}
+
+		if (!m_calib.select_from_bank( m_apiType, m_bin_mode ))
+		{
+			Vt_fail( "no calibration for this binning mode. A calibration run must be performed in this mode, or without vertical binning with deriveBinned set" );
+		}
+		read_field();
+
+		// initialise main listening pipe
+		if (!m_quiet)
+			printf( "Initialising pipe data....\n" );
+
+		return true;
+	}
+
+	//! Merely an access function for the current firmware filename.
+	virtual char * get_fwfname()
+	{
+		return DEFAULT_HEX_FW_FNAME;
+	}
+
+	//
+	// general control port access functions
+	//
+	virtual vt_byte ctrl_port() 
+	{
+		Vt_precondition( m_driver.driver_handle() != NULL, "Device not initialised can't query ready status\n" );
+
+		return m_driver.ctrl_port();
+	}
+
+	virtual vt_ulong half() 
+	{
+		return m_driver.half();
+	}
+
+	///
+	// The amount of data to skip at the beginning of acquiring each image. On the current 
+	// TDI mode ccd sensor the initial frames are saturated and hence should be discarded.
+	//
+	virtual vt_ulong get_header_size()
+	{
+		return DEFAULT_HDR_SIZE;
+	}
+	///
+	// note: currently start is active low on the a paritcular pin of the usb
+	// Hence the following code merely polls the pin looking for the active low state.
+	//
+	virtual CVtAPI::START_SIG  wait_for_start(const vt_double wait_time, const vt_double min_wait_time ) // in milliseconds
+	{
+		Vt_precondition( m_driver.driver_handle() != NULL, "Device not initialised can't query ready status\n" );
+
+		clock_t start = clock();
+
+		double time_taken = 0.0;
+		while( m_driver.pc_start() )
+		{
+			clock_t end = clock();
+			time_taken = ((double)(end - start))/CLOCKS_PER_SEC;
+
+			if (time_taken > wait_time)
+				return CVtAPI::START_SIG_TIMEOUT;
+		}
+	
+		// time taken must be more than min
+		if (time_taken < min_wait_time)
+			return CVtAPI::START_SIG_TOOQUICK;
+
+		if (!m_quiet)
+			BUGOUT( stderr, "Control port is %x\n", ctrl_port() );
+
+		return CVtAPI::START_SIG_RECEIVED;
+	}
+		
+
+	virtual CVtAPI::START_SIG  wait_for_start() // in milliseconds
+	{
+		// default wait a long time, in this case a long time is 
+		// about 16-17 mins.
+		//
+		return wait_for_start(1000000.0, 0.0); 
+	}
+
+	///
+	// Inverse of above
+	//
+	virtual vt_bool  wait_for_not_start(const vt_double wait_time)
+	{
+		Vt_precondition( m_driver.driver_handle() != NULL, "Device not initialised can't query ready status\n" );
+		clock_t start = clock();
+
+		while( ! m_driver.pc_start() )
+		{
+			clock_t end = clock();
+			double time_taken = ((double)(end - start))/CLOCKS_PER_SEC;
+
+			if (time_taken > wait_time)
+				return false;
+
+			if (!m_quiet)
+				rotator();
+		}
+		if (!m_quiet)
+			printf( "OK\n" );
+
+		return true;
+	}
+	virtual vt_bool  wait_for_not_start()
+	{
+		return wait_for_not_start( 40000 );
+	}
+
+
+	//----------------------------------------------------------
+	// Main PanoCapture Interface routines Start
+	//-----------------------------------------------------------
+	///
+	// main run thread
+	//
+	virtual void run()
+	{
+		Vt_precondition( m_driver.driver_handle() != NULL, "Device not initialised can't query ready status\n" );
+	
+		m_driver.read_pipe();
+
+		// reset the device - we don't actually want to reset the device now
+		// vt_byte status[16];
+		// send_command( status, m_driver.driver_handle(), VR_IUSBI_NOT_ACK, DEFAULT_SUB );
+		if (!m_quiet)
+			printf( "Control Port is %x\n",ctrl_port() );
+	}
+
+	template<typename T> 
+	CVtImage<T>* transpose_lineim( CVtImage<T>& lineim )
+	{
+		//
+		// transpose data
+		//
+		vt_long width = lineim.height(); // the output width is the input height
+
+		// every pixel is written below - so take a recycled frame rather than initialising
+		CVtImage<vt_acq_im_type> *pim = new CVtImage<vt_acq_im_type> (width, m_chip_height*m_numChips, pool_allocator());
+		CVtImage<vt_acq_im_type> &im  = *pim;
+		
+		for( vt_ulong lineno = 0; lineno < width; lineno++)
+		{
+			vt_acq_im_type  *inptr  = lineim[lineno];
+
+			vt_ulong row = 0;
+			// tile a
+			for(row = 0; row < m_chip_height; row++)
+			{
+				im[row][lineno] = *inptr++;
+			}
+			// tile b
+			for(row = m_chip_height; row < 2*m_chip_height; row++)
+			{
+				im[row][lineno] = *inptr++;
+			}
+			// tile c
+			if (m_invertC)
+			{
+				inptr += m_chip_height-1;
+				for(row = 2*m_chip_height; row < 3*m_chip_height; row++)
+				{
+					im[row][lineno] = *inptr--;
+				}
+			}
+			else
+			{
+				for(row = 2*m_chip_height; row < 3*m_chip_height; row++)
+				{
+					im[row][lineno] = *inptr++;
+				}
+			}
+		}
+		return pim;
+	}
+
+	///
+	// read_lineim
+	//
+	// Read width lines of raw A|B|C data straight into a column-major acquisition
+	// image - each line is one image column so no transpose is needed, only the
+	// C tile has to be reversed in place when it is inverted.
+	//
+	CVtImage<vt_acq_im_type>* read_lineim( std::istream &strm, const vt_ulong width, CVtImageAllocator &alloc )
+	{
+		const vt_ulong height = m_chip_height*m_numChips;
+
+		CVtImage<vt_acq_im_type> *pim = new CVtImage<vt_acq_im_type> (width, height, CVtImageBaseClass::COL_MAJOR, alloc);
+		CVtImage<vt_acq_im_type> &im  = *pim;
+
+		strm.read( (char *) im.begin(), sizeof( vt_acq_im_type )*width*height );
+
+		invert_tileC( im );
+
+		return pim;
+	}
+
+	///
+	// invert_tileC
+	//
+	// Reverse the C tile of each line of a column-major acquisition image in place
+	// if the C chip is read out inverted.
+	//
+	void invert_tileC( CVtImage<vt_acq_im_type> &im )
+	{
+		if (!m_invertC)
+			return;
+
+		for( vt_ulong lineno = 0; lineno < im.width(); lineno++)
+		{
+			vt_acq_im_type *tilec = im[lineno] + 2*m_chip_height;
+			std::reverse( tilec, tilec + m_chip_height );
+		}
+	}
+
+	///
+	// main capture thread
+	//
+	// currently merely an alias for run
+	//
+	virtual void capture()
+	{
+		m_process_pending = false; // the new frames haven't been asked for yet
+
+		run();
+		trim_dataset();
+		Vt_postcondition( _CrtCheckMemory() == TRUE, "Capture:::Memory problem detected\n" );
+	}
+
+	///
+	// simulate capture based on file image rather than grabbed from system.
+	//
+	virtual void capture(std::string& fname)
+	{
+		m_process_pending = false; // the new frames haven't been asked for yet
+
+		if (is_packed12_fname( fname ))
+		{
+			capture_packed( fname );
+			return;
+		}
+
+		vt_ulong width;
+		if (get_filesize(fname.c_str(), sizeof( vt_acq_im_type), width) == true)
+		{
+			std::ifstream cfile( fname.c_str(), std::ios::binary | std::ios::in );
+
+			// opened file
+			if (cfile.is_open())
+			{
+				if (!m_quiet)
+					std::cout << "opened input file" << std::endl;
+
+				if (!m_quiet)
+					std::cout << "reading input file...." << std::endl;
+
+				// read in data - the file lines are the columns of the column-major image
+				CVtImage<vt_acq_im_type> *im = read_lineim( cfile, width, pool_allocator() );
+				//
+				DATASET_ENTRY_TYPE ent_type;
+				ent_type.type			= ACQ_IM;
+				ent_type.half_idx = m_out_width/2;  // !!!!! cheat value
+
+				add_dataset( ent_type, im );
+				trim_dataset();
+			}
+			else
+			{
+				Vt_fail( "failed to open input image"  );
+			}
+		}
+	}
+
+
+	///
+	// simulate capture based on a packed 12-bit file image, the packed lines are 
+	// unpacked straight into the columns of the acquisition image.
+	//
+	void capture_packed(const std::string& fname)
+	{
+		CVtPacked12Image packed;
+
+		if (!packed.load( fname, m_chip_height*m_numChips, CVtImageBaseClass::COL_MAJOR ))
+		{
+			Vt_fail( "failed to open input image"  );
+		}
+
+		if (!m_quiet)
+			std::cout << "unpacking input file...." << std::endl;
+
+		CVtImage<vt_acq_im_type> *im = new CVtImage<vt_acq_im_type> (packed.width(), packed.height()
+																																	, CVtImageBaseClass::COL_MAJOR, pool_allocator() );
+		packed.unpack( *im );
+
+		invert_tileC( *im );
+
+		DATASET_ENTRY_TYPE ent_type;
+		ent_type.type			= ACQ_IM;
+		ent_type.half_idx = m_out_width/2;  // !!!!! cheat value
+
+		add_dataset( ent_type, im );
+		trim_dataset();
+	}
+
+
+	///
+	// PROCESSING ROUTINES
+	//
+	// This is were the main data processing routines go. 
+	// Currently this is merely reconstruction and calibration
+	//
+	//
+	virtual void calibrate()
+	{
+		prepare_calib();
+
+		///
+		// for each data set current stored
+		//
+		vt_ulong num = m_dataset.size(); // save current size - this allows us to add more
+																		 // entries in loop without invalidating it
+		for(vt_ulong idx = 0; idx < num; idx++)
+		{
+			DATASET::iterator it = m_dataset.begin() + idx;
+
+			if ( (*it).first.type == CENTRE_IM )
+			{
+				CVtImage<vt_centre_im_type>* im = dynamic_cast<CVtImage<vt_centre_im_type>*>(m_dataset.fetch( it ));
+
+				// OK apply calibration to each line
+				std::auto_ptr< CVtImage<vt_out_im_type> > cal_im( new CVtImage<vt_out_im_type>(im->width(), im->height()) );
+				//
+				// do calibration
+				//
+				if (m_darkFrameCal)
+					m_calib( *im, *cal_im, (*it).first.half_idx, true );
+				else
+					m_calib( *im, *cal_im, (*it).first.half_idx );
+		
+				DATASET_ENTRY_TYPE ent_type( (*it).first );
+				ent_type.type = OUTPUT_IM;
+
+				add_dataset( ent_type, cal_im.release() );
+			}
+		}
+		trim_dataset();
+
+		Vt_postcondition( _CrtCheckMemory() == TRUE, "Calibrate::Memory problem detected\n" );
+	}
+
+	///
+	// centre_calibrate
+	//
+	// The fused version of centre() followed by calibrate(). Each acquired image is read once
+	// and the output image written directly, without the intermediate centred image. The
+	// output is the same as the separate stages give.
+	//
+	void centre_calibrate()
+	{
+		prepare_calib();
+
+		vt_ulong num = m_dataset.size(); // save current size - this allows us to add more
+																		 // entries in loop without invalidating it
+		for(vt_ulong idx = 0; idx < num; idx++)
+		{
+			DATASET::iterator it = m_dataset.begin() + idx;
+
+			if ( (*it).first.type != ACQ_IM )
+				continue;
+
+			CVtImageBaseClass					 *data	 = m_dataset.fetch( it );
+			CVtPacked12Image					 *packed = dynamic_cast<CVtPacked12Image*>( data );
+			CVtImage<vt_acq_im_type> *im		 = NULL;
+
+			std::auto_ptr< CVtImage<vt_acq_im_type> > unpacked; // only owned when unpacked here
+			if (packed != NULL)
+			{
+				unpacked.reset( packed->unpack( pool_allocator() ) );
+				im = unpacked.get();
+			}
+			else
+			{
+				im = dynamic_cast<CVtImage<vt_acq_im_type>*>( data );
+			}
+
+			// every pixel of the output is written
+			std::auto_ptr< CVtImage<vt_out_im_type> > cal_im( new CVtImage<vt_out_im_type>( m_out_width, im->height()
+																																									, CVtImageBaseClass::ROW_MAJOR, uninit_allocator() ) );
+
+			m_calib.centre_calibrate( *im, *cal_im, (*it).first.half_idx, m_darkFrameCal );
+
+			unpacked.reset();
+
+			DATASET_ENTRY_TYPE ent_type( (*it).first );
+			ent_type.type = OUTPUT_IM;
+
+			add_dataset( ent_type, cal_im.release() );
+		}
+		trim_dataset();
+
+		Vt_postcondition( _CrtCheckMemory() == TRUE, "Centre calibrate::Memory problem detected\n" );
+	}
+
+	///
+	// the calibration settings from the api parameters, for a calibrate() run
+	//
+	void prepare_calib()
+	{
+		m_calib.set_threads( m_numThreads );
+		m_calib.set_seam_noise( m_seamNoise, m_seamSeed );
+		m_calib.set_full_field( m_fullField );
+		m_calib.set_ab_correct( m_abCorrect );
+	}
+
+
+	///
+	// centres specific image types - let templates do the work
+	// of generating the code for the different versions.
+	//
+	template<typename T>
+	centre(const CVtImage<T>& im, const vt_ulong half_idx)
+	{
+		///
+		// allocate output image
+		//
+		CVtImage<vt_out_im_type> *outimp = new CVtImage<vt_out_im_type>(m_out_width, im.height());
+		CVtImage<vt_out_im_type>& outim  = *outimp;
+
+		///
+		// half index is relative to acquired image, the output image will be narrower than this
+		// hence we wish to come back from the centre line by half the output image width.
+		//
+		vt_long start_idx = (vt_long)half_idx-(vt_long)m_out_width/2;
+
+		if (start_idx < 0 )
+		{
+			start_idx = 0;
+		}
+
+		///
+		// note im.width is note necessarily m_out_width - it will probably be larger depending on 
+		// the number of packets that we have chosen to collect.
+		//
+		vt_long cols = (vt_long)im.width() - start_idx;
+		if (cols > (vt_long)m_out_width)
+			cols = m_out_width;
+
+		///
+		// centred update the dataset - a column-major acquisition image is transposed
+		// to the row-major centred image here
+		//
+		if (cols > 0)
+			copy_region( im, Diff2D( start_idx, 0 ), outim, Diff2D( 0, 0 ), Diff2D( cols, im.height() ) );
+
+		// OK complete - add dataset
+		DATASET_ENTRY_TYPE ent_type;
+		ent_type.type			= CENTRE_IM;
+		ent_type.half_idx = half_idx;
+
+		add_dataset( ent_type, outimp );
+	}
+
+	///
+	// centre a packed acquisition image - unpacked into a recycled frame first
+	//
+	void centre(const CVtPacked12Image& packed, const vt_ulong half_idx)
+	{
+		CVtImage<vt_acq_im_type> *im = packed.unpack( pool_allocator() );
+
+		centre( *im, half_idx );
+
+		delete im;
+	}
+
+
+	///
+	// Centre the image
+	// Centre takes an image type. However, currently
+	// it only centres calib_ims and recon_ims
+	//
+	virtual void centre(IM_TYPE im_type)
+	{
+		///
+		// for each calibrated image - produce a centred image
+		//
+		vt_ulong num = m_dataset.size(); // save current size - this allows us to add more
+																		 // entries in loop without invalidating it
+		for(vt_ulong idx = 0; idx < num; idx++)
+		{
+			DATASET::iterator it = m_dataset.begin() + idx;
+
+			if ((*it).first.type == im_type)
+			{
+				switch(im_type)
+				{
+				case ACQ_IM:
+					if (dynamic_cast<CVtPacked12Image*>(m_dataset.fetch( it )) != NULL)
+						centre(*dynamic_cast<CVtPacked12Image*>(m_dataset.fetch( it )), (*it).first.half_idx );
+					else
+						centre(*dynamic_cast<CVtImage<vt_acq_im_type>*>(m_dataset.fetch( it )), (*it).first.half_idx );
+					break;
+
+				case CALIB_IM:
+					centre(*dynamic_cast<CVtImage<vt_calib_im_type>*>(m_dataset.fetch( it )), (*it).first.half_idx );
+					break;
+				default:
+					Vt_fail( "Invalid image type for centring" );
+					break;
+				}
+			}
+		}
+		trim_dataset();
+
+		Vt_postcondition( _CrtCheckMemory() == TRUE, "Centre::Memory problem detected\n" );
+	}
+
+	//
+	// generic process function this contains all the default
+	// processing applied to a particular image
+	//
+	// currently not doing reconstruction process. The processing merely consists
+	// of calibration and data access,
+	//
+	virtual void process()
+	{
+		calibrate();
+	}
+
+	//
+	// The centred and calibrated images are made when they are first accessed,
+	// unless m_eagerProcess is set.
+	//
+	virtual void process(IM_TYPE imtype)
+	{
+		if (!m_quiet)
+			std::cout << "OK" << std::endl;
+		
+		// a different source - anything made from the old one is out of date
+		if (imtype != m_centre_src)
+			m_dataset.invalidate( m_centre_src );
+
+		m_centre_src = imtype;
+		m_dataset.set_input( CENTRE_IM, imtype );
+		m_process_pending = true;
+
+		if (m_eagerProcess)
+			m_dataset.materialise( OUTPUT_IM );
+
+		// the acquired frames are only kept for saving or reprocessing from here on
+		if (m_packed12)
+		{
+			m_dataset.pack( ACQ_IM );
+			trim_dataset();
+		}
+	}
+
+	///
+	// CVtDatasetProducer - make the centred and calibrated images on demand
+	//
+	virtual vt_bool produce(const IM_TYPE im_type)
+	{
+		switch(im_type)
+		{
+		case CENTRE_IM:
+			if (!m_process_pending)
+				return false;
+
+			centre( m_centre_src ); // centring before calib
+			return true;
+
+		case OUTPUT_IM:
+			// straight from the acquired images unless the centred images have been made anyway
+			if (m_fusedProcess && m_process_pending && m_centre_src == ACQ_IM && !m_dataset.present( CENTRE_IM ))
+			{
+				if (!m_quiet)
+					std::cout << "Centring and calibrating data set..." << std::endl;
+
+				centre_calibrate();
+				return true;
+			}
+
+			if (!m_dataset.materialise( CENTRE_IM ))
+				return false;
+
+			if (!m_quiet)
+				std::cout << "Calibrating data set..." << std::endl;
+
+			calibrate();
+			return true;
+
+		default:
+			return false;
+		}
+	}
+
+	///
+	// CVtDatasetProducer - the size of the centred and calibrated images, so they
+	// aren't made just to be measured. Both are m_out_width wide and as high as the
+	// images they are made from.
+	//
+	virtual vt_bool geometry(const IM_TYPE im_type, vt_ulong &width, vt_ulong &height, CVtImageBaseClass::LAYOUT &layout)
+	{
+		if ((im_type != CENTRE_IM && im_type != OUTPUT_IM) || !m_process_pending)
+			return false;
+
+		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
+		{
+			if ((*it).first.type == m_centre_src)
+			{
+				width	 = m_out_width;
+				height = (*it).second->height();
+				layout = CVtImageBaseClass::ROW_MAJOR;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	///
+	// apply the memory budget to the dataset
+	//
+	void trim_dataset()
+	{
+		m_dataset.set_budget( m_memBudget );
+		m_dataset.trim();
+	}
+
+	///
+	// calibrate
+	//
+	virtual void calibration_run()
+	{
+		Vt_precondition( m_calFrames > 0, "calibration_run - calFrames must be at least 1" );
+
+		////
+		// dark frames
+		//
+		printf( "\nCAPTURE DARK FRAMES :: Press return when ready - will wait for start\n\n" );
+		getchar();
+
+		for (vt_ulong frame = 0; frame < m_calFrames; frame++)
+		{
+			wait_for_start();
+			printf( "START... frame %lu of %lu\n", frame + 1, m_calFrames );
+			capture();
+			DATASET_ENTRY dark_entry = pop_back( ACQ_IM );
+
+			CVtImage<vt_acq_im_type>* dark_ptr = dynamic_cast<CVtImage<vt_acq_im_type>*>( dark_entry.second );
+			Vt_postcondition( dark_ptr != NULL, "failed to obtain a valid imahe in calibration calculation routine" );
+
+			// only the running sums are kept
+			m_calib.add_dark_frame( *dark_ptr );
+			delete dark_ptr;
+		}
+
+		////
+		// bright frames
+		//
+		printf( "Waiting for stable position\n" );
+		wait_for_not_start();
+		printf( "CAPTURE BRIGHT FRAMES:: Press return when ready - will wait for start\n\n" );
+		getchar();
+		
+		vt_ulong half_idx = 0;
+		for (vt_ulong frame = 0; frame < m_calFrames; frame++)
+		{
+			wait_for_start();
+			printf( "START... frame %lu of %lu\n", frame + 1, m_calFrames );
+			capture();
+
+			DATASET_ENTRY bright_entry  = pop_back( ACQ_IM );
+			CVtImage<vt_acq_im_type> *bright_ptr = dynamic_cast<CVtImage<vt_acq_im_type>*>( bright_entry.second );
+			Vt_postcondition( bright_ptr != NULL, "failed to obtain a valid imahe in calibration calculation routine" );
+
+			m_calib.add_bright_frame( *bright_ptr );
+			half_idx = bright_entry.first.half_idx;
+			delete bright_ptr;
+		}
+
+		if (m_calFrames > 1)
+		{
+			printf( "Dark frame noise %.2f bright frame noise %.2f\n"
+						, m_calib.dark_accumulator().mean_noise()
+						, m_calib.bright_accumulator().mean_noise() );
+		}
+
+		// the full field calibration needs the averaged frames, set_accumulated() releases them
+		std::auto_ptr< CVtImage<vt_acq_im_type> > field_dark;
+		std::auto_ptr< CVtImage<vt_acq_im_type> > field_bright;
+		if (m_fullField)
+		{
+			field_dark.reset( m_calib.dark_accumulator().mean() );
+			field_bright.reset( m_calib.bright_accumulator().mean() );
+		}
+
+		printf( "Calculating the appropriate regions of the bright image to use....\n" );
+
+		m_calib.set_accumulated( half_idx );
+
+		printf( "OK\n" );
+		///
+		// calculation
+		//
+		printf( "Recalculating coefficients...\n" );
+
+		m_calib.recalc();
+
+		// replaces every calibration held for this api
+		calib_bank<vt_double>().clear( m_apiType );
+		store_in_bank( m_bin_mode );
+
+		////
+		// save
+		//
+		printf( "Saving coefficients...\n" );
+
+		save_calib();
+
+		printf( "New coefficients writen to file %s\n" , get_calib_fname() );
+
+		if (m_fullField)
+		{
+			printf( "Calculating per pixel calibration...\n" );
+
+			m_calib.set_field( *field_dark, *field_bright, half_idx, m_out_width );
+			m_calib.save_field( get_field_fname() );
+
+			printf( "Per pixel calibration writen to file %s\n" , get_field_fname() );
+		}
+
+		save(); // save source images
+	}
+
+  ///
+  // Close the system safely
+  //
+  virtual vt_bool close_system()
+  {
+    return true;
+  }
+private:
+	///
+	// send a command to the device
+	//
+	void send_command(vt_byte status[16]
+									 , vt_byte CommandCode
+									 , vt_uint16 SubCommandCode )
+	{
+		m_driver.send_command(status, CommandCode, SubCommandCode );
+	}
+
+	////
+	// Send reset command
+	//
+	// Note - send command throws and exception if it doesn't receive expected 
+	// return from transmitting data.
+	//
+	void Reset(const HANDLE hDevice)
+	{
+			vt_byte status[16];
+			send_command( status, VR_IUSBI_RESET, DEFAULT_SUB );
+	}
+
+	////
+	// Send ready command
+	//
+	void Ready(const HANDLE hDevice)
+	{
+			vt_byte status[16];
+			send_command( status, VR_IUSBI_READY, DEFAULT_SUB );
+	}
+
+	////
+	// Send not ready command
+	//
+	void NotReady(const HANDLE hDevice)
+	{
+			vt_byte status[16];
+			send_command( status, VR_IUSBI_NOT_READY, DEFAULT_SUB );
+	}
+
+	//----------------------------------------------------------
+	// Main PanoCapture Interface routines Start
+	//-----------------------------------------------------------
+	//
+	// bin mode effectively set the height and width of the image
+	//
+	virtual vt_ulong get_num_pkts()
+	{
+		set_num_pkts(); // ensure that the number of packets is set to the default for the acqusition mode
+		return m_numPkts;
+	}
+
+	virtual void set_calib_fname()
+	{
+		m_calibFname = (m_apiType == PANO_API) ? DEFAULT_PANO_CALIB_FNAME : DEFAULT_CEPH_CALIB_FNAME;
+	}
+
+	virtual char* get_calib_fname()
+	{
+		set_calib_fname(); //  make sure name is set to default for acquisition mode
+		return m_calibFname;
+	}
+
+	//! the per pixel calibration file for the api and a binning mode, a field only suits frames of its own mode
+	const char* get_field_fname(const BIN_MODE mode) const
+	{
+		static const char *const pano[] = { NULL
+																			, DEFAULT_PANO_FIELD_FNAME "1x1.cal"
+																			, DEFAULT_PANO_FIELD_FNAME "2x2.cal"
+																			, DEFAULT_PANO_FIELD_FNAME "1x2.cal"
+																			, DEFAULT_PANO_FIELD_FNAME "2x1.cal" };
+		static const char *const ceph[] = { NULL
+																			, DEFAULT_CEPH_FIELD_FNAME "1x1.cal"
+																			, DEFAULT_CEPH_FIELD_FNAME "2x2.cal"
+																			, DEFAULT_CEPH_FIELD_FNAME "1x2.cal"
+																			, DEFAULT_CEPH_FIELD_FNAME "2x1.cal" };
+
+		Vt_precondition( mode >= BIN1x1 && mode <= BIN2x1, "CVtpcImpAPI::get_field_fname - invalid binning mode" );
+
+		return (m_apiType == PANO_API) ? pano[mode] : ceph[mode];
+	}
+
+	//! the per pixel calibration file for the current binning mode
+	const char* get_field_fname() const
+	{
+		return get_field_fname( m_bin_mode );
+	}
+
+	// interface type accessor
+	virtual API_TYPE get_api_type()
+	{
+		return m_apiType;
+	}
+
+
+	///
+	// what does the hardware think that the device is?
+	//
+	virtual API_TYPE  hw_device_type() 
+	{
+		Vt_precondition( m_driver.driver_handle() != NULL, "Device not initialised can't query ready status\n" );
+
+		return m_driver.hw_device_type();
+	}
+
+	///
+	// private funcs - not exposed through API but useable
+	//
+	virtual void set_num_pkts(vt_ulong num_pkts) // explicitly set num pkts
+	{
+		m_numPkt_override = true;
+		m_numPkts = num_pkts;
+	}
+	virtual void set_num_pkts(vt_bool dummy) // turn off override and set default num pkts
+	{
+		m_numPkt_override = false;
+		set_num_pkts();
+	}
+	virtual void set_num_pkts() // set default num pkts
+	{
+		if (m_numPkt_override)
+			return;
+
+		if (m_calibFlag)
+		{
+			m_numPkts = (m_apiType == PANO_API) ? PANO_CALIB_NUM_PKTS : CEPH_CALIB_NUM_PKTS;
+		}
+		else
+		{
+			m_numPkts = (m_apiType == PANO_API) ? PANO_NUM_PKTS : CEPH_NUM_PKTS;
+		}
+		// are we horizontal binning
+		if ( (m_bin_mode == BIN1x1) || (m_bin_mode == BIN2x1) )
+		{
+			// not hbinning
+			m_numPkts *= 2;
+		}
+		// else do nothing for binned case
+
+	}
+
+protected:
+	///
+	// read a calibration file into the calibration bank. The file holds the rows of the mode it
+	// was made in, which may not be the current mode, the number of rows gives its vertical binning.
+	//
+	void read_calib(std::ifstream &CalDataStream)
+	{
+		Vt_precondition( CalDataStream.good(), "CVtpcImpAPI::read_calib - Failed to open calibration file" );
+
+		CalDataStream.seekg( 0, std::ios_base::end );
+		const vt_ulong fsize = (vt_ulong) CalDataStream.tellg();
+		CalDataStream.seekg( 0, std::ios_base::beg );
+
+		// dark, bright and coefficient rows, for a binned or an unbinned chip height
+		const vt_ulong	row_bytes				 = 3*sizeof(vt_double)*m_numChips;
+		const vt_ulong	file_chip_height = fsize/row_bytes;
+
+		if (file_chip_height*row_bytes != fsize
+			|| (file_chip_height != DEFAULT_CHIP_HEIGHT_BIN2x && file_chip_height != 2*DEFAULT_CHIP_HEIGHT_BIN2x))
+		{
+			Vt_fail( "CVtpcImpAPI::read_calib - calibration file is not the size of a binned or unbinned calibration" );
+		}
+
+		const vt_bool		file_vbin				 = (file_chip_height == DEFAULT_CHIP_HEIGHT_BIN2x);
+
+		m_calib.set_geometry( file_chip_height, file_vbin );
+		CalDataStream >> m_calib;
+		store_in_bank( CVtCalibBank<vt_double>::with_vbin( m_bin_mode, file_vbin ) );
+
+		// back to the current mode
+		set_binmode_params();
+	}
+
+	///
+	// save the per row calibration. A per pixel field was made against the old rows, so the
+	// field files of every mode go and the per row calibration is used until a calibration run
+	// makes a new one.
+	//
+	void save_calib()
+	{
+		m_calib.save( get_calib_fname() );
+
+		const BIN_MODE modes[] = { BIN1x1, BIN2x2, BIN1x2, BIN2x1 };
+		for (vt_ulong idx = 0; idx < sizeof(modes)/sizeof(modes[0]); idx++)
+			remove( get_field_fname( modes[idx] ) );
+	}
+
+	///
+	// keep the current calibration in the calibration bank for a binning mode, and the binned
+	// modes derived from it when deriveBinned is set
+	//
+	void store_in_bank(const BIN_MODE mode)
+	{
+		if (m_calib.store_in_bank( m_apiType, mode, m_deriveBinned ) && !m_quiet)
+			printf( "Derived the vertically binned calibration from the unbinned rows....\n" );
+	}
+
+	///
+	// read the per pixel calibration if it is wanted and there is one for the current mode,
+	// without it the per row calibration is used
+	//
+	void read_field()
+	{
+		if (!m_fullField)
+			return;
+
+		std::ifstream FieldStream( get_field_fname(), std::ios_base::binary );
+
+		if (FieldStream.good() && m_calib.read_field( FieldStream ))
+		{
+			if (!m_quiet)
+				printf( "Read per pixel calibration data....\n" );
+		}
+		else if (!m_quiet)
+		{
+			printf( "No per pixel calibration for this mode, using the per row calibration\n" );
+		}
+	}
+
+	///
+	// setup all the params which depend on the current binning mode
+	//
+	virtual vt_bool set_binmode_params(const vt_ulong vert, const vt_ulong horiz)
+	{
+		if (vert == 1)
+		{	
+			m_chip_height = 2*DEFAULT_CHIP_HEIGHT_BIN2x;
+		}	
+		else
+		{	
+			m_chip_height = DEFAULT_CHIP_HEIGHT_BIN2x;
+		}	
+		m_image_height = m_numChips*m_chip_height;
+
+		// the calibration rows and the rows interpolated across the tile cuts depend on the vertical binning
+		m_calib.set_geometry( m_chip_height, vert != 1 );
+
+		// a calibration already made for the mode, otherwise init() finds one
+		const BIN_MODE mode = (vert == 1) ? ((horiz == 1) ? BIN1x1 : BIN1x2) : ((horiz == 1) ? BIN2x1 : BIN2x2);
+		m_calib.select_from_bank( m_apiType, mode );
+
+		if (m_apiType == PANO_API)
+		{
+			if (horiz == 1)
+			{	
+				m_out_width = 2*PANO_DEFAULT_OUT_IMAGE_WIDTH_BINx2;
+
+				///
+				// we are not binning in the horizontal direction - tell the calibration
+				// it needs to know this so that it can work out were to take the bright 
+				// regions from
+				//
+				m_calib.set_hbin( false, m_apiType );
+			}	
+			else
+			{	
+				m_out_width = PANO_DEFAULT_OUT_IMAGE_WIDTH_BINx2;
+				///
+				// we are binning in the horizontal direction - tell the calibration
+				// it needs to know this so that it can work out were to take the bright 
+				// regions from
+				//
+				m_calib.set_hbin( true, m_apiType );
+			}	
+		}
+		else
+		{
+			// ceph mode
+			if (horiz == 1)
+			{	
+				//  not binned
+				m_out_width = 2*CEPH_DEFAULT_OUT_IMAGE_WIDTH_BINx2;
+
+				///
+				// we are not binning in the horizontal direction - tell the calibration
+				// it needs to know this so that it can work out were to take the bright 
+				// regions from
+				//
+				m_calib.set_hbin( false, m_apiType );
+			}	
+			else
+			{	
+				m_out_width = CEPH_DEFAULT_OUT_IMAGE_WIDTH_BINx2;
+				///
+				// we are binning in the horizontal direction - tell the calibration
+				// it needs to know this so that it can work out were to take the bright 
+				// regions from
+				//
+				m_calib.set_hbin( true, m_apiType );
+			}	
+		}
+
+		return true;
+	}
+
+	virtual vt_bool set_binmode_params()
+	{
+		switch(m_bin_mode)
+		{
+		case BIN2x2:
+			return set_binmode_params(2,2);
+
+		case BIN2x1:
+			return set_binmode_params(2,1);
+
+		case BIN1x2:
+			return set_binmode_params(1,2);
+
+		case BIN1x1:
+			return set_binmode_params(1,1);
+		}
+		return true;
+	}
+
+	///
+	// set the api to have required characteristics
+	// for the current binning mode and api type
+	//
+	virtual void set_api_params()
+	{
+		set_num_pkts();
+		set_calib_fname();
+	}
+
+	/************************************
+		 DATASET Manipulation
+	************************************/
+	///
+	// IMAGE PROPERTY
+	//
+	///
+	// Default image width is out image width
+	//
+	virtual vt_ulong image_width()
+	{
+		return m_out_width;
+	}
+	/// 
+	// image information access functions
+	//
+	virtual vt_ulong image_width(IM_TYPE im_type)
+	{
+		return m_dataset.image_width(im_type);
+	}
+
+	///
+	// get image height - returns image height
+	// currently all the images are the same height
+	//
+	virtual vt_ulong image_height() 
+	{
+		return m_image_height;
+	}
+	virtual vt_ulong image_height(IM_TYPE) // arg not used
+	{
+		return m_image_height;
+	}
+
+	///
+	// get image layout - the acquisition images may be column-major
+	//
+	virtual CVtImageBaseClass::LAYOUT image_layout(IM_TYPE im_type)
+	{
+		return m_dataset.image_layout(im_type);
+	}
+
+
+	virtual vt_bool delete_dataset()
+	{
+		m_process_pending = false;
+
+		return m_dataset.delete_dataset();
+	}
+
+	virtual vt_bool delete_image(IM_TYPE im_type)
+	{
+		return m_dataset.delete_image(im_type);
+	}
+
+	///
+	// image data accessors
+	//
+	virtual vt_ushort * image_ptr()
+	{
+		return m_dataset.image_ptr();
+	}
+
+	virtual vt_ushort * image_ptr(IM_TYPE im_type)
+	{
+		return m_dataset.image_ptr(im_type);
+	}
+
+	virtual vt_ushort ** image_ptrs(IM_TYPE im_type)
+	{
+		return m_dataset.image_ptrs(im_type);
+	}
+
+
+	///
+	// dataset manipulation
+	//
+	// Datasets can be any 2d set of data. If we are in non-sync
+	// mode then Dataset 0 is usually the raw input data buffers.
+	//
+	virtual void add_dataset( DATASET_ENTRY_TYPE ent_type, CVtImageBaseClass *pdata )
+	{
+		m_dataset.add_dataset( ent_type, pdata );
+	}
+
+	virtual DATASET_ENTRY pop_back( const IM_TYPE im_type )
+	{
+		return m_dataset.pop_back( im_type );
+	}
+
+	virtual DATASET_ENTRY get_back( const IM_TYPE im_type )
+	{
+		return m_dataset.get_back( im_type );
+	}
+
+	virtual void save()
+	{
+		std::string fname_base( HDS_DEFAULT_BASE_DIR );
+
+		vt_ulong fname_cnt = 1;
+
+		// the processed images haven't been made yet
+		if (m_process_pending)
+			m_dataset.materialise( OUTPUT_IM );
+
+		for(DATASET::iterator it = m_dataset.begin(); it != m_dataset.end(); it++)
+		{
+			vt_ulong pixel_size = 0;
+
+			switch((*it).first.type)
+			{
+				case ACQ_IM:
+				{
+					std::cout << "Saving acquired image" << std::endl;
+					CVtPacked12Image *packed = dynamic_cast<CVtPacked12Image*>(m_dataset.fetch( it ));
+					if (packed != NULL)
+					{
+						packed->save( packed12_fname( Fname(fname_base, fname_cnt) ), CVtImageBaseClass::COL_MAJOR );
+						break;
+					}
+
+					CVtImage<vt_acq_im_type> *im = dynamic_cast<CVtImage<vt_acq_im_type>*>(m_dataset.fetch( it ));
+					if (im == NULL)
+					{
+						Vt_fail( "Unexpected image type" );
+					}
+					if (m_packed12)
+					{
+						CVtPacked12Image( *im ).save( packed12_fname( Fname(fname_base, fname_cnt) ), CVtImageBaseClass::COL_MAJOR );
+						break;
+					}
+					save_imfile( *im
+									, Fname(fname_base, fname_cnt)
+									, false ); 	
+				}
+				break;
+				case CENTRE_IM:
+				{
+					std::cout << "Saving centred image" << std::endl;
+					CVtImage<vt_centre_im_type>* im = dynamic_cast<CVtImage<vt_centre_im_type>*>(m_dataset.fetch( it ));
+					if (im == NULL)
+					{
+						Vt_fail( "Unexpected image type" );
+					}
+					save_imfile( *im
+									, Fname(fname_base, fname_cnt)
+									, false ); 	
+					break;
+				}
+				case CALIB_IM:
+				{
+					std::cout << "Saving calibrated image" << std::endl;
+					CVtImage<vt_calib_im_type>* im = dynamic_cast<CVtImage<vt_calib_im_type>*>(m_dataset.fetch( it ));
+					if (im == NULL)
+					{
+						Vt_fail( "Unexpected image type" );
+					}
+					save_imfile( *im
+									, Fname(fname_base, fname_cnt)
+									, false ); 	
+					break;
+				}
+				case RECON_IM:
+				{
+					std::cout << "Saving recon image" << std::endl;
+					CVtImage<vt_recon_im_type>* im = dynamic_cast<CVtImage<vt_recon_im_type>*>(m_dataset.fetch( it ));
+					if (im == NULL)
+					{
+						Vt_fail( "Unexpected image type" );
+					}
+					save_imfile( *im
+									, Fname(fname_base, fname_cnt)
+									, false ); 	
+					break;
+				}
+				case OUTPUT_IM:
+				{
+					std::cout << "Saving output image" << std::endl;
+					CVtImage<vt_out_im_type>* im = dynamic_cast<CVtImage<vt_out_im_type>*>(m_dataset.fetch( it ));
+					if (im == NULL)
+					{
+						Vt_fail( "Unexpected image type" );
+					}
+					save_imfile( *im
+									, Fname(fname_base, fname_cnt)
+									, false ); 	
+					break;
+				}
+				default:
+					std::cout << "Invalid image type" << std::endl;
+			}
+		}
+	}
+	///
+	// small utility to return the size of a particular file
+	//
+	vt_bool get_filesize( const std::string &fname, const vt_ulong pixel_size, vt_ulong &width )
+	{
+			vt_ulong fsize = 0;
+			vt_bool  ret_code = false;
+			
+			width = 0;
+			HANDLE handle = ::CreateFile(fname.c_str()
+																	, GENERIC_READ
+																	, FILE_SHARE_READ
+																	, NULL
+																	, OPEN_EXISTING
+																	, 0
+																	, NULL );
+
+			if (handle != INVALID_HANDLE_VALUE)
+			{
+				fsize = ::GetFileSize(handle, NULL);
+				::CloseHandle( handle );
+
+				ret_code = true;
+				width		 = fsize/(m_chip_height*m_numChips*pixel_size);
+			}
+
+			return ret_code;
+	}
+
+	///
+	// read_darkbright()
+	//
+	// read in dark and bright frames and use this as the basis of the calibration
+	//
+	vt_bool read_darkbright()
+	{
+		vt_bool read_dark = false;
+		vt_bool read_bright = false;
+		if (file_exists( DEFAULT_DARK_FNAME ) && file_exists( DEFAULT_DARK_FNAME ) )
+		{
+			///
+			// OK if the bright and dark frames are available open these and recalculate the
+			// coeficients. If these are not available then look for the calibration file
+			// .cal
+			//
+			vt_ulong dark_width = 0;
+			if (get_filesize(DEFAULT_DARK_FNAME, sizeof(vt_acq_im_type), dark_width) == true)
+			{
+				if (!m_quiet)
+					printf( "Dark frame found....\n" );
+
+				std::ifstream darkframe_strm(DEFAULT_DARK_FNAME, std::ios_base::binary );
+				CVtImage<vt_acq_im_type> *im = read_lineim( darkframe_strm, dark_width, uninit_allocator() );
+
+				m_calib.set_dark( *im );
+
+				delete im;
+				read_dark = true;
+			}
+
+			vt_ulong bright_width = 0;
+			if (get_filesize(DEFAULT_BRIGHT_FNAME, sizeof( vt_acq_im_type), bright_width) == true)
+			{
+				if (!m_quiet)
+					printf( "Bright frame found....\n" );
+
+				std::ifstream brightframe_strm(DEFAULT_BRIGHT_FNAME, std::ios_base::binary );
+				CVtImage<vt_acq_im_type> *im = read_lineim( brightframe_strm, bright_width, uninit_allocator() );
+
+				m_calib.set_bright( *im, m_out_width/2 );
+
+				delete im;
+				read_bright = true;
+			}
+		}
+		else
+		{
+			return false;
+		}
+
+		return (read_dark && read_bright);
+	}
+};
+
+} // end Vt namespace
+
+#endif // __CVTPCIMAPI_H__
@@ -0,0 +1,678 @@
+/** \file VtKernelTest.cpp
+
+	\brief Checks of the pixel kernels against plain C++ versions of the same sums.
+
+	Each check fills its inputs from a fixed seed, runs a kernel and compares the result
+	with a straightforward loop over the pixels, so a fault in a vector path or a change
+	in rounding shows up as a count of mismatches. Build it as a console program with the
+	library sources, e.g.
+
+		cl /EHsc /O2 /I.. VtKernelTest.cpp ..\VtImage.cpp ..\VtErrors.cpp
+
+	It prints one line per failed check and returns the number of failures.
+
+ * Copyright (c) 2013 by
+ * All Rights Reserved
+ * REVISIONS:
+ * $Log: $
+ *
+ */
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "VtSysdefs.h"
+#include "VtErrors.h"
+#include "VtKernels.h"
+#include "VtImage.h"
+
+using namespace Vt;
+
+namespace {
+
+int g_failures = 0;
+
+#define VT_CHECK(cond) \
+	do { if (!(cond)) { printf( "%s(%d): check failed: %s\n", __FILE__, __LINE__, #cond ); g_failures++; } } while (0)
+
+/// Small linear congruential generator so every run sees the same pixels.
+vt_ulong g_seed = 12345;
+
+vt_ushort next_pixel(const vt_ushort range = 16384)
+{
+	g_seed = g_seed * 1103515245 + 12345;
+	return (vt_ushort) ((g_seed >> 16) % range);
+}
+
+//*********************************************************************
+// LAYOUT
+//*********************************************************************
+
+/**
+	\brief transpose_lines() against a plain loop, for sizes either side of the 8 x 8 block.
+*/
+void test_transpose_lines()
+{
+	const vt_ulong sizes[] = { 1, 7, 8, 9, 16, 37 };
+	const vt_ulong num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+
+	for (vt_ulong r = 0; r < num_sizes; r++)
+	{
+		for (vt_ulong c = 0; c < num_sizes; c++)
+		{
+			const vt_ulong rows = sizes[r], cols = sizes[c], src_row = 3;
+
+			std::vector<vt_ushort> in( cols * (rows + src_row) ), out( rows * cols, 0 );
+			std::vector<const vt_ushort *> src( cols );
+			std::vector<vt_ushort *> dst( rows );
+
+			for (vt_ulong i = 0; i < in.size(); i++)
+				in[i] = next_pixel();
+			for (vt_ulong col = 0; col < cols; col++)
+				src[col] = &in[col * (rows + src_row)];
+			for (vt_ulong row = 0; row < rows; row++)
+				dst[row] = &out[row * cols];
+
+			transpose_lines( &dst[0], &src[0], src_row, rows, cols );
+
+			vt_ulong bad = 0;
+
+			for (vt_ulong row = 0; row < rows; row++)
+				for (vt_ulong col = 0; col < cols; col++)
+					if (out[row * cols + col] != src[col][src_row + row])
+						bad++;
+
+			VT_CHECK( bad == 0 );
+		}
+	}
+}
+
+/**
+	\brief Pixel access and copy_region() agree between row-major and column-major images.
+*/
+void test_layout_round_trip()
+{
+	const vt_uint width = 101, height = 67;
+
+	CVtImage<vt_ushort> rows( width, height );
+	CVtImage<vt_ushort> cols( width, height, CVtImageBaseClass::COL_MAJOR );
+
+	for (vt_uint y = 0; y < height; y++)
+		for (vt_uint x = 0; x < width; x++)
+			rows(x, y) = next_pixel();
+
+	copy_region( rows, Diff2D(0, 0), cols, Diff2D(0, 0), rows.size() );
+
+	vt_ulong bad = 0;
+
+	for (vt_uint y = 0; y < height; y++)
+		for (vt_uint x = 0; x < width; x++)
+			if (cols(x, y) != rows(x, y) || cols[x][y] != rows[y][x])
+				bad++;
+
+	VT_CHECK( bad == 0 );
+
+	// and back again through relayout()
+	cols.relayout( CVtImageBaseClass::ROW_MAJOR );
+
+	bad = 0;
+	for (vt_uint y = 0; y < height; y++)
+		for (vt_uint x = 0; x < width; x++)
+			if (cols[y][x] != rows[y][x])
+				bad++;
+
+	VT_CHECK( cols.layout() == CVtImageBaseClass::ROW_MAJOR );
+	VT_CHECK( bad == 0 );
+}
+
+//*********************************************************************
+// GAIN AND BIAS
+//*********************************************************************
+
+/**
+	\brief gain_bias_row() against the double precision (src - dark)*coef + offset.
+
+	The row coefficients are folded the way CVtPanoramicCalibration folds them, gain = coef
+	and bias = offset - dark*coef, over a frame of 12-bit pixels with dark levels, gains and
+	offsets in the range the pano/ceph calibrations produce. Pixels below the dark level
+	check the clamp at zero.
+*/
+void test_gain_bias_row()
+{
+	const vt_ulong width = 1500, rows = 512;
+
+	std::vector<vt_ushort> in( width ), out( width );
+	vt_ulong bad = 0;
+
+	for (vt_ulong row = 0; row < rows; row++)
+	{
+		const vt_double dark   = 150.0 + next_pixel( 250 ) + next_pixel( 1000 )/1000.0;
+		const vt_double coef   = 0.75 + next_pixel( 600 )/1000.0;
+		const vt_double offset = 64.0 + next_pixel( 64 );
+
+		const vt_float gain = (vt_float) coef;
+		const vt_float bias = (vt_float) (offset - dark*(vt_double) gain);
+
+		for (vt_ulong idx = 0; idx < width; idx++)
+			in[idx] = next_pixel( 4096 );
+
+		gain_bias_row( &out[0], &in[0], width, gain, bias );
+
+		for (vt_ulong idx = 0; idx < width; idx++)
+		{
+			const vt_double ref = ((vt_double) in[idx] - dark)*coef + offset;
+			const vt_double expect = ref <= 0.0 ? 0.0 : (ref >= USHRT_MAX ? USHRT_MAX : floor( ref ));
+
+			if (fabs( out[idx] - expect ) > 1.0)
+				bad++;
+		}
+	}
+
+	VT_CHECK( bad == 0 );
+}
+
+//*********************************************************************
+// POLYNOMIALS
+//*********************************************************************
+
+/**
+	\brief Double precision poly_line() of one pixel, the evaluation the HDS calibration used to make.
+*/
+vt_double poly_double(const vt_double x, const vt_double *coefs, const vt_ulong order)
+{
+	vt_double val = coefs[1] + coefs[0]*x;
+	for (vt_ulong k = 2; k < order; k++)
+		val = coefs[k] + x*val;
+
+	return val*x;
+}
+
+/**
+	\brief The single precision coefficient planes against the double precision coefficients.
+
+	Follows a row of the HDS calibration, see CVthdsCalib::add_signal_line() and finish_line():
+	p3( sum of (p5(bright) - p5(dark)) / frames ) with 5th and 3rd order coefficients in the
+	range of a sensor calibration, a gain near one and small higher order terms. The float
+	result must be within half a level of the double one, so the output pixels differ by at
+	most one. poly_line() must also give the same values as its scalar loop, poly_pixels().
+*/
+void test_poly_planes()
+{
+	const vt_ulong width = 1003, num_frames = 4, order5 = 5, order3 = 3;
+
+	std::vector<vt_double> c5( order5*width ), c3( order3*width );
+	std::vector< std::vector<vt_float> > p5( order5, std::vector<vt_float>( width ) ), p3( order3, std::vector<vt_float>( width ) );
+	const vt_float *cal5[order5], *cal3[order3];
+
+	for (vt_ulong idx = 0; idx < width; idx++)
+	{
+		// highest power first
+		vt_double *k5 = &c5[idx*order5], *k3 = &c3[idx*order3];
+
+		k5[0] = (next_pixel( 2001 ) - 1000.0)*1e-19;
+		k5[1] = (next_pixel( 2001 ) - 1000.0)*1e-15;
+		k5[2] = (next_pixel( 2001 ) - 1000.0)*1e-11;
+		k5[3] = (next_pixel( 2001 ) - 1000.0)*1e-8;
+		k5[4] = 0.8 + next_pixel( 4001 )*1e-4;
+
+		k3[0] = (next_pixel( 2001 ) - 1000.0)*1e-12;
+		k3[1] = (next_pixel( 2001 ) - 1000.0)*1e-8;
+		k3[2] = 0.9 + next_pixel( 2001 )*1e-4;
+
+		for (vt_ulong k = 0; k < order5; k++)
+			p5[k][idx] = (vt_float) k5[k];
+		for (vt_ulong k = 0; k < order3; k++)
+			p3[k][idx] = (vt_float) k3[k];
+	}
+	for (vt_ulong k = 0; k < order5; k++)
+		cal5[k] = &p5[k][0];
+	for (vt_ulong k = 0; k < order3; k++)
+		cal3[k] = &p3[k][0];
+
+	std::vector<vt_ushort> dark( width );
+	std::vector< std::vector<vt_ushort> > frames( num_frames, std::vector<vt_ushort>( width ) );
+
+	for (vt_ulong idx = 0; idx < width; idx++)
+	{
+		dark[idx] = (vt_ushort) (200 + next_pixel( 200 ));
+		for (vt_ulong f = 0; f < num_frames; f++)
+			frames[f][idx] = (vt_ushort) (dark[idx] + next_pixel( 3500 ));
+	}
+
+	// single precision, as the calibration does it
+	std::vector<vt_float> dark_sig( width ), sig( width, 0.0f ), check( width, 0.0f );
+	std::vector<vt_ushort> out( width );
+
+	poly_line( &dark_sig[0], &dark[0], cal5, order5, width );
+	for (vt_ulong f = 0; f < num_frames; f++)
+		poly_line( &sig[0], &frames[f][0], cal5, order5, width, &dark_sig[0] );
+
+	// the vector and scalar versions must agree exactly
+	std::vector<vt_float> scalar_dark( width ), scalar_sig( width, 0.0f );
+	poly_pixels( &scalar_dark[0], &dark[0], cal5, order5, 0, width, (const vt_float *) NULL );
+	for (vt_ulong f = 0; f < num_frames; f++)
+		poly_pixels( &scalar_sig[0], &frames[f][0], cal5, order5, 0, width, &scalar_dark[0] );
+
+	VT_CHECK( memcmp( &scalar_dark[0], &dark_sig[0], width*sizeof(vt_float) ) == 0 );
+	VT_CHECK( memcmp( &scalar_sig[0], &sig[0], width*sizeof(vt_float) ) == 0 );
+
+	divide_line( &sig[0], width, (vt_double) num_frames );
+	check = sig;
+	poly_line( &sig[0], &sig[0], cal3, order3, width );
+	poly_pixels( &check[0], &check[0], cal3, order3, 0, width, (const vt_float *) NULL );
+	VT_CHECK( memcmp( &check[0], &sig[0], width*sizeof(vt_float) ) == 0 );
+
+	clamp_line( &out[0], &sig[0], width );
+
+	// double precision
+	vt_ulong bad_value = 0, bad_pixel = 0;
+	for (vt_ulong idx = 0; idx < width; idx++)
+	{
+		const vt_double dark_d = poly_double( dark[idx], &c5[idx*order5], order5 );
+
+		vt_double sum = 0.0;
+		for (vt_ulong f = 0; f < num_frames; f++)
+			sum += poly_double( frames[f][idx], &c5[idx*order5], order5 ) - dark_d;
+
+		const vt_double exact = poly_double( sum/num_frames, &c3[idx*order3], order3 );
+		const vt_double pixel = exact <= 0.0 ? 0.0 : (exact >= USHRT_MAX ? USHRT_MAX : floor( exact ));
+
+		if (fabs( sig[idx] - exact ) > 0.5)
+			bad_value++;
+		if (fabs( out[idx] - pixel ) > 1.0)
+			bad_pixel++;
+	}
+
+	VT_CHECK( bad_value == 0 );
+	VT_CHECK( bad_pixel == 0 );
+}
+
+/**
+	\brief The stream fold against the row by row calibration of the same frames.
+
+	CVthdsCalib::operator() works a row at a time, p5(dark) and then every frame, while
+	begin_stream(), fold() and end_stream() make p5(dark) for the whole image first and
+	then add one whole frame after another. The sums are made in the same order for each
+	pixel, so the two must give identical images.
+*/
+void test_stream_fold()
+{
+	const vt_ulong width = 517, height = 9, num_frames = 6, order5 = 5, order3 = 3;
+	const vt_ulong size = width*height;
+
+	std::vector< std::vector<vt_float> > p5( order5, std::vector<vt_float>( size ) ), p3( order3, std::vector<vt_float>( size ) );
+
+	for (vt_ulong idx = 0; idx < size; idx++)
+	{
+		p5[0][idx] = (vt_float) ((next_pixel( 2001 ) - 1000.0)*1e-19);
+		p5[1][idx] = (vt_float) ((next_pixel( 2001 ) - 1000.0)*1e-15);
+		p5[2][idx] = (vt_float) ((next_pixel( 2001 ) - 1000.0)*1e-11);
+		p5[3][idx] = (vt_float) ((next_pixel( 2001 ) - 1000.0)*1e-8);
+		p5[4][idx] = (vt_float) (0.8 + next_pixel( 4001 )*1e-4);
+
+		p3[0][idx] = (vt_float) ((next_pixel( 2001 ) - 1000.0)*1e-12);
+		p3[1][idx] = (vt_float) ((next_pixel( 2001 ) - 1000.0)*1e-8);
+		p3[2][idx] = (vt_float) (0.9 + next_pixel( 2001 )*1e-4);
+	}
+
+	CVtImage<vt_ushort> dark( width, height );
+	std::vector< CVtImage<vt_ushort> > frames( num_frames, CVtImage<vt_ushort>( width, height ) );
+
+	for (vt_ulong row = 0; row < height; row++)
+	{
+		for (vt_ulong col = 0; col < width; col++)
+		{
+			dark[row][col] = (vt_ushort) (200 + next_pixel( 200 ));
+			for (vt_ulong f = 0; f < num_frames; f++)
+				frames[f][row][col] = (vt_ushort) (dark[row][col] + next_pixel( 3500 ));
+		}
+	}
+
+	const vt_float *cal5[order5], *cal3[order3];
+	CVtImage<vt_ushort> by_row( width, height ), by_frame( width, height );
+
+	// operator(): a row at a time
+	std::vector<vt_float> dark_sig( width ), sig( width );
+
+	for (vt_ulong row = 0; row < height; row++)
+	{
+		for (vt_ulong k = 0; k < order5; k++)
+			cal5[k] = &p5[k][row*width];
+		for (vt_ulong k = 0; k < order3; k++)
+			cal3[k] = &p3[k][row*width];
+
+		std::fill( sig.begin(), sig.end(), 0.0f );
+		poly_line( &dark_sig[0], dark[row], cal5, order5, width );
+		for (vt_ulong f = 0; f < num_frames; f++)
+			poly_line( &sig[0], frames[f][row], cal5, order5, width, &dark_sig[0] );
+
+		divide_line( &sig[0], width, (vt_double) num_frames );
+		poly_line( &sig[0], &sig[0], cal3, order3, width );
+		clamp_line( by_row[row], &sig[0], width );
+	}
+
+	// begin_stream(), fold() of each frame, end_stream()
+	std::vector<vt_float> stream_dark( size ), stream_sum( size, 0.0f );
+
+	for (vt_ulong row = 0; row < height; row++)
+	{
+		for (vt_ulong k = 0; k < order5; k++)
+			cal5[k] = &p5[k][row*width];
+		poly_line( &stream_dark[row*width], dark[row], cal5, order5, width );
+	}
+	for (vt_ulong f = 0; f < num_frames; f++)
+	{
+		for (vt_ulong row = 0; row < height; row++)
+		{
+			for (vt_ulong k = 0; k < order5; k++)
+				cal5[k] = &p5[k][row*width];
+			poly_line( &stream_sum[row*width], frames[f][row], cal5, order5, width, &stream_dark[row*width] );
+		}
+	}
+	for (vt_ulong row = 0; row < height; row++)
+	{
+		for (vt_ulong k = 0; k < order3; k++)
+			cal3[k] = &p3[k][row*width];
+
+		divide_line( &stream_sum[row*width], width, (vt_double) num_frames );
+		poly_line( &stream_sum[row*width], &stream_sum[row*width], cal3, order3, width );
+		clamp_line( by_frame[row], &stream_sum[row*width], width );
+	}
+
+	vt_ulong differ = 0;
+	for (vt_ulong row = 0; row < height; row++)
+		differ += memcmp( by_row[row], by_frame[row], width*sizeof(vt_ushort) ) != 0;
+
+	VT_CHECK( differ == 0 );
+}
+
+/**
+	\brief cholesky_solve() on a system with a known solution, and on a singular one.
+*/
+void test_cholesky_solve()
+{
+	const vt_ulong n = 5;
+
+	// a = m'm + I is symmetric positive definite
+	vt_double m[n*n], a[n*n], x[n], b[n];
+
+	for (vt_ulong idx = 0; idx < n*n; idx++)
+		m[idx] = next_pixel( 2001 )/1000.0 - 1.0;
+
+	for (vt_ulong i = 0; i < n; i++)
+	{
+		for (vt_ulong j = 0; j < n; j++)
+		{
+			vt_double sum = (i == j) ? 1.0 : 0.0;
+			for (vt_ulong k = 0; k < n; k++)
+				sum += m[k*n + i]*m[k*n + j];
+			a[i*n + j] = sum;
+		}
+		x[i] = next_pixel( 2001 )/100.0 - 10.0;
+	}
+	for (vt_ulong i = 0; i < n; i++)
+	{
+		b[i] = 0.0;
+		for (vt_ulong j = 0; j < n; j++)
+			b[i] += a[i*n + j]*x[j];
+	}
+
+	VT_CHECK( cholesky_solve( a, b, n ) );
+
+	vt_double error = 0.0;
+	for (vt_ulong i = 0; i < n; i++)
+		error = (fabs( b[i] - x[i] ) > error) ? fabs( b[i] - x[i] ) : error;
+	VT_CHECK( error < 1e-10 );
+
+	// rank one, not positive definite
+	vt_double s[n*n], t[n];
+	for (vt_ulong i = 0; i < n; i++)
+	{
+		for (vt_ulong j = 0; j < n; j++)
+			s[i*n + j] = (i + 1.0)*(j + 1.0);
+		t[i] = 1.0;
+	}
+	VT_CHECK( !cholesky_solve( s, t, n ) );
+}
+
+/**
+	\brief fit_poly_line() recovers known polynomials from the sums of poly_sums_line().
+
+	Each pixel has its own 5th order polynomial with no constant term, a gain near one and
+	small higher order terms so it rises steadily over the 12 bit range, and a point for
+	each of 20 levels of a sweep, found by solving p(x) = y.
+	The fitted polynomials must match the known ones to well within a level over the 12 bit
+	range. The SSE2 sums must equal those of the scalar loop, and a pixel whose points are
+	all the same must be marked bad and given y = x.
+*/
+void test_poly_fit()
+{
+	const vt_ulong width = 101, order = 5, num_levels = 20, num_sums = 3*order - 1;
+	const vt_double scale = 1.0/4096;
+
+	std::vector<vt_double> known( width*order ), fitted( width*order );
+	std::vector<vt_double> sums( num_sums*width, 0.0 ), scalar_sums( num_sums*width, 0.0 );
+	std::vector<vt_double> x( width );
+	std::vector<vt_byte>	 good( width );
+	vt_double							 residual = 0.0;
+
+	for (vt_ulong idx = 0; idx < width; idx++)
+	{
+		vt_double *c = &known[idx*order];
+
+		c[0] = (next_pixel( 2001 ) - 1000.0)*1e-20;
+		c[1] = (next_pixel( 2001 ) - 1000.0)*1e-16;
+		c[2] = (next_pixel( 2001 ) - 1000.0)*1e-12;
+		c[3] = (next_pixel( 2001 ) - 1000.0)*1e-8;
+		c[4] = 0.8 + next_pixel( 4001 )*1e-4;
+	}
+
+	for (vt_ulong level = 0; level < num_levels; level++)
+	{
+		const vt_double y = 300.0 + level*(3500.0/(num_levels - 1));
+
+		for (vt_ulong idx = 0; idx < width; idx++)
+		{
+			const vt_double *c = &known[idx*order];
+
+			// Newton's method from the linear term alone, p is close to linear
+			vt_double u = y/c[order - 1];
+			for (vt_ulong iter = 0; iter < 20; iter++)
+			{
+				vt_double p = 0.0, dp = 0.0;
+				for (vt_ulong k = 0; k < order; k++)
+				{
+					dp = dp*u + p;
+					p	 = p*u + c[k];
+				}
+				dp = dp*u + p;
+				p	*= u;
+
+				u -= (p - y)/dp;
+			}
+
+			if (fabs( poly_double( u, c, order ) - y ) > residual)
+				residual = fabs( poly_double( u, c, order ) - y );
+
+			// the last pixel's points are all the same
+			x[idx] = (idx == width - 1) ? 1000.0 : u;
+		}
+
+		poly_sums_line( &sums[0], width, &x[0], y, scale, order, width );
+		poly_sums_pixels( &scalar_sums[0], width, &x[0], y, scale, order, 0, width );
+	}
+
+	VT_CHECK( residual < 1e-9 );
+	VT_CHECK( memcmp( &sums[0], &scalar_sums[0], sums.size()*sizeof(vt_double) ) == 0 );
+
+	fit_poly_line( &fitted[0], order, &sums[0], width, scale, order, width, &good[0] );
+
+	vt_ulong bad = 0;
+	for (vt_ulong idx = 0; idx + 1 < width; idx++)
+	{
+		if (!good[idx])
+		{
+			bad++;
+			continue;
+		}
+
+		for (vt_ulong level = 0; level <= 4095; level += 15)
+		{
+			const vt_double u = level;
+			if (fabs( poly_double( u, &fitted[idx*order], order ) - poly_double( u, &known[idx*order], order ) ) > 1e-3)
+			{
+				bad++;
+				break;
+			}
+		}
+	}
+	VT_CHECK( bad == 0 );
+
+	const vt_double *last = &fitted[(width - 1)*order];
+	VT_CHECK( !good[width - 1] && last[0] == 0.0 && last[order - 2] == 0.0 && last[order - 1] == 1.0 );
+}
+
+//*********************************************************************
+// REDUCTIONS
+//*********************************************************************
+
+/**
+	\brief Run every reduction kernel over the same inputs and collect the results in order.
+*/
+void run_reductions(std::vector<vt_double> &out, const std::vector<vt_ushort> &pix, const std::vector<vt_double> &val)
+{
+	const vt_ulong num = pix.size();
+
+	out.clear();
+
+	// lengths either side of the vector widths and of the pairwise block
+	const vt_ulong lengths[] = { 1, 3, 4, 7, 8, 15, 16, 33, 127, 128, 129, 1000, num };
+	for (vt_ulong idx = 0; idx < sizeof(lengths) / sizeof(lengths[0]); idx++)
+	{
+		out.push_back( line_sum( &val[0], lengths[idx] ) );
+		out.push_back( line_sum( &pix[0], lengths[idx] ) );
+	}
+
+	vt_uint64 sum = 0, sumsq = 0;
+	kernels().sum_sq_u16( sum, sumsq, &pix[0], num );
+	out.push_back( (vt_double) sum );
+	out.push_back( (vt_double) sumsq );
+
+	std::vector<vt_uint32> acc32( num, 7 );
+	kernels().add_u16( &acc32[0], &pix[0], num );
+	out.insert( out.end(), acc32.begin(), acc32.end() );
+
+	std::vector<vt_double> acc( val );
+	add_line( &acc[0], &pix[0], num );
+	divide_line( &acc[0], num, 3.0 );
+	out.insert( out.end(), acc.begin(), acc.end() );
+
+	// the pixels as rows of 100, summed down the columns
+	const vt_ulong width = 100, rows = num/width;
+	std::vector<const vt_ushort *> lines( rows );
+	for (vt_ulong row = 0; row < rows; row++)
+		lines[row] = &pix[row*width];
+
+	std::vector<vt_double> sums( width - 10 );
+	column_sums( &sums[0], &lines[0], rows, 5, sums.size() );
+	out.insert( out.end(), sums.begin(), sums.end() );
+
+	std::vector<vt_double> box( num, 0.0 );
+	box_filter( &box[0], &val[0], num, 9 );
+	out.insert( out.end(), box.begin(), box.end() );
+}
+
+/**
+	\brief The scalar kernels against plain loops, then every other instruction set against the scalar kernels.
+
+	The SSE2 and AVX2 kernels must give results identical to the bit, an instruction set
+	the build or the processor doesn't have is reported and skipped.
+*/
+void test_isa_paths()
+{
+	const vt_ulong num = 5003, span = 9;
+
+	std::vector<vt_ushort> pix( num );
+	std::vector<vt_double> val( num );
+
+	for (vt_ulong idx = 0; idx < num; idx++)
+	{
+		pix[idx] = next_pixel( 65535 );
+		val[idx] = next_pixel()/7.0 + 1000.0;
+	}
+
+	const VT_ISA best = cpu_isa();
+
+	VT_CHECK( select_isa( VT_ISA_SCALAR ) == VT_ISA_SCALAR );
+
+	std::vector<vt_double> ref;
+	run_reductions( ref, pix, val );
+
+	// plain loops
+	vt_uint64 sum = 0, sumsq = 0;
+	for (vt_ulong idx = 0; idx < num; idx++)
+	{
+		sum		+= pix[idx];
+		sumsq += (vt_uint64) pix[idx]*pix[idx];
+	}
+	VT_CHECK( kernels().sum_u16( &pix[0], num ) == sum );
+
+	vt_uint64 ksum = 0, ksumsq = 0;
+	kernels().sum_sq_u16( ksum, ksumsq, &pix[0], num );
+	VT_CHECK( ksum == sum && ksumsq == sumsq );
+
+	std::vector<vt_double> box( num, 0.0 );
+	box_filter( &box[0], &val[0], num, span );
+
+	vt_ulong bad = 0;
+	for (vt_ulong pos = span; pos + span < num; pos++)
+	{
+		vt_double window = 0.0;
+		for (vt_ulong idx = pos - span; idx <= pos + span; idx++)
+			window += val[idx];
+		window /= 2*span + 1;
+
+		if (fabs( box[pos] - window ) > 1e-9*window)
+			bad++;
+	}
+	VT_CHECK( bad == 0 );
+
+	// the vector kernels
+	const VT_ISA isas[] = { VT_ISA_SSE2, VT_ISA_AVX2 };
+	for (vt_ulong idx = 0; idx < sizeof(isas) / sizeof(isas[0]); idx++)
+	{
+		if (select_isa( isas[idx] ) != isas[idx])
+		{
+			printf( "instruction set %d not available, skipped\n", (int) isas[idx] );
+			continue;
+		}
+
+		std::vector<vt_double> out;
+		run_reductions( out, pix, val );
+
+		VT_CHECK( out.size() == ref.size() && memcmp( &out[0], &ref[0], sizeof(ref[0])*ref.size() ) == 0 );
+	}
+
+	select_isa( best );
+}
+
+} // namespace
+
+int main()
+{
+	test_transpose_lines();
+	test_layout_round_trip();
+	test_gain_bias_row();
+	test_poly_planes();
+	test_stream_fold();
+	test_cholesky_solve();
+	test_poly_fit();
+	test_isa_paths();
+
+	if (g_failures == 0)
+		printf( "all checks passed\n" );
+
+	return g_failures;
+}